@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+namespace Utilities
+{
+	// Fixed-width integers in stored formats are little-endian on every host
+	class ByteOrder
+	{
+	public:
+		template <typename Target, typename T>
+		static auto append_little_endian(Target& target, const T& value) -> void
+		{
+			auto bits = static_cast<std::make_unsigned_t<T>>(value);
+			for (size_t index = 0; index < sizeof(T); ++index)
+			{
+				target.push_back(static_cast<typename Target::value_type>((bits >> (index * 8)) & 0xff));
+			}
+		}
+
+		template <typename Source, typename T>
+		static auto read_little_endian(const Source& source, size_t& offset, T& value) -> bool
+		{
+			if (offset > source.size() || source.size() - offset < sizeof(T))
+			{
+				return false;
+			}
+
+			std::make_unsigned_t<T> bits = 0;
+			for (size_t index = 0; index < sizeof(T); ++index)
+			{
+				bits |= static_cast<std::make_unsigned_t<T>>(static_cast<uint8_t>(source[offset + index])) << (index * 8);
+			}
+
+			value = static_cast<T>(bits);
+			offset += sizeof(T);
+			return true;
+		}
+	};
+}
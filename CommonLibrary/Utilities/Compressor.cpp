@@ -1,5 +1,6 @@
 #include "Compressor.h"
 
+#include "ByteOrder.h"
 #include "Logger.h"
 
 #include "lz4.h"
@@ -9,7 +10,8 @@
 
 namespace Utilities
 {
-	auto Compressor::compression(const std::vector<uint8_t>& original_data, const uint16_t& block_bytes)
+	auto Compressor::compression(const std::vector<uint8_t>& original_data, const uint32_t& block_bytes,
+								 const std::vector<uint8_t>& dictionary)
 		-> std::tuple<std::optional<std::vector<uint8_t>>, std::optional<std::string>>
 	{
 		if (original_data.empty())
@@ -17,6 +19,11 @@ namespace Utilities
 			return { std::nullopt, "the data field is empty." };
 		}
 
+		if (block_bytes == 0 || block_bytes > LZ4_MAX_INPUT_SIZE)
+		{
+			return { std::nullopt, std::format("invalid block size: {}", block_bytes) };
+		}
+
 		LZ4_stream_t lz4Stream_body;
 		size_t read_index = 0;
 		int32_t source_buffer_index = 0;
@@ -24,19 +31,20 @@ namespace Utilities
 		std::vector<std::vector<char>> source_buffer;
 		source_buffer.push_back(std::vector<char>());
 		source_buffer.push_back(std::vector<char>());
-		source_buffer[0].reserve(block_bytes);
-		source_buffer[1].reserve(block_bytes);
+		source_buffer[0].resize(block_bytes);
+		source_buffer[1].resize(block_bytes);
 
 		int32_t original_size = 0;
 		int32_t compress_size = LZ4_COMPRESSBOUND(block_bytes);
 		std::vector<char> compress_buffer;
-		compress_buffer.reserve(compress_size);
+		compress_buffer.resize(compress_size);
 		std::vector<uint8_t> compressed_data;
 
-		char original_size_data[4];
-		char compress_size_data[4];
-
 		LZ4_resetStream(&lz4Stream_body);
+		if (!dictionary.empty())
+		{
+			LZ4_loadDict(&lz4Stream_body, (const char*)dictionary.data(), (int32_t)dictionary.size());
+		}
 
 		while (true)
 		{
@@ -64,14 +72,11 @@ namespace Utilities
 												 (char*)compress_buffer_pointer, (int32_t)inpBytes, compress_size, 1);
 				if (compressed_size <= 0)
 				{
-					break;
+					return { std::nullopt, std::format("cannot compress block at offset {}", read_index) };
 				}
 
-				memcpy(original_size_data, &original_size, sizeof(int32_t));
-				memcpy(compress_size_data, &compressed_size, sizeof(int32_t));
-
-				compressed_data.insert(compressed_data.end(), original_size_data, original_size_data + sizeof(int32_t));
-				compressed_data.insert(compressed_data.end(), compress_size_data, compress_size_data + sizeof(int32_t));
+				ByteOrder::append_little_endian(compressed_data, original_size);
+				ByteOrder::append_little_endian(compressed_data, compressed_size);
 				compressed_data.insert(compressed_data.end(), compress_buffer_pointer,
 									   compress_buffer_pointer + compressed_size);
 			}
@@ -95,7 +100,8 @@ namespace Utilities
 							 (((double)compressed_data.size() / (double)original_data.size()) * 100)) };
 	}
 
-	auto Compressor::decompression(const std::vector<uint8_t>& compressed_data, const uint16_t& block_bytes)
+	auto Compressor::decompression(const std::vector<uint8_t>& compressed_data, const uint32_t& block_bytes,
+								   const std::vector<uint8_t>& dictionary)
 		-> std::tuple<std::optional<std::vector<uint8_t>>, std::optional<std::string>>
 	{
 		if (compressed_data.empty())
@@ -103,9 +109,14 @@ namespace Utilities
 			return { std::nullopt, "the data field is empty." };
 		}
 
+		if (block_bytes == 0 || block_bytes > LZ4_MAX_INPUT_SIZE)
+		{
+			return { std::nullopt, std::format("invalid block size: {}", block_bytes) };
+		}
+
 		LZ4_streamDecode_t lz4StreamDecode_body;
 
-		int32_t read_index = 0;
+		size_t read_index = 0;
 		int32_t original_size = 0;
 		int32_t compressed_size = 0;
 
@@ -114,39 +125,43 @@ namespace Utilities
 		std::vector<std::vector<char>> target_buffer;
 		target_buffer.push_back(std::vector<char>());
 		target_buffer.push_back(std::vector<char>());
-		target_buffer[0].reserve(block_bytes);
-		target_buffer[1].reserve(block_bytes);
+		target_buffer[0].resize(block_bytes);
+		target_buffer[1].resize(block_bytes);
 
 		int32_t compress_size = LZ4_COMPRESSBOUND(block_bytes);
 		std::vector<char> compress_buffer;
-		compress_buffer.reserve(compress_size);
+		compress_buffer.resize(compress_size);
 		std::vector<uint8_t> decompressed_data;
 
-		LZ4_setStreamDecode(&lz4StreamDecode_body, NULL, 0);
+		LZ4_setStreamDecode(&lz4StreamDecode_body, dictionary.empty() ? NULL : (const char*)dictionary.data(),
+							(int32_t)dictionary.size());
 
-		while (true)
+		// Every block must decode in full and the blocks must cover the input exactly; a torn frame is an error, not a shorter payload
+		while (read_index < compressed_data.size())
 		{
 			char* const compress_buffer_pointer = compress_buffer.data();
 
 			memset(compress_buffer_pointer, 0, sizeof(char) * compress_size);
-			if ((compressed_data.size() - read_index) < 1)
+			if ((compressed_data.size() - read_index) < sizeof(int32_t) * 2)
 			{
-				break;
+				return { std::nullopt, std::format("truncated block header at offset {}", read_index) };
 			}
 
-			memcpy(&original_size, compressed_data.data() + read_index, sizeof(int32_t));
-			if (0 >= original_size)
+			ByteOrder::read_little_endian(compressed_data, read_index, original_size);
+			ByteOrder::read_little_endian(compressed_data, read_index, compressed_size);
+
+			if (0 >= original_size || 0 >= compressed_size || compressed_size > compress_size
+				|| static_cast<size_t>(original_size) > block_bytes)
 			{
-				break;
+				return { std::nullopt, std::format("invalid block sizes ({} -> {}) at offset {}", compressed_size, original_size,
+												   read_index - sizeof(int32_t) * 2) };
 			}
-			read_index += sizeof(int32_t);
 
-			memcpy(&compressed_size, compressed_data.data() + read_index, sizeof(int32_t));
-			if (0 >= compressed_size)
+			if (compressed_data.size() - read_index < static_cast<size_t>(compressed_size))
 			{
-				break;
+				return { std::nullopt, std::format("truncated block at offset {}: {} of {} bytes", read_index,
+												   compressed_data.size() - read_index, compressed_size) };
 			}
-			read_index += sizeof(int32_t);
 
 			memcpy(compress_buffer_pointer, compressed_data.data() + read_index, sizeof(char) * compressed_size);
 			read_index += compressed_size;
@@ -155,9 +170,10 @@ namespace Utilities
 			const int32_t decompressed_size
 				= LZ4_decompress_safe_continue(&lz4StreamDecode_body, (const char*)compress_buffer_pointer,
 											   (char*)target_buffer_pointer, compressed_size, block_bytes);
-			if (decompressed_size <= 0)
+			if (decompressed_size != original_size)
 			{
-				break;
+				return { std::nullopt, std::format("corrupt block before offset {}: decoded {} of {} bytes", read_index,
+												   decompressed_size, original_size) };
 			}
 
 			decompressed_data.insert(decompressed_data.end(), target_buffer_pointer,
@@ -11,9 +11,12 @@ namespace Utilities
 	class Compressor
 	{
 	public:
-		static auto compression(const std::vector<uint8_t>& original_data, const uint16_t& block_bytes = 1024)
+		// A non-empty dictionary primes the stream (only its last 64KB are used); decompression must pass the same bytes
+		static auto compression(const std::vector<uint8_t>& original_data, const uint32_t& block_bytes = 1024,
+								const std::vector<uint8_t>& dictionary = {})
 			-> std::tuple<std::optional<std::vector<uint8_t>>, std::optional<std::string>>;
-		static auto decompression(const std::vector<uint8_t>& compressed_data, const uint16_t& block_bytes = 1024)
+		static auto decompression(const std::vector<uint8_t>& compressed_data, const uint32_t& block_bytes = 1024,
+								  const std::vector<uint8_t>& dictionary = {})
 			-> std::tuple<std::optional<std::vector<uint8_t>>, std::optional<std::string>>;
 	};
 }
@@ -272,7 +272,7 @@ namespace Utilities
 		file_path_ = "";
 	}
 
-	auto File::compression(const std::string& path, const uint16_t& block_bytes) -> std::tuple<bool, std::optional<std::string>>
+	auto File::compression(const std::string& path, const uint32_t& block_bytes) -> std::tuple<bool, std::optional<std::string>>
 	{
 		File source;
 		auto [open_condition, open_message] = source.open(path, std::ios::in | std::ios::binary);
@@ -312,7 +312,7 @@ namespace Utilities
 		return { true, std::nullopt };
 	}
 
-	auto File::decompression(const std::string& path, const uint16_t& block_bytes) -> std::tuple<bool, std::optional<std::string>>
+	auto File::decompression(const std::string& path, const uint32_t& block_bytes) -> std::tuple<bool, std::optional<std::string>>
 	{
 		File source;
 		auto [open_condition, open_message] = source.open(path, std::ios::in | std::ios::binary);
@@ -36,8 +36,8 @@ namespace Utilities
 			-> std::tuple<std::optional<std::deque<std::string>>, std::optional<std::string>>;
 		void close(void);
 		
-		static auto compression(const std::string& path, const uint16_t& block_bytes = 1024) -> std::tuple<bool, std::optional<std::string>>;
-		static auto decompression(const std::string& path, const uint16_t& block_bytes = 1024) -> std::tuple<bool, std::optional<std::string>>;
+		static auto compression(const std::string& path, const uint32_t& block_bytes = 1024) -> std::tuple<bool, std::optional<std::string>>;
+		static auto decompression(const std::string& path, const uint32_t& block_bytes = 1024) -> std::tuple<bool, std::optional<std::string>>;
 
 	private:
 		std::fstream stream_;
@@ -0,0 +1,737 @@
+#include "IoEngine.h"
+
+#include <cerrno>
+#include <format>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef USE_IO_URING
+#include <atomic>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+namespace Utilities
+{
+#ifdef USE_IO_URING
+	// Submission and completion rings mapped straight from the kernel ABI, so no liburing is needed
+	struct IoEngine::Ring
+	{
+		int fd = -1;
+		uint32_t entries = 0;
+
+		void* sq_ring = nullptr;
+		size_t sq_ring_bytes = 0;
+		void* cq_ring = nullptr;
+		size_t cq_ring_bytes = 0;
+		io_uring_sqe* sqes = nullptr;
+		size_t sqes_bytes = 0;
+
+		uint32_t* sq_head = nullptr;
+		uint32_t* sq_tail = nullptr;
+		uint32_t sq_mask = 0;
+		uint32_t* sq_array = nullptr;
+		uint32_t* cq_head = nullptr;
+		uint32_t* cq_tail = nullptr;
+		uint32_t cq_mask = 0;
+		io_uring_cqe* cqes = nullptr;
+
+		// renameat and unlinkat arrived in Linux 5.11, after io_uring itself
+		bool finish_opcodes = false;
+
+		~Ring(void)
+		{
+			if (sqes != nullptr)
+			{
+				::munmap(sqes, sqes_bytes);
+			}
+			if (cq_ring != nullptr && cq_ring != sq_ring)
+			{
+				::munmap(cq_ring, cq_ring_bytes);
+			}
+			if (sq_ring != nullptr)
+			{
+				::munmap(sq_ring, sq_ring_bytes);
+			}
+			if (fd >= 0)
+			{
+				::close(fd);
+			}
+		}
+
+		auto setup(const uint32_t& requested) -> bool
+		{
+			io_uring_params params;
+			std::memset(&params, 0, sizeof(params));
+
+			fd = static_cast<int>(::syscall(__NR_io_uring_setup, requested, &params));
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+			cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (single_mmap)
+			{
+				sq_ring_bytes = cq_ring_bytes = std::max(sq_ring_bytes, cq_ring_bytes);
+			}
+
+			auto* mapped = ::mmap(nullptr, sq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+			if (mapped == MAP_FAILED)
+			{
+				return false;
+			}
+			sq_ring = mapped;
+
+			if (single_mmap)
+			{
+				cq_ring = sq_ring;
+			}
+			else
+			{
+				mapped = ::mmap(nullptr, cq_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+				if (mapped == MAP_FAILED)
+				{
+					return false;
+				}
+				cq_ring = mapped;
+			}
+
+			sqes_bytes = params.sq_entries * sizeof(io_uring_sqe);
+			mapped = ::mmap(nullptr, sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+			if (mapped == MAP_FAILED)
+			{
+				return false;
+			}
+			sqes = static_cast<io_uring_sqe*>(mapped);
+
+			auto* sq_base = static_cast<uint8_t*>(sq_ring);
+			sq_head = reinterpret_cast<uint32_t*>(sq_base + params.sq_off.head);
+			sq_tail = reinterpret_cast<uint32_t*>(sq_base + params.sq_off.tail);
+			sq_mask = *reinterpret_cast<uint32_t*>(sq_base + params.sq_off.ring_mask);
+			sq_array = reinterpret_cast<uint32_t*>(sq_base + params.sq_off.array);
+
+			auto* cq_base = static_cast<uint8_t*>(cq_ring);
+			cq_head = reinterpret_cast<uint32_t*>(cq_base + params.cq_off.head);
+			cq_tail = reinterpret_cast<uint32_t*>(cq_base + params.cq_off.tail);
+			cq_mask = *reinterpret_cast<uint32_t*>(cq_base + params.cq_off.ring_mask);
+			cqes = reinterpret_cast<io_uring_cqe*>(cq_base + params.cq_off.cqes);
+
+			entries = params.sq_entries;
+
+			std::vector<uint8_t> buffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+			auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+			if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0)
+			{
+				auto supported = [probe](const uint8_t& opcode) {
+					return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+				};
+				finish_opcodes = supported(IORING_OP_RENAMEAT) && supported(IORING_OP_UNLINKAT);
+			}
+
+			return true;
+		}
+	};
+
+	struct IoEngine::Context
+	{
+		const IoOperation* operation = nullptr;
+		std::string temp_path;
+		int fd = -1;
+		std::optional<std::string> error = std::nullopt;
+	};
+
+	// A single write covers at most this much; anything longer completes as a short write
+	static constexpr size_t max_write_bytes = size_t(1) << 30;
+
+	// Calls this small run on the caller's thread while no other call is in the engine
+	static constexpr size_t inline_operations = 4;
+
+	static auto prepare_sqe(void* entry, const uint8_t& opcode, const int& fd, const void* address, const uint32_t& length,
+							const uint64_t& offset) -> io_uring_sqe*
+	{
+		auto* sqe = static_cast<io_uring_sqe*>(entry);
+		std::memset(sqe, 0, sizeof(io_uring_sqe));
+		sqe->opcode = opcode;
+		sqe->fd = fd;
+		sqe->addr = reinterpret_cast<uint64_t>(address);
+		sqe->len = length;
+		sqe->off = offset;
+		return sqe;
+	}
+#endif
+
+	IoEngine::IoEngine(void)
+		: uring_enabled_(false)
+		, thread_stop_(false)
+		, submission_count_(0)
+		, operation_count_(0)
+		, callers_(0)
+		, thread_(nullptr)
+	{
+#ifdef USE_IO_URING
+		auto ring = std::make_unique<Ring>();
+		if (!ring->setup(256))
+		{
+			// kernels without io_uring, or with it disabled, keep the blocking path
+			return;
+		}
+
+		ring_ = std::move(ring);
+		uring_enabled_.store(true);
+		thread_ = std::make_unique<std::thread>(&IoEngine::run, this);
+#endif
+	}
+
+	IoEngine::~IoEngine(void) { stop(); }
+
+	auto IoEngine::atomic_write(const std::string& path, const std::string& content, const bool& sync)
+		-> std::tuple<bool, std::optional<std::string>>
+	{
+		return execute({ IoOperation{ IoOperationTypes::AtomicWrite, path, "", content, sync } }).front();
+	}
+
+	auto IoEngine::rename(const std::string& source_path, const std::string& target_path) -> std::tuple<bool, std::optional<std::string>>
+	{
+		return execute({ IoOperation{ IoOperationTypes::Rename, source_path, target_path, "", false } }).front();
+	}
+
+	auto IoEngine::unlink(const std::string& path) -> std::tuple<bool, std::optional<std::string>>
+	{
+		return execute({ IoOperation{ IoOperationTypes::Unlink, path, "", "", false } }).front();
+	}
+
+	auto IoEngine::sync_directory(const std::string& directory) -> std::tuple<bool, std::optional<std::string>>
+	{
+		int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0)
+		{
+			return { false, std::format("cannot open directory {}: {}", directory, std::strerror(errno)) };
+		}
+
+		auto result = ::fsync(fd);
+		auto error = errno;
+		::close(fd);
+
+		if (result != 0)
+		{
+			return { false, std::format("fsync of directory {} failed: {}", directory, std::strerror(error)) };
+		}
+
+		return { true, std::nullopt };
+	}
+
+	auto IoEngine::execute(const std::vector<IoOperation>& operations) -> std::vector<std::tuple<bool, std::optional<std::string>>>
+	{
+		operation_count_.fetch_add(operations.size());
+
+		bool counted = false;
+		if (uring_enabled_.load())
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			if (!thread_stop_.load())
+			{
+				// With nothing to batch against, the hand-off to the submitter and its phased submissions only add
+				// latency, so a small call made alone runs on this thread like the blocking path
+				counted = true;
+				if (callers_++ > 0 || operations.size() > inline_operations)
+				{
+					auto pending = std::make_shared<Pending>();
+					pending->operations = &operations;
+					pending_.push_back(pending);
+					condition_.notify_one();
+
+					completed_condition_.wait(lock, [&pending]() { return pending->completed; });
+					callers_--;
+
+					return pending->results;
+				}
+			}
+		}
+
+		std::vector<std::tuple<bool, std::optional<std::string>>> results;
+		results.reserve(operations.size());
+		for (const auto& operation : operations)
+		{
+			submission_count_.fetch_add(1);
+			results.push_back(execute_blocking(operation));
+		}
+
+		if (counted)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			callers_--;
+		}
+
+		return results;
+	}
+
+	auto IoEngine::uring_enabled(void) const -> bool { return uring_enabled_.load(); }
+
+	auto IoEngine::submission_count(void) const -> uint64_t { return submission_count_.load(); }
+
+	auto IoEngine::operation_count(void) const -> uint64_t { return operation_count_.load(); }
+
+	auto IoEngine::stop(void) -> void
+	{
+		if (thread_ == nullptr)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			thread_stop_.store(true);
+		}
+		condition_.notify_all();
+
+		if (thread_->joinable())
+		{
+			thread_->join();
+		}
+		thread_.reset();
+
+#ifdef USE_IO_URING
+		ring_.reset();
+#endif
+		uring_enabled_.store(false);
+	}
+
+	auto IoEngine::execute_blocking(const IoOperation& operation) -> std::tuple<bool, std::optional<std::string>>
+	{
+		switch (operation.type)
+		{
+		case IoOperationTypes::AtomicWrite:
+		{
+			auto temp_path = operation.path + ".tmp";
+
+			int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (fd < 0)
+			{
+				return { false, std::format("cannot create temp file: {}", temp_path) };
+			}
+
+			auto error = write_all(fd, operation.content, 0);
+			if (!error.has_value() && operation.sync && ::fsync(fd) != 0)
+			{
+				error = std::format("fsync failed: {}", std::strerror(errno));
+			}
+			::close(fd);
+
+			if (error.has_value())
+			{
+				::unlink(temp_path.c_str());
+				return { false, error };
+			}
+
+			if (::rename(temp_path.c_str(), operation.path.c_str()) != 0)
+			{
+				auto message = std::format("rename failed: {}", std::strerror(errno));
+				::unlink(temp_path.c_str());
+				return { false, message };
+			}
+
+			return { true, std::nullopt };
+		}
+		case IoOperationTypes::Rename:
+			if (::rename(operation.path.c_str(), operation.target_path.c_str()) != 0)
+			{
+				return { false, std::format("move failed: {}", std::strerror(errno)) };
+			}
+			return { true, std::nullopt };
+		case IoOperationTypes::Unlink:
+			if (::unlink(operation.path.c_str()) != 0 && errno != ENOENT)
+			{
+				return { false, std::format("delete failed: {}", std::strerror(errno)) };
+			}
+			return { true, std::nullopt };
+		}
+
+		return { false, "unknown io operation" };
+	}
+
+	auto IoEngine::write_all(const int& fd, const std::string& content, const size_t& offset) -> std::optional<std::string>
+	{
+		size_t written = offset;
+		while (written < content.size())
+		{
+			auto result = ::pwrite(fd, content.data() + written, content.size() - written, static_cast<off_t>(written));
+			if (result < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				return std::format("write failed: {}", std::strerror(errno));
+			}
+
+			written += static_cast<size_t>(result);
+		}
+
+		return std::nullopt;
+	}
+
+#ifdef USE_IO_URING
+	auto IoEngine::run(void) -> void
+	{
+		while (true)
+		{
+			std::vector<std::shared_ptr<Pending>> batch;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				condition_.wait(lock, [this]() { return thread_stop_.load() || !pending_.empty(); });
+
+				if (pending_.empty() && thread_stop_.load())
+				{
+					break;
+				}
+
+				batch.swap(pending_);
+			}
+
+			execute_uring(batch);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				for (auto& pending : batch)
+				{
+					pending->completed = true;
+				}
+			}
+			completed_condition_.notify_all();
+		}
+	}
+
+	auto IoEngine::execute_uring(std::vector<std::shared_ptr<Pending>>& batch) -> void
+	{
+		std::vector<Context> contexts;
+		for (auto& pending : batch)
+		{
+			for (const auto& operation : *pending->operations)
+			{
+				Context context;
+				context.operation = &operation;
+				if (operation.type == IoOperationTypes::AtomicWrite)
+				{
+					context.temp_path = operation.path + ".tmp";
+				}
+				contexts.push_back(std::move(context));
+			}
+		}
+
+		auto collect = [&contexts](const std::function<bool(Context&)>& filter) {
+			std::vector<Context*> selected;
+			for (auto& context : contexts)
+			{
+				if (!context.error.has_value() && filter(context))
+				{
+					selected.push_back(&context);
+				}
+			}
+			return selected;
+		};
+
+		// openat for every atomic write
+		auto opening = collect([](Context& context) { return context.operation->type == IoOperationTypes::AtomicWrite; });
+		std::vector<std::function<void(void*)>> prepares;
+		for (auto* context : opening)
+		{
+			prepares.push_back([context](void* entry) {
+				auto* sqe = prepare_sqe(entry, IORING_OP_OPENAT, AT_FDCWD, context->temp_path.c_str(), 0644, 0);
+				sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+			});
+		}
+		auto results = submit_phase(prepares);
+		for (size_t index = 0; index < opening.size(); ++index)
+		{
+			if (results[index] < 0)
+			{
+				opening[index]->error = std::format("cannot create temp file: {}", opening[index]->temp_path);
+				continue;
+			}
+			opening[index]->fd = results[index];
+		}
+
+		// write, linked to its fsync when one is requested; a short write breaks the link and is finished synchronously
+		struct Step
+		{
+			Context* context;
+			bool sync;
+		};
+		std::vector<Step> steps;
+		prepares.clear();
+		for (auto* context : collect([](Context& context) { return context.fd >= 0; }))
+		{
+			auto length = static_cast<uint32_t>(std::min<size_t>(context->operation->content.size(), max_write_bytes));
+			prepares.push_back([context, length](void* entry) {
+				auto* sqe = prepare_sqe(entry, IORING_OP_WRITE, context->fd, context->operation->content.data(), length, 0);
+				if (context->operation->sync)
+				{
+					sqe->flags |= IOSQE_IO_LINK;
+				}
+			});
+			steps.push_back({ context, false });
+
+			if (context->operation->sync)
+			{
+				prepares.push_back([context](void* entry) { prepare_sqe(entry, IORING_OP_FSYNC, context->fd, nullptr, 0, 0); });
+				steps.push_back({ context, true });
+			}
+		}
+		results = submit_phase(prepares);
+		bool short_write = false;
+		for (size_t index = 0; index < steps.size(); ++index)
+		{
+			auto* context = steps[index].context;
+			auto result = results[index];
+			if (context->error.has_value())
+			{
+				continue;
+			}
+
+			if (!steps[index].sync)
+			{
+				short_write = false;
+				if (result < 0)
+				{
+					context->error = std::format("write failed: {}", std::strerror(-result));
+				}
+				else if (static_cast<size_t>(result) < context->operation->content.size())
+				{
+					short_write = true;
+					context->error = write_all(context->fd, context->operation->content, static_cast<size_t>(result));
+				}
+				continue;
+			}
+
+			if (result == -ECANCELED && short_write)
+			{
+				if (::fsync(context->fd) != 0)
+				{
+					context->error = std::format("fsync failed: {}", std::strerror(errno));
+				}
+				continue;
+			}
+			if (result < 0)
+			{
+				context->error = std::format("fsync failed: {}", std::strerror(-result));
+			}
+		}
+
+		for (auto& context : contexts)
+		{
+			if (context.fd >= 0)
+			{
+				::close(context.fd);
+				context.fd = -1;
+			}
+
+			if (context.error.has_value() && !context.temp_path.empty())
+			{
+				::unlink(context.temp_path.c_str());
+			}
+		}
+
+		// Without the opcodes the renames and unlinks run here one by one, still in each caller's order
+		if (!ring_->finish_opcodes)
+		{
+			for (auto& context : contexts)
+			{
+				if (context.error.has_value())
+				{
+					continue;
+				}
+
+				if (context.operation->type != IoOperationTypes::AtomicWrite)
+				{
+					context.error = std::get<1>(execute_blocking(*context.operation));
+					continue;
+				}
+
+				if (::rename(context.temp_path.c_str(), context.operation->path.c_str()) != 0)
+				{
+					context.error = std::format("rename failed: {}", std::strerror(errno));
+					::unlink(context.temp_path.c_str());
+				}
+			}
+
+			collect_results(batch, contexts);
+			return;
+		}
+
+		// renameat and unlinkat share the final submission; each caller's operations form one hard-linked chain, so they
+		// run in the order the caller gave them while a failure does not cancel the rest
+		std::vector<Context*> finishing;
+		prepares.clear();
+		size_t first = 0;
+		for (auto& pending : batch)
+		{
+			bool chained = false;
+			for (size_t index = first; index < first + pending->operations->size(); ++index)
+			{
+				auto* context = &contexts[index];
+				if (context->error.has_value())
+				{
+					continue;
+				}
+
+				if (chained)
+				{
+					prepares.back() = [prepare = prepares.back()](void* entry) {
+						prepare(entry);
+						static_cast<io_uring_sqe*>(entry)->flags |= IOSQE_IO_HARDLINK;
+					};
+				}
+
+				prepares.push_back([context](void* entry) {
+					switch (context->operation->type)
+					{
+					case IoOperationTypes::AtomicWrite:
+						prepare_sqe(entry, IORING_OP_RENAMEAT, AT_FDCWD, context->temp_path.c_str(), static_cast<uint32_t>(AT_FDCWD),
+									reinterpret_cast<uint64_t>(context->operation->path.c_str()));
+						break;
+					case IoOperationTypes::Rename:
+						prepare_sqe(entry, IORING_OP_RENAMEAT, AT_FDCWD, context->operation->path.c_str(), static_cast<uint32_t>(AT_FDCWD),
+									reinterpret_cast<uint64_t>(context->operation->target_path.c_str()));
+						break;
+					case IoOperationTypes::Unlink:
+						prepare_sqe(entry, IORING_OP_UNLINKAT, AT_FDCWD, context->operation->path.c_str(), 0, 0);
+						break;
+					}
+				});
+				finishing.push_back(context);
+				chained = true;
+			}
+			first += pending->operations->size();
+		}
+		results = submit_phase(prepares);
+		for (size_t index = 0; index < finishing.size(); ++index)
+		{
+			auto* context = finishing[index];
+			auto result = results[index];
+
+			if (result >= 0 || (result == -ENOENT && context->operation->type == IoOperationTypes::Unlink))
+			{
+				continue;
+			}
+
+			switch (context->operation->type)
+			{
+			case IoOperationTypes::AtomicWrite:
+				context->error = std::format("rename failed: {}", std::strerror(-result));
+				::unlink(context->temp_path.c_str());
+				break;
+			case IoOperationTypes::Rename:
+				context->error = std::format("move failed: {}", std::strerror(-result));
+				break;
+			case IoOperationTypes::Unlink:
+				context->error = std::format("delete failed: {}", std::strerror(-result));
+				break;
+			}
+		}
+
+		collect_results(batch, contexts);
+	}
+
+	auto IoEngine::collect_results(std::vector<std::shared_ptr<Pending>>& batch, const std::vector<Context>& contexts) -> void
+	{
+		size_t offset = 0;
+		for (auto& pending : batch)
+		{
+			pending->results.clear();
+			for (size_t index = 0; index < pending->operations->size(); ++index)
+			{
+				const auto& context = contexts[offset++];
+				pending->results.push_back({ !context.error.has_value(), context.error });
+			}
+		}
+	}
+
+	auto IoEngine::submit_phase(const std::vector<std::function<void(void*)>>& prepares) -> std::vector<int>
+	{
+		std::vector<int> results(prepares.size(), -ECANCELED);
+
+		size_t index = 0;
+		while (index < prepares.size())
+		{
+			auto prepared = static_cast<uint32_t>(std::min<size_t>(prepares.size() - index, ring_->entries));
+
+			// This thread is the only producer, so the tail needs no load-acquire
+			auto tail = *ring_->sq_tail;
+			for (uint32_t offset = 0; offset < prepared; ++offset)
+			{
+				auto slot = (tail + offset) & ring_->sq_mask;
+				auto* sqe = &ring_->sqes[slot];
+				prepares[index + offset](sqe);
+				sqe->user_data = index + offset;
+				if (offset + 1 == prepared)
+				{
+					// a chain never spans two submissions; the next one starts after this one completes anyway
+					sqe->flags &= static_cast<uint8_t>(~(IOSQE_IO_LINK | IOSQE_IO_HARDLINK));
+				}
+				ring_->sq_array[slot] = slot;
+			}
+			std::atomic_ref<uint32_t>(*ring_->sq_tail).store(tail + prepared, std::memory_order_release);
+			submission_count_.fetch_add(1);
+
+			uint32_t reaped = 0;
+			while (reaped < prepared)
+			{
+				auto unsubmitted = tail + prepared - std::atomic_ref<uint32_t>(*ring_->sq_head).load(std::memory_order_acquire);
+				auto entered = ::syscall(__NR_io_uring_enter, ring_->fd, unsubmitted, prepared - reaped, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if (entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				{
+					auto error = -errno;
+					for (auto& result : results)
+					{
+						if (result == -ECANCELED)
+						{
+							result = error;
+						}
+					}
+					return results;
+				}
+
+				auto head = *ring_->cq_head;
+				auto available = std::atomic_ref<uint32_t>(*ring_->cq_tail).load(std::memory_order_acquire);
+				while (head != available)
+				{
+					const auto& cqe = ring_->cqes[head & ring_->cq_mask];
+					if (cqe.user_data < results.size())
+					{
+						results[cqe.user_data] = cqe.res;
+					}
+					++head;
+					++reaped;
+				}
+				std::atomic_ref<uint32_t>(*ring_->cq_head).store(head, std::memory_order_release);
+			}
+
+			index += prepared;
+		}
+
+		return results;
+	}
+#endif
+
+#pragma region Handle
+	std::unique_ptr<IoEngine> IoEngine::handle_;
+	std::once_flag IoEngine::once_;
+
+	auto IoEngine::handle(void) -> IoEngine&
+	{
+		std::call_once(once_, []() { handle_.reset(new IoEngine()); });
+
+		return *handle_.get();
+	}
+
+	auto IoEngine::destroy(void) -> void { handle_.reset(); }
+#pragma endregion
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <tuple>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <condition_variable>
+
+namespace Utilities
+{
+	enum class IoOperationTypes : uint8_t
+	{
+		AtomicWrite = 0,
+		Rename = 1,
+		Unlink = 2,
+	};
+
+	struct IoOperation
+	{
+		IoOperationTypes type = IoOperationTypes::AtomicWrite;
+		std::string path;
+		std::string target_path;
+		std::string content;
+		bool sync = false;
+	};
+
+	class IoEngine
+	{
+	private:
+		IoEngine(void);
+
+	public:
+		~IoEngine(void);
+
+		auto atomic_write(const std::string& path, const std::string& content, const bool& sync = false)
+			-> std::tuple<bool, std::optional<std::string>>;
+		auto rename(const std::string& source_path, const std::string& target_path) -> std::tuple<bool, std::optional<std::string>>;
+		auto unlink(const std::string& path) -> std::tuple<bool, std::optional<std::string>>;
+		// Renames, including the one that finishes an atomic write, are not durable until the directory is synced
+		auto sync_directory(const std::string& directory) -> std::tuple<bool, std::optional<std::string>>;
+
+		auto execute(const std::vector<IoOperation>& operations) -> std::vector<std::tuple<bool, std::optional<std::string>>>;
+
+		auto uring_enabled(void) const -> bool;
+		auto submission_count(void) const -> uint64_t;
+		auto operation_count(void) const -> uint64_t;
+
+		auto stop(void) -> void;
+
+	private:
+		struct Pending
+		{
+			const std::vector<IoOperation>* operations = nullptr;
+			std::vector<std::tuple<bool, std::optional<std::string>>> results;
+			bool completed = false;
+		};
+
+		auto execute_blocking(const IoOperation& operation) -> std::tuple<bool, std::optional<std::string>>;
+		auto write_all(const int& fd, const std::string& content, const size_t& offset) -> std::optional<std::string>;
+
+#ifdef USE_IO_URING
+		struct Ring;
+		struct Context;
+
+		auto run(void) -> void;
+		auto execute_uring(std::vector<std::shared_ptr<Pending>>& batch) -> void;
+		auto collect_results(std::vector<std::shared_ptr<Pending>>& batch, const std::vector<Context>& contexts) -> void;
+		auto submit_phase(const std::vector<std::function<void(void*)>>& prepares) -> std::vector<int>;
+#endif
+
+	private:
+		std::atomic<bool> uring_enabled_;
+		std::atomic<bool> thread_stop_;
+		std::atomic<uint64_t> submission_count_;
+		std::atomic<uint64_t> operation_count_;
+
+		std::mutex mutex_;
+		std::condition_variable condition_;
+		std::condition_variable completed_condition_;
+		// Calls inside execute() on the io_uring path, queued or running inline
+		size_t callers_;
+		std::unique_ptr<std::thread> thread_;
+		std::vector<std::shared_ptr<Pending>> pending_;
+
+#ifdef USE_IO_URING
+		std::unique_ptr<Ring> ring_;
+#endif
+
+#pragma region Handle
+	public:
+		static auto handle(void) -> IoEngine&;
+		static auto destroy(void) -> void;
+
+	private:
+		static std::unique_ptr<IoEngine> handle_;
+		static std::once_flag once_;
+#pragma endregion
+	};
+}
@@ -0,0 +1,154 @@
+#include "LatencyHistogram.h"
+
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+namespace Utilities
+{
+	LatencyHistogram::LatencyHistogram(void)
+		: sum_(0)
+		, max_(0)
+	{
+		for (auto& bucket : buckets_)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	auto LatencyHistogram::record(const uint64_t& value_us) -> void
+	{
+		buckets_[bucket_of(value_us)].fetch_add(1, std::memory_order_relaxed);
+		sum_.fetch_add(value_us, std::memory_order_relaxed);
+
+		auto current = max_.load(std::memory_order_relaxed);
+		while (value_us > current && !max_.compare_exchange_weak(current, value_us, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	auto LatencyHistogram::record_since(const std::chrono::steady_clock::time_point& started) -> void
+	{
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+		record(static_cast<uint64_t>(std::max<int64_t>(elapsed, 0)));
+	}
+
+	auto LatencyHistogram::reset(void) -> void
+	{
+		// Records racing a reset may survive it in part; a histogram is a sample, not a ledger
+		for (auto& bucket : buckets_)
+		{
+			bucket.store(0, std::memory_order_relaxed);
+		}
+		sum_.store(0, std::memory_order_relaxed);
+		max_.store(0, std::memory_order_relaxed);
+	}
+
+	auto LatencyHistogram::count(void) const -> uint64_t
+	{
+		uint64_t total = 0;
+		for (const auto& bucket : buckets_)
+		{
+			total += bucket.load(std::memory_order_relaxed);
+		}
+		return total;
+	}
+
+	auto LatencyHistogram::percentile(const double& quantile) const -> uint64_t
+	{
+		std::array<uint64_t, bucket_count> counts;
+		uint64_t total = 0;
+		for (size_t index = 0; index < bucket_count; ++index)
+		{
+			counts[index] = buckets_[index].load(std::memory_order_relaxed);
+			total += counts[index];
+		}
+		if (total == 0)
+		{
+			return 0;
+		}
+
+		auto rank = static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(total)));
+		rank = std::max<uint64_t>(rank, 1);
+
+		uint64_t seen = 0;
+		for (size_t index = 0; index < bucket_count; ++index)
+		{
+			seen += counts[index];
+			if (seen >= rank)
+			{
+				return std::min(highest_of(index), max_.load(std::memory_order_relaxed));
+			}
+		}
+
+		return max_.load(std::memory_order_relaxed);
+	}
+
+	auto LatencyHistogram::snapshot(void) const -> Snapshot
+	{
+		// One pass over the buckets serves every quantile, so they agree with each other even while writers record
+		std::array<uint64_t, bucket_count> counts;
+		Snapshot result;
+		for (size_t index = 0; index < bucket_count; ++index)
+		{
+			counts[index] = buckets_[index].load(std::memory_order_relaxed);
+			result.count += counts[index];
+		}
+		result.sum_us = sum_.load(std::memory_order_relaxed);
+		result.max_us = max_.load(std::memory_order_relaxed);
+		if (result.count == 0)
+		{
+			return result;
+		}
+
+		const std::array<std::pair<double, uint64_t*>, 4> targets = { {
+			{ 0.5, &result.p50_us }, { 0.9, &result.p90_us }, { 0.99, &result.p99_us }, { 0.999, &result.p999_us }
+		} };
+
+		size_t target = 0;
+		uint64_t seen = 0;
+		for (size_t index = 0; index < bucket_count && target < targets.size(); ++index)
+		{
+			seen += counts[index];
+			while (target < targets.size()
+				   && seen >= std::max<uint64_t>(static_cast<uint64_t>(std::ceil(targets[target].first * static_cast<double>(result.count))), 1))
+			{
+				*targets[target].second = std::min(highest_of(index), result.max_us);
+				++target;
+			}
+		}
+
+		return result;
+	}
+
+	auto LatencyHistogram::bucket_of(const uint64_t& value_us) -> size_t
+	{
+		if (value_us < sub_bucket_count)
+		{
+			return static_cast<size_t>(value_us);
+		}
+
+		// Magnitude m >= 1 covers [32 << (m - 1), 64 << (m - 1)) in 32 steps of 1 << (m - 1)
+		auto magnitude = static_cast<size_t>(std::bit_width(value_us)) - sub_bucket_bits;
+		if (magnitude > tracked_bits - sub_bucket_bits)
+		{
+			return bucket_count - 1;
+		}
+
+		auto sub_bucket = static_cast<size_t>(value_us >> (magnitude - 1)) - sub_bucket_count;
+		return magnitude * sub_bucket_count + sub_bucket;
+	}
+
+	auto LatencyHistogram::highest_of(const size_t& bucket) -> uint64_t
+	{
+		auto magnitude = bucket / sub_bucket_count;
+		auto sub_bucket = bucket % sub_bucket_count;
+		if (magnitude == 0)
+		{
+			return sub_bucket;
+		}
+
+		auto width = uint64_t(1) << (magnitude - 1);
+		return (static_cast<uint64_t>(sub_bucket + sub_bucket_count) << (magnitude - 1)) + width - 1;
+	}
+}
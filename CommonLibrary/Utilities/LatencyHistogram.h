@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Utilities
+{
+	// Log-linear latency histogram in microseconds, in the style of HdrHistogram: each power of two is split into
+	// 32 linear sub-buckets, so a reported percentile is within about 3% of the recorded value. Values from 0 us up
+	// to about 12 days are tracked; larger ones land in the last bucket. record() is a few relaxed atomic adds and
+	// never blocks, and reads walk the buckets while writers keep recording.
+	class LatencyHistogram
+	{
+	public:
+		struct Snapshot
+		{
+			uint64_t count = 0;
+			uint64_t sum_us = 0;
+			uint64_t max_us = 0;
+			uint64_t p50_us = 0;
+			uint64_t p90_us = 0;
+			uint64_t p99_us = 0;
+			uint64_t p999_us = 0;
+
+			auto mean_us(void) const -> double { return count > 0 ? static_cast<double>(sum_us) / static_cast<double>(count) : 0.0; }
+		};
+
+		LatencyHistogram(void);
+
+		LatencyHistogram(const LatencyHistogram&) = delete;
+		LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+		auto record(const uint64_t& value_us) -> void;
+		auto record_since(const std::chrono::steady_clock::time_point& started) -> void;
+		auto reset(void) -> void;
+
+		auto count(void) const -> uint64_t;
+		// Highest value of the bucket holding the given quantile (0.0 - 1.0), capped at the largest value recorded
+		auto percentile(const double& quantile) const -> uint64_t;
+		auto snapshot(void) const -> Snapshot;
+
+		static auto bucket_of(const uint64_t& value_us) -> size_t;
+		static auto highest_of(const size_t& bucket) -> uint64_t;
+
+	private:
+		static constexpr size_t sub_bucket_bits = 5;
+		static constexpr size_t sub_bucket_count = size_t(1) << sub_bucket_bits;
+		static constexpr size_t tracked_bits = 40;
+		static constexpr size_t bucket_count = (tracked_bits - sub_bucket_bits + 1) * sub_bucket_count;
+
+		std::array<std::atomic<uint64_t>, bucket_count> buckets_;
+		std::atomic<uint64_t> sum_;
+		std::atomic<uint64_t> max_;
+	};
+
+	// Records the time from construction to destruction
+	class ScopedLatency
+	{
+	public:
+		ScopedLatency(LatencyHistogram& histogram) : histogram_(histogram), started_(std::chrono::steady_clock::now()) {}
+		~ScopedLatency(void) { histogram_.record_since(started_); }
+
+		ScopedLatency(const ScopedLatency&) = delete;
+		ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+	private:
+		LatencyHistogram& histogram_;
+		std::chrono::steady_clock::time_point started_;
+	};
+}
@@ -0,0 +1,206 @@
+#include "MailboxClient.h"
+
+#include "Generator.h"
+
+#include <chrono>
+#include <format>
+#include <thread>
+#include <fstream>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace Utilities
+{
+	namespace
+	{
+		// Even with a watch, re-check the file now and then in case an event was dropped (IN_Q_OVERFLOW)
+		constexpr int32_t watch_recheck_ms = 250;
+
+		auto current_time_ms(void) -> int64_t
+		{
+			return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		}
+	}
+
+	MailboxClient::MailboxClient(const std::string& root, const std::string& requests_dir, const std::string& responses_dir,
+								 const std::string& client_id, const int32_t& fallback_poll_ms)
+		: client_id_(client_id)
+		, fallback_poll_ms_(fallback_poll_ms)
+		, notify_fd_(-1)
+		, watch_fd_(-1)
+	{
+		std::filesystem::path requests_path = root;
+		requests_path /= requests_dir;
+		requests_path_ = requests_path.string();
+
+		std::filesystem::path responses_path = root;
+		responses_path /= responses_dir;
+		responses_path /= client_id;
+		responses_path_ = responses_path.string();
+
+		std::error_code ec;
+		std::filesystem::create_directories(requests_path_, ec);
+		std::filesystem::create_directories(responses_path_, ec);
+
+#if defined(__linux__)
+		notify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (notify_fd_ >= 0)
+		{
+			watch_fd_ = inotify_add_watch(notify_fd_, responses_path_.c_str(), IN_MOVED_TO | IN_CLOSE_WRITE);
+			if (watch_fd_ < 0)
+			{
+				close(notify_fd_);
+				notify_fd_ = -1;
+			}
+		}
+#endif
+	}
+
+	MailboxClient::~MailboxClient(void)
+	{
+#if defined(__linux__)
+		if (notify_fd_ >= 0)
+		{
+			close(notify_fd_);
+		}
+#endif
+	}
+
+	auto MailboxClient::send_request(const std::string& command, const nlohmann::json& payload, const int32_t& timeout_ms)
+		-> std::tuple<bool, nlohmann::json>
+	{
+		nlohmann::json request;
+		request["command"] = command;
+		request["payload"] = payload;
+
+		return exchange(std::move(request), timeout_ms);
+	}
+
+	auto MailboxClient::send_batch(const nlohmann::json& commands, const int32_t& timeout_ms) -> std::tuple<bool, nlohmann::json>
+	{
+		nlohmann::json request;
+		request["command"] = "batch";
+		request["commands"] = commands;
+
+		return exchange(std::move(request), timeout_ms);
+	}
+
+	auto MailboxClient::exchange(nlohmann::json request, const int32_t& timeout_ms) -> std::tuple<bool, nlohmann::json>
+	{
+		auto request_id = Generator::guid();
+		auto now = current_time_ms();
+		auto deadline = now + timeout_ms;
+
+		request["requestId"] = request_id;
+		request["clientId"] = client_id_;
+		request["timestampMs"] = now;
+		request["deadlineMs"] = deadline;
+
+		// The watch is already armed, so a response that lands right after the request cannot be missed
+		auto request_file = (std::filesystem::path(requests_path_) / std::format("{}.json", request_id)).string();
+		if (!write_request(request_file, request.dump(2)))
+		{
+			return { false, { { "error", "failed to write request" } } };
+		}
+
+		auto response_file = (std::filesystem::path(responses_path_) / std::format("{}.json", request_id)).string();
+		while (true)
+		{
+			std::error_code ec;
+			if (std::filesystem::exists(response_file, ec))
+			{
+				return read_response(response_file);
+			}
+
+			auto remaining = deadline - current_time_ms();
+			if (remaining <= 0)
+			{
+				break;
+			}
+
+			wait_for_change(static_cast<int32_t>(remaining));
+		}
+
+		return { false, { { "error", "timeout waiting for response" } } };
+	}
+
+	auto MailboxClient::watching(void) const -> bool
+	{
+		return watch_fd_ >= 0;
+	}
+
+	auto MailboxClient::write_request(const std::string& request_file, const std::string& content) -> bool
+	{
+		auto temp_path = request_file + ".tmp";
+
+		std::ofstream file(temp_path, std::ios::out | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+
+		file << content;
+		file.flush();
+		file.close();
+
+		std::error_code ec;
+		std::filesystem::rename(temp_path, request_file, ec);
+		if (ec)
+		{
+			std::filesystem::remove(temp_path, ec);
+			return false;
+		}
+
+		return true;
+	}
+
+	auto MailboxClient::read_response(const std::string& response_file) -> std::tuple<bool, nlohmann::json>
+	{
+		std::ifstream file(response_file);
+		if (!file.is_open())
+		{
+			return { false, { { "error", "failed to open response" } } };
+		}
+
+		std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		file.close();
+
+		std::error_code ec;
+		std::filesystem::remove(response_file, ec);
+
+		try
+		{
+			return { true, nlohmann::json::parse(content) };
+		}
+		catch (const nlohmann::json::exception& e)
+		{
+			return { false, { { "error", std::format("response parse error: {}", e.what()) } } };
+		}
+	}
+
+	auto MailboxClient::wait_for_change(const int32_t& timeout_ms) -> void
+	{
+#if defined(__linux__)
+		if (notify_fd_ >= 0)
+		{
+			pollfd descriptor{ notify_fd_, POLLIN, 0 };
+			if (poll(&descriptor, 1, std::min(timeout_ms, watch_recheck_ms)) > 0)
+			{
+				// Any event means "look again"; the caller checks for its own file
+				alignas(inotify_event) char buffer[4096];
+				while (read(notify_fd_, buffer, sizeof(buffer)) > 0)
+				{
+				}
+			}
+			return;
+		}
+#endif
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeout_ms, fallback_poll_ms_)));
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <tuple>
+#include <string>
+#include <cstdint>
+
+namespace Utilities
+{
+	// Client side of the file mailbox: drops a request file and waits for the matching response.
+	// The client's response directory is watched with inotify (IN_MOVED_TO/IN_CLOSE_WRITE) for the lifetime
+	// of the object, so a response is picked up as soon as the daemon publishes it; where inotify is not
+	// available the wait falls back to polling.
+	class MailboxClient
+	{
+	public:
+		MailboxClient(const std::string& root, const std::string& requests_dir, const std::string& responses_dir, const std::string& client_id,
+					  const int32_t& fallback_poll_ms = 50);
+		~MailboxClient(void);
+
+		MailboxClient(const MailboxClient&) = delete;
+		MailboxClient& operator=(const MailboxClient&) = delete;
+
+		auto send_request(const std::string& command, const nlohmann::json& payload, const int32_t& timeout_ms) -> std::tuple<bool, nlohmann::json>;
+		// commands: [{ "command": ..., "payload": {...} }, ...]; the response carries one entry per command in "results"
+		auto send_batch(const nlohmann::json& commands, const int32_t& timeout_ms) -> std::tuple<bool, nlohmann::json>;
+
+		auto watching(void) const -> bool;
+
+	private:
+		auto exchange(nlohmann::json request, const int32_t& timeout_ms) -> std::tuple<bool, nlohmann::json>;
+		auto write_request(const std::string& request_file, const std::string& content) -> bool;
+		auto read_response(const std::string& response_file) -> std::tuple<bool, nlohmann::json>;
+		auto wait_for_change(const int32_t& timeout_ms) -> void;
+
+	private:
+		std::string requests_path_;
+		std::string responses_path_;
+		std::string client_id_;
+		int32_t fallback_poll_ms_;
+
+		int notify_fd_;
+		int watch_fd_;
+	};
+}
@@ -0,0 +1,245 @@
+#include "RequestWatcher.h"
+
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace Utilities
+{
+	RequestWatcher::RequestWatcher(const std::string& directory, const std::string& suffix, const size_t& ring_capacity)
+		: directory_(directory)
+		, suffix_(suffix)
+		, ring_(std::max(ring_capacity, size_t(1)))
+		, head_(0)
+		, count_(0)
+		, overflowed_(false)
+		, rescans_(0)
+		, notify_fd_(-1)
+		, wake_fd_(-1)
+	{
+	}
+
+	RequestWatcher::~RequestWatcher(void)
+	{
+		stop();
+	}
+
+	auto RequestWatcher::start(void) -> std::tuple<bool, std::optional<std::string>>
+	{
+#if defined(__linux__)
+		if (notify_fd_ >= 0)
+		{
+			return { false, "already started" };
+		}
+
+		notify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (notify_fd_ < 0)
+		{
+			return { false, std::string("inotify_init1 failed: ") + std::strerror(errno) };
+		}
+
+		if (inotify_add_watch(notify_fd_, directory_.c_str(), IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR) < 0)
+		{
+			auto error = std::string("inotify_add_watch failed for ") + directory_ + ": " + std::strerror(errno);
+			stop();
+			return { false, error };
+		}
+
+		wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (wake_fd_ < 0)
+		{
+			auto error = std::string("eventfd failed: ") + std::strerror(errno);
+			stop();
+			return { false, error };
+		}
+
+		// Files already in the directory (or dropped before the watch was armed) come from the first wait()'s scan
+		overflowed_ = true;
+
+		return { true, std::nullopt };
+#else
+		return { false, "inotify is not available on this platform" };
+#endif
+	}
+
+	auto RequestWatcher::stop(void) -> void
+	{
+#if defined(__linux__)
+		if (notify_fd_ >= 0)
+		{
+			close(notify_fd_);
+			notify_fd_ = -1;
+		}
+		if (wake_fd_ >= 0)
+		{
+			close(wake_fd_);
+			wake_fd_ = -1;
+		}
+#endif
+		head_ = 0;
+		count_ = 0;
+	}
+
+	auto RequestWatcher::wait(std::vector<std::string>& paths, const int32_t& timeout_ms) -> size_t
+	{
+#if defined(__linux__)
+		if (notify_fd_ < 0)
+		{
+			return 0;
+		}
+
+		if (count_ == 0 && !overflowed_)
+		{
+			pollfd descriptors[2] = { { notify_fd_, POLLIN, 0 }, { wake_fd_, POLLIN, 0 } };
+			poll(descriptors, 2, timeout_ms);
+
+			if (descriptors[1].revents & POLLIN)
+			{
+				uint64_t value = 0;
+				[[maybe_unused]] auto consumed = read(wake_fd_, &value, sizeof(value));
+			}
+		}
+
+		read_events();
+#endif
+
+		if (overflowed_)
+		{
+			return rescan(paths);
+		}
+
+		return drain(paths);
+	}
+
+	auto RequestWatcher::wake(void) -> void
+	{
+#if defined(__linux__)
+		if (wake_fd_ >= 0)
+		{
+			uint64_t value = 1;
+			[[maybe_unused]] auto written = write(wake_fd_, &value, sizeof(value));
+		}
+#endif
+	}
+
+	auto RequestWatcher::read_events(void) -> void
+	{
+#if defined(__linux__)
+		alignas(inotify_event) char buffer[64 * 1024];
+
+		while (true)
+		{
+			auto length = read(notify_fd_, buffer, sizeof(buffer));
+			if (length <= 0)
+			{
+				break;
+			}
+
+			for (ssize_t offset = 0; offset < length;)
+			{
+				auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					overflowed_ = true;
+					continue;
+				}
+
+				if ((event->mask & IN_ISDIR) || event->len == 0 || overflowed_)
+				{
+					continue;
+				}
+
+				if (!matches(event->name, event->len))
+				{
+					continue;
+				}
+
+				std::string path;
+				path.reserve(directory_.size() + 1 + event->len);
+				path.append(directory_);
+				path.push_back('/');
+				path.append(event->name);
+				push(std::move(path));
+			}
+		}
+#endif
+	}
+
+	auto RequestWatcher::push(std::string path) -> void
+	{
+		// A full ring would drop paths silently; a rescan picks all of them up instead
+		if (count_ == ring_.size())
+		{
+			overflowed_ = true;
+			return;
+		}
+
+		ring_[(head_ + count_) % ring_.size()] = std::move(path);
+		count_++;
+	}
+
+	auto RequestWatcher::drain(std::vector<std::string>& paths) -> size_t
+	{
+		auto drained = count_;
+		paths.reserve(paths.size() + drained);
+
+		for (; count_ > 0; --count_)
+		{
+			paths.push_back(std::move(ring_[head_]));
+			head_ = (head_ + 1) % ring_.size();
+		}
+		head_ = 0;
+
+		return drained;
+	}
+
+	auto RequestWatcher::rescan(std::vector<std::string>& paths) -> size_t
+	{
+		overflowed_ = false;
+		head_ = 0;
+		count_ = 0;
+		rescans_++;
+
+		std::vector<std::string> found;
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(directory_, ec))
+		{
+			std::error_code entry_ec;
+			if (!entry.is_regular_file(entry_ec))
+			{
+				continue;
+			}
+
+			auto name = entry.path().filename().string();
+			if (matches(name.c_str(), name.size()))
+			{
+				found.push_back(entry.path().string());
+			}
+		}
+
+		// Request ids carry no order, but a stable one keeps a rescan deterministic
+		std::sort(found.begin(), found.end());
+
+		paths.reserve(paths.size() + found.size());
+		std::move(found.begin(), found.end(), std::back_inserter(paths));
+
+		return found.size();
+	}
+
+	auto RequestWatcher::matches(const char* name, const size_t& length) const -> bool
+	{
+		// inotify pads names with NULs up to the event length
+		std::string_view view(name, strnlen(name, length));
+		return view.size() > suffix_.size() && view.substr(view.size() - suffix_.size()) == suffix_;
+	}
+}
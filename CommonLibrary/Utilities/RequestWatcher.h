@@ -0,0 +1,55 @@
+#pragma once
+
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+namespace Utilities
+{
+	// Linux-native watcher for a request drop directory: files that land in it (IN_MOVED_TO, IN_CLOSE_WRITE)
+	// and end with the suffix are collected into a ring of pending paths. Events are read in bulk by the thread
+	// that calls wait(), so a burst is one read() per buffer instead of one callback and lock handoff per file.
+	// When the kernel queue or the ring overflows, the next wait() rescans the directory instead.
+	// Instances are independent; each owns its inotify descriptor.
+	class RequestWatcher
+	{
+	public:
+		RequestWatcher(const std::string& directory, const std::string& suffix = ".json", const size_t& ring_capacity = 16384);
+		~RequestWatcher(void);
+
+		RequestWatcher(const RequestWatcher&) = delete;
+		RequestWatcher& operator=(const RequestWatcher&) = delete;
+
+		auto start(void) -> std::tuple<bool, std::optional<std::string>>;
+		auto stop(void) -> void;
+
+		// Moves every pending path into paths, waiting up to timeout_ms for the first one; returns how many were added
+		auto wait(std::vector<std::string>& paths, const int32_t& timeout_ms) -> size_t;
+		// Interrupts a wait() in progress
+		auto wake(void) -> void;
+
+		auto rescans(void) const -> uint64_t { return rescans_; }
+
+	private:
+		auto read_events(void) -> void;
+		auto push(std::string path) -> void;
+		auto drain(std::vector<std::string>& paths) -> size_t;
+		auto rescan(std::vector<std::string>& paths) -> size_t;
+		auto matches(const char* name, const size_t& length) const -> bool;
+
+	private:
+		std::string directory_;
+		std::string suffix_;
+
+		std::vector<std::string> ring_;
+		size_t head_;
+		size_t count_;
+		bool overflowed_;
+		uint64_t rescans_;
+
+		int notify_fd_;
+		int wake_fd_;
+	};
+}
@@ -0,0 +1,40 @@
+#include "ShardedCounter.h"
+
+namespace Utilities
+{
+	ShardedCounter::ShardedCounter(void)
+	{
+		reset();
+	}
+
+	auto ShardedCounter::add(const uint64_t& amount) -> void
+	{
+		shards_[shard_index()].value.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	auto ShardedCounter::value(void) const -> uint64_t
+	{
+		uint64_t total = 0;
+		for (const auto& shard : shards_)
+		{
+			total += shard.value.load(std::memory_order_relaxed);
+		}
+		return total;
+	}
+
+	auto ShardedCounter::reset(void) -> void
+	{
+		for (auto& shard : shards_)
+		{
+			shard.value.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	auto ShardedCounter::shard_index(void) -> size_t
+	{
+		// Threads are numbered as they first count; consecutive numbers get distinct shards
+		static std::atomic<size_t> next_thread{ 0 };
+		thread_local size_t index = next_thread.fetch_add(1, std::memory_order_relaxed) % shard_count;
+		return index;
+	}
+}
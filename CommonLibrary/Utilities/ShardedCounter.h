@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Utilities
+{
+	// Monotonic counter for hot paths: each thread adds to its own cache-line-sized shard, so concurrent writers
+	// never share a line, and the shards are only summed when the value is read. A thread keeps the shard it was
+	// first given; with more threads than shards a few share one, which is still correct, just contended.
+	class ShardedCounter
+	{
+	public:
+		ShardedCounter(void);
+
+		ShardedCounter(const ShardedCounter&) = delete;
+		ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+		auto add(const uint64_t& amount = 1) -> void;
+		auto value(void) const -> uint64_t;
+		// Not atomic with respect to concurrent add(); meant for a quiescent counter
+		auto reset(void) -> void;
+
+	private:
+		static constexpr size_t shard_count = 16;
+
+		struct alignas(64) Shard
+		{
+			std::atomic<uint64_t> value;
+		};
+
+		static auto shard_index(void) -> size_t;
+
+	private:
+		std::array<Shard, shard_count> shards_;
+	};
+}
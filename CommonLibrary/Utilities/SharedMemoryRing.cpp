@@ -0,0 +1,440 @@
+#include "SharedMemoryRing.h"
+
+#include <new>
+#include <ctime>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <format>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace Utilities
+{
+	namespace
+	{
+		constexpr uint32_t channel_magic = 0x594d5152; // "YMQR"
+		constexpr uint32_t doorbell_magic = 0x594d5142; // "YMQB"
+		constexpr uint32_t channel_version = 1;
+		constexpr uint32_t wrap_marker = 0xFFFFFFFF;
+
+		auto align8(const uint64_t& value) -> uint64_t { return (value + 7) & ~static_cast<uint64_t>(7); }
+
+		auto futex_wait(std::atomic<uint32_t>& word, const uint32_t& expected, const int32_t& timeout_us) -> void
+		{
+			timespec timeout{ timeout_us / 1000000, static_cast<long>(timeout_us % 1000000) * 1000 };
+			::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, timeout_us >= 0 ? &timeout : nullptr, nullptr, 0);
+		}
+
+		auto futex_wake(std::atomic<uint32_t>& word) -> void
+		{
+			::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+		}
+
+		auto map_segment(const std::string& name, const int& flags, const size_t& create_bytes)
+			-> std::tuple<void*, size_t, std::optional<std::string>>
+		{
+			int fd = ::shm_open(name.c_str(), flags, 0600);
+			if (fd < 0)
+			{
+				return { nullptr, 0, std::format("shm_open {} failed: {}", name, std::strerror(errno)) };
+			}
+
+			if (create_bytes > 0 && ::ftruncate(fd, static_cast<off_t>(create_bytes)) != 0)
+			{
+				auto error = std::format("ftruncate {} failed: {}", name, std::strerror(errno));
+				::close(fd);
+				::shm_unlink(name.c_str());
+				return { nullptr, 0, error };
+			}
+
+			struct stat status{};
+			if (::fstat(fd, &status) != 0)
+			{
+				auto error = std::format("fstat {} failed: {}", name, std::strerror(errno));
+				::close(fd);
+				return { nullptr, 0, error };
+			}
+
+			auto bytes = static_cast<size_t>(status.st_size);
+			void* mapping = bytes > 0 ? ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+			::close(fd);
+
+			if (mapping == MAP_FAILED)
+			{
+				return { nullptr, 0, std::format("mmap {} failed: {}", name, bytes > 0 ? std::strerror(errno) : "empty segment") };
+			}
+
+			return { mapping, bytes, std::nullopt };
+		}
+	}
+
+	struct SharedMemoryChannel::Ring
+	{
+		alignas(64) std::atomic<uint64_t> head;
+		alignas(64) std::atomic<uint64_t> tail;
+		alignas(64) std::atomic<uint32_t> signal;
+		std::atomic<uint32_t> waiters;
+	};
+
+	struct SharedMemoryChannel::Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t ring_bytes;
+		std::atomic<uint32_t> closed;
+		Ring rings[2];
+	};
+
+	struct SharedMemoryDoorbell::Header
+	{
+		uint32_t magic;
+		std::atomic<uint32_t> sequence;
+		std::atomic<uint32_t> waiters;
+	};
+
+	SharedMemoryChannel::SharedMemoryChannel(void)
+		: owner_(false)
+		, mapping_(nullptr)
+		, mapping_bytes_(0)
+		, header_(nullptr)
+		, ring_bytes_(0)
+		, faulted_(false)
+	{
+	}
+
+	SharedMemoryChannel::~SharedMemoryChannel(void)
+	{
+		close();
+	}
+
+	auto SharedMemoryChannel::create(const std::string& name, const uint32_t& ring_bytes)
+		-> std::tuple<std::shared_ptr<SharedMemoryChannel>, std::optional<std::string>>
+	{
+		auto bytes = static_cast<uint32_t>(align8(std::max<uint32_t>(ring_bytes, 4096)));
+
+		// A segment left behind by a crashed client is replaced, not reused
+		::shm_unlink(name.c_str());
+
+		auto [mapping, mapped, map_error] = map_segment(name, O_CREAT | O_EXCL | O_RDWR, data_offset() + static_cast<size_t>(bytes) * 2);
+		if (mapping == nullptr)
+		{
+			return { nullptr, map_error };
+		}
+
+		std::shared_ptr<SharedMemoryChannel> channel(new SharedMemoryChannel());
+		channel->name_ = name;
+		channel->owner_ = true;
+		channel->mapping_ = mapping;
+		channel->mapping_bytes_ = mapped;
+		channel->header_ = new (mapping) Header{};
+		channel->header_->version = channel_version;
+		channel->header_->ring_bytes = bytes;
+		channel->ring_bytes_ = bytes;
+		std::atomic_thread_fence(std::memory_order_release);
+		channel->header_->magic = channel_magic;
+
+		return { channel, std::nullopt };
+	}
+
+	auto SharedMemoryChannel::attach(const std::string& name) -> std::tuple<std::shared_ptr<SharedMemoryChannel>, std::optional<std::string>>
+	{
+		auto [mapping, mapped, map_error] = map_segment(name, O_RDWR, 0);
+		if (mapping == nullptr)
+		{
+			return { nullptr, map_error };
+		}
+
+		auto* header = static_cast<Header*>(mapping);
+		uint32_t ring_bytes = mapped < data_offset() ? 0 : header->ring_bytes;
+		if (mapped < data_offset() || header->magic != channel_magic || header->version != channel_version || ring_bytes < 4096
+			|| ring_bytes % 8 != 0 || mapped < data_offset() + static_cast<size_t>(ring_bytes) * 2)
+		{
+			::munmap(mapping, mapped);
+			return { nullptr, std::format("shared memory segment {} is not a channel", name) };
+		}
+
+		std::shared_ptr<SharedMemoryChannel> channel(new SharedMemoryChannel());
+		channel->name_ = name;
+		channel->mapping_ = mapping;
+		channel->mapping_bytes_ = mapped;
+		channel->header_ = header;
+		channel->ring_bytes_ = ring_bytes;
+
+		return { channel, std::nullopt };
+	}
+
+	auto SharedMemoryChannel::push(const SharedMemoryDirection& direction, const std::string& record)
+		-> std::tuple<bool, std::optional<std::string>>
+	{
+		if (header_ == nullptr)
+		{
+			return { false, "channel is closed" };
+		}
+
+		auto* target = ring(direction);
+		auto* base = data(direction);
+		uint64_t capacity = ring_bytes_;
+		uint64_t need = align8(sizeof(uint32_t) + record.size());
+
+		if (need > capacity / 2)
+		{
+			return { false, std::format("record of {} bytes exceeds half the ring ({} bytes)", record.size(), capacity) };
+		}
+
+		auto tail = target->tail.load(std::memory_order_relaxed);
+		auto head = target->head.load(std::memory_order_acquire);
+		auto position = tail % capacity;
+		auto contiguous = capacity - position;
+		auto total = need + (contiguous < need ? contiguous : 0);
+
+		if (capacity - (tail - head) < total)
+		{
+			return { false, "ring full" };
+		}
+
+		// Records never straddle the end: skip the remainder with a marker the reader jumps over
+		if (contiguous < need)
+		{
+			std::memcpy(base + position, &wrap_marker, sizeof(wrap_marker));
+			tail += contiguous;
+			position = 0;
+		}
+
+		auto length = static_cast<uint32_t>(record.size());
+		std::memcpy(base + position, &length, sizeof(length));
+		std::memcpy(base + position + sizeof(length), record.data(), record.size());
+		target->tail.store(tail + need, std::memory_order_release);
+
+		target->signal.fetch_add(1);
+		if (target->waiters.load() > 0)
+		{
+			futex_wake(target->signal);
+		}
+
+		return { true, std::nullopt };
+	}
+
+	auto SharedMemoryChannel::pop(const SharedMemoryDirection& direction) -> std::optional<std::string>
+	{
+		if (header_ == nullptr || faulted_.load())
+		{
+			return std::nullopt;
+		}
+
+		auto* source = ring(direction);
+		auto* base = data(direction);
+		uint64_t capacity = ring_bytes_;
+
+		auto head = source->head.load(std::memory_order_relaxed);
+		auto tail = source->tail.load(std::memory_order_acquire);
+		if (head == tail)
+		{
+			return std::nullopt;
+		}
+
+		// Indices and lengths come from the peer's memory: everything read must lie inside what it published
+		auto available = tail - head;
+		auto position = head % capacity;
+		uint32_t length = 0;
+		if (available > capacity || position % 8 != 0)
+		{
+			faulted_.store(true);
+			return std::nullopt;
+		}
+
+		std::memcpy(&length, base + position, sizeof(length));
+		if (length == wrap_marker)
+		{
+			if (capacity - position >= available)
+			{
+				faulted_.store(true);
+				return std::nullopt;
+			}
+
+			available -= capacity - position;
+			head += capacity - position;
+			position = 0;
+			std::memcpy(&length, base, sizeof(length));
+		}
+
+		if (align8(sizeof(uint32_t) + static_cast<uint64_t>(length)) > available
+			|| position + sizeof(uint32_t) + length > capacity)
+		{
+			faulted_.store(true);
+			return std::nullopt;
+		}
+
+		std::string record(reinterpret_cast<const char*>(base + position + sizeof(length)), length);
+		source->head.store(head + align8(sizeof(uint32_t) + length), std::memory_order_release);
+
+		return record;
+	}
+
+	auto SharedMemoryChannel::wait(const SharedMemoryDirection& direction, const int32_t& timeout_us) -> bool
+	{
+		if (header_ == nullptr)
+		{
+			return false;
+		}
+
+		auto* source = ring(direction);
+		auto empty = [source]()
+		{
+			return source->head.load(std::memory_order_relaxed) == source->tail.load(std::memory_order_acquire);
+		};
+
+		if (!empty())
+		{
+			return true;
+		}
+
+		// Register as a waiter before sampling the signal so a concurrent push either wakes us or is seen here
+		source->waiters.fetch_add(1);
+		auto signal = source->signal.load();
+		if (empty() && header_->closed.load() == 0)
+		{
+			futex_wait(source->signal, signal, timeout_us);
+		}
+		source->waiters.fetch_sub(1);
+
+		return !empty();
+	}
+
+	auto SharedMemoryChannel::close(void) -> void
+	{
+		if (header_ == nullptr)
+		{
+			return;
+		}
+
+		if (owner_)
+		{
+			header_->closed.store(1);
+			futex_wake(header_->rings[0].signal);
+			futex_wake(header_->rings[1].signal);
+			::shm_unlink(name_.c_str());
+		}
+
+		::munmap(mapping_, mapping_bytes_);
+		mapping_ = nullptr;
+		header_ = nullptr;
+	}
+
+	auto SharedMemoryChannel::closed(void) const -> bool
+	{
+		return header_ == nullptr || faulted_.load() || header_->closed.load() != 0;
+	}
+
+	auto SharedMemoryChannel::name(void) const -> std::string
+	{
+		return name_;
+	}
+
+	auto SharedMemoryChannel::data_offset(void) -> size_t
+	{
+		return (sizeof(Header) + 63) & ~static_cast<size_t>(63);
+	}
+
+	auto SharedMemoryChannel::ring(const SharedMemoryDirection& direction) const -> Ring*
+	{
+		return &header_->rings[static_cast<uint8_t>(direction)];
+	}
+
+	auto SharedMemoryChannel::data(const SharedMemoryDirection& direction) const -> uint8_t*
+	{
+		return static_cast<uint8_t*>(mapping_) + data_offset() + static_cast<size_t>(ring_bytes_) * static_cast<uint8_t>(direction);
+	}
+
+	SharedMemoryDoorbell::SharedMemoryDoorbell(void)
+		: owner_(false)
+		, header_(nullptr)
+	{
+	}
+
+	SharedMemoryDoorbell::~SharedMemoryDoorbell(void)
+	{
+		if (header_ == nullptr)
+		{
+			return;
+		}
+
+		if (owner_)
+		{
+			::shm_unlink(name_.c_str());
+		}
+
+		::munmap(header_, sizeof(Header));
+	}
+
+	auto SharedMemoryDoorbell::create(const std::string& name) -> std::tuple<std::shared_ptr<SharedMemoryDoorbell>, std::optional<std::string>>
+	{
+		::shm_unlink(name.c_str());
+
+		auto [mapping, mapped, map_error] = map_segment(name, O_CREAT | O_EXCL | O_RDWR, sizeof(Header));
+		if (mapping == nullptr)
+		{
+			return { nullptr, map_error };
+		}
+
+		std::shared_ptr<SharedMemoryDoorbell> doorbell(new SharedMemoryDoorbell());
+		doorbell->name_ = name;
+		doorbell->owner_ = true;
+		doorbell->header_ = new (mapping) Header{};
+		doorbell->header_->magic = doorbell_magic;
+
+		return { doorbell, std::nullopt };
+	}
+
+	auto SharedMemoryDoorbell::attach(const std::string& name) -> std::tuple<std::shared_ptr<SharedMemoryDoorbell>, std::optional<std::string>>
+	{
+		auto [mapping, mapped, map_error] = map_segment(name, O_RDWR, 0);
+		if (mapping == nullptr)
+		{
+			return { nullptr, map_error };
+		}
+
+		auto* header = static_cast<Header*>(mapping);
+		if (mapped < sizeof(Header) || header->magic != doorbell_magic)
+		{
+			::munmap(mapping, mapped);
+			return { nullptr, std::format("shared memory segment {} is not a doorbell", name) };
+		}
+
+		std::shared_ptr<SharedMemoryDoorbell> doorbell(new SharedMemoryDoorbell());
+		doorbell->name_ = name;
+		doorbell->header_ = header;
+
+		return { doorbell, std::nullopt };
+	}
+
+	auto SharedMemoryDoorbell::ring(void) -> void
+	{
+		header_->sequence.fetch_add(1);
+		if (header_->waiters.load() > 0)
+		{
+			futex_wake(header_->sequence);
+		}
+	}
+
+	auto SharedMemoryDoorbell::sequence(void) const -> uint32_t
+	{
+		return header_->sequence.load();
+	}
+
+	auto SharedMemoryDoorbell::wait(const uint32_t& sequence, const int32_t& timeout_us) -> void
+	{
+		header_->waiters.fetch_add(1);
+		if (header_->sequence.load() == sequence)
+		{
+			futex_wait(header_->sequence, sequence, timeout_us);
+		}
+		header_->waiters.fetch_sub(1);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <tuple>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <optional>
+
+namespace Utilities
+{
+	enum class SharedMemoryDirection : uint8_t
+	{
+		Request = 0,
+		Response = 1,
+	};
+
+	// A pair of single-producer/single-consumer byte rings in one POSIX shared memory segment.
+	// Records are length-prefixed; readers block on a futex word in the ring header, so cross-process
+	// wakeups need no extra descriptors.
+	class SharedMemoryChannel
+	{
+	public:
+		~SharedMemoryChannel(void);
+
+		static auto create(const std::string& name, const uint32_t& ring_bytes)
+			-> std::tuple<std::shared_ptr<SharedMemoryChannel>, std::optional<std::string>>;
+		static auto attach(const std::string& name) -> std::tuple<std::shared_ptr<SharedMemoryChannel>, std::optional<std::string>>;
+
+		// Fails without blocking when the ring is full
+		auto push(const SharedMemoryDirection& direction, const std::string& record) -> std::tuple<bool, std::optional<std::string>>;
+		// A record the peer corrupted faults the channel: pop returns nothing more and closed() turns true
+		auto pop(const SharedMemoryDirection& direction) -> std::optional<std::string>;
+		auto wait(const SharedMemoryDirection& direction, const int32_t& timeout_us) -> bool;
+
+		auto close(void) -> void;
+		auto closed(void) const -> bool;
+		auto name(void) const -> std::string;
+
+	private:
+		struct Ring;
+		struct Header;
+
+		SharedMemoryChannel(void);
+
+		static auto data_offset(void) -> size_t;
+		auto ring(const SharedMemoryDirection& direction) const -> Ring*;
+		auto data(const SharedMemoryDirection& direction) const -> uint8_t*;
+
+	private:
+		std::string name_;
+		bool owner_;
+		void* mapping_;
+		size_t mapping_bytes_;
+		Header* header_;
+		uint32_t ring_bytes_;  // copied at create/attach; the peer can rewrite the header's copy
+		std::atomic<bool> faulted_;
+	};
+
+	// Process-shared wakeup counter: clients ring it after pushing so one server thread can sleep for all rings
+	class SharedMemoryDoorbell
+	{
+	public:
+		~SharedMemoryDoorbell(void);
+
+		static auto create(const std::string& name) -> std::tuple<std::shared_ptr<SharedMemoryDoorbell>, std::optional<std::string>>;
+		static auto attach(const std::string& name) -> std::tuple<std::shared_ptr<SharedMemoryDoorbell>, std::optional<std::string>>;
+
+		auto ring(void) -> void;
+		auto sequence(void) const -> uint32_t;
+		auto wait(const uint32_t& sequence, const int32_t& timeout_us) -> void;
+
+	private:
+		struct Header;
+
+		SharedMemoryDoorbell(void);
+
+	private:
+		std::string name_;
+		bool owner_;
+		Header* header_;
+	};
+}
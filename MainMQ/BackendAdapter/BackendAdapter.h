@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <map>
 #include <optional>
 #include <string>
 #include <tuple>
@@ -44,6 +45,13 @@ struct QueuePolicy
 	DlqPolicy dlq;
 };
 
+enum class EnvelopeFormat
+{
+	Json,
+	CompactJson,
+	Binary
+};
+
 struct FileSystemConfig
 {
 	std::string root;
@@ -52,6 +60,13 @@ struct FileSystemConfig
 	std::string archive_dir;
 	std::string dlq_dir;
 	std::string meta_dir;
+	EnvelopeFormat envelope_format = EnvelopeFormat::Json;
+};
+
+enum class PayloadStorage
+{
+	Files,
+	Packs
 };
 
 struct SQLiteConfig
@@ -62,6 +77,32 @@ struct SQLiteConfig
 	int32_t busy_timeout_ms = 0;
 	std::string journal_mode;
 	std::string synchronous;
+	int32_t inline_payload_max_bytes = 0;
+	bool sync_payloads = false;
+	PayloadStorage payload_storage = PayloadStorage::Files;
+	uint64_t pack_max_bytes = 64 * 1024 * 1024;
+	double pack_compact_live_ratio = 0.5;
+	int32_t pack_compact_interval_ms = 60000;
+};
+
+struct CompressionPolicy
+{
+	static constexpr uint32_t max_block_bytes = 4 * 1024 * 1024;
+
+	bool enabled = false;
+	uint32_t min_bytes = 256;
+	uint32_t block_bytes = 64 * 1024;
+	bool dictionary = false;
+	uint32_t dictionary_bytes = 16 * 1024;
+	uint32_t dictionary_samples = 128;
+	uint64_t dictionary_retrain_messages = 0;
+};
+
+struct ReclaimConfig
+{
+	bool deferred = true;
+	int32_t batch_size = 64;
+	int32_t interval_ms = 50;
 };
 
 struct BackendConfig
@@ -69,6 +110,9 @@ struct BackendConfig
 	BackendType type = BackendType::SQLite;
 	FileSystemConfig filesystem;
 	SQLiteConfig sqlite;
+	CompressionPolicy compression;
+	std::map<std::string, CompressionPolicy> queue_compression;
+	ReclaimConfig reclaim;
 };
 
 struct MessageEnvelope
@@ -107,6 +151,11 @@ struct QueueMetrics
 	uint64_t inflight = 0;
 	uint64_t delayed = 0;
 	uint64_t dlq = 0;
+	uint64_t compressed_messages = 0;
+	uint64_t compression_original_bytes = 0;
+	uint64_t compression_stored_bytes = 0;
+	uint64_t compression_cpu_us = 0;
+	uint32_t compression_dictionary_version = 0;
 };
 
 struct ExpiredLeaseInfo
@@ -152,6 +201,14 @@ struct ConsistencyReport
 	std::vector<ConsistencyIssue> issues;
 };
 
+struct ConsistencySlice
+{
+	ConsistencyReport report;
+	std::string queue;
+	int32_t checked_keys = 0;
+	bool pass_completed = false;
+};
+
 class BackendAdapter
 {
 public:
@@ -198,4 +255,11 @@ public:
 	{
 		return { 0, "not supported" };
 	}
+
+	// Checks the next key range from a persisted cursor; repeated calls cover every queue and then wrap around
+	virtual auto check_consistency_slice(const int32_t& max_keys)
+		-> std::tuple<ConsistencySlice, std::optional<std::string>>
+	{
+		return { ConsistencySlice{ {}, "", 0, true }, "not supported" };
+	}
 };
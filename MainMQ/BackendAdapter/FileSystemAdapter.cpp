@@ -1,6 +1,8 @@
 #include "FileSystemAdapter.h"
 
+#include "ByteOrder.h"
 #include "Generator.h"
+#include "IoEngine.h"
 #include "Logger.h"
 
 #include <nlohmann/json.hpp>
@@ -13,6 +15,56 @@
 
 using json = nlohmann::json;
 
+namespace
+{
+	// Binary envelope: magic, header length, fixed fields, length-prefixed strings, payload encoding, payload; integers are little-endian
+	const std::string binary_envelope_magic = "YMQE";
+	constexpr size_t binary_envelope_prefix = 8;
+
+	// Headers written before the encoding byte existed end at the strings; their payloads are told apart by the frame magic
+	enum class PayloadEncoding : uint8_t
+	{
+		Raw = 0,
+		Lz4 = 1
+	};
+
+	template <typename T>
+	auto append_value(std::string& target, const T& value) -> void
+	{
+		Utilities::ByteOrder::append_little_endian(target, value);
+	}
+
+	auto append_string(std::string& target, const std::string& value) -> void
+	{
+		append_value(target, static_cast<uint32_t>(value.size()));
+		target.append(value);
+	}
+
+	template <typename T>
+	auto read_value(const std::string& source, size_t& offset, T& value) -> bool
+	{
+		return Utilities::ByteOrder::read_little_endian(source, offset, value);
+	}
+
+	auto read_string(const std::string& source, size_t& offset, std::string& value) -> bool
+	{
+		uint32_t length = 0;
+		if (!read_value(source, offset, length) || offset + length > source.size())
+		{
+			return false;
+		}
+
+		value.assign(source.data() + offset, length);
+		offset += length;
+		return true;
+	}
+
+	auto is_binary_envelope(const std::string& content) -> bool
+	{
+		return content.compare(0, binary_envelope_magic.size(), binary_envelope_magic) == 0;
+	}
+}
+
 FileSystemAdapter::FileSystemAdapter(void)
 	: is_open_(false)
 {
@@ -31,6 +83,7 @@ auto FileSystemAdapter::open(const BackendConfig& config) -> std::tuple<bool, st
 	}
 
 	fs_config_ = config.filesystem;
+	reclaim_config_ = config.reclaim;
 
 	auto [ok, error] = ensure_directories();
 	if (!ok)
@@ -38,6 +91,17 @@ auto FileSystemAdapter::open(const BackendConfig& config) -> std::tuple<bool, st
 		return { false, error };
 	}
 
+	auto [codec_ok, codec_error] = codec_.configure(config.compression, config.queue_compression, build_meta_path("dictionaries"));
+	if (!codec_ok)
+	{
+		return { false, codec_error };
+	}
+
+	if (reclaim_config_.deferred)
+	{
+		reclaimer_.start(reclaim_config_.batch_size, reclaim_config_.interval_ms);
+	}
+
 	is_open_ = true;
 
 	Utilities::Logger::handle().write(
@@ -55,6 +119,8 @@ auto FileSystemAdapter::close(void) -> void
 		return;
 	}
 
+	reclaimer_.stop();
+
 	is_open_ = false;
 	policies_.clear();
 }
@@ -63,7 +129,10 @@ auto FileSystemAdapter::ensure_directories(void) -> std::tuple<bool, std::option
 {
 	std::vector<std::string> dirs = {
 		fs_config_.root,
-		build_meta_path()
+		build_meta_path(),
+		build_meta_path("leases"),
+		build_meta_path("delayed"),
+		build_meta_path("state")
 	};
 
 	for (const auto& dir : dirs)
@@ -129,6 +198,27 @@ auto FileSystemAdapter::build_meta_path(const std::string& filename) -> std::str
 	return path.string();
 }
 
+auto FileSystemAdapter::build_lease_meta_path(const std::string& message_key) -> std::string
+{
+	std::string safe_key = message_key;
+	std::replace(safe_key.begin(), safe_key.end(), ':', '_');
+	return build_meta_path(std::format("leases/{}.json", safe_key));
+}
+
+auto FileSystemAdapter::build_delayed_meta_path(const std::string& message_key) -> std::string
+{
+	std::string safe_key = message_key;
+	std::replace(safe_key.begin(), safe_key.end(), ':', '_');
+	return build_meta_path(std::format("delayed/{}.json", safe_key));
+}
+
+auto FileSystemAdapter::build_state_meta_path(const std::string& message_key) -> std::string
+{
+	std::string safe_key = message_key;
+	std::replace(safe_key.begin(), safe_key.end(), ':', '_');
+	return build_meta_path(std::format("state/{}.json", safe_key));
+}
+
 auto FileSystemAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bool, std::optional<std::string>>
 {
 	std::lock_guard<std::mutex> lock(mutex_);
@@ -168,7 +258,7 @@ auto FileSystemAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bo
 		target_path = build_queue_path(message.queue, fs_config_.inbox_dir, filename);
 	}
 
-	auto content = serialize_envelope(message);
+	auto content = serialize_envelope({ message });
 	return atomic_write(target_path, content);
 }
 
@@ -201,27 +291,35 @@ auto FileSystemAdapter::lease_next(const std::string& queue, const std::string&
 
 	for (const auto& file_path : files)
 	{
-		auto [content, read_error] = read_file(file_path);
-		if (!content.has_value())
+		auto [header_opt, header_error] = read_envelope_header(file_path);
+		if (!header_opt.has_value())
 		{
 			continue;
 		}
 
-		auto [envelope_opt, parse_error] = deserialize_envelope(content.value(), file_path);
-		if (!envelope_opt.has_value())
+		// Check target_consumer_id filter
+		auto& target_consumer_id = header_opt->envelope.target_consumer_id;
+		if (!target_consumer_id.empty() && target_consumer_id != consumer_id)
 		{
 			continue;
 		}
 
-		auto& envelope = envelope_opt.value();
-
-		// Check target_consumer_id filter
-		if (envelope.target_consumer_id.empty() || envelope.target_consumer_id == consumer_id)
+		if (header_opt->complete)
 		{
 			matched_file_path = file_path;
-			matched_envelope = envelope;
+			matched_envelope = std::move(header_opt->envelope);
 			break;
 		}
+
+		auto [stored_opt, read_error] = read_envelope(file_path);
+		if (!stored_opt.has_value())
+		{
+			continue;
+		}
+
+		matched_file_path = file_path;
+		matched_envelope = stored_opt->envelope;
+		break;
 	}
 
 	if (!matched_envelope.has_value())
@@ -231,18 +329,10 @@ auto FileSystemAdapter::lease_next(const std::string& queue, const std::string&
 
 	auto& envelope = matched_envelope.value();
 
-	// Move to processing
 	std::filesystem::path src_path(matched_file_path);
 	auto filename = src_path.filename().string();
 	auto processing_path = build_queue_path(queue, fs_config_.processing_dir, filename);
 
-	auto [moved, move_error] = move_file(matched_file_path, processing_path);
-	if (!moved)
-	{
-		result.error = move_error;
-		return result;
-	}
-
 	// Create lease token
 	auto lease_id = generate_uuid();
 	auto now = current_time_ms();
@@ -259,9 +349,20 @@ auto FileSystemAdapter::lease_next(const std::string& queue, const std::string&
 	meta.consumer_id = consumer_id;
 	meta.lease_id = lease_id;
 	meta.lease_until_ms = lease_until;
-	meta.attempt = envelope.attempt + 1;
 	meta.queue = queue;
 
+	// Attempts from earlier leases live in state meta, not in the envelope file
+	auto [state_opt, state_error] = read_state_meta(envelope.key);
+	meta.attempt = (state_opt.has_value() ? state_opt->attempt : envelope.attempt) + 1;
+
+	// Move to processing; the envelope file itself is not rewritten
+	auto [moved, move_error] = move_file(matched_file_path, processing_path);
+	if (!moved)
+	{
+		result.error = move_error;
+		return result;
+	}
+
 	auto [meta_ok, meta_error] = write_lease_meta(envelope.key, meta);
 	if (!meta_ok)
 	{
@@ -271,9 +372,7 @@ auto FileSystemAdapter::lease_next(const std::string& queue, const std::string&
 		return result;
 	}
 
-	// Update attempt count in envelope file
 	envelope.attempt = meta.attempt;
-	atomic_write(processing_path, serialize_envelope(envelope));
 
 	result.leased = true;
 	result.message = envelope;
@@ -331,8 +430,10 @@ auto FileSystemAdapter::ack(const LeaseToken& lease) -> std::tuple<bool, std::op
 		return { false, move_error };
 	}
 
-	// Delete lease meta
+	// The archive rename is the ack. The lease meta goes right after it so the expiry scan never reports an acked
+	// message; one left behind by a failed unlink or a crash names a processing file that is gone, and the scan drops it.
 	delete_lease_meta(lease.message_key);
+	reclaimer_.schedule(lease.message_key, { Utilities::IoOperationTypes::Unlink, build_state_meta_path(lease.message_key) });
 
 	return { true, std::nullopt };
 }
@@ -367,49 +468,20 @@ auto FileSystemAdapter::nack(const LeaseToken& lease, const std::string& reason,
 
 	auto processing_path = build_queue_path(meta.queue, fs_config_.processing_dir, filename);
 
+	StateMeta state;
+	state.attempt = meta.attempt;
+
 	if (requeue)
 	{
 		// Move back to inbox
-		auto inbox_path = build_queue_path(meta.queue, fs_config_.inbox_dir, filename);
-		auto [moved, move_error] = move_file(processing_path, inbox_path);
-		if (!moved)
-		{
-			return { false, move_error };
-		}
-	}
-	else
-	{
-		// Move to DLQ
-		auto dlq_path = build_queue_path(meta.queue, fs_config_.dlq_dir, filename);
-
-		// Read and update message with DLQ info
-		auto [content, read_error] = read_file(processing_path);
-		if (content.has_value())
-		{
-			try
-			{
-				json envelope = json::parse(content.value());
-				envelope["dlqReason"] = reason;
-				envelope["dlqAt"] = current_time_ms();
-				atomic_write(processing_path, envelope.dump(2));
-			}
-			catch (...)
-			{
-				// Continue even if update fails
-			}
-		}
-
-		auto [moved, move_error] = move_file(processing_path, dlq_path);
-		if (!moved)
-		{
-			return { false, move_error };
-		}
+		return release_lease(lease.message_key, processing_path, build_queue_path(meta.queue, fs_config_.inbox_dir, filename), state);
 	}
 
-	// Delete lease meta
-	delete_lease_meta(lease.message_key);
+	// Move to DLQ, reason is recorded in state meta
+	state.dlq_reason = reason;
+	state.dlq_at_ms = current_time_ms();
 
-	return { true, std::nullopt };
+	return release_lease(lease.message_key, processing_path, build_queue_path(meta.queue, fs_config_.dlq_dir, filename), state);
 }
 
 auto FileSystemAdapter::extend_lease(const LeaseToken& lease, const int32_t& visibility_timeout_sec)
@@ -545,6 +617,8 @@ auto FileSystemAdapter::metrics(const std::string& queue) -> std::tuple<QueueMet
 	m.delayed = list_json_files(build_queue_path(queue, "delayed")).size();
 	m.dlq = list_json_files(build_queue_path(queue, fs_config_.dlq_dir)).size();
 
+	codec_.apply_metrics(queue, m);
+
 	return { m, std::nullopt };
 }
 
@@ -568,6 +642,9 @@ auto FileSystemAdapter::recover_expired_leases(void) -> std::tuple<int32_t, std:
 		return { 0, std::nullopt };
 	}
 
+	std::vector<Utilities::IoOperation> moves;
+	std::vector<Utilities::IoOperation> states;
+	std::vector<Utilities::IoOperation> cleanups;
 	for (const auto& entry : std::filesystem::directory_iterator(meta_dir, ec))
 	{
 		if (!entry.is_regular_file())
@@ -610,15 +687,16 @@ auto FileSystemAdapter::recover_expired_leases(void) -> std::tuple<int32_t, std:
 
 				if (std::filesystem::exists(processing_path, ec))
 				{
-					std::filesystem::rename(processing_path, inbox_path, ec);
-					if (!ec)
-					{
-						recovered++;
-					}
+					// Carry the attempt count over to state meta
+					StateMeta state;
+					state.attempt = j.value("attempt", 0);
+
+					moves.push_back({ Utilities::IoOperationTypes::Rename, processing_path, inbox_path });
+					states.push_back(write_state_meta_operation(message_key, state));
 				}
 
 				// Delete lease meta
-				std::filesystem::remove(entry.path(), ec);
+				cleanups.push_back({ Utilities::IoOperationTypes::Unlink, entry.path().string() });
 			}
 		}
 		catch (...)
@@ -627,6 +705,18 @@ auto FileSystemAdapter::recover_expired_leases(void) -> std::tuple<int32_t, std:
 		}
 	}
 
+	auto results = Utilities::IoEngine::handle().execute(moves);
+	for (size_t index = 0; index < results.size(); ++index)
+	{
+		if (std::get<0>(results[index]))
+		{
+			recovered++;
+			cleanups.push_back(states[index]);
+		}
+	}
+
+	Utilities::IoEngine::handle().execute(cleanups);
+
 	return { recovered, std::nullopt };
 }
 
@@ -663,46 +753,55 @@ auto FileSystemAdapter::process_delayed_messages(void) -> std::tuple<int32_t, st
 			continue;
 		}
 
+		std::vector<Utilities::IoOperation> moves;
+		std::vector<std::string> message_keys;
 		auto files = list_json_files(delayed_dir);
 		for (const auto& file_path : files)
 		{
-			auto [content, read_error] = read_file(file_path);
-			if (!content.has_value())
+			auto [header_opt, header_error] = read_envelope_header(file_path);
+			if (!header_opt.has_value())
 			{
 				continue;
 			}
 
-			try
+			// Delay requests record the new due time in delayed meta only
+			auto available_at = header_opt->envelope.available_at_ms;
+			auto [delayed_opt, delayed_error] = read_delayed_meta(header_opt->envelope.key);
+			if (delayed_opt.has_value())
 			{
-				json envelope = json::parse(content.value());
-				int64_t available_at = envelope.value("availableAt", static_cast<int64_t>(0));
+				available_at = delayed_opt->available_at_ms;
+			}
 
-				if (now >= available_at)
-				{
-					// Move to inbox
-					std::filesystem::path src_path(file_path);
-					auto filename = src_path.filename().string();
-					auto inbox_path = build_queue_path(queue_name, fs_config_.inbox_dir, filename);
+			if (now >= available_at)
+			{
+				// Move to inbox
+				std::filesystem::path src_path(file_path);
+				auto filename = src_path.filename().string();
+				auto inbox_path = build_queue_path(queue_name, fs_config_.inbox_dir, filename);
 
-					std::filesystem::rename(file_path, inbox_path, ec);
-					if (!ec)
-					{
-						processed++;
-
-						// Delete delayed meta if exists
-						std::string message_key = envelope.value("key", "");
-						if (!message_key.empty())
-						{
-							delete_delayed_meta(message_key);
-						}
-					}
-				}
+				moves.push_back({ Utilities::IoOperationTypes::Rename, file_path, inbox_path });
+				message_keys.push_back(header_opt->envelope.key);
 			}
-			catch (...)
+		}
+
+		// Delete delayed meta only for messages that actually moved
+		std::vector<Utilities::IoOperation> unlinks;
+		auto results = Utilities::IoEngine::handle().execute(moves);
+		for (size_t index = 0; index < results.size(); ++index)
+		{
+			if (!std::get<0>(results[index]))
 			{
 				continue;
 			}
+
+			processed++;
+			if (!message_keys[index].empty())
+			{
+				unlinks.push_back({ Utilities::IoOperationTypes::Unlink, build_delayed_meta_path(message_keys[index]) });
+			}
 		}
+
+		Utilities::IoEngine::handle().execute(unlinks);
 	}
 
 	return { processed, std::nullopt };
@@ -728,6 +827,7 @@ auto FileSystemAdapter::get_expired_inflight_messages(void) -> std::tuple<std::v
 		return { expired, std::nullopt };
 	}
 
+	std::vector<Utilities::IoOperation> orphans;
 	for (const auto& entry : std::filesystem::directory_iterator(meta_dir, ec))
 	{
 		if (!entry.is_regular_file())
@@ -752,6 +852,19 @@ auto FileSystemAdapter::get_expired_inflight_messages(void) -> std::tuple<std::v
 				info.message_key = j.value("messageKey", "");
 				info.queue = j.value("queue", "");
 				info.attempt = j.value("attempt", 0);
+
+				// A lease whose message already left processing (acked, or moved before a crash) has nothing to expire
+				auto parts = info.message_key.rfind(':');
+				if (parts != std::string::npos && !info.queue.empty())
+				{
+					auto filename = std::format("{}.json", info.message_key.substr(parts + 1));
+					if (!std::filesystem::exists(build_queue_path(info.queue, fs_config_.processing_dir, filename), ec))
+					{
+						orphans.push_back({ Utilities::IoOperationTypes::Unlink, entry.path().string() });
+						continue;
+					}
+				}
+
 				expired.push_back(info);
 			}
 		}
@@ -761,6 +874,8 @@ auto FileSystemAdapter::get_expired_inflight_messages(void) -> std::tuple<std::v
 		}
 	}
 
+	Utilities::IoEngine::handle().execute(orphans);
+
 	return { expired, std::nullopt };
 }
 
@@ -793,53 +908,33 @@ auto FileSystemAdapter::delay_message(const std::string& message_key, int64_t de
 
 	auto processing_path = build_queue_path(queue, fs_config_.processing_dir, filename);
 
+	StateMeta state;
+	state.attempt = meta.attempt;
+
 	if (delay_ms <= 0)
 	{
 		// Move directly to inbox
-		auto inbox_path = build_queue_path(queue, fs_config_.inbox_dir, filename);
-		auto [moved, move_error] = move_file(processing_path, inbox_path);
-		if (!moved)
-		{
-			return { false, move_error };
-		}
+		return release_lease(message_key, processing_path, build_queue_path(queue, fs_config_.inbox_dir, filename), state);
 	}
-	else
-	{
-		// Move to delayed folder
-		auto delayed_path = build_queue_path(queue, "delayed", filename);
-
-		// Update available_at in the message
-		auto [content, read_error] = read_file(processing_path);
-		if (content.has_value())
-		{
-			try
-			{
-				json envelope = json::parse(content.value());
-				envelope["availableAt"] = current_time_ms() + delay_ms;
-				atomic_write(processing_path, envelope.dump(2));
-			}
-			catch (...)
-			{
-			}
-		}
-
-		auto [moved, move_error] = move_file(processing_path, delayed_path);
-		if (!moved)
-		{
-			return { false, move_error };
-		}
 
-		// Write delayed meta
-		DelayedMeta delayed_meta;
-		delayed_meta.message_key = message_key;
-		delayed_meta.queue = queue;
-		delayed_meta.available_at_ms = current_time_ms() + delay_ms;
-		delayed_meta.attempt = meta.attempt;
-		write_delayed_meta(message_key, delayed_meta);
+	// The new due time lives in delayed meta, written before the move so the delayed scan never sees the file without it
+	DelayedMeta delayed_meta;
+	delayed_meta.message_key = message_key;
+	delayed_meta.queue = queue;
+	delayed_meta.available_at_ms = current_time_ms() + delay_ms;
+	delayed_meta.attempt = meta.attempt;
+	auto [delayed_ok, delayed_error] = write_delayed_meta(message_key, delayed_meta);
+	if (!delayed_ok)
+	{
+		return { false, delayed_error };
 	}
 
-	// Delete lease meta
-	delete_lease_meta(message_key);
+	auto [released, release_error] = release_lease(message_key, processing_path, build_queue_path(queue, "delayed", filename), state);
+	if (!released)
+	{
+		delete_delayed_meta(message_key);
+		return { false, release_error };
+	}
 
 	return { true, std::nullopt };
 }
@@ -872,63 +967,60 @@ auto FileSystemAdapter::move_to_dlq(const std::string& message_key, const std::s
 	auto processing_path = build_queue_path(meta.queue, fs_config_.processing_dir, filename);
 	auto dlq_path = build_queue_path(meta.queue, fs_config_.dlq_dir, filename);
 
-	// Update message with DLQ info
-	auto [content, read_error] = read_file(processing_path);
-	if (content.has_value())
+	// DLQ info is recorded in state meta instead of rewriting the envelope
+	StateMeta state;
+	state.attempt = meta.attempt;
+	state.dlq_reason = reason;
+	state.dlq_at_ms = current_time_ms();
+
+	return release_lease(message_key, processing_path, dlq_path, state);
+}
+
+auto FileSystemAdapter::release_lease(const std::string& message_key, const std::string& processing_path, const std::string& target_path,
+	const StateMeta& state) -> std::tuple<bool, std::optional<std::string>>
+{
+	// State meta is only read once the message has left processing, so writing it first leaves a failed release with
+	// the lease as it was. The move is the commit point: a lease meta that fails to unlink after it names a processing
+	// file that is gone, and the expiry scan drops it.
+	auto [state_ok, state_error] = Utilities::IoEngine::handle().execute({ write_state_meta_operation(message_key, state) }).front();
+	if (!state_ok)
 	{
-		try
-		{
-			json envelope = json::parse(content.value());
-			envelope["dlqReason"] = reason;
-			envelope["dlqAt"] = current_time_ms();
-			atomic_write(processing_path, envelope.dump(2));
-		}
-		catch (...)
-		{
-		}
+		return { false, state_error };
 	}
 
-	auto [moved, move_error] = move_file(processing_path, dlq_path);
+	auto [moved, move_error] = move_file(processing_path, target_path);
 	if (!moved)
 	{
 		return { false, move_error };
 	}
 
-	delete_lease_meta(message_key);
+	auto [removed, remove_error] = delete_lease_meta(message_key);
+	if (!removed)
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("lease meta of {} left behind: {}", message_key, remove_error.value_or("unknown"))
+		);
+	}
 
 	return { true, std::nullopt };
 }
 
+auto FileSystemAdapter::flush_reclaimer(void) -> void
+{
+	reclaimer_.flush();
+}
+
 auto FileSystemAdapter::atomic_write(const std::string& target_path, const std::string& content)
 	-> std::tuple<bool, std::optional<std::string>>
 {
-	auto temp_path = target_path + ".tmp";
-
-	std::ofstream file(temp_path, std::ios::out | std::ios::trunc);
-	if (!file.is_open())
-	{
-		return { false, std::format("cannot create temp file: {}", temp_path) };
-	}
-
-	file << content;
-	file.flush();
-	file.close();
-
-	std::error_code ec;
-	std::filesystem::rename(temp_path, target_path, ec);
-	if (ec)
-	{
-		std::filesystem::remove(temp_path, ec);
-		return { false, std::format("rename failed: {}", ec.message()) };
-	}
-
-	return { true, std::nullopt };
+	return Utilities::IoEngine::handle().atomic_write(target_path, content);
 }
 
 auto FileSystemAdapter::read_file(const std::string& file_path)
 	-> std::tuple<std::optional<std::string>, std::optional<std::string>>
 {
-	std::ifstream file(file_path);
+	std::ifstream file(file_path, std::ios::binary);
 	if (!file.is_open())
 	{
 		return { std::nullopt, std::format("cannot open file: {}", file_path) };
@@ -944,25 +1036,13 @@ auto FileSystemAdapter::read_file(const std::string& file_path)
 auto FileSystemAdapter::move_file(const std::string& src, const std::string& dest)
 	-> std::tuple<bool, std::optional<std::string>>
 {
-	std::error_code ec;
-	std::filesystem::rename(src, dest, ec);
-	if (ec)
-	{
-		return { false, std::format("move failed: {}", ec.message()) };
-	}
-	return { true, std::nullopt };
+	return Utilities::IoEngine::handle().rename(src, dest);
 }
 
 auto FileSystemAdapter::delete_file(const std::string& file_path)
 	-> std::tuple<bool, std::optional<std::string>>
 {
-	std::error_code ec;
-	std::filesystem::remove(file_path, ec);
-	if (ec)
-	{
-		return { false, std::format("delete failed: {}", ec.message()) };
-	}
-	return { true, std::nullopt };
+	return Utilities::IoEngine::handle().unlink(file_path);
 }
 
 auto FileSystemAdapter::list_json_files(const std::string& dir_path) -> std::vector<std::string>
@@ -993,42 +1073,134 @@ auto FileSystemAdapter::list_json_files(const std::string& dir_path) -> std::vec
 	return files;
 }
 
-auto FileSystemAdapter::serialize_envelope(const MessageEnvelope& envelope) -> std::string
+auto FileSystemAdapter::serialize_envelope(const StoredEnvelope& stored) -> std::string
 {
+	const auto& envelope = stored.envelope;
+
+	if (fs_config_.envelope_format == EnvelopeFormat::Binary)
+	{
+		std::string header;
+		append_value(header, envelope.priority);
+		append_value(header, envelope.attempt);
+		append_value(header, envelope.created_at_ms);
+		append_value(header, envelope.available_at_ms);
+		append_value(header, stored.dlq_at_ms);
+		append_string(header, envelope.key);
+		append_string(header, envelope.message_id);
+		append_string(header, envelope.queue);
+		append_string(header, envelope.target_consumer_id);
+		append_string(header, stored.dlq_reason);
+		append_string(header, envelope.attributes_json);
+
+		auto compressed = codec_.compress(envelope.queue, envelope.payload_json);
+		append_value(header, static_cast<uint8_t>(compressed.has_value() ? PayloadEncoding::Lz4 : PayloadEncoding::Raw));
+		const auto& payload = compressed.has_value() ? compressed.value() : envelope.payload_json;
+
+		std::string content;
+		content.reserve(binary_envelope_prefix + header.size() + payload.size());
+		content.append(binary_envelope_magic);
+		append_value(content, static_cast<uint32_t>(header.size()));
+		content.append(header);
+		content.append(payload);
+		return content;
+	}
+
 	json j;
 	j["key"] = envelope.key;
 	j["messageId"] = envelope.message_id;
 	j["queue"] = envelope.queue;
-	j["payload"] = envelope.payload_json;
+	codec_.encode_field(envelope.queue, envelope.payload_json, j, "payload");
 	j["attributes"] = envelope.attributes_json;
 	j["priority"] = envelope.priority;
 	j["attempt"] = envelope.attempt;
 	j["createdAt"] = envelope.created_at_ms;
 	j["availableAt"] = envelope.available_at_ms;
 	j["targetConsumerId"] = envelope.target_consumer_id;
-	return j.dump(2);
+	if (!stored.dlq_reason.empty() || stored.dlq_at_ms != 0)
+	{
+		j["dlqReason"] = stored.dlq_reason;
+		j["dlqAt"] = stored.dlq_at_ms;
+	}
+
+	return (fs_config_.envelope_format == EnvelopeFormat::CompactJson) ? j.dump() : j.dump(2);
 }
 
-auto FileSystemAdapter::deserialize_envelope(const std::string& json_content, const std::string& file_path)
-	-> std::tuple<std::optional<MessageEnvelope>, std::optional<std::string>>
+auto FileSystemAdapter::deserialize_envelope(const std::string& content, const std::string& file_path, const bool& header_only)
+	-> std::tuple<std::optional<StoredEnvelope>, std::optional<std::string>>
 {
+	if (is_binary_envelope(content))
+	{
+		StoredEnvelope stored;
+		auto& envelope = stored.envelope;
+
+		size_t offset = binary_envelope_magic.size();
+		uint32_t header_size = 0;
+		if (!read_value(content, offset, header_size) || binary_envelope_prefix + header_size > content.size()
+			|| !read_value(content, offset, envelope.priority) || !read_value(content, offset, envelope.attempt)
+			|| !read_value(content, offset, envelope.created_at_ms) || !read_value(content, offset, envelope.available_at_ms)
+			|| !read_value(content, offset, stored.dlq_at_ms) || !read_string(content, offset, envelope.key)
+			|| !read_string(content, offset, envelope.message_id) || !read_string(content, offset, envelope.queue)
+			|| !read_string(content, offset, envelope.target_consumer_id) || !read_string(content, offset, stored.dlq_reason)
+			|| !read_string(content, offset, envelope.attributes_json))
+		{
+			return { std::nullopt, std::format("envelope parse error: truncated binary header in {}", file_path) };
+		}
+
+		std::optional<PayloadEncoding> encoding;
+		if (offset < binary_envelope_prefix + header_size)
+		{
+			uint8_t value = 0;
+			read_value(content, offset, value);
+			if (value > static_cast<uint8_t>(PayloadEncoding::Lz4))
+			{
+				return { std::nullopt, std::format("envelope parse error: unknown payload encoding {} in {}", value, file_path) };
+			}
+			encoding = static_cast<PayloadEncoding>(value);
+		}
+
+		if (header_only)
+		{
+			return { stored, std::nullopt };
+		}
+
+		auto body = content.substr(binary_envelope_prefix + header_size);
+		auto [payload, payload_error] = !encoding.has_value() ? codec_.decode(envelope.queue, body)
+			: encoding == PayloadEncoding::Lz4 ? codec_.decompress(envelope.queue, body)
+			: std::tuple<std::optional<std::string>, std::optional<std::string>>{ body, std::nullopt };
+		if (!payload.has_value())
+		{
+			return { std::nullopt, std::format("envelope parse error: {} in {}", payload_error.value_or("unknown"), file_path) };
+		}
+		envelope.payload_json = payload.value();
+
+		return { stored, std::nullopt };
+	}
+
 	try
 	{
-		json j = json::parse(json_content);
+		json j = json::parse(content);
 
-		MessageEnvelope envelope;
+		StoredEnvelope stored;
+		auto& envelope = stored.envelope;
 		envelope.key = j.value("key", "");
 		envelope.message_id = j.value("messageId", "");
 		envelope.queue = j.value("queue", "");
-		envelope.payload_json = j.value("payload", "{}");
+		auto [payload, payload_error] = codec_.decode_field(envelope.queue, j, "payload", "{}");
+		if (!payload.has_value())
+		{
+			return { std::nullopt, std::format("envelope parse error: {} in {}", payload_error.value_or("unknown"), file_path) };
+		}
+		envelope.payload_json = payload.value();
 		envelope.attributes_json = j.value("attributes", "{}");
 		envelope.priority = j.value("priority", 0);
 		envelope.attempt = j.value("attempt", 0);
 		envelope.created_at_ms = j.value("createdAt", static_cast<int64_t>(0));
 		envelope.available_at_ms = j.value("availableAt", static_cast<int64_t>(0));
 		envelope.target_consumer_id = j.value("targetConsumerId", "");
+		stored.dlq_reason = j.value("dlqReason", "");
+		stored.dlq_at_ms = j.value("dlqAt", static_cast<int64_t>(0));
 
-		return { envelope, std::nullopt };
+		return { stored, std::nullopt };
 	}
 	catch (const json::exception& e)
 	{
@@ -1036,6 +1208,64 @@ auto FileSystemAdapter::deserialize_envelope(const std::string& json_content, co
 	}
 }
 
+auto FileSystemAdapter::read_envelope(const std::string& file_path)
+	-> std::tuple<std::optional<StoredEnvelope>, std::optional<std::string>>
+{
+	auto [content, read_error] = read_file(file_path);
+	if (!content.has_value())
+	{
+		return { std::nullopt, read_error };
+	}
+
+	auto [stored, parse_error] = deserialize_envelope(content.value(), file_path);
+	if (stored.has_value())
+	{
+		stored->complete = true;
+	}
+
+	return { stored, parse_error };
+}
+
+auto FileSystemAdapter::read_envelope_header(const std::string& file_path)
+	-> std::tuple<std::optional<StoredEnvelope>, std::optional<std::string>>
+{
+	std::ifstream file(file_path, std::ios::binary);
+	if (!file.is_open())
+	{
+		return { std::nullopt, std::format("cannot open file: {}", file_path) };
+	}
+
+	std::string prefix(binary_envelope_prefix, '\0');
+	file.read(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+	prefix.resize(static_cast<size_t>(file.gcount()));
+
+	if (!is_binary_envelope(prefix))
+	{
+		// JSON envelopes carry no header boundary, parse the whole document
+		file.close();
+		return read_envelope(file_path);
+	}
+
+	std::error_code ec;
+	auto file_size = std::filesystem::file_size(file_path, ec);
+
+	size_t offset = binary_envelope_magic.size();
+	uint32_t header_size = 0;
+	if (ec || !read_value(prefix, offset, header_size) || binary_envelope_prefix + header_size > file_size)
+	{
+		return { std::nullopt, std::format("envelope parse error: truncated binary header in {}", file_path) };
+	}
+
+	std::string header(header_size, '\0');
+	file.read(header.data(), static_cast<std::streamsize>(header.size()));
+	if (static_cast<size_t>(file.gcount()) != header.size())
+	{
+		return { std::nullopt, std::format("envelope parse error: truncated binary header in {}", file_path) };
+	}
+
+	return deserialize_envelope(prefix + header, file_path, true);
+}
+
 auto FileSystemAdapter::write_lease_meta(const std::string& message_key, const LeaseMeta& meta)
 	-> std::tuple<bool, std::optional<std::string>>
 {
@@ -1047,9 +1277,7 @@ auto FileSystemAdapter::write_lease_meta(const std::string& message_key, const L
 	}
 
 	// Use URL-safe encoding for filename
-	std::string safe_key = message_key;
-	std::replace(safe_key.begin(), safe_key.end(), ':', '_');
-	auto meta_file = build_meta_path(std::format("leases/{}.json", safe_key));
+	auto meta_file = build_lease_meta_path(message_key);
 
 	json j;
 	j["messageKey"] = message_key;
@@ -1065,9 +1293,7 @@ auto FileSystemAdapter::write_lease_meta(const std::string& message_key, const L
 auto FileSystemAdapter::read_lease_meta(const std::string& message_key)
 	-> std::tuple<std::optional<LeaseMeta>, std::optional<std::string>>
 {
-	std::string safe_key = message_key;
-	std::replace(safe_key.begin(), safe_key.end(), ':', '_');
-	auto meta_file = build_meta_path(std::format("leases/{}.json", safe_key));
+	auto meta_file = build_lease_meta_path(message_key);
 
 	auto [content, read_error] = read_file(meta_file);
 	if (!content.has_value())
@@ -1097,9 +1323,7 @@ auto FileSystemAdapter::read_lease_meta(const std::string& message_key)
 auto FileSystemAdapter::delete_lease_meta(const std::string& message_key)
 	-> std::tuple<bool, std::optional<std::string>>
 {
-	std::string safe_key = message_key;
-	std::replace(safe_key.begin(), safe_key.end(), ':', '_');
-	auto meta_file = build_meta_path(std::format("leases/{}.json", safe_key));
+	auto meta_file = build_lease_meta_path(message_key);
 
 	return delete_file(meta_file);
 }
@@ -1114,9 +1338,7 @@ auto FileSystemAdapter::write_delayed_meta(const std::string& message_key, const
 		std::filesystem::create_directories(delayed_dir, ec);
 	}
 
-	std::string safe_key = message_key;
-	std::replace(safe_key.begin(), safe_key.end(), ':', '_');
-	auto meta_file = build_meta_path(std::format("delayed/{}.json", safe_key));
+	auto meta_file = build_delayed_meta_path(message_key);
 
 	json j;
 	j["messageKey"] = message_key;
@@ -1127,16 +1349,97 @@ auto FileSystemAdapter::write_delayed_meta(const std::string& message_key, const
 	return atomic_write(meta_file, j.dump(2));
 }
 
+auto FileSystemAdapter::read_delayed_meta(const std::string& message_key)
+	-> std::tuple<std::optional<DelayedMeta>, std::optional<std::string>>
+{
+	auto meta_file = build_delayed_meta_path(message_key);
+
+	std::error_code ec;
+	if (!std::filesystem::exists(meta_file, ec))
+	{
+		return { std::nullopt, std::nullopt };
+	}
+
+	auto [content, read_error] = read_file(meta_file);
+	if (!content.has_value())
+	{
+		return { std::nullopt, read_error };
+	}
+
+	try
+	{
+		json j = json::parse(content.value());
+
+		DelayedMeta meta;
+		meta.message_key = j.value("messageKey", message_key);
+		meta.queue = j.value("queue", "");
+		meta.available_at_ms = j.value("availableAt", static_cast<int64_t>(0));
+		meta.attempt = j.value("attempt", 0);
+
+		return { meta, std::nullopt };
+	}
+	catch (const json::exception& e)
+	{
+		return { std::nullopt, std::format("delayed meta parse error: {}", e.what()) };
+	}
+}
+
 auto FileSystemAdapter::delete_delayed_meta(const std::string& message_key)
 	-> std::tuple<bool, std::optional<std::string>>
 {
-	std::string safe_key = message_key;
-	std::replace(safe_key.begin(), safe_key.end(), ':', '_');
-	auto meta_file = build_meta_path(std::format("delayed/{}.json", safe_key));
+	auto meta_file = build_delayed_meta_path(message_key);
 
 	return delete_file(meta_file);
 }
 
+auto FileSystemAdapter::write_state_meta_operation(const std::string& message_key, const StateMeta& meta) -> Utilities::IoOperation
+{
+	json j;
+	j["messageKey"] = message_key;
+	j["attempt"] = meta.attempt;
+	if (!meta.dlq_reason.empty() || meta.dlq_at_ms != 0)
+	{
+		j["dlqReason"] = meta.dlq_reason;
+		j["dlqAt"] = meta.dlq_at_ms;
+	}
+
+	return { Utilities::IoOperationTypes::AtomicWrite, build_state_meta_path(message_key), "", j.dump() };
+}
+
+auto FileSystemAdapter::read_state_meta(const std::string& message_key)
+	-> std::tuple<std::optional<StateMeta>, std::optional<std::string>>
+{
+	auto meta_file = build_state_meta_path(message_key);
+
+	std::error_code ec;
+	if (!std::filesystem::exists(meta_file, ec))
+	{
+		return { std::nullopt, std::nullopt };
+	}
+
+	auto [content, read_error] = read_file(meta_file);
+	if (!content.has_value())
+	{
+		return { std::nullopt, read_error };
+	}
+
+	try
+	{
+		json j = json::parse(content.value());
+
+		StateMeta meta;
+		meta.attempt = j.value("attempt", 0);
+		meta.dlq_reason = j.value("dlqReason", "");
+		meta.dlq_at_ms = j.value("dlqAt", static_cast<int64_t>(0));
+
+		return { meta, std::nullopt };
+	}
+	catch (const json::exception& e)
+	{
+		return { std::nullopt, std::format("state meta parse error: {}", e.what()) };
+	}
+}
+
 auto FileSystemAdapter::current_time_ms(void) -> int64_t
 {
 	return std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -1190,30 +1493,29 @@ auto FileSystemAdapter::list_dlq_messages(const std::string& queue, int32_t limi
 			break;
 		}
 
-		auto [content, read_error] = read_file(file_path);
-		if (!content.has_value())
+		auto [header_opt, header_error] = read_envelope_header(file_path);
+		if (!header_opt.has_value())
 		{
 			continue;
 		}
 
-		try
-		{
-			json j = json::parse(content.value());
-
-			DlqMessageInfo info;
-			info.message_key = j.value("key", "");
-			info.queue = j.value("queue", queue);
-			info.reason = j.value("dlqReason", "");
-			info.dlq_at_ms = j.value("dlqAt", static_cast<int64_t>(0));
-			info.attempt = j.value("attempt", 0);
+		DlqMessageInfo info;
+		info.message_key = header_opt->envelope.key;
+		info.queue = header_opt->envelope.queue.empty() ? queue : header_opt->envelope.queue;
+		info.reason = header_opt->dlq_reason;
+		info.dlq_at_ms = header_opt->dlq_at_ms;
+		info.attempt = header_opt->envelope.attempt;
 
-			dlq_list.push_back(info);
-			count++;
-		}
-		catch (...)
+		auto [state_opt, state_error] = read_state_meta(info.message_key);
+		if (state_opt.has_value())
 		{
-			continue;
+			info.reason = state_opt->dlq_reason;
+			info.dlq_at_ms = state_opt->dlq_at_ms;
+			info.attempt = state_opt->attempt;
 		}
+
+		dlq_list.push_back(info);
+		count++;
 	}
 
 	return { dlq_list, std::nullopt };
@@ -1246,31 +1548,10 @@ auto FileSystemAdapter::reprocess_dlq_message(const std::string& message_key)
 	auto dlq_path = build_queue_path(queue, fs_config_.dlq_dir, filename);
 	auto inbox_path = build_queue_path(queue, fs_config_.inbox_dir, filename);
 
-	// Read and update message
-	auto [content, read_error] = read_file(dlq_path);
-	if (!content.has_value())
-	{
-		return { false, std::format("DLQ message not found: {}", read_error.value_or("unknown")) };
-	}
-
-	try
-	{
-		json envelope = json::parse(content.value());
-		envelope.erase("dlqReason");
-		envelope.erase("dlqAt");
-		envelope["attempt"] = 0;
-		envelope["availableAt"] = current_time_ms();
-
-		// Write updated content
-		auto [write_ok, write_error] = atomic_write(dlq_path, envelope.dump(2));
-		if (!write_ok)
-		{
-			return { false, write_error };
-		}
-	}
-	catch (const json::exception& e)
+	std::error_code ec;
+	if (!std::filesystem::exists(dlq_path, ec))
 	{
-		return { false, std::format("failed to parse DLQ message: {}", e.what()) };
+		return { false, std::format("DLQ message not found: {}", dlq_path) };
 	}
 
 	// Move from DLQ to inbox
@@ -1280,5 +1561,12 @@ auto FileSystemAdapter::reprocess_dlq_message(const std::string& message_key)
 		return { false, move_error };
 	}
 
+	// Reset attempts without touching the envelope file
+	auto [state_ok, state_error] = Utilities::IoEngine::handle().execute({ write_state_meta_operation(message_key, StateMeta{}) }).front();
+	if (!state_ok)
+	{
+		return { false, state_error };
+	}
+
 	return { true, std::nullopt };
 }
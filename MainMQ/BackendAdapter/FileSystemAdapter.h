@@ -1,6 +1,9 @@
 #pragma once
 
 #include "BackendAdapter.h"
+#include "IoEngine.h"
+#include "PayloadCodec.h"
+#include "PayloadReclaimer.h"
 
 #include <map>
 #include <mutex>
@@ -39,12 +42,18 @@ public:
 	auto list_dlq_messages(const std::string& queue, int32_t limit) -> std::tuple<std::vector<DlqMessageInfo>, std::optional<std::string>> override;
 	auto reprocess_dlq_message(const std::string& message_key) -> std::tuple<bool, std::optional<std::string>> override;
 
+	// Waits for meta cleanup deferred by ack; close() drains it as well
+	auto flush_reclaimer(void) -> void;
+
 private:
 	// Directory structure
 	auto ensure_directories(void) -> std::tuple<bool, std::optional<std::string>>;
 	auto ensure_queue_directories(const std::string& queue) -> std::tuple<bool, std::optional<std::string>>;
 	auto build_queue_path(const std::string& queue, const std::string& sub_dir, const std::string& filename = "") -> std::string;
 	auto build_meta_path(const std::string& filename = "") -> std::string;
+	auto build_lease_meta_path(const std::string& message_key) -> std::string;
+	auto build_delayed_meta_path(const std::string& message_key) -> std::string;
+	auto build_state_meta_path(const std::string& message_key) -> std::string;
 
 	// File operations (atomic write)
 	auto atomic_write(const std::string& target_path, const std::string& content) -> std::tuple<bool, std::optional<std::string>>;
@@ -54,8 +63,20 @@ private:
 	auto list_json_files(const std::string& dir_path) -> std::vector<std::string>;
 
 	// Message serialization
-	auto serialize_envelope(const MessageEnvelope& envelope) -> std::string;
-	auto deserialize_envelope(const std::string& json_content, const std::string& file_path) -> std::tuple<std::optional<MessageEnvelope>, std::optional<std::string>>;
+	struct StoredEnvelope
+	{
+		MessageEnvelope envelope;
+		std::string dlq_reason;
+		int64_t dlq_at_ms = 0;
+		// Set when the payload was read as well, as for JSON envelopes that have no separate header
+		bool complete = false;
+	};
+
+	auto serialize_envelope(const StoredEnvelope& stored) -> std::string;
+	auto deserialize_envelope(const std::string& content, const std::string& file_path, const bool& header_only = false)
+		-> std::tuple<std::optional<StoredEnvelope>, std::optional<std::string>>;
+	auto read_envelope(const std::string& file_path) -> std::tuple<std::optional<StoredEnvelope>, std::optional<std::string>>;
+	auto read_envelope_header(const std::string& file_path) -> std::tuple<std::optional<StoredEnvelope>, std::optional<std::string>>;
 
 	// Lease meta operations
 	struct LeaseMeta
@@ -81,8 +102,24 @@ private:
 	};
 
 	auto write_delayed_meta(const std::string& message_key, const DelayedMeta& meta) -> std::tuple<bool, std::optional<std::string>>;
+	auto read_delayed_meta(const std::string& message_key) -> std::tuple<std::optional<DelayedMeta>, std::optional<std::string>>;
 	auto delete_delayed_meta(const std::string& message_key) -> std::tuple<bool, std::optional<std::string>>;
 
+	// Mutable per-message state, kept beside the envelope so envelope files are written once
+	struct StateMeta
+	{
+		int32_t attempt = 0;
+		std::string dlq_reason;
+		int64_t dlq_at_ms = 0;
+	};
+
+	auto write_state_meta_operation(const std::string& message_key, const StateMeta& meta) -> Utilities::IoOperation;
+	auto read_state_meta(const std::string& message_key) -> std::tuple<std::optional<StateMeta>, std::optional<std::string>>;
+
+	// Ends a lease by writing state meta, moving the message out of processing and unlinking the lease meta, in that order
+	auto release_lease(const std::string& message_key, const std::string& processing_path, const std::string& target_path,
+		const StateMeta& state) -> std::tuple<bool, std::optional<std::string>>;
+
 	// Utilities
 	auto current_time_ms(void) -> int64_t;
 	auto generate_uuid(void) -> std::string;
@@ -93,4 +130,9 @@ private:
 	FileSystemConfig fs_config_;
 	std::map<std::string, QueuePolicy> policies_;
 	mutable std::mutex mutex_;
+
+	PayloadCodec codec_;
+
+	ReclaimConfig reclaim_config_;
+	PayloadReclaimer reclaimer_;
 };
@@ -2,20 +2,36 @@
 
 #include "File.h"
 #include "Generator.h"
+#include "IoEngine.h"
 #include "Logger.h"
 
 #include <nlohmann/json.hpp>
+#include <sqlite3.h>
 
 #include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <map>
+#include <set>
 
 using json = nlohmann::json;
 
 namespace
 {
+	const std::string placement_column =
+		"CASE WHEN json_extract(k.value, '$.inline') THEN 'inline' "
+		"WHEN json_extract(k.value, '$.packId') IS NOT NULL THEN 'pack' ELSE 'file' END";
+
+	const int64_t archive_retention_ms = static_cast<int64_t>(7 * 24 * 60 * 60 * 1000);
+
+	const std::string consistency_cursor_key = "consistency:cursor";
+	const int32_t consistency_range_keys = 1024;
+
+	// kv rows read or rewritten per db_mutex_ hold while compacting packs
+	const int32_t compact_chunk_rows = 256;
+
 	auto current_time_ms_helper() -> int64_t
 	{
 		return std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -28,6 +44,9 @@ HybridAdapter::HybridAdapter(const std::string& schema_path)
 	: is_open_(false)
 	, schema_path_(schema_path)
 	, payload_root_("./data/payloads")
+	, pack_root_("./data/packs")
+	, dictionary_root_("./data/dictionaries")
+	, compactor_stop_(false)
 {
 }
 
@@ -46,6 +65,7 @@ auto HybridAdapter::open(const BackendConfig& config) -> std::tuple<bool, std::o
 	}
 
 	sqlite_config_ = config.sqlite;
+	reclaim_config_ = config.reclaim;
 
 	std::filesystem::path db_path(sqlite_config_.db_path);
 	auto parent_path = db_path.parent_path();
@@ -58,6 +78,12 @@ auto HybridAdapter::open(const BackendConfig& config) -> std::tuple<bool, std::o
 	std::error_code ec;
 	std::filesystem::create_directories(payload_root_, ec);
 
+	auto [codec_ok, codec_error] = codec_.configure(config.compression, config.queue_compression, dictionary_root_);
+	if (!codec_ok)
+	{
+		return { false, codec_error };
+	}
+
 	auto [opened, open_error] = db_.open(sqlite_config_.db_path);
 	if (!opened)
 	{
@@ -78,11 +104,32 @@ auto HybridAdapter::open(const BackendConfig& config) -> std::tuple<bool, std::o
 		return { false, schema_error };
 	}
 
+	if (sqlite_config_.payload_storage == PayloadStorage::Packs)
+	{
+		auto [packs_ok, packs_error] = pack_store_.open(pack_root_, sqlite_config_.pack_max_bytes);
+		if (!packs_ok)
+		{
+			db_.close();
+			return { false, packs_error };
+		}
+
+		compactor_stop_ = false;
+		compactor_ = std::make_unique<std::thread>(&HybridAdapter::compactor_loop, this);
+	}
+
+	if (reclaim_config_.deferred)
+	{
+		reclaimer_.start(reclaim_config_.batch_size, reclaim_config_.interval_ms,
+			[this](const std::vector<std::string>& message_keys) { finish_reclaim(message_keys); });
+	}
+	resume_reclaim();
+
 	is_open_ = true;
 
 	Utilities::Logger::handle().write(
 		Utilities::LogTypes::Information,
-		std::format("HybridAdapter opened (db: {}, payloads: {})", sqlite_config_.db_path, payload_root_)
+		std::format("HybridAdapter opened (db: {}, payloads: {})", sqlite_config_.db_path,
+			sqlite_config_.payload_storage == PayloadStorage::Packs ? pack_root_ : payload_root_)
 	);
 
 	return { true, std::nullopt };
@@ -90,6 +137,20 @@ auto HybridAdapter::open(const BackendConfig& config) -> std::tuple<bool, std::o
 
 auto HybridAdapter::close(void) -> void
 {
+	if (compactor_ != nullptr)
+	{
+		{
+			std::lock_guard<std::mutex> lock(compactor_mutex_);
+			compactor_stop_ = true;
+		}
+		compactor_condition_.notify_all();
+		compactor_->join();
+		compactor_.reset();
+	}
+
+	// Drained before taking the database lock: completions delete their reclaim rows under it
+	reclaimer_.stop();
+
 	std::lock_guard<std::mutex> lock(db_mutex_);
 
 	if (!is_open_)
@@ -97,6 +158,7 @@ auto HybridAdapter::close(void) -> void
 		return;
 	}
 
+	pack_store_.close();
 	db_.close();
 	is_open_ = false;
 }
@@ -184,6 +246,7 @@ auto HybridAdapter::ensure_payload_directories(const std::string& queue) -> std:
 		std::format("{}/{}/dlq", payload_root_, queue)
 	};
 
+	bool created = false;
 	for (const auto& dir : dirs)
 	{
 		std::error_code ec;
@@ -193,6 +256,22 @@ auto HybridAdapter::ensure_payload_directories(const std::string& queue) -> std:
 			{
 				return { false, std::format("failed to create directory {}: {}", dir, ec.message()) };
 			}
+			created = true;
+		}
+	}
+
+	if (!created || !sqlite_config_.sync_payloads)
+	{
+		return { true, std::nullopt };
+	}
+
+	// New queue directories are linked into the payload root, which must be synced for them to survive a crash
+	for (const auto& dir : { std::format("{}/{}", payload_root_, queue), payload_root_ })
+	{
+		auto [synced, sync_error] = Utilities::IoEngine::handle().sync_directory(dir);
+		if (!synced)
+		{
+			return { false, sync_error };
 		}
 	}
 
@@ -216,63 +295,98 @@ auto HybridAdapter::build_dlq_path(const std::string& queue, const std::string&
 
 auto HybridAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bool, std::optional<std::string>>
 {
-	std::lock_guard<std::mutex> lock(db_mutex_);
-
 	if (!is_open_)
 	{
 		return { false, "adapter not open" };
 	}
 
-	auto [dirs_ok, dirs_error] = ensure_payload_directories(message.queue);
-	if (!dirs_ok)
+	json envelope;
+	envelope["messageId"] = message.message_id;
+	envelope["queue"] = message.queue;
+	envelope["priority"] = message.priority;
+	envelope["attempt"] = message.attempt;
+	envelope["createdAt"] = message.created_at_ms;
+
+	{
+		std::lock_guard<std::mutex> lock(enqueuing_mutex_);
+		enqueuing_keys_.insert(message.key);
+	}
+
+	// Payload I/O happens before db_mutex_ so the write transaction only covers the index rows
+	auto [payload_path, place_error] = place_payload(message, envelope);
+	auto [indexed, index_error] = place_error.has_value()
+		? std::tuple<bool, std::optional<std::string>>{ false, place_error }
+		: index_message(message, envelope, payload_path);
+
+	// A pack record stays pinned until its index row is committed or rolled back, so compaction cannot remove the pack
+	if (envelope.contains("packId"))
+	{
+		pack_store_.release(envelope["packId"].get<uint32_t>());
+	}
+
+	std::lock_guard<std::mutex> lock(enqueuing_mutex_);
+	enqueuing_keys_.erase(message.key);
+
+	return { indexed, index_error };
+}
+
+auto HybridAdapter::index_message(const MessageEnvelope& message, const json& envelope, const std::string& payload_path)
+	-> std::tuple<bool, std::optional<std::string>>
+{
+	std::lock_guard<std::mutex> lock(db_mutex_);
+
+	if (!is_open_)
 	{
-		return { false, dirs_error };
+		remove_payload_file(payload_path);
+		return { false, "adapter not open" };
 	}
 
 	auto now = current_time_ms();
 	std::string state = (message.available_at_ms > now) ? "delayed" : "ready";
 
+	// Serialized before the transaction opens: dump() throws on invalid UTF-8
+	std::string envelope_text;
+	try
+	{
+		envelope_text = envelope.dump();
+	}
+	catch (const json::exception& e)
+	{
+		remove_payload_file(payload_path);
+		return { false, std::format("failed to serialize envelope: {}", e.what()) };
+	}
+
 	auto [tx_ok, tx_error] = db_.begin_transaction();
 	if (!tx_ok)
 	{
+		remove_payload_file(payload_path);
 		return { false, tx_error };
 	}
 
-	auto payload_path = build_payload_path(message.queue, message.message_id);
-	json payload_json;
-	payload_json["payload"] = message.payload_json;
-	payload_json["attributes"] = message.attributes_json;
+	// Inline payloads carry arbitrary client text, so the kv row is bound rather than interpolated
+	std::string insert_kv = std::format(
+		"INSERT INTO {} (key, value, value_type, created_at, updated_at) VALUES (?, ?, 'message', ?, ?)",
+		sqlite_config_.kv_table
+	);
 
-	auto [write_ok, write_error] = atomic_write(payload_path, payload_json.dump(2));
-	if (!write_ok)
+	auto [kv_stmt, kv_prepare_error] = db_.prepare(insert_kv);
+	if (!kv_stmt)
 	{
 		db_.rollback();
-		return { false, write_error };
+		remove_payload_file(payload_path);
+		return { false, std::format("kv insert failed: {}", kv_prepare_error.value_or("unknown")) };
 	}
 
-	json envelope;
-	envelope["messageId"] = message.message_id;
-	envelope["queue"] = message.queue;
-	envelope["payloadPath"] = payload_path;
-	envelope["priority"] = message.priority;
-	envelope["attempt"] = message.attempt;
-	envelope["createdAt"] = message.created_at_ms;
-
-	std::string insert_kv = std::format(
-		"INSERT INTO {} (key, value, value_type, created_at, updated_at) VALUES ('{}', '{}', 'message', {}, {})",
-		sqlite_config_.kv_table,
-		message.key,
-		envelope.dump(),
-		now,
-		now
-	);
+	kv_stmt->bind_text(1, message.key);
+	kv_stmt->bind_text(2, envelope_text);
+	kv_stmt->bind_int64(3, now);
+	kv_stmt->bind_int64(4, now);
 
-	auto [kv_ok, kv_error] = db_.execute(insert_kv);
-	if (!kv_ok)
+	if (kv_stmt->step() != SQLITE_DONE)
 	{
 		db_.rollback();
-		std::filesystem::remove(payload_path);
-		return { false, std::format("kv insert failed: {}", kv_error.value_or("unknown")) };
+		remove_payload_file(payload_path);
+		return { false, "failed to insert into kv table" };
 	}
 
 	std::string insert_idx = std::format(
@@ -292,7 +406,7 @@ auto HybridAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bool,
 	if (!idx_ok)
 	{
 		db_.rollback();
-		std::filesystem::remove(payload_path);
+		remove_payload_file(payload_path);
 		return { false, std::format("index insert failed: {}", idx_error.value_or("unknown")) };
 	}
 
@@ -300,7 +414,7 @@ auto HybridAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bool,
 	if (!commit_ok)
 	{
 		db_.rollback();
-		std::filesystem::remove(payload_path);
+		remove_payload_file(payload_path);
 		return { false, commit_error };
 	}
 
@@ -310,7 +424,7 @@ auto HybridAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bool,
 auto HybridAdapter::lease_next(const std::string& queue, const std::string& consumer_id, const int32_t& visibility_timeout_sec)
 	-> LeaseResult
 {
-	std::lock_guard<std::mutex> lock(db_mutex_);
+	std::unique_lock<std::mutex> lock(db_mutex_);
 
 	LeaseResult result;
 	result.leased = false;
@@ -393,6 +507,10 @@ auto HybridAdapter::lease_next(const std::string& queue, const std::string& cons
 		return result;
 	}
 
+	// The message is now inflight and owned by this lease, so the payload read needs no lock
+	lock.unlock();
+
+	std::optional<std::string> load_error;
 	try
 	{
 		json envelope = json::parse(envelope_json);
@@ -405,27 +523,58 @@ auto HybridAdapter::lease_next(const std::string& queue, const std::string& cons
 		msg.attempt = attempt + 1;
 		msg.created_at_ms = envelope.value("createdAt", static_cast<int64_t>(0));
 
-		auto [payload_content, payload_error] = read_payload(msg.queue, msg.message_id);
-		if (payload_content.has_value())
+		if (envelope.value("inline", false))
+		{
+			auto [payload, payload_error] = codec_.decode_field(msg.queue, envelope, "payload", "{}");
+			if (!payload.has_value())
+			{
+				load_error = payload_error.value_or("payload decode failed");
+			}
+			msg.payload_json = payload.value_or("");
+			msg.attributes_json = envelope.value("attributes", "{}");
+		}
+		else
 		{
-			json payload_json = json::parse(payload_content.value());
-			msg.payload_json = payload_json.value("payload", "{}");
-			msg.attributes_json = payload_json.value("attributes", "{}");
+			auto [payload_content, payload_error] = read_stored_payload(message_key, envelope);
+			if (!payload_content.has_value())
+			{
+				load_error = payload_error.value_or("payload read failed");
+			}
+			else
+			{
+				json payload_json = json::parse(payload_content.value());
+				msg.payload_json = payload_json.value("payload", "{}");
+				msg.attributes_json = payload_json.value("attributes", "{}");
+			}
 		}
 
-		LeaseToken lease;
-		lease.lease_id = lease_id;
-		lease.message_key = message_key;
-		lease.consumer_id = consumer_id;
-		lease.lease_until_ms = lease_until;
-
-		result.leased = true;
-		result.message = msg;
-		result.lease = lease;
+		if (!load_error.has_value())
+		{
+			LeaseToken lease;
+			lease.lease_id = lease_id;
+			lease.message_key = message_key;
+			lease.consumer_id = consumer_id;
+			lease.lease_until_ms = lease_until;
+
+			result.leased = true;
+			result.message = msg;
+			result.lease = lease;
+		}
 	}
 	catch (const json::exception& e)
 	{
-		result.error = std::format("envelope parse error: {}", e.what());
+		load_error = std::format("envelope parse error: {}", e.what());
+	}
+
+	if (load_error.has_value())
+	{
+		// Leasing it with an empty payload would lose the message, and a retry would fail the same way
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("Failed to load message {}, moving it to the DLQ: {}", message_key, load_error.value())
+		);
+		move_to_dlq(message_key, "payload unreadable");
+		result.error = load_error;
 	}
 
 	return result;
@@ -447,8 +596,11 @@ auto HybridAdapter::ack(const LeaseToken& lease) -> std::tuple<bool, std::option
 	}
 
 	std::string check_sql = std::format(
-		"SELECT queue FROM {} WHERE message_key = '{}' AND state = 'inflight'",
+		"SELECT m.queue, {} FROM {} m LEFT JOIN {} k ON k.key = m.message_key "
+		"WHERE m.message_key = '{}' AND m.state = 'inflight'",
+		placement_column,
 		sqlite_config_.message_index_table,
+		sqlite_config_.kv_table,
 		lease.message_key
 	);
 
@@ -460,6 +612,34 @@ auto HybridAdapter::ack(const LeaseToken& lease) -> std::tuple<bool, std::option
 	}
 
 	std::string queue = check_result->rows[0][0];
+	auto placement = parse_placement(check_result->rows[0][1]);
+
+	if (placement == PayloadPlacement::Pack)
+	{
+		// Packed payloads are archived in place; the compactor reclaims them after retention
+		std::string archive_idx = std::format(
+			"UPDATE {} SET state = 'archived', lease_until = NULL, available_at = {} WHERE message_key = '{}'",
+			sqlite_config_.message_index_table,
+			current_time_ms(),
+			lease.message_key
+		);
+
+		auto [archive_ok, archive_error] = db_.execute(archive_idx);
+		if (!archive_ok)
+		{
+			db_.rollback();
+			return { false, archive_error };
+		}
+
+		auto [commit_ok, commit_error] = db_.commit();
+		if (!commit_ok)
+		{
+			db_.rollback();
+			return { false, commit_error };
+		}
+
+		return { true, std::nullopt };
+	}
 
 	std::string delete_idx = std::format(
 		"DELETE FROM {} WHERE message_key = '{}'",
@@ -487,6 +667,28 @@ auto HybridAdapter::ack(const LeaseToken& lease) -> std::tuple<bool, std::option
 		return { false, del_kv_error };
 	}
 
+	auto message_id = extract_message_id_from_key(lease.message_key);
+	auto deferred = placement == PayloadPlacement::File && reclaim_config_.deferred;
+	if (deferred)
+	{
+		// The pending move commits with the ack, so a crash before the reclaimer runs is replayed on open
+		std::string insert_reclaim = std::format(
+			"INSERT OR REPLACE INTO payload_reclaim (message_key, source_path, target_path, created_at) "
+			"VALUES ('{}', '{}', '{}', {})",
+			lease.message_key,
+			build_payload_path(queue, message_id),
+			build_archive_path(queue, message_id),
+			current_time_ms()
+		);
+
+		auto [reclaim_ok, reclaim_error] = db_.execute(insert_reclaim);
+		if (!reclaim_ok)
+		{
+			db_.rollback();
+			return { false, reclaim_error };
+		}
+	}
+
 	auto [commit_ok, commit_error] = db_.commit();
 	if (!commit_ok)
 	{
@@ -494,8 +696,15 @@ auto HybridAdapter::ack(const LeaseToken& lease) -> std::tuple<bool, std::option
 		return { false, commit_error };
 	}
 
-	auto message_id = extract_message_id_from_key(lease.message_key);
-	move_payload_to_archive(queue, message_id);
+	if (deferred)
+	{
+		reclaimer_.schedule(lease.message_key,
+			{ Utilities::IoOperationTypes::Rename, build_payload_path(queue, message_id), build_archive_path(queue, message_id) });
+	}
+	else if (placement == PayloadPlacement::File)
+	{
+		move_payload_to_archive(queue, message_id);
+	}
 
 	return { true, std::nullopt };
 }
@@ -519,8 +728,11 @@ auto HybridAdapter::nack(const LeaseToken& lease, const std::string& reason, con
 	}
 
 	std::string check_sql = std::format(
-		"SELECT queue FROM {} WHERE message_key = '{}' AND state = 'inflight'",
+		"SELECT m.queue, {} FROM {} m LEFT JOIN {} k ON k.key = m.message_key "
+		"WHERE m.message_key = '{}' AND m.state = 'inflight'",
+		placement_column,
 		sqlite_config_.message_index_table,
+		sqlite_config_.kv_table,
 		lease.message_key
 	);
 
@@ -532,6 +744,7 @@ auto HybridAdapter::nack(const LeaseToken& lease, const std::string& reason, con
 	}
 
 	std::string queue = check_result->rows[0][0];
+	auto placement = parse_placement(check_result->rows[0][1]);
 
 	if (requeue)
 	{
@@ -575,8 +788,11 @@ auto HybridAdapter::nack(const LeaseToken& lease, const std::string& reason, con
 
 		db_.execute(update_kv);
 
-		auto message_id = extract_message_id_from_key(lease.message_key);
-		move_payload_to_dlq(queue, message_id);
+		if (placement == PayloadPlacement::File)
+		{
+			auto message_id = extract_message_id_from_key(lease.message_key);
+			move_payload_to_dlq(queue, message_id);
+		}
 	}
 
 	auto [commit_ok, commit_error] = db_.commit();
@@ -763,6 +979,8 @@ auto HybridAdapter::metrics(const std::string& queue) -> std::tuple<QueueMetrics
 		}
 	}
 
+	codec_.apply_metrics(queue, m);
+
 	return { m, std::nullopt };
 }
 
@@ -944,16 +1162,21 @@ auto HybridAdapter::move_to_dlq(const std::string& message_key, const std::strin
 	}
 
 	std::string check_sql = std::format(
-		"SELECT queue FROM {} WHERE message_key = '{}'",
+		"SELECT m.queue, {} FROM {} m LEFT JOIN {} k ON k.key = m.message_key "
+		"WHERE m.message_key = '{}'",
+		placement_column,
 		sqlite_config_.message_index_table,
+		sqlite_config_.kv_table,
 		message_key
 	);
 
 	auto [check_result, check_error] = db_.query(check_sql);
 	std::string queue;
+	auto placement = PayloadPlacement::File;
 	if (check_result.has_value() && !check_result->rows.empty())
 	{
 		queue = check_result->rows[0][0];
+		placement = parse_placement(check_result->rows[0][1]);
 	}
 
 	std::string update_idx = std::format(
@@ -987,7 +1210,7 @@ auto HybridAdapter::move_to_dlq(const std::string& message_key, const std::strin
 		return { false, commit_error };
 	}
 
-	if (!queue.empty())
+	if (!queue.empty() && placement == PayloadPlacement::File)
 	{
 		auto message_id = extract_message_id_from_key(message_key);
 		move_payload_to_dlq(queue, message_id);
@@ -1008,7 +1231,7 @@ auto HybridAdapter::read_payload(const std::string& queue, const std::string& me
 {
 	auto path = build_payload_path(queue, message_id);
 
-	std::ifstream file(path);
+	std::ifstream file(path, std::ios::binary);
 	if (!file.is_open())
 	{
 		return { std::nullopt, std::format("cannot open payload file: {}", path) };
@@ -1018,7 +1241,7 @@ auto HybridAdapter::read_payload(const std::string& queue, const std::string& me
 		std::istreambuf_iterator<char>());
 	file.close();
 
-	return { content, std::nullopt };
+	return codec_.decode(queue, content);
 }
 
 auto HybridAdapter::move_payload_to_archive(const std::string& queue, const std::string& message_id)
@@ -1027,14 +1250,7 @@ auto HybridAdapter::move_payload_to_archive(const std::string& queue, const std:
 	auto src = build_payload_path(queue, message_id);
 	auto dest = build_archive_path(queue, message_id);
 
-	std::error_code ec;
-	std::filesystem::rename(src, dest, ec);
-	if (ec)
-	{
-		return { false, ec.message() };
-	}
-
-	return { true, std::nullopt };
+	return Utilities::IoEngine::handle().rename(src, dest);
 }
 
 auto HybridAdapter::move_payload_to_dlq(const std::string& queue, const std::string& message_id)
@@ -1043,152 +1259,624 @@ auto HybridAdapter::move_payload_to_dlq(const std::string& queue, const std::str
 	auto src = build_payload_path(queue, message_id);
 	auto dest = build_dlq_path(queue, message_id);
 
-	std::error_code ec;
-	std::filesystem::rename(src, dest, ec);
-	if (ec)
+	return Utilities::IoEngine::handle().rename(src, dest);
+}
+
+auto HybridAdapter::remove_payload_file(const std::string& payload_path) -> void
+{
+	if (payload_path.empty())
 	{
-		return { false, ec.message() };
+		return;
 	}
 
-	return { true, std::nullopt };
+	Utilities::IoEngine::handle().unlink(payload_path);
 }
 
-auto HybridAdapter::atomic_write(const std::string& target_path, const std::string& content)
-	-> std::tuple<bool, std::optional<std::string>>
+auto HybridAdapter::is_inline_payload(const MessageEnvelope& message) -> bool
 {
-	auto temp_path = target_path + ".tmp";
+	auto size = message.payload_json.size() + message.attributes_json.size();
+	return sqlite_config_.inline_payload_max_bytes > 0
+		&& size <= static_cast<size_t>(sqlite_config_.inline_payload_max_bytes);
+}
 
-	std::ofstream file(temp_path, std::ios::out | std::ios::trunc);
-	if (!file.is_open())
+auto HybridAdapter::place_payload(const MessageEnvelope& message, json& envelope)
+	-> std::tuple<std::string, std::optional<std::string>>
+{
+	if (is_inline_payload(message))
 	{
-		return { false, std::format("cannot create temp file: {}", temp_path) };
+		envelope["inline"] = true;
+		codec_.encode_field(message.queue, message.payload_json, envelope, "payload");
+		envelope["attributes"] = message.attributes_json;
+		return { "", std::nullopt };
 	}
 
-	file << content;
-	file.flush();
-	file.close();
+	json payload_json;
+	payload_json["payload"] = message.payload_json;
+	payload_json["attributes"] = message.attributes_json;
 
-	std::error_code ec;
-	std::filesystem::rename(temp_path, target_path, ec);
-	if (ec)
+	if (sqlite_config_.payload_storage == PayloadStorage::Packs)
 	{
-		std::filesystem::remove(temp_path, ec);
-		return { false, std::format("rename failed: {}", ec.message()) };
-	}
-
-	return { true, std::nullopt };
-}
+		auto [location, append_error] = pack_store_.append(codec_.encode(message.queue, payload_json.dump()), sqlite_config_.sync_payloads, true);
+		if (!location.has_value())
+		{
+			return { "", append_error.value_or("pack append failed") };
+		}
 
-auto HybridAdapter::current_time_ms(void) -> int64_t
-{
-	return current_time_ms_helper();
-}
+		envelope["packId"] = location->pack_id;
+		envelope["packOffset"] = location->offset;
+		envelope["packLength"] = location->length;
+		return { "", std::nullopt };
+	}
 
-auto HybridAdapter::extract_message_id_from_key(const std::string& message_key) -> std::string
-{
-	auto pos = message_key.rfind(':');
-	if (pos == std::string::npos)
+	auto [dirs_ok, dirs_error] = ensure_payload_directories(message.queue);
+	if (!dirs_ok)
 	{
-		return message_key;
+		return { "", dirs_error.value_or("failed to create payload directories") };
 	}
-	return message_key.substr(pos + 1);
-}
 
-auto HybridAdapter::extract_queue_from_key(const std::string& message_key) -> std::string
-{
-	auto first = message_key.find(':');
-	if (first == std::string::npos)
+	auto payload_path = build_payload_path(message.queue, message.message_id);
+	auto [write_ok, write_error] = atomic_write(payload_path, codec_.encode(message.queue, payload_json.dump(2)), sqlite_config_.sync_payloads);
+	if (!write_ok)
 	{
-		return "";
+		return { "", write_error.value_or("payload write failed") };
 	}
 
-	auto second = message_key.find(':', first + 1);
-	if (second == std::string::npos)
+	// The index row is committed next, so the rename that published the file has to reach disk first
+	if (sqlite_config_.sync_payloads)
 	{
-		return "";
+		auto [synced, sync_error] = Utilities::IoEngine::handle().sync_directory(std::filesystem::path(payload_path).parent_path().string());
+		if (!synced)
+		{
+			remove_payload_file(payload_path);
+			return { "", sync_error.value_or("payload directory sync failed") };
+		}
 	}
 
-	return message_key.substr(first + 1, second - first - 1);
+	envelope["payloadPath"] = payload_path;
+	return { payload_path, std::nullopt };
 }
 
-auto HybridAdapter::list_dlq_messages(const std::string& queue, int32_t limit)
-	-> std::tuple<std::vector<DlqMessageInfo>, std::optional<std::string>>
+auto HybridAdapter::read_stored_payload(const std::string& message_key, const json& envelope)
+	-> std::tuple<std::optional<std::string>, std::optional<std::string>>
 {
-	std::lock_guard<std::mutex> lock(db_mutex_);
+	if (!envelope.contains("packId"))
+	{
+		return read_payload(envelope.value("queue", ""), envelope.value("messageId", ""));
+	}
 
-	std::vector<DlqMessageInfo> dlq_list;
+	auto queue = envelope.value("queue", "");
 
-	if (!is_open_)
+	auto [content, read_error] = pack_store_.read(pack_location(envelope));
+	if (content.has_value())
 	{
-		return { dlq_list, "adapter not open" };
+		return codec_.decode(queue, content.value());
 	}
 
-	std::string sql = std::format(
-		"SELECT message_key, queue, dlq_reason, dlq_at, attempt FROM {} "
-		"WHERE queue = '{}' AND state = 'dlq' ORDER BY dlq_at DESC LIMIT {}",
-		sqlite_config_.message_index_table,
-		queue,
-		limit
+	// The compactor may have relocated the record after commit; reload its location once
+	std::string kv_sql = std::format(
+		"SELECT value FROM {} WHERE key = '{}'",
+		sqlite_config_.kv_table,
+		message_key
 	);
 
-	auto [result, error] = db_.query(sql);
-	if (!result.has_value())
+	std::lock_guard<std::mutex> lock(db_mutex_);
+
+	auto [kv_result, kv_error] = db_.query(kv_sql);
+	if (!kv_result.has_value() || kv_result->rows.empty())
 	{
-		return { dlq_list, error };
+		return { std::nullopt, read_error };
 	}
 
-	for (const auto& row : result->rows)
+	auto [reloaded, reload_error] = pack_store_.read(pack_location(json::parse(kv_result->rows[0][0], nullptr, false)));
+	if (!reloaded.has_value())
 	{
-		if (row.size() < 5)
-		{
-			continue;
-		}
-
-		DlqMessageInfo info;
-		info.message_key = row[0];
-		info.queue = row[1];
-		info.reason = row[2];
-		info.dlq_at_ms = row[3].empty() ? 0 : std::stoll(row[3]);
-		info.attempt = row[4].empty() ? 0 : std::stoi(row[4]);
-		dlq_list.push_back(info);
+		return { std::nullopt, reload_error };
 	}
 
-	return { dlq_list, std::nullopt };
+	return codec_.decode(queue, reloaded.value());
 }
 
-auto HybridAdapter::reprocess_dlq_message(const std::string& message_key)
-	-> std::tuple<bool, std::optional<std::string>>
+auto HybridAdapter::parse_placement(const std::string& value) -> PayloadPlacement
 {
-	std::lock_guard<std::mutex> lock(db_mutex_);
-
-	if (!is_open_)
+	if (value == "inline")
 	{
-		return { false, "adapter not open" };
+		return PayloadPlacement::Inline;
 	}
 
-	auto [tx_ok, tx_error] = db_.begin_transaction();
-	if (!tx_ok)
+	if (value == "pack")
 	{
-		return { false, tx_error };
+		return PayloadPlacement::Pack;
 	}
 
-	auto now = current_time_ms();
-
-	// Get queue info first
-	std::string check_sql = std::format(
-		"SELECT queue FROM {} WHERE message_key = '{}' AND state = 'dlq'",
-		sqlite_config_.message_index_table,
-		message_key
-	);
+	return PayloadPlacement::File;
+}
 
-	auto [check_result, check_error] = db_.query(check_sql);
-	if (!check_result.has_value() || check_result->rows.empty())
+auto HybridAdapter::pack_location(const json& envelope) -> PackLocation
+{
+	PackLocation location;
+	if (envelope.is_object())
 	{
-		db_.rollback();
-		return { false, "DLQ message not found" };
+		location.pack_id = envelope.value("packId", static_cast<uint32_t>(0));
+		location.offset = envelope.value("packOffset", static_cast<uint64_t>(0));
+		location.length = envelope.value("packLength", static_cast<uint64_t>(0));
 	}
 
-	std::string queue = check_result->rows[0][0];
+	return location;
+}
+
+auto HybridAdapter::compact_payload_packs(void) -> std::tuple<int32_t, std::optional<std::string>>
+{
+	{
+		std::lock_guard<std::mutex> lock(db_mutex_);
+
+		if (!is_open_)
+		{
+			return { 0, "adapter not open" };
+		}
+
+		if (sqlite_config_.payload_storage != PayloadStorage::Packs)
+		{
+			return { 0, std::nullopt };
+		}
+
+		// Archived payloads past retention become dead bytes in their pack
+		auto retention_end = current_time_ms() - archive_retention_ms;
+		std::string purge_kv = std::format(
+			"DELETE FROM {} WHERE key IN (SELECT message_key FROM {} WHERE state = 'archived' AND available_at < {})",
+			sqlite_config_.kv_table,
+			sqlite_config_.message_index_table,
+			retention_end
+		);
+		std::string purge_idx = std::format(
+			"DELETE FROM {} WHERE state = 'archived' AND available_at < {}",
+			sqlite_config_.message_index_table,
+			retention_end
+		);
+
+		auto [tx_ok, tx_error] = db_.begin_transaction();
+		if (!tx_ok)
+		{
+			return { 0, tx_error };
+		}
+
+		for (const auto& purge_sql : { purge_kv, purge_idx })
+		{
+			auto [purged, purge_error] = db_.execute(purge_sql);
+			if (!purged)
+			{
+				db_.rollback();
+				return { 0, purge_error };
+			}
+		}
+
+		auto [committed, commit_error] = db_.commit();
+		if (!committed)
+		{
+			return { 0, commit_error };
+		}
+	}
+
+	// Only packs that are neither active nor pinned now are candidates: nothing appends to them any more, and every
+	// record they hold has a committed index row, so the scan below sees all of them
+	auto active_pack_id = pack_store_.active_pack_id();
+	std::map<uint32_t, std::vector<PackRecord>> candidates;
+	for (const auto& pack_id : pack_store_.pack_ids())
+	{
+		if (pack_id != active_pack_id && pack_store_.pack_size(pack_id) > 0 && !pack_store_.is_pinned(pack_id))
+		{
+			candidates[pack_id];
+		}
+	}
+
+	if (candidates.empty())
+	{
+		return { 0, std::nullopt };
+	}
+
+	// The kv table is walked in key order a chunk at a time, so writers wait for one chunk at most
+	std::string cursor;
+	while (true)
+	{
+		std::string chunk_sql = std::format(
+			"SELECT key, json_extract(value, '$.packId'), json_extract(value, '$.packOffset'), json_extract(value, '$.packLength') "
+			"FROM {} WHERE key > '{}' ORDER BY key LIMIT {}",
+			sqlite_config_.kv_table,
+			cursor,
+			compact_chunk_rows
+		);
+
+		std::optional<DataBase::QueryResult> chunk;
+		{
+			std::lock_guard<std::mutex> lock(db_mutex_);
+
+			if (!is_open_)
+			{
+				return { 0, "adapter not open" };
+			}
+
+			auto [chunk_result, chunk_error] = db_.query(chunk_sql);
+			if (!chunk_result.has_value())
+			{
+				return { 0, chunk_error };
+			}
+			chunk = std::move(chunk_result);
+		}
+
+		for (const auto& row : chunk->rows)
+		{
+			if (row.size() < 4 || row[1].empty() || row[2].empty() || row[3].empty())
+			{
+				continue;
+			}
+
+			auto record = candidates.find(static_cast<uint32_t>(std::stoul(row[1])));
+			if (record != candidates.end())
+			{
+				record->second.push_back({ row[0], { record->first, std::stoull(row[2]), std::stoull(row[3]) } });
+			}
+		}
+
+		if (chunk->rows.size() < static_cast<size_t>(compact_chunk_rows))
+		{
+			break;
+		}
+		cursor = chunk->rows.back()[0];
+	}
+
+	int32_t compacted = 0;
+	for (const auto& [pack_id, records] : candidates)
+	{
+		uint64_t live = 0;
+		for (const auto& record : records)
+		{
+			live += record.location.length;
+		}
+
+		auto size = pack_store_.pack_size(pack_id);
+		if (size == 0 || static_cast<double>(live) / static_cast<double>(size) >= sqlite_config_.pack_compact_live_ratio)
+		{
+			continue;
+		}
+
+		auto [relocated, relocate_error] = relocate_pack(pack_id, records);
+		if (!relocated)
+		{
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Error,
+				std::format("Failed to compact pack {}: {}", pack_id, relocate_error.value_or("unknown"))
+			);
+			continue;
+		}
+
+		auto [removed, remove_error] = pack_store_.remove(pack_id);
+		if (!removed)
+		{
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Error,
+				std::format("Failed to remove compacted pack {}: {}", pack_id, remove_error.value_or("unknown"))
+			);
+			continue;
+		}
+		compacted++;
+	}
+
+	if (compacted > 0)
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Information,
+			std::format("Pack compaction completed: {} packs rewritten", compacted)
+		);
+	}
+
+	return { compacted, std::nullopt };
+}
+
+auto HybridAdapter::relocate_pack(const uint32_t& pack_id, const std::vector<PackRecord>& records)
+	-> std::tuple<bool, std::optional<std::string>>
+{
+	// Copies are read and appended without db_mutex_. Each one is pinned, so its pack cannot be compacted away before
+	// the row pointing at it commits; the pins are dropped once the rows are updated or the copy is abandoned.
+	std::vector<PackRecord> copies;
+	auto release_copies = [this, &copies]() {
+		for (const auto& copy : copies)
+		{
+			pack_store_.release(copy.location.pack_id);
+		}
+	};
+
+	std::set<uint32_t> destinations;
+	for (const auto& record : records)
+	{
+		auto [content, read_error] = pack_store_.read(record.location);
+		if (!content.has_value())
+		{
+			release_copies();
+			return { false, read_error };
+		}
+
+		auto [location, append_error] = pack_store_.append(content.value(), false, true);
+		if (!location.has_value())
+		{
+			release_copies();
+			return { false, append_error };
+		}
+
+		copies.push_back({ record.key, location.value() });
+		destinations.insert(location->pack_id);
+	}
+
+	// The source pack is deleted once the rows move, so the copies must be on disk first whatever sync_payloads says
+	for (const auto& destination : destinations)
+	{
+		auto [synced, sync_error] = pack_store_.sync(destination);
+		if (!synced)
+		{
+			release_copies();
+			return { false, sync_error };
+		}
+	}
+
+	// A row only moves while it still points at the record that was copied; one deleted meanwhile leaves its copy as
+	// dead bytes for a later pass
+	for (size_t first = 0; first < copies.size(); first += static_cast<size_t>(compact_chunk_rows))
+	{
+		auto last = std::min(copies.size(), first + static_cast<size_t>(compact_chunk_rows));
+
+		std::lock_guard<std::mutex> lock(db_mutex_);
+
+		if (!is_open_)
+		{
+			release_copies();
+			return { false, "adapter not open" };
+		}
+
+		auto [tx_ok, tx_error] = db_.begin_transaction();
+		if (!tx_ok)
+		{
+			release_copies();
+			return { false, tx_error };
+		}
+
+		for (size_t index = first; index < last; ++index)
+		{
+			std::string update_kv = std::format(
+				"UPDATE {} SET value = json_set(value, '$.packId', {}, '$.packOffset', {}, '$.packLength', {}) "
+				"WHERE key = '{}' AND json_extract(value, '$.packId') = {} AND json_extract(value, '$.packOffset') = {}",
+				sqlite_config_.kv_table,
+				copies[index].location.pack_id,
+				copies[index].location.offset,
+				copies[index].location.length,
+				copies[index].key,
+				pack_id,
+				records[index].location.offset
+			);
+
+			auto [update_ok, update_error] = db_.execute(update_kv);
+			if (!update_ok)
+			{
+				db_.rollback();
+				release_copies();
+				return { false, update_error };
+			}
+		}
+
+		auto [committed, commit_error] = db_.commit();
+		if (!committed)
+		{
+			release_copies();
+			return { false, commit_error };
+		}
+	}
+
+	release_copies();
+	return { true, std::nullopt };
+}
+
+auto HybridAdapter::compactor_loop(void) -> void
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(compactor_mutex_);
+			compactor_condition_.wait_for(lock, std::chrono::milliseconds(sqlite_config_.pack_compact_interval_ms),
+				[this]() { return compactor_stop_; });
+			if (compactor_stop_)
+			{
+				return;
+			}
+		}
+
+		compact_payload_packs();
+	}
+}
+
+auto HybridAdapter::flush_reclaimer(void) -> void
+{
+	reclaimer_.flush();
+}
+
+auto HybridAdapter::resume_reclaim(void) -> void
+{
+	auto [pending, pending_error] = db_.query("SELECT message_key, source_path, target_path FROM payload_reclaim");
+	if (!pending.has_value() || pending->rows.empty())
+	{
+		return;
+	}
+
+	std::vector<std::string> completed;
+	for (const auto& row : pending->rows)
+	{
+		if (row.size() < 3)
+		{
+			continue;
+		}
+
+		if (reclaim_config_.deferred)
+		{
+			reclaimer_.schedule(row[0], { Utilities::IoOperationTypes::Rename, row[1], row[2] });
+			continue;
+		}
+
+		std::error_code ec;
+		auto [moved, move_error] = Utilities::IoEngine::handle().rename(row[1], row[2]);
+		if (moved || !std::filesystem::exists(row[1], ec))
+		{
+			completed.push_back(row[0]);
+		}
+	}
+
+	delete_reclaim_rows(completed);
+
+	Utilities::Logger::handle().write(
+		Utilities::LogTypes::Information,
+		std::format("Resumed {} deferred payload moves", pending->rows.size())
+	);
+}
+
+auto HybridAdapter::finish_reclaim(const std::vector<std::string>& message_keys) -> void
+{
+	std::lock_guard<std::mutex> lock(db_mutex_);
+
+	if (!is_open_)
+	{
+		return;
+	}
+
+	delete_reclaim_rows(message_keys);
+}
+
+auto HybridAdapter::delete_reclaim_rows(const std::vector<std::string>& message_keys) -> void
+{
+	if (message_keys.empty())
+	{
+		return;
+	}
+
+	std::string keys;
+	for (const auto& message_key : message_keys)
+	{
+		keys += std::format("{}'{}'", keys.empty() ? "" : ", ", message_key);
+	}
+
+	db_.execute(std::format("DELETE FROM payload_reclaim WHERE message_key IN ({})", keys));
+}
+
+auto HybridAdapter::atomic_write(const std::string& target_path, const std::string& content, const bool& sync)
+	-> std::tuple<bool, std::optional<std::string>>
+{
+	return Utilities::IoEngine::handle().atomic_write(target_path, content, sync);
+}
+
+auto HybridAdapter::current_time_ms(void) -> int64_t
+{
+	return current_time_ms_helper();
+}
+
+auto HybridAdapter::extract_message_id_from_key(const std::string& message_key) -> std::string
+{
+	auto pos = message_key.rfind(':');
+	if (pos == std::string::npos)
+	{
+		return message_key;
+	}
+	return message_key.substr(pos + 1);
+}
+
+auto HybridAdapter::extract_queue_from_key(const std::string& message_key) -> std::string
+{
+	auto first = message_key.find(':');
+	if (first == std::string::npos)
+	{
+		return "";
+	}
+
+	auto second = message_key.find(':', first + 1);
+	if (second == std::string::npos)
+	{
+		return "";
+	}
+
+	return message_key.substr(first + 1, second - first - 1);
+}
+
+auto HybridAdapter::list_dlq_messages(const std::string& queue, int32_t limit)
+	-> std::tuple<std::vector<DlqMessageInfo>, std::optional<std::string>>
+{
+	std::lock_guard<std::mutex> lock(db_mutex_);
+
+	std::vector<DlqMessageInfo> dlq_list;
+
+	if (!is_open_)
+	{
+		return { dlq_list, "adapter not open" };
+	}
+
+	std::string sql = std::format(
+		"SELECT message_key, queue, dlq_reason, dlq_at, attempt FROM {} "
+		"WHERE queue = '{}' AND state = 'dlq' ORDER BY dlq_at DESC LIMIT {}",
+		sqlite_config_.message_index_table,
+		queue,
+		limit
+	);
+
+	auto [result, error] = db_.query(sql);
+	if (!result.has_value())
+	{
+		return { dlq_list, error };
+	}
+
+	for (const auto& row : result->rows)
+	{
+		if (row.size() < 5)
+		{
+			continue;
+		}
+
+		DlqMessageInfo info;
+		info.message_key = row[0];
+		info.queue = row[1];
+		info.reason = row[2];
+		info.dlq_at_ms = row[3].empty() ? 0 : std::stoll(row[3]);
+		info.attempt = row[4].empty() ? 0 : std::stoi(row[4]);
+		dlq_list.push_back(info);
+	}
+
+	return { dlq_list, std::nullopt };
+}
+
+auto HybridAdapter::reprocess_dlq_message(const std::string& message_key)
+	-> std::tuple<bool, std::optional<std::string>>
+{
+	std::lock_guard<std::mutex> lock(db_mutex_);
+
+	if (!is_open_)
+	{
+		return { false, "adapter not open" };
+	}
+
+	auto [tx_ok, tx_error] = db_.begin_transaction();
+	if (!tx_ok)
+	{
+		return { false, tx_error };
+	}
+
+	auto now = current_time_ms();
+
+	// Get queue info first
+	std::string check_sql = std::format(
+		"SELECT queue FROM {} WHERE message_key = '{}' AND state = 'dlq'",
+		sqlite_config_.message_index_table,
+		message_key
+	);
+
+	auto [check_result, check_error] = db_.query(check_sql);
+	if (!check_result.has_value() || check_result->rows.empty())
+	{
+		db_.rollback();
+		return { false, "DLQ message not found" };
+	}
+
+	std::string queue = check_result->rows[0][0];
 
 	// Reset state to ready
 	std::string update_idx = std::format(
@@ -1233,7 +1921,7 @@ auto HybridAdapter::reprocess_dlq_message(const std::string& message_key)
 		std::error_code ec;
 		if (std::filesystem::exists(dlq_path, ec))
 		{
-			std::filesystem::rename(dlq_path, active_path, ec);
+			Utilities::IoEngine::handle().rename(dlq_path, active_path);
 		}
 	}
 
@@ -1261,281 +1949,626 @@ auto HybridAdapter::get_all_queues(void) -> std::vector<std::string>
 		}
 	}
 
-	// Also check filesystem for queues
-	std::error_code ec;
-	if (std::filesystem::exists(payload_root_, ec))
+	// Also check filesystem for queues
+	std::error_code ec;
+	if (std::filesystem::exists(payload_root_, ec))
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(payload_root_, ec))
+		{
+			if (entry.is_directory())
+			{
+				std::string queue_name = entry.path().filename().string();
+				if (std::find(queues.begin(), queues.end(), queue_name) == queues.end())
+				{
+					queues.push_back(queue_name);
+				}
+			}
+		}
+	}
+
+	return queues;
+}
+
+auto HybridAdapter::list_payload_files(const std::string& queue, const std::string& subdir)
+	-> std::tuple<std::vector<std::string>, std::optional<std::string>>
+{
+	std::vector<std::string> message_ids;
+
+	std::string dir_path = std::format("{}/{}/{}", payload_root_, queue, subdir);
+
+	std::error_code ec;
+	if (!std::filesystem::exists(dir_path, ec))
+	{
+		return { message_ids, std::nullopt };
+	}
+
+	for (const auto& entry : std::filesystem::directory_iterator(dir_path, ec))
+	{
+		if (entry.is_regular_file())
+		{
+			std::string filename = entry.path().filename().string();
+			// Remove .json extension
+			if (filename.size() > 5 && filename.substr(filename.size() - 5) == ".json")
+			{
+				message_ids.push_back(filename.substr(0, filename.size() - 5));
+			}
+		}
+	}
+
+	return { message_ids, std::nullopt };
+}
+
+auto HybridAdapter::check_consistency(const std::string& queue)
+	-> std::tuple<ConsistencyReport, std::optional<std::string>>
+{
+	std::lock_guard<std::mutex> consistency_lock(consistency_mutex_);
+
+	ConsistencyReport report;
+
+	std::vector<std::string> queues_to_check;
+	{
+		std::lock_guard<std::mutex> lock(db_mutex_);
+
+		if (!is_open_)
+		{
+			return { report, "adapter not open" };
+		}
+
+		if (queue.empty())
+		{
+			queues_to_check = get_all_queues();
+		}
+		else
+		{
+			queues_to_check.push_back(queue);
+		}
+	}
+
+	// Only a pass over every queue sees every stored payload, so only that one can retire dictionaries
+	if (queue.empty())
+	{
+		begin_dictionary_audit();
+	}
+
+	// Walk each queue in key ranges so the database lock is only held per range
+	for (const auto& q : queues_to_check)
 	{
-		for (const auto& entry : std::filesystem::directory_iterator(payload_root_, ec))
+		auto snapshot = take_consistency_snapshot(q);
+
+		std::optional<std::string> cursor = "";
+		while (cursor.has_value())
 		{
-			if (entry.is_directory())
-			{
-				std::string queue_name = entry.path().filename().string();
-				if (std::find(queues.begin(), queues.end(), queue_name) == queues.end())
-				{
-					queues.push_back(queue_name);
-				}
-			}
+			auto [next, checked] = check_consistency_range(snapshot, cursor.value(), consistency_range_keys, report);
+			cursor = next;
 		}
 	}
 
-	return queues;
+	if (queue.empty())
+	{
+		finish_dictionary_audit();
+	}
+
+	Utilities::Logger::handle().write(
+		Utilities::LogTypes::Information,
+		std::format("Consistency check completed: {} orphan payloads, {} missing payloads, {} stale archives",
+			report.orphan_payloads, report.missing_payloads, report.stale_archives)
+	);
+
+	return { report, std::nullopt };
 }
 
-auto HybridAdapter::list_payload_files(const std::string& queue, const std::string& subdir)
-	-> std::tuple<std::vector<std::string>, std::optional<std::string>>
+auto HybridAdapter::check_consistency_slice(const int32_t& max_keys)
+	-> std::tuple<ConsistencySlice, std::optional<std::string>>
 {
-	std::vector<std::string> message_ids;
+	std::lock_guard<std::mutex> consistency_lock(consistency_mutex_);
 
-	std::string dir_path = std::format("{}/{}/{}", payload_root_, queue, subdir);
+	ConsistencySlice slice;
 
-	std::error_code ec;
-	if (!std::filesystem::exists(dir_path, ec))
+	std::vector<std::string> queues;
+	std::string cursor_queue;
+	std::string after_id;
 	{
-		return { message_ids, std::nullopt };
-	}
+		std::lock_guard<std::mutex> lock(db_mutex_);
 
-	for (const auto& entry : std::filesystem::directory_iterator(dir_path, ec))
-	{
-		if (entry.is_regular_file())
+		if (!is_open_)
 		{
-			std::string filename = entry.path().filename().string();
-			// Remove .json extension
-			if (filename.size() > 5 && filename.substr(filename.size() - 5) == ".json")
-			{
-				message_ids.push_back(filename.substr(0, filename.size() - 5));
-			}
+			return { slice, "adapter not open" };
 		}
+
+		queues = get_all_queues();
+		std::tie(cursor_queue, after_id) = load_consistency_cursor();
 	}
 
-	return { message_ids, std::nullopt };
-}
+	std::sort(queues.begin(), queues.end());
+	if (queues.empty())
+	{
+		slice.pass_completed = true;
+		return { slice, std::nullopt };
+	}
 
-auto HybridAdapter::get_indexed_message_ids(const std::string& queue, const std::string& state)
-	-> std::tuple<std::vector<std::string>, std::optional<std::string>>
-{
-	std::vector<std::string> message_ids;
+	// A pass starts with an empty cursor; one resumed after a restart has missed keys and leaves the dictionaries alone
+	if (cursor_queue.empty() && after_id.empty())
+	{
+		begin_dictionary_audit();
+	}
 
-	std::string sql;
-	if (state.empty())
+	// Resume at the cursor queue; if it is gone, start the next queue from its first key
+	auto current = std::lower_bound(queues.begin(), queues.end(), cursor_queue);
+	if (current == queues.end() || *current != cursor_queue)
 	{
-		sql = std::format(
-			"SELECT message_key FROM {} WHERE queue = '{}'",
-			sqlite_config_.message_index_table,
-			queue
-		);
+		after_id.clear();
 	}
-	else
+	if (current == queues.end())
 	{
-		sql = std::format(
-			"SELECT message_key FROM {} WHERE queue = '{}' AND state = '{}'",
-			sqlite_config_.message_index_table,
-			queue,
-			state
-		);
+		current = queues.begin();
 	}
 
-	auto [result, error] = db_.query(sql);
-	if (!result.has_value())
+	slice.queue = *current;
+	if (consistency_snapshot_.queue != slice.queue || after_id.empty())
 	{
-		return { message_ids, error };
+		consistency_snapshot_ = take_consistency_snapshot(slice.queue);
 	}
 
-	for (const auto& row : result->rows)
+	auto [next, checked] = check_consistency_range(consistency_snapshot_, after_id, max_keys, slice.report);
+	slice.checked_keys = checked;
+
+	std::string next_queue = slice.queue;
+	std::string next_after = next.value_or("");
+	if (!next.has_value())
 	{
-		if (!row.empty() && !row[0].empty())
+		consistency_snapshot_ = ConsistencySnapshot{};
+
+		auto following = std::next(current);
+		slice.pass_completed = following == queues.end();
+		next_queue = slice.pass_completed ? "" : *following;
+
+		if (slice.pass_completed)
 		{
-			// Extract message_id from message_key (format: msg:queue:message_id)
-			auto message_id = extract_message_id_from_key(row[0]);
-			message_ids.push_back(message_id);
+			finish_dictionary_audit();
 		}
 	}
 
-	return { message_ids, std::nullopt };
+	std::lock_guard<std::mutex> lock(db_mutex_);
+	if (is_open_)
+	{
+		save_consistency_cursor(next_queue, next_after);
+	}
+
+	return { slice, std::nullopt };
 }
 
-auto HybridAdapter::check_consistency(const std::string& queue)
-	-> std::tuple<ConsistencyReport, std::optional<std::string>>
+auto HybridAdapter::take_consistency_snapshot(const std::string& queue) -> ConsistencySnapshot
 {
-	std::lock_guard<std::mutex> lock(db_mutex_);
+	ConsistencySnapshot snapshot;
+	snapshot.queue = queue;
 
-	ConsistencyReport report;
+	std::tie(snapshot.active, std::ignore) = list_payload_files(queue, "active");
+	std::tie(snapshot.dlq, std::ignore) = list_payload_files(queue, "dlq");
+	std::tie(snapshot.archive, std::ignore) = list_payload_files(queue, "archive");
 
-	if (!is_open_)
-	{
-		return { report, "adapter not open" };
-	}
+	std::sort(snapshot.active.begin(), snapshot.active.end());
+	std::sort(snapshot.dlq.begin(), snapshot.dlq.end());
+	std::sort(snapshot.archive.begin(), snapshot.archive.end());
 
-	std::vector<std::string> queues_to_check;
-	if (queue.empty())
+	return snapshot;
+}
+
+auto HybridAdapter::check_consistency_range(const ConsistencySnapshot& snapshot, const std::string& after_id,
+	const int32_t& max_keys, ConsistencyReport& report) -> std::tuple<std::optional<std::string>, int32_t>
+{
+	const auto& q = snapshot.queue;
+	auto limit = static_cast<size_t>(std::max(max_keys, 1));
+	auto key_prefix = std::format("msg:{}:", q);
+
+	auto past_cursor = [&after_id](const std::vector<std::string>& ids) {
+		return after_id.empty() ? ids.begin() : std::upper_bound(ids.begin(), ids.end(), after_id);
+	};
+
+	// The range ends at the limit-th key past the cursor, counting both files and index rows
+	std::vector<std::string> file_ids;
+	for (const auto* ids : { &snapshot.active, &snapshot.dlq, &snapshot.archive })
 	{
-		queues_to_check = get_all_queues();
+		auto begin = past_cursor(*ids);
+		file_ids.insert(file_ids.end(), begin, begin + std::min<size_t>(limit, std::distance(begin, ids->end())));
 	}
-	else
+	std::sort(file_ids.begin(), file_ids.end());
+	file_ids.erase(std::unique(file_ids.begin(), file_ids.end()), file_ids.end());
+
+	std::optional<std::string> upper;
+	if (file_ids.size() >= limit)
 	{
-		queues_to_check.push_back(queue);
+		upper = file_ids[limit - 1];
 	}
 
-	for (const auto& q : queues_to_check)
+	std::vector<std::vector<std::string>> rows;
+	std::vector<std::string> reclaim_keys;
+	std::vector<std::string> enqueuing_ids;
 	{
-		// Get indexed messages (ready, inflight, delayed states have payload in active/)
-		auto [indexed_active, idx_error] = get_indexed_message_ids(q, "");
-		if (idx_error.has_value())
+		std::lock_guard<std::mutex> lock(db_mutex_);
+
+		if (!is_open_)
 		{
-			Utilities::Logger::handle().write(
-				Utilities::LogTypes::Error,
-				std::format("Failed to get indexed messages for queue {}: {}", q, idx_error.value())
-			);
-			continue;
+			return { std::nullopt, 0 };
+		}
+
+		// Taken before the index query: a listed file whose enqueue is not in flight here has already committed its row
+		{
+			std::lock_guard<std::mutex> enqueuing_lock(enqueuing_mutex_);
+			for (auto key = enqueuing_keys_.lower_bound(key_prefix); key != enqueuing_keys_.end() && key->starts_with(key_prefix); ++key)
+			{
+				enqueuing_ids.push_back(key->substr(key_prefix.size()));
+			}
 		}
 
-		// Filter by state: ready, inflight, delayed should have payload in active/
-		std::string active_sql = std::format(
-			"SELECT message_key FROM {} WHERE queue = '{}' AND state IN ('ready', 'inflight', 'delayed')",
+		std::string upper_clause = upper.has_value() ? std::format(" AND m.message_key <= '{}{}'", key_prefix, upper.value()) : "";
+		std::string index_sql = std::format(
+			"SELECT m.message_key, m.state, {}, "
+			"CASE WHEN json_extract(k.value, '$.packId') IS NOT NULL OR json_extract(k.value, '$.inline') THEN k.value ELSE '' END "
+			"FROM {} m LEFT JOIN {} k ON k.key = m.message_key "
+			"WHERE m.queue = '{}' AND m.message_key > '{}{}'{} ORDER BY m.message_key LIMIT {}",
+			placement_column,
 			sqlite_config_.message_index_table,
-			q
+			sqlite_config_.kv_table,
+			q,
+			key_prefix,
+			after_id,
+			upper_clause,
+			limit
 		);
 
-		auto [active_result, active_error] = db_.query(active_sql);
-		std::vector<std::string> indexed_active_ids;
-		if (active_result.has_value())
+		auto [index_result, index_error] = db_.query(index_sql);
+		if (index_result.has_value())
+		{
+			rows = index_result->rows;
+		}
+
+		if (rows.size() >= limit)
 		{
-			for (const auto& row : active_result->rows)
+			auto last_id = extract_message_id_from_key(rows.back()[0]);
+			if (!upper.has_value() || last_id < upper.value())
 			{
-				if (!row.empty())
-				{
-					indexed_active_ids.push_back(extract_message_id_from_key(row[0]));
-				}
+				upper = last_id;
 			}
 		}
 
-		// Get DLQ indexed messages
-		std::string dlq_sql = std::format(
-			"SELECT message_key FROM {} WHERE queue = '{}' AND state = 'dlq'",
-			sqlite_config_.message_index_table,
-			q
+		// Acked payloads waiting on the reclaimer are still in active/ but are not orphans
+		std::string reclaim_sql = std::format(
+			"SELECT message_key FROM payload_reclaim WHERE message_key > '{}{}'{}",
+			key_prefix,
+			after_id,
+			upper.has_value() ? std::format(" AND message_key <= '{}{}'", key_prefix, upper.value()) : ""
 		);
 
-		auto [dlq_result, dlq_error] = db_.query(dlq_sql);
-		std::vector<std::string> indexed_dlq_ids;
-		if (dlq_result.has_value())
+		auto [reclaim_result, reclaim_error] = db_.query(reclaim_sql);
+		if (reclaim_result.has_value())
 		{
-			for (const auto& row : dlq_result->rows)
+			for (const auto& row : reclaim_result->rows)
 			{
-				if (!row.empty())
+				if (!row.empty() && row[0].starts_with(key_prefix))
 				{
-					indexed_dlq_ids.push_back(extract_message_id_from_key(row[0]));
+					reclaim_keys.push_back(extract_message_id_from_key(row[0]));
 				}
 			}
 		}
+	}
+
+	auto in_range = [&](const std::vector<std::string>& ids) {
+		auto begin = past_cursor(ids);
+		auto end = upper.has_value() ? std::upper_bound(begin, ids.end(), upper.value()) : ids.end();
+		return std::vector<std::string>(begin, end);
+	};
 
-		// Get actual payload files
-		auto [active_files, active_files_error] = list_payload_files(q, "active");
-		auto [dlq_files, dlq_files_error] = list_payload_files(q, "dlq");
-		auto [archive_files, archive_files_error] = list_payload_files(q, "archive");
+	auto active_files = in_range(snapshot.active);
+	auto dlq_files = in_range(snapshot.dlq);
+	auto archive_files = in_range(snapshot.archive);
 
-		// Check for orphan payloads in active/ (file exists but no index)
-		for (const auto& file_id : active_files)
+	std::vector<std::string> indexed_active_ids;
+	std::vector<std::string> indexed_dlq_ids;
+	std::vector<std::string> checked_ids = file_ids;
+	for (const auto& row : rows)
+	{
+		if (row.size() < 4)
 		{
-			if (std::find(indexed_active_ids.begin(), indexed_active_ids.end(), file_id) == indexed_active_ids.end())
-			{
-				ConsistencyIssue issue;
-				issue.type = ConsistencyIssueType::OrphanPayload;
-				issue.queue = q;
-				issue.message_key = std::format("msg:{}:{}", q, file_id);
-				issue.payload_path = build_payload_path(q, file_id);
-				issue.description = std::format("Orphan payload in active/: {}", file_id);
-				report.issues.push_back(issue);
-				report.orphan_payloads++;
-			}
+			continue;
 		}
 
-		// Check for orphan payloads in dlq/ (file exists but no index)
-		for (const auto& file_id : dlq_files)
+		auto message_id = extract_message_id_from_key(row[0]);
+		checked_ids.push_back(message_id);
+
+		auto placement = parse_placement(row[2]);
+		if (placement == PayloadPlacement::File)
 		{
-			if (std::find(indexed_dlq_ids.begin(), indexed_dlq_ids.end(), file_id) == indexed_dlq_ids.end())
+			// Ready, inflight and delayed messages keep their payload in active/
+			if (row[1] == "ready" || row[1] == "inflight" || row[1] == "delayed")
 			{
-				ConsistencyIssue issue;
-				issue.type = ConsistencyIssueType::OrphanPayload;
-				issue.queue = q;
-				issue.message_key = std::format("msg:{}:{}", q, file_id);
-				issue.payload_path = build_dlq_path(q, file_id);
-				issue.description = std::format("Orphan payload in dlq/: {}", file_id);
-				report.issues.push_back(issue);
-				report.orphan_payloads++;
+				indexed_active_ids.push_back(message_id);
+			}
+			else if (row[1] == "dlq")
+			{
+				indexed_dlq_ids.push_back(message_id);
 			}
+			continue;
 		}
 
-		// Check for missing payloads (index exists but no file)
-		for (const auto& idx_id : indexed_active_ids)
+		// Check packed payloads point inside an existing pack
+		if (placement != PayloadPlacement::Pack || row[1] == "archived")
 		{
-			if (std::find(active_files.begin(), active_files.end(), idx_id) == active_files.end())
-			{
-				ConsistencyIssue issue;
-				issue.type = ConsistencyIssueType::MissingPayload;
-				issue.queue = q;
-				issue.message_key = std::format("msg:{}:{}", q, idx_id);
-				issue.payload_path = build_payload_path(q, idx_id);
-				issue.description = std::format("Missing payload for indexed message: {}", idx_id);
-				report.issues.push_back(issue);
-				report.missing_payloads++;
-			}
+			continue;
+		}
+
+		auto location = pack_location(json::parse(row[3], nullptr, false));
+		if (location.offset + location.length <= pack_store_.pack_size(location.pack_id))
+		{
+			continue;
+		}
+
+		ConsistencyIssue issue;
+		issue.type = ConsistencyIssueType::MissingPayload;
+		issue.queue = q;
+		issue.message_key = row[0];
+		issue.payload_path = pack_store_.build_pack_path(location.pack_id);
+		issue.description = std::format("Missing packed payload for indexed message: {}", message_id);
+		report.issues.push_back(issue);
+		report.missing_payloads++;
+	}
+
+	if (codec_.audits_dictionaries(q))
+	{
+		note_dictionary_uses(q, rows);
+	}
+
+	std::sort(checked_ids.begin(), checked_ids.end());
+	checked_ids.erase(std::unique(checked_ids.begin(), checked_ids.end()), checked_ids.end());
+	if (upper.has_value())
+	{
+		checked_ids.erase(std::upper_bound(checked_ids.begin(), checked_ids.end(), upper.value()), checked_ids.end());
+	}
+
+	// File ranges come from the sorted snapshot; the id lists are sorted so every lookup is a binary search
+	std::sort(indexed_active_ids.begin(), indexed_active_ids.end());
+	std::sort(indexed_dlq_ids.begin(), indexed_dlq_ids.end());
+	std::sort(reclaim_keys.begin(), reclaim_keys.end());
+
+	// The file listing predates the index query, so candidates are confirmed against the filesystem
+	auto contains = [](const std::vector<std::string>& ids, const std::string& id) {
+		return std::binary_search(ids.begin(), ids.end(), id);
+	};
+	auto exists = [](const std::string& path) {
+		std::error_code ec;
+		return std::filesystem::exists(path, ec);
+	};
+
+	// Check for orphan payloads in active/ (file exists but no index); an enqueue writes the file before its index row
+	for (const auto& file_id : active_files)
+	{
+		if (contains(indexed_active_ids, file_id) || contains(reclaim_keys, file_id) || contains(enqueuing_ids, file_id)
+			|| !exists(build_payload_path(q, file_id)))
+		{
+			continue;
+		}
+
+		ConsistencyIssue issue;
+		issue.type = ConsistencyIssueType::OrphanPayload;
+		issue.queue = q;
+		issue.message_key = std::format("msg:{}:{}", q, file_id);
+		issue.payload_path = build_payload_path(q, file_id);
+		issue.description = std::format("Orphan payload in active/: {}", file_id);
+		report.issues.push_back(issue);
+		report.orphan_payloads++;
+	}
+
+	// Check for orphan payloads in dlq/ (file exists but no index)
+	for (const auto& file_id : dlq_files)
+	{
+		if (contains(indexed_dlq_ids, file_id) || !exists(build_dlq_path(q, file_id)))
+		{
+			continue;
+		}
+
+		ConsistencyIssue issue;
+		issue.type = ConsistencyIssueType::OrphanPayload;
+		issue.queue = q;
+		issue.message_key = std::format("msg:{}:{}", q, file_id);
+		issue.payload_path = build_dlq_path(q, file_id);
+		issue.description = std::format("Orphan payload in dlq/: {}", file_id);
+		report.issues.push_back(issue);
+		report.orphan_payloads++;
+	}
+
+	// Check for missing payloads (index exists but no file)
+	for (const auto& idx_id : indexed_active_ids)
+	{
+		if (contains(active_files, idx_id) || exists(build_payload_path(q, idx_id)))
+		{
+			continue;
 		}
 
-		for (const auto& idx_id : indexed_dlq_ids)
+		ConsistencyIssue issue;
+		issue.type = ConsistencyIssueType::MissingPayload;
+		issue.queue = q;
+		issue.message_key = std::format("msg:{}:{}", q, idx_id);
+		issue.payload_path = build_payload_path(q, idx_id);
+		issue.description = std::format("Missing payload for indexed message: {}", idx_id);
+		report.issues.push_back(issue);
+		report.missing_payloads++;
+	}
+
+	for (const auto& idx_id : indexed_dlq_ids)
+	{
+		if (contains(dlq_files, idx_id) || exists(build_dlq_path(q, idx_id)))
+		{
+			continue;
+		}
+
+		ConsistencyIssue issue;
+		issue.type = ConsistencyIssueType::MissingPayload;
+		issue.queue = q;
+		issue.message_key = std::format("msg:{}:{}", q, idx_id);
+		issue.payload_path = build_dlq_path(q, idx_id);
+		issue.description = std::format("Missing DLQ payload for indexed message: {}", idx_id);
+		report.issues.push_back(issue);
+		report.missing_payloads++;
+	}
+
+	// Check for stale archives (older than retention period, e.g., 7 days)
+	auto now = current_time_ms();
+	auto retention_ms = archive_retention_ms;
+
+	for (const auto& archive_id : archive_files)
+	{
+		auto archive_path = build_archive_path(q, archive_id);
+
+		std::error_code ec;
+		auto last_write = std::filesystem::last_write_time(archive_path, ec);
+		if (!ec)
 		{
-			if (std::find(dlq_files.begin(), dlq_files.end(), idx_id) == dlq_files.end())
+			auto file_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+				last_write.time_since_epoch()
+			).count();
+
+			// Convert to comparable time (approximate since different clocks)
+			auto age_ms = now - file_time;
+			if (age_ms > retention_ms)
 			{
 				ConsistencyIssue issue;
-				issue.type = ConsistencyIssueType::MissingPayload;
+				issue.type = ConsistencyIssueType::StaleArchive;
 				issue.queue = q;
-				issue.message_key = std::format("msg:{}:{}", q, idx_id);
-				issue.payload_path = build_dlq_path(q, idx_id);
-				issue.description = std::format("Missing DLQ payload for indexed message: {}", idx_id);
+				issue.message_key = std::format("msg:{}:{}", q, archive_id);
+				issue.payload_path = archive_path;
+				issue.description = std::format("Stale archive (older than 7 days): {}", archive_id);
 				report.issues.push_back(issue);
-				report.missing_payloads++;
+				report.stale_archives++;
 			}
 		}
+	}
 
-		// Check for stale archives (older than retention period, e.g., 7 days)
-		auto now = current_time_ms();
-		auto retention_ms = static_cast<int64_t>(7 * 24 * 60 * 60 * 1000); // 7 days
+	return { upper, static_cast<int32_t>(checked_ids.size()) };
+}
+
+auto HybridAdapter::begin_dictionary_audit(void) -> void
+{
+	codec_.begin_dictionary_audit();
 
-		for (const auto& archive_id : archive_files)
+	// Taken after the audit starts: an enqueue that encoded with a retired version and is still indexing is listed here
+	std::set<std::string> enqueuing_queues;
+	{
+		std::lock_guard<std::mutex> lock(enqueuing_mutex_);
+		for (const auto& key : enqueuing_keys_)
 		{
-			auto archive_path = build_archive_path(q, archive_id);
+			enqueuing_queues.insert(extract_queue_from_key(key));
+		}
+	}
 
-			std::error_code ec;
-			auto last_write = std::filesystem::last_write_time(archive_path, ec);
-			if (!ec)
-			{
-				auto file_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-					last_write.time_since_epoch()
-				).count();
+	for (const auto& queue : enqueuing_queues)
+	{
+		codec_.note_dictionary_use(queue, std::nullopt);
+	}
+}
 
-				// Convert to comparable time (approximate since different clocks)
-				auto age_ms = now - file_time;
-				if (age_ms > retention_ms)
-				{
-					ConsistencyIssue issue;
-					issue.type = ConsistencyIssueType::StaleArchive;
-					issue.queue = q;
-					issue.message_key = std::format("msg:{}:{}", q, archive_id);
-					issue.payload_path = archive_path;
-					issue.description = std::format("Stale archive (older than 7 days): {}", archive_id);
-					report.issues.push_back(issue);
-					report.stale_archives++;
-				}
+auto HybridAdapter::note_dictionary_uses(const std::string& queue, const std::vector<std::vector<std::string>>& rows) -> void
+{
+	for (const auto& row : rows)
+	{
+		// Archived payloads are never decoded again
+		if (row.size() < 4 || row[1] == "archived")
+		{
+			continue;
+		}
+
+		auto placement = parse_placement(row[2]);
+		if (placement == PayloadPlacement::Inline)
+		{
+			codec_.note_dictionary_field(queue, json::parse(row[3], nullptr, false), "payload");
+			continue;
+		}
+
+		std::optional<std::string> header;
+		if (placement == PayloadPlacement::Pack)
+		{
+			auto location = pack_location(json::parse(row[3], nullptr, false));
+			location.length = std::min<uint64_t>(location.length, PayloadCodec::frame_header_bytes);
+			std::tie(header, std::ignore) = pack_store_.read(location);
+		}
+		else
+		{
+			auto message_id = extract_message_id_from_key(row[0]);
+			std::ifstream file(row[1] == "dlq" ? build_dlq_path(queue, message_id) : build_payload_path(queue, message_id), std::ios::binary);
+			if (file.is_open())
+			{
+				header = std::string(PayloadCodec::frame_header_bytes, '\0');
+				file.read(header->data(), static_cast<std::streamsize>(header->size()));
+				header->resize(static_cast<size_t>(file.gcount()));
 			}
 		}
+
+		// A payload gone by now may have been deleted or moved to dlq/; either way the queue keeps every version this pass
+		codec_.note_dictionary_use(queue, header);
 	}
+}
 
-	Utilities::Logger::handle().write(
-		Utilities::LogTypes::Information,
-		std::format("Consistency check completed: {} orphan payloads, {} missing payloads, {} stale archives",
-			report.orphan_payloads, report.missing_payloads, report.stale_archives)
+auto HybridAdapter::finish_dictionary_audit(void) -> void
+{
+	auto [dropped, error] = codec_.finish_dictionary_audit();
+	if (error.has_value())
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("Dictionary retention failed: {}", error.value())
+		);
+	}
+}
+
+auto HybridAdapter::is_enqueuing(const std::string& message_key) -> bool
+{
+	std::lock_guard<std::mutex> lock(enqueuing_mutex_);
+
+	return enqueuing_keys_.contains(message_key);
+}
+
+auto HybridAdapter::load_consistency_cursor(void) -> std::tuple<std::string, std::string>
+{
+	std::string cursor_sql = std::format(
+		"SELECT value FROM {} WHERE key = '{}'",
+		sqlite_config_.kv_table,
+		consistency_cursor_key
 	);
 
-	return { report, std::nullopt };
+	auto [result, error] = db_.query(cursor_sql);
+	if (!result.has_value() || result->rows.empty() || result->rows[0].empty())
+	{
+		return { "", "" };
+	}
+
+	auto cursor = json::parse(result->rows[0][0], nullptr, false);
+	if (cursor.is_discarded())
+	{
+		return { "", "" };
+	}
+
+	return { cursor.value("queue", ""), cursor.value("after", "") };
+}
+
+auto HybridAdapter::save_consistency_cursor(const std::string& queue, const std::string& after_id) -> void
+{
+	auto now = current_time_ms();
+
+	json cursor;
+	cursor["queue"] = queue;
+	cursor["after"] = after_id;
+
+	std::string upsert_sql = std::format(
+		"INSERT INTO {} (key, value, value_type, created_at, updated_at) VALUES ('{}', '{}', 'cursor', {}, {}) "
+		"ON CONFLICT(key) DO UPDATE SET value = '{}', updated_at = {}",
+		sqlite_config_.kv_table,
+		consistency_cursor_key,
+		cursor.dump(),
+		now,
+		now,
+		cursor.dump(),
+		now
+	);
+
+	db_.execute(upsert_sql);
 }
 
 auto HybridAdapter::repair_consistency(const ConsistencyReport& report)
@@ -1557,8 +2590,14 @@ auto HybridAdapter::repair_consistency(const ConsistencyReport& report)
 		{
 		case ConsistencyIssueType::OrphanPayload:
 		{
+			// db_mutex_ is held, so a key that is not being enqueued now cannot start indexing before this repair commits
+			if (is_enqueuing(issue.message_key))
+			{
+				break;
+			}
+
 			// Create index entry for orphan payload
-			std::ifstream file(issue.payload_path);
+			std::ifstream file(issue.payload_path, std::ios::binary);
 			if (file.is_open())
 			{
 				std::string content((std::istreambuf_iterator<char>(file)),
@@ -1567,7 +2606,8 @@ auto HybridAdapter::repair_consistency(const ConsistencyReport& report)
 
 				try
 				{
-					json payload_json = json::parse(content);
+					auto [decoded, decode_error] = codec_.decode(issue.queue, content);
+					json payload_json = json::parse(decoded.value_or(content));
 					std::string message_id = extract_message_id_from_key(issue.message_key);
 
 					// Create envelope in KV
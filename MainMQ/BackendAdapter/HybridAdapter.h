@@ -1,13 +1,23 @@
 #pragma once
 
 #include "BackendAdapter.h"
+#include "PayloadCodec.h"
+#include "PayloadPackStore.h"
+#include "PayloadReclaimer.h"
 
 #include "SQLite.h"
 
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <condition_variable>
 
-// Hybrid Backend: Payload stored in files, state/index in SQLite
+// Hybrid Backend: Payload stored in files or pack files (or inline in kv when small), state/index in SQLite
 class HybridAdapter : public BackendAdapter
 {
 public:
@@ -46,8 +56,39 @@ public:
 		-> std::tuple<ConsistencyReport, std::optional<std::string>> override;
 	auto repair_consistency(const ConsistencyReport& report)
 		-> std::tuple<int32_t, std::optional<std::string>> override;
+	auto check_consistency_slice(const int32_t& max_keys)
+		-> std::tuple<ConsistencySlice, std::optional<std::string>> override;
+
+	// Rewrites packs whose live ratio fell below the threshold; also run periodically in the background
+	auto compact_payload_packs(void) -> std::tuple<int32_t, std::optional<std::string>>;
+
+	// Waits for archive moves deferred by ack; close() drains them as well
+	auto flush_reclaimer(void) -> void;
 
 private:
+	enum class PayloadPlacement
+	{
+		File,
+		Inline,
+		Pack
+	};
+
+	// Sorted payload file ids of one queue, listed once per pass over that queue
+	struct ConsistencySnapshot
+	{
+		std::string queue;
+		std::vector<std::string> active;
+		std::vector<std::string> dlq;
+		std::vector<std::string> archive;
+	};
+
+	// A kv row whose payload lives in a pack, as seen by the compactor
+	struct PackRecord
+	{
+		std::string key;
+		PackLocation location;
+	};
+
 	// Database operations
 	auto apply_pragmas(void) -> std::tuple<bool, std::optional<std::string>>;
 	auto ensure_schema(void) -> std::tuple<bool, std::optional<std::string>>;
@@ -64,7 +105,23 @@ private:
 	auto move_payload_to_archive(const std::string& queue, const std::string& message_id) -> std::tuple<bool, std::optional<std::string>>;
 	auto move_payload_to_dlq(const std::string& queue, const std::string& message_id) -> std::tuple<bool, std::optional<std::string>>;
 
-	auto atomic_write(const std::string& target_path, const std::string& content) -> std::tuple<bool, std::optional<std::string>>;
+	auto remove_payload_file(const std::string& payload_path) -> void;
+	auto is_inline_payload(const MessageEnvelope& message) -> bool;
+	auto place_payload(const MessageEnvelope& message, nlohmann::json& envelope) -> std::tuple<std::string, std::optional<std::string>>;
+	auto index_message(const MessageEnvelope& message, const nlohmann::json& envelope, const std::string& payload_path)
+		-> std::tuple<bool, std::optional<std::string>>;
+	auto read_stored_payload(const std::string& message_key, const nlohmann::json& envelope)
+		-> std::tuple<std::optional<std::string>, std::optional<std::string>>;
+	auto parse_placement(const std::string& value) -> PayloadPlacement;
+	auto pack_location(const nlohmann::json& envelope) -> PackLocation;
+	auto relocate_pack(const uint32_t& pack_id, const std::vector<PackRecord>& records) -> std::tuple<bool, std::optional<std::string>>;
+	auto compactor_loop(void) -> void;
+	auto resume_reclaim(void) -> void;
+	auto finish_reclaim(const std::vector<std::string>& message_keys) -> void;
+	auto delete_reclaim_rows(const std::vector<std::string>& message_keys) -> void;
+
+	auto atomic_write(const std::string& target_path, const std::string& content, const bool& sync = false)
+		-> std::tuple<bool, std::optional<std::string>>;
 
 	// Utilities
 	auto current_time_ms(void) -> int64_t;
@@ -75,14 +132,41 @@ private:
 	auto get_all_queues(void) -> std::vector<std::string>;
 	auto list_payload_files(const std::string& queue, const std::string& subdir)
 		-> std::tuple<std::vector<std::string>, std::optional<std::string>>;
-	auto get_indexed_message_ids(const std::string& queue, const std::string& state)
-		-> std::tuple<std::vector<std::string>, std::optional<std::string>>;
+	auto take_consistency_snapshot(const std::string& queue) -> ConsistencySnapshot;
+	auto check_consistency_range(const ConsistencySnapshot& snapshot, const std::string& after_id, const int32_t& max_keys,
+		ConsistencyReport& report) -> std::tuple<std::optional<std::string>, int32_t>;
+	auto is_enqueuing(const std::string& message_key) -> bool;
+	auto begin_dictionary_audit(void) -> void;
+	auto note_dictionary_uses(const std::string& queue, const std::vector<std::vector<std::string>>& rows) -> void;
+	auto finish_dictionary_audit(void) -> void;
+	auto load_consistency_cursor(void) -> std::tuple<std::string, std::string>;
+	auto save_consistency_cursor(const std::string& queue, const std::string& after_id) -> void;
 
 private:
-	bool is_open_;
+	std::atomic<bool> is_open_;
 	std::string schema_path_;
 	std::string payload_root_;
+	std::string pack_root_;
+	std::string dictionary_root_;
 	SQLiteConfig sqlite_config_;
 	DataBase::SQLite db_;
 	mutable std::mutex db_mutex_;
+
+	PayloadPackStore pack_store_;
+	PayloadCodec codec_;
+
+	ReclaimConfig reclaim_config_;
+	PayloadReclaimer reclaimer_;
+
+	std::mutex consistency_mutex_;
+	ConsistencySnapshot consistency_snapshot_;
+
+	// Keys whose payload may be on disk before their index row commits; the consistency check leaves them alone
+	std::mutex enqueuing_mutex_;
+	std::set<std::string> enqueuing_keys_;
+
+	bool compactor_stop_;
+	std::mutex compactor_mutex_;
+	std::condition_variable compactor_condition_;
+	std::unique_ptr<std::thread> compactor_;
 };
@@ -0,0 +1,652 @@
+#include "PayloadCodec.h"
+
+#include "ByteOrder.h"
+#include "Compressor.h"
+#include "Converter.h"
+#include "IoEngine.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+using json = nlohmann::json;
+
+namespace
+{
+	// Frame: magic, block size used by the compressor, original size, [dictionary version,] LZ4 block stream; integers are little-endian
+	const std::string compressed_magic = "YMQZ";
+	const std::string dictionary_magic = "YMQD";
+	const size_t compressed_prefix = 4 + sizeof(uint32_t) * 2;
+	const size_t dictionary_prefix = compressed_prefix + sizeof(uint32_t);
+	static_assert(dictionary_prefix == PayloadCodec::frame_header_bytes);
+
+	// LZ4 only references the last 64KB of a dictionary
+	const size_t max_dictionary_bytes = 64 * 1024;
+
+	const std::vector<uint8_t> no_dictionary;
+
+	auto elapsed_us(const std::chrono::steady_clock::time_point& start) -> uint64_t
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start
+		).count());
+	}
+}
+
+PayloadCodec::PayloadCodec(void)
+{
+}
+
+PayloadCodec::~PayloadCodec(void)
+{
+}
+
+auto PayloadCodec::configure(const CompressionPolicy& defaults, const std::map<std::string, CompressionPolicy>& queues,
+							 const std::string& dictionary_root) -> std::tuple<bool, std::optional<std::string>>
+{
+	{
+		std::unique_lock<std::shared_mutex> settings_lock(settings_mutex_);
+		defaults_ = defaults;
+		queues_ = queues;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	dictionary_root_ = dictionary_root;
+	dictionaries_.clear();
+
+	return load_dictionaries();
+}
+
+auto PayloadCodec::encode(const std::string& queue, const std::string& content) -> std::string
+{
+	auto stored = compress(queue, content);
+	return stored.has_value() ? std::move(stored.value()) : content;
+}
+
+auto PayloadCodec::decode(const std::string& queue, const std::string& stored)
+	-> std::tuple<std::optional<std::string>, std::optional<std::string>>
+{
+	if (!is_compressed(stored))
+	{
+		return { stored, std::nullopt };
+	}
+
+	return decompress(queue, stored);
+}
+
+auto PayloadCodec::compress(const std::string& queue, const std::string& content) -> std::optional<std::string>
+{
+	auto current = policy(queue);
+	if (!current.enabled || content.size() < current.min_bytes || content.size() > UINT32_MAX)
+	{
+		return std::nullopt;
+	}
+
+	uint32_t version = 0;
+	std::shared_ptr<const std::vector<uint8_t>> dictionary;
+	if (current.dictionary)
+	{
+		std::tie(version, dictionary) = sample_payload(queue, current, content);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	auto [compressed, message] = Utilities::Compressor::compression(
+		std::vector<uint8_t>(content.begin(), content.end()), current.block_bytes, dictionary ? *dictionary : no_dictionary);
+	auto prefix = dictionary ? dictionary_prefix : compressed_prefix;
+	if (!compressed.has_value() || prefix + compressed->size() >= content.size())
+	{
+		return std::nullopt;
+	}
+
+	std::string stored;
+	stored.reserve(prefix + compressed->size());
+	stored.append(dictionary ? dictionary_magic : compressed_magic);
+	Utilities::ByteOrder::append_little_endian(stored, current.block_bytes);
+	Utilities::ByteOrder::append_little_endian(stored, static_cast<uint32_t>(content.size()));
+	if (dictionary)
+	{
+		Utilities::ByteOrder::append_little_endian(stored, version);
+	}
+	stored.append(compressed->begin(), compressed->end());
+
+	auto& counters = statistics(queue);
+	counters.compressed_messages.add();
+	counters.original_bytes.add(content.size());
+	counters.stored_bytes.add(stored.size());
+	counters.compress_time_us.add(elapsed_us(start));
+
+	return stored;
+}
+
+auto PayloadCodec::decompress(const std::string& queue, const std::string& stored)
+	-> std::tuple<std::optional<std::string>, std::optional<std::string>>
+{
+	if (!is_compressed(stored))
+	{
+		return { std::nullopt, "payload is flagged as compressed but has no frame header" };
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	size_t offset = compressed_magic.size();
+	uint32_t block_bytes = 0;
+	uint32_t original_bytes = 0;
+	Utilities::ByteOrder::read_little_endian(stored, offset, block_bytes);
+	Utilities::ByteOrder::read_little_endian(stored, offset, original_bytes);
+	// The frame names its own block size, which sizes the decode buffers; no valid configuration goes above the cap
+	if (block_bytes == 0 || block_bytes > CompressionPolicy::max_block_bytes)
+	{
+		return { std::nullopt, std::format("payload frame block size {} is outside 1..{}", block_bytes, CompressionPolicy::max_block_bytes) };
+	}
+
+	auto prefix = compressed_prefix;
+	std::shared_ptr<const std::vector<uint8_t>> dictionary;
+	if (stored.compare(0, dictionary_magic.size(), dictionary_magic) == 0)
+	{
+		uint32_t version = 0;
+		Utilities::ByteOrder::read_little_endian(stored, offset, version);
+		prefix = dictionary_prefix;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto& versions = dictionaries_[queue].versions;
+		auto found = versions.find(version);
+		if (found == versions.end())
+		{
+			return { std::nullopt, std::format("compression dictionary {} for queue {} not found", version, queue) };
+		}
+		dictionary = found->second;
+	}
+
+	auto [decompressed, message] = Utilities::Compressor::decompression(
+		std::vector<uint8_t>(stored.begin() + prefix, stored.end()), block_bytes, dictionary ? *dictionary : no_dictionary);
+	if (!decompressed.has_value())
+	{
+		return { std::nullopt, std::format("payload decompression failed: {}", message.value_or("unknown")) };
+	}
+	// Blocks carry no count, so a frame torn at a block boundary is only caught by the recorded size
+	if (decompressed->size() != original_bytes)
+	{
+		return { std::nullopt, std::format("payload frame decoded to {} of {} bytes", decompressed->size(), original_bytes) };
+	}
+
+	statistics(queue).decompress_time_us.add(elapsed_us(start));
+
+	return { std::string(decompressed->begin(), decompressed->end()), std::nullopt };
+}
+
+auto PayloadCodec::encode_field(const std::string& queue, const std::string& content, json& target, const std::string& field) -> void
+{
+	auto stored = compress(queue, content);
+	if (!stored.has_value())
+	{
+		target[field] = content;
+		return;
+	}
+
+	target[field] = Utilities::Converter::to_base64(std::vector<uint8_t>(stored->begin(), stored->end()));
+	target[field + "Encoding"] = "lz4";
+}
+
+auto PayloadCodec::decode_field(const std::string& queue, const json& source, const std::string& field, const std::string& fallback)
+	-> std::tuple<std::optional<std::string>, std::optional<std::string>>
+{
+	auto value = source.value(field, fallback);
+	if (source.value(field + "Encoding", "") != "lz4")
+	{
+		return { value, std::nullopt };
+	}
+
+	auto bytes = Utilities::Converter::from_base64(value);
+
+	return decompress(queue, std::string(bytes.begin(), bytes.end()));
+}
+
+auto PayloadCodec::apply_metrics(const std::string& queue, QueueMetrics& metrics) -> void
+{
+	{
+		std::shared_lock<std::shared_mutex> settings_lock(settings_mutex_);
+
+		auto statistics = statistics_.find(queue);
+		if (statistics == statistics_.end())
+		{
+			return;
+		}
+
+		const auto& counters = statistics->second;
+		metrics.compressed_messages = counters.compressed_messages.value();
+		metrics.compression_original_bytes = counters.original_bytes.value();
+		metrics.compression_stored_bytes = counters.stored_bytes.value();
+		metrics.compression_cpu_us = counters.compress_time_us.value() + counters.decompress_time_us.value();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto dictionaries = dictionaries_.find(queue);
+	if (dictionaries != dictionaries_.end() && !dictionaries->second.versions.empty())
+	{
+		metrics.compression_dictionary_version = dictionaries->second.versions.rbegin()->first;
+	}
+}
+
+auto PayloadCodec::train_dictionary(const std::string& queue) -> std::tuple<std::optional<uint32_t>, std::optional<std::string>>
+{
+	auto current = policy(queue);
+
+	std::optional<Training> training;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto [started, start_error] = begin_training_locked(queue, current);
+		if (!started.has_value())
+		{
+			return { std::nullopt, start_error };
+		}
+		training = started;
+	}
+
+	return finish_training(queue, training.value());
+}
+
+auto PayloadCodec::dictionary_version(const std::string& queue) -> uint32_t
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto dictionaries = dictionaries_.find(queue);
+	if (dictionaries == dictionaries_.end() || dictionaries->second.versions.empty())
+	{
+		return 0;
+	}
+
+	return dictionaries->second.versions.rbegin()->first;
+}
+
+auto PayloadCodec::begin_dictionary_audit(void) -> void
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// The latest version is always kept; an encode that picked an older one before begin has to be reported by the caller
+	audit_candidates_.emplace();
+	for (const auto& [queue, state] : dictionaries_)
+	{
+		if (state.versions.size() < 2)
+		{
+			continue;
+		}
+
+		auto& candidates = (*audit_candidates_)[queue];
+		for (auto version = state.versions.begin(); std::next(version) != state.versions.end(); ++version)
+		{
+			candidates.insert(version->first);
+		}
+	}
+}
+
+auto PayloadCodec::audits_dictionaries(const std::string& queue) -> bool
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (!audit_candidates_.has_value())
+	{
+		return false;
+	}
+
+	auto candidates = audit_candidates_->find(queue);
+	return candidates != audit_candidates_->end() && !candidates->second.empty();
+}
+
+auto PayloadCodec::note_dictionary_use(const std::string& queue, const std::optional<std::string>& stored) -> void
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (!audit_candidates_.has_value())
+	{
+		return;
+	}
+
+	auto candidates = audit_candidates_->find(queue);
+	if (candidates == audit_candidates_->end())
+	{
+		return;
+	}
+
+	// A payload that could not be read may use any version, so the queue keeps them all this time
+	if (!stored.has_value())
+	{
+		audit_candidates_->erase(candidates);
+		return;
+	}
+
+	if (stored->size() < dictionary_prefix || stored->compare(0, dictionary_magic.size(), dictionary_magic) != 0)
+	{
+		return;
+	}
+
+	size_t offset = compressed_prefix;
+	uint32_t version = 0;
+	Utilities::ByteOrder::read_little_endian(stored.value(), offset, version);
+	candidates->second.erase(version);
+}
+
+auto PayloadCodec::note_dictionary_field(const std::string& queue, const json& source, const std::string& field) -> void
+{
+	if (source.value(field + "Encoding", "") != "lz4")
+	{
+		return;
+	}
+
+	// 24 base64 characters decode to 18 bytes, enough for the frame header
+	auto bytes = Utilities::Converter::from_base64(source.value(field, "").substr(0, 24));
+	note_dictionary_use(queue, std::string(bytes.begin(), bytes.end()));
+}
+
+auto PayloadCodec::finish_dictionary_audit(void) -> std::tuple<int32_t, std::optional<std::string>>
+{
+	int32_t dropped = 0;
+	std::vector<std::string> paths;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (!audit_candidates_.has_value())
+		{
+			return { 0, std::nullopt };
+		}
+
+		auto candidates = std::move(audit_candidates_.value());
+		audit_candidates_.reset();
+
+		for (const auto& [queue, versions] : candidates)
+		{
+			auto& state = dictionaries_[queue];
+			for (const auto& version : versions)
+			{
+				if (state.versions.erase(version) == 0)
+				{
+					continue;
+				}
+
+				dropped++;
+				if (!dictionary_root_.empty())
+				{
+					paths.push_back(build_dictionary_path(dictionary_root_, queue, version));
+				}
+			}
+		}
+	}
+
+	// Dropped from memory first: a file that fails to unlink is only reloaded, and pruned again, after a restart
+	std::optional<std::string> error = std::nullopt;
+	for (const auto& path : paths)
+	{
+		auto [removed, remove_error] = Utilities::IoEngine::handle().unlink(path);
+		if (!removed && !error.has_value())
+		{
+			error = std::format("failed to remove dictionary {}: {}", path, remove_error.value_or("unknown"));
+		}
+	}
+
+	if (dropped > 0)
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Information,
+			std::format("dropped {} compression dictionaries no stored message uses", dropped)
+		);
+	}
+
+	return { dropped, error };
+}
+
+auto PayloadCodec::is_compressed(const std::string& stored) -> bool
+{
+	if (stored.size() > dictionary_prefix && stored.compare(0, dictionary_magic.size(), dictionary_magic) == 0)
+	{
+		return true;
+	}
+
+	return stored.size() > compressed_prefix && stored.compare(0, compressed_magic.size(), compressed_magic) == 0;
+}
+
+auto PayloadCodec::policy(const std::string& queue) -> CompressionPolicy
+{
+	std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+
+	auto found = queues_.find(queue);
+	return found == queues_.end() ? defaults_ : found->second;
+}
+
+auto PayloadCodec::statistics(const std::string& queue) -> Statistics&
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+
+		auto found = statistics_.find(queue);
+		if (found != statistics_.end())
+		{
+			return found->second;
+		}
+	}
+
+	// Map nodes never move, so the reference outlives the lock; only a queue's first payload takes it exclusively
+	std::unique_lock<std::shared_mutex> lock(settings_mutex_);
+	return statistics_.try_emplace(queue).first->second;
+}
+
+auto PayloadCodec::load_dictionaries(void) -> std::tuple<bool, std::optional<std::string>>
+{
+	if (dictionary_root_.empty())
+	{
+		return { true, std::nullopt };
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(dictionary_root_, ec);
+	if (ec)
+	{
+		return { false, std::format("failed to create dictionary directory {}: {}", dictionary_root_, ec.message()) };
+	}
+
+	for (const auto& queue_entry : std::filesystem::directory_iterator(dictionary_root_, ec))
+	{
+		if (!queue_entry.is_directory())
+		{
+			continue;
+		}
+
+		auto queue = queue_entry.path().filename().string();
+		for (const auto& entry : std::filesystem::directory_iterator(queue_entry.path(), ec))
+		{
+			if (!entry.is_regular_file() || entry.path().extension() != ".dict")
+			{
+				continue;
+			}
+
+			uint32_t version = 0;
+			try
+			{
+				version = static_cast<uint32_t>(std::stoul(entry.path().stem().string()));
+			}
+			catch (const std::exception&)
+			{
+				continue;
+			}
+
+			std::ifstream file(entry.path(), std::ios::binary);
+			std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			if (!file.good() && !file.eof())
+			{
+				return { false, std::format("failed to read dictionary {}", entry.path().string()) };
+			}
+
+			dictionaries_[queue].versions[version] = std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+		}
+	}
+
+	return { true, std::nullopt };
+}
+
+auto PayloadCodec::sample_payload(const std::string& queue, const CompressionPolicy& current, const std::string& content)
+	-> std::tuple<uint32_t, std::shared_ptr<const std::vector<uint8_t>>>
+{
+	auto sample_limit = std::max<uint32_t>(current.dictionary_samples, 1);
+
+	std::optional<Training> training;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto& state = dictionaries_[queue];
+		state.since_training++;
+
+		// Only the last sample_limit messages before a training feed it, so most encodes between trainings copy nothing
+		auto wanted = state.versions.empty()
+			|| (current.dictionary_retrain_messages > 0
+				&& state.since_training + sample_limit > current.dictionary_retrain_messages);
+		if (wanted)
+		{
+			state.samples.push_back(content.substr(0, std::min<size_t>(current.dictionary_bytes, max_dictionary_bytes)));
+			while (state.samples.size() > sample_limit)
+			{
+				state.samples.pop_front();
+			}
+		}
+
+		auto due = state.versions.empty()
+			? state.samples.size() >= sample_limit
+			: current.dictionary_retrain_messages > 0 && state.since_training >= current.dictionary_retrain_messages;
+		if (due && !state.training)
+		{
+			training = std::get<0>(begin_training_locked(queue, current));
+		}
+
+		if (!training.has_value())
+		{
+			return latest_dictionary_locked(state);
+		}
+	}
+
+	// The dictionary is written outside mutex_, other encoders keep using the previous version meanwhile
+	auto [version, error] = finish_training(queue, training.value());
+	if (!version.has_value())
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("dictionary training failed for queue {}: {}", queue, error.value_or("unknown"))
+		);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	return latest_dictionary_locked(dictionaries_[queue]);
+}
+
+auto PayloadCodec::latest_dictionary_locked(const Dictionaries& state) -> std::tuple<uint32_t, std::shared_ptr<const std::vector<uint8_t>>>
+{
+	if (state.versions.empty())
+	{
+		return { 0, nullptr };
+	}
+
+	auto latest = state.versions.rbegin();
+	return { latest->first, latest->second };
+}
+
+auto PayloadCodec::begin_training_locked(const std::string& queue, const CompressionPolicy& current)
+	-> std::tuple<std::optional<Training>, std::optional<std::string>>
+{
+	auto& state = dictionaries_[queue];
+	if (state.training)
+	{
+		return { std::nullopt, "dictionary training already in progress" };
+	}
+	if (state.samples.empty())
+	{
+		return { std::nullopt, "no samples to train from" };
+	}
+
+	// Newest samples go last, where LZ4 reaches them with the shortest match offsets
+	auto limit = std::min<size_t>(current.dictionary_bytes, max_dictionary_bytes);
+	std::string trained;
+	for (auto sample = state.samples.rbegin(); sample != state.samples.rend() && trained.size() < limit; ++sample)
+	{
+		trained.insert(0, *sample);
+	}
+	if (trained.size() > limit)
+	{
+		trained.erase(0, trained.size() - limit);
+	}
+
+	state.training = true;
+
+	Training training;
+	training.version = state.versions.empty() ? 1 : state.versions.rbegin()->first + 1;
+	training.bytes = std::make_shared<const std::vector<uint8_t>>(trained.begin(), trained.end());
+
+	return { training, std::nullopt };
+}
+
+auto PayloadCodec::finish_training(const std::string& queue, const Training& training)
+	-> std::tuple<std::optional<uint32_t>, std::optional<std::string>>
+{
+	std::string root;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		root = dictionary_root_;
+	}
+
+	auto [stored, store_error] = root.empty()
+		? std::tuple<bool, std::optional<std::string>>{ true, std::nullopt }
+		: store_dictionary(build_dictionary_path(root, queue, training.version), *training.bytes);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto& state = dictionaries_[queue];
+	state.training = false;
+	if (!stored)
+	{
+		return { std::nullopt, store_error };
+	}
+
+	state.versions[training.version] = training.bytes;
+	state.since_training = 0;
+
+	Utilities::Logger::handle().write(
+		Utilities::LogTypes::Information,
+		std::format("trained compression dictionary v{} for queue {} ({} bytes)", training.version, queue, training.bytes->size())
+	);
+
+	return { training.version, std::nullopt };
+}
+
+auto PayloadCodec::store_dictionary(const std::string& path, const std::vector<uint8_t>& bytes) -> std::tuple<bool, std::optional<std::string>>
+{
+	// Messages are encoded against this version as soon as it is installed, so it must survive a crash before they do
+	auto directory = std::filesystem::path(path).parent_path();
+
+	std::error_code ec;
+	auto created = std::filesystem::create_directories(directory, ec);
+	if (ec)
+	{
+		return { false, std::format("failed to create dictionary directory {}: {}", directory.string(), ec.message()) };
+	}
+
+	auto [written, write_error] = Utilities::IoEngine::handle().atomic_write(path, std::string(bytes.begin(), bytes.end()), true);
+	if (!written)
+	{
+		return { false, std::format("failed to store dictionary {}: {}", path, write_error.value_or("unknown")) };
+	}
+
+	auto [synced, sync_error] = Utilities::IoEngine::handle().sync_directory(directory.string());
+	if (synced && created)
+	{
+		std::tie(synced, sync_error) = Utilities::IoEngine::handle().sync_directory(directory.parent_path().string());
+	}
+
+	return { synced, sync_error };
+}
+
+auto PayloadCodec::build_dictionary_path(const std::string& root, const std::string& queue, const uint32_t& version) -> std::string
+{
+	return std::format("{}/{}/{:08}.dict", root, queue, version);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "BackendAdapter.h"
+#include "ShardedCounter.h"
+
+#include <nlohmann/json.hpp>
+
+#include <map>
+#include <set>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+// Per-queue LZ4 payload compression shared by the storage backends.
+// Compressed payloads are framed with a magic header so uncompressed data written earlier stays readable.
+// Queues with dictionary compression train a dictionary from recent payloads; every version is kept
+// under the dictionary root so messages encoded with an older one stay decodable.
+class PayloadCodec
+{
+public:
+	PayloadCodec(void);
+	~PayloadCodec(void);
+
+	auto configure(const CompressionPolicy& defaults, const std::map<std::string, CompressionPolicy>& queues,
+				   const std::string& dictionary_root = "") -> std::tuple<bool, std::optional<std::string>>;
+
+	// For containers that record whether the payload was compressed: compress returns nullopt when the payload stays raw,
+	// and decompress fails on anything that is not a frame
+	auto compress(const std::string& queue, const std::string& content) -> std::optional<std::string>;
+	auto decompress(const std::string& queue, const std::string& stored) -> std::tuple<std::optional<std::string>, std::optional<std::string>>;
+
+	// For containers with no flag: the frame magic tells the two apart, so the raw content must never start with it
+	auto encode(const std::string& queue, const std::string& content) -> std::string;
+	auto decode(const std::string& queue, const std::string& stored) -> std::tuple<std::optional<std::string>, std::optional<std::string>>;
+
+	// Text containers (JSON envelopes, kv rows) carry compressed payloads as base64 with an encoding flag
+	auto encode_field(const std::string& queue, const std::string& content, nlohmann::json& target, const std::string& field) -> void;
+	auto decode_field(const std::string& queue, const nlohmann::json& source, const std::string& field, const std::string& fallback)
+		-> std::tuple<std::optional<std::string>, std::optional<std::string>>;
+
+	auto train_dictionary(const std::string& queue) -> std::tuple<std::optional<uint32_t>, std::optional<std::string>>;
+	auto dictionary_version(const std::string& queue) -> uint32_t;
+
+	// Dictionary retention: a full pass over the stored messages reports the versions they use between begin and finish,
+	// and finish drops every version older than the latest that nobody reported. nullopt marks a use that could not be read
+	auto begin_dictionary_audit(void) -> void;
+	auto audits_dictionaries(const std::string& queue) -> bool;
+	auto note_dictionary_use(const std::string& queue, const std::optional<std::string>& stored) -> void;
+	auto note_dictionary_field(const std::string& queue, const nlohmann::json& source, const std::string& field) -> void;
+	auto finish_dictionary_audit(void) -> std::tuple<int32_t, std::optional<std::string>>;
+
+	auto apply_metrics(const std::string& queue, QueueMetrics& metrics) -> void;
+
+	static auto is_compressed(const std::string& stored) -> bool;
+
+	// Enough leading bytes of a stored payload to name its dictionary version
+	static constexpr size_t frame_header_bytes = 16;
+
+private:
+	struct Statistics
+	{
+		Utilities::ShardedCounter compressed_messages;
+		Utilities::ShardedCounter original_bytes;
+		Utilities::ShardedCounter stored_bytes;
+		Utilities::ShardedCounter compress_time_us;
+		Utilities::ShardedCounter decompress_time_us;
+	};
+
+	struct Dictionaries
+	{
+		std::map<uint32_t, std::shared_ptr<const std::vector<uint8_t>>> versions;
+		std::deque<std::string> samples;
+		uint64_t since_training = 0;
+		bool training = false;
+	};
+
+	struct Training
+	{
+		uint32_t version = 0;
+		std::shared_ptr<const std::vector<uint8_t>> bytes;
+	};
+
+	auto policy(const std::string& queue) -> CompressionPolicy;
+	auto statistics(const std::string& queue) -> Statistics&;
+	auto load_dictionaries(void) -> std::tuple<bool, std::optional<std::string>>;
+	auto sample_payload(const std::string& queue, const CompressionPolicy& current, const std::string& content)
+		-> std::tuple<uint32_t, std::shared_ptr<const std::vector<uint8_t>>>;
+	auto latest_dictionary_locked(const Dictionaries& state) -> std::tuple<uint32_t, std::shared_ptr<const std::vector<uint8_t>>>;
+	auto begin_training_locked(const std::string& queue, const CompressionPolicy& current)
+		-> std::tuple<std::optional<Training>, std::optional<std::string>>;
+	auto finish_training(const std::string& queue, const Training& training) -> std::tuple<std::optional<uint32_t>, std::optional<std::string>>;
+	auto store_dictionary(const std::string& path, const std::vector<uint8_t>& bytes) -> std::tuple<bool, std::optional<std::string>>;
+	auto build_dictionary_path(const std::string& root, const std::string& queue, const uint32_t& version) -> std::string;
+
+private:
+	// Read on every encode and decode: shared-locked, and the counters are sharded. Queues without a dictionary never
+	// take mutex_; dictionary queues hold it briefly per message to pick the dictionary version and keep a sample
+	CompressionPolicy defaults_;
+	std::map<std::string, CompressionPolicy> queues_;
+	std::map<std::string, Statistics> statistics_;
+	std::shared_mutex settings_mutex_;
+
+	std::map<std::string, Dictionaries> dictionaries_;
+	std::string dictionary_root_;
+	// Versions of each queue that no stored message has reported yet in the running audit
+	std::optional<std::map<std::string, std::set<uint32_t>>> audit_candidates_;
+	std::mutex mutex_;
+};
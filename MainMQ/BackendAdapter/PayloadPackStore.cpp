@@ -0,0 +1,366 @@
+#include "PayloadPackStore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <format>
+#include <unistd.h>
+
+PayloadPackStore::PayloadPackStore(void)
+	: max_pack_bytes_(0)
+	, active_pack_id_(0)
+{
+}
+
+PayloadPackStore::~PayloadPackStore(void)
+{
+	close();
+}
+
+auto PayloadPackStore::open(const std::string& root, const uint64_t& max_pack_bytes) -> std::tuple<bool, std::optional<std::string>>
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	root_ = root;
+	max_pack_bytes_ = max_pack_bytes;
+	active_pack_id_ = 0;
+
+	std::error_code ec;
+	std::filesystem::create_directories(root_, ec);
+	if (ec)
+	{
+		return { false, std::format("failed to create pack directory {}: {}", root_, ec.message()) };
+	}
+
+	for (const auto& entry : std::filesystem::directory_iterator(root_, ec))
+	{
+		if (!entry.is_regular_file() || entry.path().extension() != ".pack")
+		{
+			continue;
+		}
+
+		try
+		{
+			auto pack_id = static_cast<uint32_t>(std::stoul(entry.path().stem().string()));
+			sizes_[pack_id] = entry.file_size();
+			active_pack_id_ = std::max(active_pack_id_, pack_id);
+		}
+		catch (const std::exception&)
+		{
+			continue;
+		}
+	}
+
+	if (sizes_.empty())
+	{
+		active_pack_id_ = 1;
+		sizes_[active_pack_id_] = 0;
+	}
+
+	return { true, std::nullopt };
+}
+
+auto PayloadPackStore::close(void) -> void
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	for (auto& [pack_id, fd] : descriptors_)
+	{
+		::close(fd);
+	}
+
+	descriptors_.clear();
+	sizes_.clear();
+	pins_.clear();
+	in_flight_.clear();
+}
+
+auto PayloadPackStore::append(const std::string& content, const bool& sync, const bool& pin)
+	-> std::tuple<std::optional<PackLocation>, std::optional<std::string>>
+{
+	PackLocation location;
+	int fd = -1;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (sizes_[active_pack_id_] > 0 && sizes_[active_pack_id_] + content.size() > max_pack_bytes_)
+		{
+			active_pack_id_++;
+			sizes_[active_pack_id_] = 0;
+		}
+
+		auto [opened, open_error] = open_pack(active_pack_id_);
+		if (opened < 0)
+		{
+			return { std::nullopt, open_error };
+		}
+
+		// The range is reserved here, the write itself runs without the lock
+		fd = opened;
+		location.pack_id = active_pack_id_;
+		location.offset = sizes_[active_pack_id_];
+		location.length = content.size();
+
+		sizes_[active_pack_id_] += content.size();
+		in_flight_[active_pack_id_]++;
+		if (pin)
+		{
+			pins_[active_pack_id_]++;
+		}
+	}
+
+	std::optional<std::string> error = std::nullopt;
+	size_t written = 0;
+	while (written < content.size())
+	{
+		auto result = ::pwrite(fd, content.data() + written, content.size() - written, static_cast<off_t>(location.offset + written));
+		if (result < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			error = std::format("pack write failed: {}", std::strerror(errno));
+			break;
+		}
+		written += static_cast<size_t>(result);
+	}
+
+	if (!error.has_value() && sync && ::fdatasync(fd) != 0)
+	{
+		error = std::format("pack sync failed: {}", std::strerror(errno));
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	end_io(location.pack_id);
+	if (!error.has_value())
+	{
+		return { location, std::nullopt };
+	}
+
+	if (pin)
+	{
+		unpin(location.pack_id);
+	}
+
+	// Give the range back when nothing was reserved after it, otherwise it stays as dead bytes for compaction
+	auto size = sizes_.find(location.pack_id);
+	if (size != sizes_.end() && size->second == location.offset + location.length)
+	{
+		size->second = location.offset;
+		::ftruncate(fd, static_cast<off_t>(location.offset));
+	}
+
+	return { std::nullopt, error };
+}
+
+auto PayloadPackStore::release(const uint32_t& pack_id) -> void
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	unpin(pack_id);
+}
+
+auto PayloadPackStore::is_pinned(const uint32_t& pack_id) -> bool
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return pins_.contains(pack_id);
+}
+
+auto PayloadPackStore::read(const PackLocation& location) -> std::tuple<std::optional<std::string>, std::optional<std::string>>
+{
+	int fd = -1;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto size = sizes_.find(location.pack_id);
+		if (size == sizes_.end() || location.offset + location.length > size->second)
+		{
+			return { std::nullopt, std::format("pack record out of range: {}@{}+{}", location.pack_id, location.offset, location.length) };
+		}
+
+		auto [opened, open_error] = open_pack(location.pack_id);
+		if (opened < 0)
+		{
+			return { std::nullopt, open_error };
+		}
+
+		fd = opened;
+		in_flight_[location.pack_id]++;
+	}
+
+	std::string content(location.length, '\0');
+	std::optional<std::string> error = std::nullopt;
+	size_t total = 0;
+	while (total < location.length)
+	{
+		auto result = ::pread(fd, content.data() + total, location.length - total, static_cast<off_t>(location.offset + total));
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (result <= 0)
+		{
+			error = std::format("pack read failed: {}", result < 0 ? std::strerror(errno) : "unexpected end of pack");
+			break;
+		}
+		total += static_cast<size_t>(result);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	end_io(location.pack_id);
+	if (error.has_value())
+	{
+		return { std::nullopt, error };
+	}
+
+	return { content, std::nullopt };
+}
+
+auto PayloadPackStore::sync(const uint32_t& pack_id) -> std::tuple<bool, std::optional<std::string>>
+{
+	int fd = -1;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (!sizes_.contains(pack_id))
+		{
+			return { false, std::format("unknown pack: {}", pack_id) };
+		}
+
+		auto [opened, open_error] = open_pack(pack_id);
+		if (opened < 0)
+		{
+			return { false, open_error };
+		}
+
+		fd = opened;
+		in_flight_[pack_id]++;
+	}
+
+	auto result = ::fdatasync(fd);
+	auto error = errno;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	end_io(pack_id);
+	if (result != 0)
+	{
+		return { false, std::format("pack sync failed: {}", std::strerror(error)) };
+	}
+
+	return { true, std::nullopt };
+}
+
+auto PayloadPackStore::pack_ids(void) -> std::vector<uint32_t>
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::vector<uint32_t> ids;
+	for (const auto& [pack_id, size] : sizes_)
+	{
+		ids.push_back(pack_id);
+	}
+
+	return ids;
+}
+
+auto PayloadPackStore::pack_size(const uint32_t& pack_id) -> uint64_t
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto size = sizes_.find(pack_id);
+	return size == sizes_.end() ? 0 : size->second;
+}
+
+auto PayloadPackStore::active_pack_id(void) -> uint32_t
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return active_pack_id_;
+}
+
+auto PayloadPackStore::remove(const uint32_t& pack_id) -> std::tuple<bool, std::optional<std::string>>
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (pack_id == active_pack_id_)
+	{
+		return { false, "cannot remove active pack" };
+	}
+
+	if (pins_.contains(pack_id))
+	{
+		return { false, "cannot remove pinned pack" };
+	}
+
+	if (in_flight_.contains(pack_id))
+	{
+		return { false, "cannot remove pack with I/O in flight" };
+	}
+
+	auto descriptor = descriptors_.find(pack_id);
+	if (descriptor != descriptors_.end())
+	{
+		::close(descriptor->second);
+		descriptors_.erase(descriptor);
+	}
+
+	sizes_.erase(pack_id);
+
+	if (::unlink(build_pack_path(pack_id).c_str()) != 0 && errno != ENOENT)
+	{
+		return { false, std::format("delete failed: {}", std::strerror(errno)) };
+	}
+
+	return { true, std::nullopt };
+}
+
+auto PayloadPackStore::build_pack_path(const uint32_t& pack_id) -> std::string
+{
+	return std::format("{}/{:08}.pack", root_, pack_id);
+}
+
+auto PayloadPackStore::open_pack(const uint32_t& pack_id) -> std::tuple<int, std::optional<std::string>>
+{
+	auto descriptor = descriptors_.find(pack_id);
+	if (descriptor != descriptors_.end())
+	{
+		return { descriptor->second, std::nullopt };
+	}
+
+	auto path = build_pack_path(pack_id);
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		return { -1, std::format("cannot open pack file {}: {}", path, std::strerror(errno)) };
+	}
+
+	descriptors_[pack_id] = fd;
+
+	return { fd, std::nullopt };
+}
+
+auto PayloadPackStore::unpin(const uint32_t& pack_id) -> void
+{
+	auto pin = pins_.find(pack_id);
+	if (pin != pins_.end() && --pin->second == 0)
+	{
+		pins_.erase(pin);
+	}
+}
+
+auto PayloadPackStore::end_io(const uint32_t& pack_id) -> void
+{
+	auto count = in_flight_.find(pack_id);
+	if (count != in_flight_.end() && --count->second == 0)
+	{
+		in_flight_.erase(count);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+struct PackLocation
+{
+	uint32_t pack_id = 0;
+	uint64_t offset = 0;
+	uint64_t length = 0;
+};
+
+// Append-only rolling pack files: many payloads share one file, addressed by (pack_id, offset, length)
+// The lock only covers offset reservation and bookkeeping; reads and writes run outside it and keep their pack from removal
+class PayloadPackStore
+{
+public:
+	PayloadPackStore(void);
+	~PayloadPackStore(void);
+
+	auto open(const std::string& root, const uint64_t& max_pack_bytes) -> std::tuple<bool, std::optional<std::string>>;
+	auto close(void) -> void;
+
+	// A pinned append keeps its pack from being removed until release() is called for it
+	auto append(const std::string& content, const bool& sync = false, const bool& pin = false)
+		-> std::tuple<std::optional<PackLocation>, std::optional<std::string>>;
+	auto release(const uint32_t& pack_id) -> void;
+	auto is_pinned(const uint32_t& pack_id) -> bool;
+	auto read(const PackLocation& location) -> std::tuple<std::optional<std::string>, std::optional<std::string>>;
+	auto sync(const uint32_t& pack_id) -> std::tuple<bool, std::optional<std::string>>;
+
+	auto pack_ids(void) -> std::vector<uint32_t>;
+	auto pack_size(const uint32_t& pack_id) -> uint64_t;
+	auto active_pack_id(void) -> uint32_t;
+	auto remove(const uint32_t& pack_id) -> std::tuple<bool, std::optional<std::string>>;
+
+	auto build_pack_path(const uint32_t& pack_id) -> std::string;
+
+private:
+	auto open_pack(const uint32_t& pack_id) -> std::tuple<int, std::optional<std::string>>;
+	auto unpin(const uint32_t& pack_id) -> void;
+	auto end_io(const uint32_t& pack_id) -> void;
+
+private:
+	std::string root_;
+	uint64_t max_pack_bytes_;
+	uint32_t active_pack_id_;
+
+	std::map<uint32_t, int> descriptors_;
+	std::map<uint32_t, uint64_t> sizes_;
+	std::map<uint32_t, uint32_t> pins_;
+	std::map<uint32_t, uint32_t> in_flight_;
+	std::mutex mutex_;
+};
@@ -0,0 +1,168 @@
+#include "PayloadReclaimer.h"
+
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+
+PayloadReclaimer::PayloadReclaimer(void)
+	: batch_size_(64)
+	, interval_ms_(50)
+	, callback_(nullptr)
+	, stop_(false)
+	, busy_(false)
+	, flushing_(0)
+	, thread_(nullptr)
+{
+}
+
+PayloadReclaimer::~PayloadReclaimer(void)
+{
+	stop();
+}
+
+auto PayloadReclaimer::start(const int32_t& batch_size, const int32_t& interval_ms, CompletionCallback callback) -> void
+{
+	stop();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	batch_size_ = static_cast<size_t>(std::max(batch_size, 1));
+	interval_ms_ = std::max(interval_ms, 0);
+	callback_ = callback;
+	stop_ = false;
+
+	thread_ = std::make_unique<std::thread>(&PayloadReclaimer::run, this);
+}
+
+auto PayloadReclaimer::stop(void) -> void
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (thread_ == nullptr)
+		{
+			return;
+		}
+		stop_ = true;
+	}
+	condition_.notify_all();
+
+	// The worker drains whatever is queued before it exits
+	thread_->join();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	thread_.reset();
+	callback_ = nullptr;
+}
+
+auto PayloadReclaimer::schedule(const std::string& token, const Utilities::IoOperation& operation) -> void
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	if (thread_ == nullptr || stop_)
+	{
+		lock.unlock();
+
+		execute({ { token, operation } });
+		return;
+	}
+
+	// The first task starts the batching window, a full batch ends it early
+	tasks_.push_back({ token, operation });
+	if (tasks_.size() == 1 || tasks_.size() >= batch_size_)
+	{
+		condition_.notify_one();
+	}
+}
+
+auto PayloadReclaimer::flush(void) -> void
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	if (thread_ == nullptr)
+	{
+		return;
+	}
+
+	flushing_++;
+	condition_.notify_one();
+	idle_condition_.wait(lock, [this]() { return tasks_.empty() && !busy_; });
+	flushing_--;
+}
+
+auto PayloadReclaimer::pending(void) -> size_t
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	return tasks_.size() + (busy_ ? 1 : 0);
+}
+
+auto PayloadReclaimer::run(void) -> void
+{
+	while (true)
+	{
+		std::vector<Task> batch;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+			if (tasks_.empty())
+			{
+				return;
+			}
+
+			// Give the batch a short window to fill unless someone is waiting on it
+			condition_.wait_for(lock, std::chrono::milliseconds(interval_ms_),
+				[this]() { return stop_ || flushing_ > 0 || tasks_.size() >= batch_size_; });
+
+			auto count = std::min(tasks_.size(), batch_size_);
+			batch.assign(std::make_move_iterator(tasks_.begin()), std::make_move_iterator(tasks_.begin() + count));
+			tasks_.erase(tasks_.begin(), tasks_.begin() + count);
+			busy_ = true;
+		}
+
+		auto completed = execute(batch);
+		if (callback_ != nullptr && !completed.empty())
+		{
+			callback_(completed);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			busy_ = false;
+		}
+		idle_condition_.notify_all();
+	}
+}
+
+auto PayloadReclaimer::execute(const std::vector<Task>& tasks) -> std::vector<std::string>
+{
+	std::vector<Utilities::IoOperation> operations;
+	operations.reserve(tasks.size());
+	for (const auto& task : tasks)
+	{
+		operations.push_back(task.operation);
+	}
+
+	auto results = Utilities::IoEngine::handle().execute(operations);
+
+	std::vector<std::string> completed;
+	for (size_t index = 0; index < results.size(); ++index)
+	{
+		// A source that is already gone means an earlier run (or a crash replay) finished the work
+		std::error_code ec;
+		if (std::get<0>(results[index]) || !std::filesystem::exists(tasks[index].operation.path, ec))
+		{
+			completed.push_back(tasks[index].token);
+			continue;
+		}
+
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("reclaim failed for {}: {}", tasks[index].operation.path, std::get<1>(results[index]).value_or("unknown"))
+		);
+	}
+
+	return completed;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "IoEngine.h"
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+// Background reclaimer for file cleanup that does not need to finish before an ack returns.
+// Operations are batched into one IoEngine submission; the callback receives the tokens whose work is done.
+class PayloadReclaimer
+{
+public:
+	using CompletionCallback = std::function<void(const std::vector<std::string>&)>;
+
+	PayloadReclaimer(void);
+	~PayloadReclaimer(void);
+
+	auto start(const int32_t& batch_size, const int32_t& interval_ms, CompletionCallback callback = nullptr) -> void;
+	auto stop(void) -> void;
+
+	// Runs the operation inline, without the callback, when the reclaimer is not running
+	auto schedule(const std::string& token, const Utilities::IoOperation& operation) -> void;
+	auto flush(void) -> void;
+
+	auto pending(void) -> size_t;
+
+private:
+	struct Task
+	{
+		std::string token;
+		Utilities::IoOperation operation;
+	};
+
+	auto run(void) -> void;
+	auto execute(const std::vector<Task>& tasks) -> std::vector<std::string>;
+
+private:
+	size_t batch_size_;
+	int32_t interval_ms_;
+	CompletionCallback callback_;
+
+	std::deque<Task> tasks_;
+	bool stop_;
+	bool busy_;
+	int32_t flushing_;
+
+	std::unique_ptr<std::thread> thread_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	std::condition_variable idle_condition_;
+};
@@ -3,6 +3,7 @@
 #include "Converter.h"
 #include "File.h"
 #include "Generator.h"
+#include "Logger.h"
 
 #include <nlohmann/json.hpp>
 #include <sqlite3.h>
@@ -101,6 +102,14 @@ auto SQLiteAdapter::open(const BackendConfig& config) -> std::tuple<bool, std::o
 		}
 	}
 
+	// Dictionaries live beside the database like its -wal/-shm files; in-memory databases keep them in memory too
+	auto dictionary_root = sqlite_config_.db_path == ":memory:" ? std::string() : sqlite_config_.db_path + "-dictionaries";
+	auto [codec_ok, codec_message] = codec_.configure(config.compression, config.queue_compression, dictionary_root);
+	if (!codec_ok)
+	{
+		return { false, codec_message };
+	}
+
 	auto [opened, open_message] = db_.open(sqlite_config_.db_path);
 	if (!opened)
 	{
@@ -153,12 +162,23 @@ auto SQLiteAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bool,
 	json envelope;
 	envelope["messageId"] = message.message_id;
 	envelope["queue"] = message.queue;
-	envelope["payload"] = message.payload_json;
+	codec_.encode_field(message.queue, message.payload_json, envelope, "payload");
 	envelope["attributes"] = message.attributes_json;
 	envelope["priority"] = message.priority;
 	envelope["attempt"] = message.attempt;
 	envelope["createdAt"] = message.created_at_ms > 0 ? message.created_at_ms : now;
 
+	// Serialized before the transaction opens: dump() throws on invalid UTF-8
+	std::string envelope_text;
+	try
+	{
+		envelope_text = envelope.dump();
+	}
+	catch (const json::exception& e)
+	{
+		return { false, std::format("failed to serialize envelope: {}", e.what()) };
+	}
+
 	auto [tx_ok, tx_error] = db_.begin_transaction();
 	if (!tx_ok)
 	{
@@ -179,7 +199,7 @@ auto SQLiteAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bool,
 	}
 
 	kv_stmt->bind_text(1, message.key);
-	kv_stmt->bind_text(2, envelope.dump());
+	kv_stmt->bind_text(2, envelope_text);
 	kv_stmt->bind_text(3, "message");
 	kv_stmt->bind_int64(4, now);
 	kv_stmt->bind_int64(5, now);
@@ -233,7 +253,7 @@ auto SQLiteAdapter::enqueue(const MessageEnvelope& message) -> std::tuple<bool,
 auto SQLiteAdapter::lease_next(const std::string& queue, const std::string& consumer_id, const int32_t& visibility_timeout_sec)
 	-> LeaseResult
 {
-	std::lock_guard<std::mutex> lock(db_mutex_);
+	std::unique_lock<std::mutex> lock(db_mutex_);
 
 	LeaseResult result;
 
@@ -346,6 +366,7 @@ auto SQLiteAdapter::lease_next(const std::string& queue, const std::string& cons
 	}
 
 	// Parse message envelope
+	std::optional<std::string> load_error;
 	try
 	{
 		json envelope = json::parse(value_json);
@@ -354,7 +375,12 @@ auto SQLiteAdapter::lease_next(const std::string& queue, const std::string& cons
 		msg.key = message_key;
 		msg.message_id = envelope.value("messageId", "");
 		msg.queue = envelope.value("queue", queue);
-		msg.payload_json = envelope.value("payload", "");
+		auto [payload, payload_error] = codec_.decode_field(msg.queue, envelope, "payload", "");
+		if (!payload.has_value())
+		{
+			load_error = payload_error.value_or("payload decode failed");
+		}
+		msg.payload_json = payload.value_or("");
 		msg.attributes_json = envelope.value("attributes", "");
 		msg.priority = priority;
 		msg.attempt = attempt + 1;
@@ -366,13 +392,28 @@ auto SQLiteAdapter::lease_next(const std::string& queue, const std::string& cons
 		lease.consumer_id = consumer_id;
 		lease.lease_until_ms = lease_until;
 
-		result.leased = true;
-		result.message = msg;
-		result.lease = lease;
+		if (!load_error.has_value())
+		{
+			result.leased = true;
+			result.message = msg;
+			result.lease = lease;
+		}
 	}
 	catch (const json::exception& e)
 	{
-		result.error = std::format("failed to parse message: {}", e.what());
+		load_error = std::format("failed to parse message: {}", e.what());
+	}
+
+	if (load_error.has_value())
+	{
+		// Leasing it with an empty payload would lose the message, and a retry would fail the same way
+		lock.unlock();
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("Failed to load message {}, moving it to the DLQ: {}", message_key, load_error.value())
+		);
+		move_to_dlq(message_key, "payload unreadable");
+		result.error = load_error;
 	}
 
 	return result;
@@ -789,6 +830,8 @@ auto SQLiteAdapter::metrics(const std::string& queue) -> std::tuple<QueueMetrics
 		}
 	}
 
+	codec_.apply_metrics(queue, metrics);
+
 	return { metrics, std::nullopt };
 }
 
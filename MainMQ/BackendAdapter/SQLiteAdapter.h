@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BackendAdapter.h"
+#include "PayloadCodec.h"
 
 #include "SQLite.h"
 
@@ -51,4 +52,6 @@ private:
 	SQLiteConfig sqlite_config_;
 	DataBase::SQLite db_;
 	mutable std::mutex db_mutex_;
+
+	PayloadCodec codec_;
 };
@@ -25,3 +25,10 @@ CREATE TABLE IF NOT EXISTS {{msg_index_table}} (
 CREATE INDEX IF NOT EXISTS idx_msg_ready ON {{msg_index_table}}(queue, state, available_at, priority);
 CREATE INDEX IF NOT EXISTS idx_msg_lease ON {{msg_index_table}}(state, lease_until);
 CREATE INDEX IF NOT EXISTS idx_msg_queue ON {{msg_index_table}}(queue);
+
+CREATE TABLE IF NOT EXISTS payload_reclaim (
+  message_key TEXT PRIMARY KEY,
+  source_path TEXT NOT NULL,
+  target_path TEXT NOT NULL,
+  created_at INTEGER NOT NULL
+);
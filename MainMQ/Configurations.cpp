@@ -46,6 +46,9 @@ namespace
 			, node_id_("local-01")
 			, backend_type_(BackendType::SQLite)
 			, operation_mode_(OperationMode::MailboxSqlite)
+			, consistency_interval_ms_(0)
+			, consistency_slice_keys_(512)
+			, consistency_repair_(false)
 			, lease_visibility_timeout_sec_(30)
 			, lease_sweep_interval_ms_(1000)
 		{
@@ -56,6 +59,7 @@ namespace
 			sqlite_config_.busy_timeout_ms = 5000;
 			sqlite_config_.journal_mode = "WAL";
 			sqlite_config_.synchronous = "NORMAL";
+			sqlite_config_.inline_payload_max_bytes = 4096;
 
 			// FileSystem defaults
 			filesystem_config_.root = "./data/fs";
@@ -105,7 +109,18 @@ namespace
 		auto Configurations::backend_type() -> BackendType { return backend_type_; }
 		auto Configurations::operation_mode() -> OperationMode { return operation_mode_; }
 
-		auto Configurations::mailbox_config() -> MailboxConfig { return mailbox_config_; }
+		auto Configurations::mailbox_config() -> MailboxConfig
+		{
+			MailboxConfig config = mailbox_config_;
+			for (const auto& queue : queues_)
+			{
+				if (queue.limits.has_value())
+				{
+					config.admission.queue_limits[queue.name] = queue.limits.value();
+				}
+			}
+			return config;
+		}
 
 		auto Configurations::sqlite_config() -> SQLiteConfig { return sqlite_config_; }
 		auto Configurations::sqlite_db_path() -> std::string { return sqlite_config_.db_path; }
@@ -118,6 +133,14 @@ namespace
 
 		auto Configurations::filesystem_config() -> FileSystemConfig { return filesystem_config_; }
 
+		auto Configurations::compression_policy() -> CompressionPolicy { return compression_policy_; }
+
+		auto Configurations::reclaim_config() -> ReclaimConfig { return reclaim_config_; }
+
+		auto Configurations::consistency_interval_ms() -> int32_t { return consistency_interval_ms_; }
+		auto Configurations::consistency_slice_keys() -> int32_t { return consistency_slice_keys_; }
+		auto Configurations::consistency_repair() -> bool { return consistency_repair_; }
+
 		auto Configurations::lease_visibility_timeout_sec() -> int32_t { return lease_visibility_timeout_sec_; }
 		auto Configurations::lease_sweep_interval_ms() -> int32_t { return lease_sweep_interval_ms_; }
 
@@ -131,6 +154,15 @@ namespace
 			config.type = backend_type_;
 			config.sqlite = sqlite_config_;
 			config.filesystem = filesystem_config_;
+			config.compression = compression_policy_;
+			config.reclaim = reclaim_config_;
+			for (const auto& queue : queues_)
+			{
+				if (queue.compression.has_value())
+				{
+					config.queue_compression[queue.name] = queue.compression.value();
+				}
+			}
 			return config;
 		}
 
@@ -254,6 +286,38 @@ namespace
 					{
 						sqlite_config_.synchronous = sqlite["synchronous"].get<std::string>();
 					}
+					if (sqlite.contains("inlinePayloadMaxBytes") && sqlite["inlinePayloadMaxBytes"].is_number())
+					{
+						sqlite_config_.inline_payload_max_bytes = sqlite["inlinePayloadMaxBytes"].get<int32_t>();
+					}
+					if (sqlite.contains("syncPayloads") && sqlite["syncPayloads"].is_boolean())
+					{
+						sqlite_config_.sync_payloads = sqlite["syncPayloads"].get<bool>();
+					}
+					if (sqlite.contains("payloadStorage") && sqlite["payloadStorage"].is_string())
+					{
+						auto storage = sqlite["payloadStorage"].get<std::string>();
+						if (storage == "pack" || storage == "packs")
+						{
+							sqlite_config_.payload_storage = PayloadStorage::Packs;
+						}
+						else
+						{
+							sqlite_config_.payload_storage = PayloadStorage::Files;
+						}
+					}
+					if (sqlite.contains("packMaxBytes") && sqlite["packMaxBytes"].is_number())
+					{
+						sqlite_config_.pack_max_bytes = sqlite["packMaxBytes"].get<uint64_t>();
+					}
+					if (sqlite.contains("packCompactLiveRatio") && sqlite["packCompactLiveRatio"].is_number())
+					{
+						sqlite_config_.pack_compact_live_ratio = sqlite["packCompactLiveRatio"].get<double>();
+					}
+					if (sqlite.contains("packCompactIntervalMs") && sqlite["packCompactIntervalMs"].is_number())
+					{
+						sqlite_config_.pack_compact_interval_ms = sqlite["packCompactIntervalMs"].get<int32_t>();
+					}
 				}
 
 				// FileSystem config
@@ -284,6 +348,22 @@ namespace
 					{
 						filesystem_config_.meta_dir = fs["metaDir"].get<std::string>();
 					}
+					if (fs.contains("envelopeFormat") && fs["envelopeFormat"].is_string())
+					{
+						auto format = fs["envelopeFormat"].get<std::string>();
+						if (format == "compact")
+						{
+							filesystem_config_.envelope_format = EnvelopeFormat::CompactJson;
+						}
+						else if (format == "binary")
+						{
+							filesystem_config_.envelope_format = EnvelopeFormat::Binary;
+						}
+						else
+						{
+							filesystem_config_.envelope_format = EnvelopeFormat::Json;
+						}
+					}
 				}
 
 				// IPC (Mailbox) config
@@ -322,6 +402,91 @@ namespace
 					{
 						mailbox_config_.use_folder_watcher = ipc["useFolderWatcher"].get<bool>();
 					}
+					if (ipc.contains("dispatchWorkers") && ipc["dispatchWorkers"].is_number())
+					{
+						mailbox_config_.dispatch_workers = ipc["dispatchWorkers"].get<int32_t>();
+					}
+					if (ipc.contains("prettyResponses") && ipc["prettyResponses"].is_boolean())
+					{
+						mailbox_config_.pretty_responses = ipc["prettyResponses"].get<bool>();
+					}
+					if (ipc.contains("laneWeights") && ipc["laneWeights"].is_object())
+					{
+						auto& weights = ipc["laneWeights"];
+						mailbox_config_.lane_weights.settle = weights.value("settle", mailbox_config_.lane_weights.settle);
+						mailbox_config_.lane_weights.consume = weights.value("consume", mailbox_config_.lane_weights.consume);
+						mailbox_config_.lane_weights.publish = weights.value("publish", mailbox_config_.lane_weights.publish);
+						mailbox_config_.lane_weights.admin = weights.value("admin", mailbox_config_.lane_weights.admin);
+					}
+					if (ipc.contains("admission") && ipc["admission"].is_object())
+					{
+						auto& admission = ipc["admission"];
+						if (admission.contains("maxPendingRequests") && admission["maxPendingRequests"].is_number_unsigned())
+						{
+							mailbox_config_.admission.max_pending_requests = admission["maxPendingRequests"].get<uint32_t>();
+						}
+						if (admission.contains("retryAfterMs") && admission["retryAfterMs"].is_number())
+						{
+							mailbox_config_.admission.retry_after_ms = admission["retryAfterMs"].get<int32_t>();
+						}
+						mailbox_config_.admission.queue_defaults = load_queue_limits(&admission, mailbox_config_.admission.queue_defaults);
+					}
+					if (ipc.contains("shm") && ipc["shm"].is_object())
+					{
+						auto& shm = ipc["shm"];
+						if (shm.contains("enabled") && shm["enabled"].is_boolean())
+						{
+							mailbox_config_.shm.enabled = shm["enabled"].get<bool>();
+						}
+						if (shm.contains("dir") && shm["dir"].is_string())
+						{
+							mailbox_config_.shm.dir = shm["dir"].get<std::string>();
+						}
+						if (shm.contains("namePrefix") && shm["namePrefix"].is_string())
+						{
+							mailbox_config_.shm.name_prefix = shm["namePrefix"].get<std::string>();
+						}
+						if (shm.contains("ringBytes") && shm["ringBytes"].is_number_unsigned())
+						{
+							mailbox_config_.shm.ring_bytes = shm["ringBytes"].get<uint32_t>();
+						}
+					}
+					if (ipc.contains("socket") && ipc["socket"].is_object())
+					{
+						auto& socket = ipc["socket"];
+						if (socket.contains("enabled") && socket["enabled"].is_boolean())
+						{
+							mailbox_config_.socket.enabled = socket["enabled"].get<bool>();
+						}
+						if (socket.contains("path") && socket["path"].is_string())
+						{
+							mailbox_config_.socket.path = socket["path"].get<std::string>();
+						}
+						if (socket.contains("maxFrameBytes") && socket["maxFrameBytes"].is_number_unsigned())
+						{
+							mailbox_config_.socket.max_frame_bytes = socket["maxFrameBytes"].get<uint32_t>();
+						}
+						if (socket.contains("maxOutputBytes") && socket["maxOutputBytes"].is_number_unsigned())
+						{
+							mailbox_config_.socket.max_output_bytes = socket["maxOutputBytes"].get<uint64_t>();
+						}
+					}
+					if (ipc.contains("journal") && ipc["journal"].is_object())
+					{
+						auto& journal = ipc["journal"];
+						if (journal.contains("enabled") && journal["enabled"].is_boolean())
+						{
+							mailbox_config_.journal.enabled = journal["enabled"].get<bool>();
+						}
+						if (journal.contains("maxFrameBytes") && journal["maxFrameBytes"].is_number_unsigned())
+						{
+							mailbox_config_.journal.max_frame_bytes = journal["maxFrameBytes"].get<uint32_t>();
+						}
+						if (journal.contains("rollBytes") && journal["rollBytes"].is_number_unsigned())
+						{
+							mailbox_config_.journal.roll_bytes = journal["rollBytes"].get<uint64_t>();
+						}
+					}
 				}
 
 				// Lease config
@@ -338,6 +503,48 @@ namespace
 					}
 				}
 
+				// Compression
+				if (config.contains("compression") && config["compression"].is_object())
+				{
+					compression_policy_ = load_compression_policy(&config["compression"], compression_policy_);
+				}
+
+				// Reclaim
+				if (config.contains("reclaim") && config["reclaim"].is_object())
+				{
+					auto& reclaim = config["reclaim"];
+					if (reclaim.contains("deferred") && reclaim["deferred"].is_boolean())
+					{
+						reclaim_config_.deferred = reclaim["deferred"].get<bool>();
+					}
+					if (reclaim.contains("batchSize") && reclaim["batchSize"].is_number())
+					{
+						reclaim_config_.batch_size = reclaim["batchSize"].get<int32_t>();
+					}
+					if (reclaim.contains("intervalMs") && reclaim["intervalMs"].is_number())
+					{
+						reclaim_config_.interval_ms = reclaim["intervalMs"].get<int32_t>();
+					}
+				}
+
+				// Consistency
+				if (config.contains("consistency") && config["consistency"].is_object())
+				{
+					auto& consistency = config["consistency"];
+					if (consistency.contains("intervalMs") && consistency["intervalMs"].is_number())
+					{
+						consistency_interval_ms_ = consistency["intervalMs"].get<int32_t>();
+					}
+					if (consistency.contains("sliceKeys") && consistency["sliceKeys"].is_number())
+					{
+						consistency_slice_keys_ = consistency["sliceKeys"].get<int32_t>();
+					}
+					if (consistency.contains("repair") && consistency["repair"].is_boolean())
+					{
+						consistency_repair_ = consistency["repair"].get<bool>();
+					}
+				}
+
 				// Policy defaults
 				if (config.contains("policyDefaults") && config["policyDefaults"].is_object())
 				{
@@ -367,6 +574,14 @@ namespace
 						{
 							queue_config.message_schema = load_message_schema(&queue_json["messageSchema"]);
 						}
+						if (queue_json.contains("compression") && queue_json["compression"].is_object())
+						{
+							queue_config.compression = load_compression_policy(&queue_json["compression"], compression_policy_);
+						}
+						if (queue_json.contains("limits") && queue_json["limits"].is_object())
+						{
+							queue_config.limits = load_queue_limits(&queue_json["limits"], mailbox_config_.admission.queue_defaults);
+						}
 						queues_.push_back(queue_config);
 					}
 				}
@@ -465,6 +680,62 @@ namespace
 			return policy;
 		}
 
+		auto Configurations::load_compression_policy(const void* json_obj, const CompressionPolicy& defaults) -> CompressionPolicy
+		{
+			CompressionPolicy policy = defaults;
+
+			const json& obj = *static_cast<const json*>(json_obj);
+
+			if (obj.contains("enabled") && obj["enabled"].is_boolean())
+			{
+				policy.enabled = obj["enabled"].get<bool>();
+			}
+			if (obj.contains("minBytes") && obj["minBytes"].is_number())
+			{
+				policy.min_bytes = obj["minBytes"].get<uint32_t>();
+			}
+			if (obj.contains("blockBytes") && obj["blockBytes"].is_number())
+			{
+				policy.block_bytes = std::clamp(obj["blockBytes"].get<uint32_t>(), 1u, CompressionPolicy::max_block_bytes);
+			}
+			if (obj.contains("dictionary") && obj["dictionary"].is_boolean())
+			{
+				policy.dictionary = obj["dictionary"].get<bool>();
+			}
+			if (obj.contains("dictionaryBytes") && obj["dictionaryBytes"].is_number())
+			{
+				policy.dictionary_bytes = obj["dictionaryBytes"].get<uint32_t>();
+			}
+			if (obj.contains("dictionarySamples") && obj["dictionarySamples"].is_number())
+			{
+				policy.dictionary_samples = obj["dictionarySamples"].get<uint32_t>();
+			}
+			if (obj.contains("dictionaryRetrainMessages") && obj["dictionaryRetrainMessages"].is_number())
+			{
+				policy.dictionary_retrain_messages = obj["dictionaryRetrainMessages"].get<uint64_t>();
+			}
+
+			return policy;
+		}
+
+		auto Configurations::load_queue_limits(const void* json_obj, const MailboxQueueLimits& defaults) -> MailboxQueueLimits
+		{
+			MailboxQueueLimits limits = defaults;
+
+			const json& obj = *static_cast<const json*>(json_obj);
+
+			if (obj.contains("maxReadyDepth") && obj["maxReadyDepth"].is_number_unsigned())
+			{
+				limits.max_ready_depth = obj["maxReadyDepth"].get<uint64_t>();
+			}
+			if (obj.contains("maxBytes") && obj["maxBytes"].is_number_unsigned())
+			{
+				limits.max_bytes = obj["maxBytes"].get<uint64_t>();
+			}
+
+			return limits;
+		}
+
 		auto Configurations::load_dlq_policy(const void* json_obj) -> DlqPolicy
 		{
 			DlqPolicy policy;
@@ -538,6 +809,48 @@ namespace
 				lease_sweep_interval_ms_ = 1000;
 			}
 
+			if (mailbox_config_.dispatch_workers <= 0)
+			{
+				Logger::handle().write(LogTypes::Information,
+					std::format("Invalid ipc.dispatchWorkers ({}), using default 4", mailbox_config_.dispatch_workers));
+				mailbox_config_.dispatch_workers = 4;
+			}
+
+			MailboxLaneWeights default_weights;
+			for (auto [weight, fallback, name] : { std::tuple{ &mailbox_config_.lane_weights.settle, default_weights.settle, "settle" },
+												   std::tuple{ &mailbox_config_.lane_weights.consume, default_weights.consume, "consume" },
+												   std::tuple{ &mailbox_config_.lane_weights.publish, default_weights.publish, "publish" },
+												   std::tuple{ &mailbox_config_.lane_weights.admin, default_weights.admin, "admin" } })
+			{
+				if (*weight <= 0)
+				{
+					Logger::handle().write(LogTypes::Information,
+						std::format("Invalid ipc.laneWeights.{} ({}), using default {}", name, *weight, fallback));
+					*weight = fallback;
+				}
+			}
+
+			if (mailbox_config_.admission.retry_after_ms <= 0)
+			{
+				Logger::handle().write(LogTypes::Information,
+					std::format("Invalid ipc.admission.retryAfterMs ({}), using default 1000", mailbox_config_.admission.retry_after_ms));
+				mailbox_config_.admission.retry_after_ms = 1000;
+			}
+
+			if (consistency_interval_ms_ < 0)
+			{
+				Logger::handle().write(LogTypes::Information,
+					std::format("Invalid consistency.intervalMs ({}), disabling consistency slices", consistency_interval_ms_));
+				consistency_interval_ms_ = 0;
+			}
+
+			if (consistency_slice_keys_ <= 0)
+			{
+				Logger::handle().write(LogTypes::Information,
+					std::format("Invalid consistency.sliceKeys ({}), using default 512", consistency_slice_keys_));
+				consistency_slice_keys_ = 512;
+			}
+
 			// Validate policy defaults
 			validate_queue_policy(policy_defaults_, "policyDefaults");
 
@@ -25,6 +25,8 @@ struct QueueConfig
 	std::string name;
 	QueuePolicy policy;
 	std::optional<MessageSchema> message_schema;
+	std::optional<CompressionPolicy> compression;
+	std::optional<MailboxQueueLimits> limits;
 };
 
 		class Configurations
@@ -64,6 +66,17 @@ struct QueueConfig
 			// FileSystem
 			auto filesystem_config() -> FileSystemConfig;
 
+			// Compression
+			auto compression_policy() -> CompressionPolicy;
+
+			// Reclaim
+			auto reclaim_config() -> ReclaimConfig;
+
+			// Consistency
+			auto consistency_interval_ms() -> int32_t;
+			auto consistency_slice_keys() -> int32_t;
+			auto consistency_repair() -> bool;
+
 			// Lease
 			auto lease_visibility_timeout_sec() -> int32_t;
 			auto lease_sweep_interval_ms() -> int32_t;
@@ -86,6 +99,8 @@ struct QueueConfig
 			auto load_retry_policy(const void* json_obj) -> RetryPolicy;
 			auto load_dlq_policy(const void* json_obj) -> DlqPolicy;
 			auto load_queue_policy(const void* json_obj) -> QueuePolicy;
+			auto load_compression_policy(const void* json_obj, const CompressionPolicy& defaults) -> CompressionPolicy;
+			auto load_queue_limits(const void* json_obj, const MailboxQueueLimits& defaults) -> MailboxQueueLimits;
 			auto load_message_schema(const void* json_obj) -> std::optional<MessageSchema>;
 			auto load_validation_rule(const void* json_obj) -> std::optional<ValidationRule>;
 			auto validate_retry_policy(RetryPolicy& policy, const std::string& context) -> void;
@@ -116,6 +131,17 @@ struct QueueConfig
 			// FileSystem
 			FileSystemConfig filesystem_config_;
 
+			// Compression
+			CompressionPolicy compression_policy_;
+
+			// Reclaim
+			ReclaimConfig reclaim_config_;
+
+			// Consistency
+			int32_t consistency_interval_ms_;
+			int32_t consistency_slice_keys_;
+			bool consistency_repair_;
+
 			// Lease
 			int32_t lease_visibility_timeout_sec_;
 			int32_t lease_sweep_interval_ms_;
@@ -0,0 +1,518 @@
+#include "JournalTransport.h"
+
+#include "Logger.h"
+#include "SocketTransport.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <set>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	constexpr size_t frame_header_bytes = 4;
+	constexpr size_t read_chunk_bytes = 64 * 1024;
+	constexpr size_t offset_record_bytes = 21;
+	const std::string journal_suffix = ".log";
+
+	auto decode_length(const char* data) -> uint32_t
+	{
+		auto bytes = reinterpret_cast<const uint8_t*>(data);
+		return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8)
+			   | static_cast<uint32_t>(bytes[3]);
+	}
+
+	auto client_of(const std::string& filename) -> std::string
+	{
+		if (filename.size() <= journal_suffix.size() || !filename.ends_with(journal_suffix))
+		{
+			return "";
+		}
+		return filename.substr(0, filename.size() - journal_suffix.size());
+	}
+
+	auto write_all(int fd, const std::string& content) -> bool
+	{
+		size_t written = 0;
+		while (written < content.size())
+		{
+			auto result = ::write(fd, content.data() + written, content.size() - written);
+			if (result < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			written += static_cast<size_t>(result);
+		}
+		return true;
+	}
+
+	auto lock_file(int fd) -> void
+	{
+		while (::flock(fd, LOCK_EX) < 0 && errno == EINTR)
+		{
+		}
+	}
+}
+
+JournalTransport::JournalTransport(const MailboxConfig& config)
+	: config_(config)
+	, notify_fd_(-1)
+	, wake_fd_(-1)
+	, rolls_(0)
+	, running_(false)
+{
+}
+
+JournalTransport::~JournalTransport(void)
+{
+	stop();
+}
+
+auto JournalTransport::start(TransportRequestCallback callback) -> std::tuple<bool, std::optional<std::string>>
+{
+	if (running_.load())
+	{
+		return { false, "already running" };
+	}
+
+	auto requests = std::filesystem::path(config_.root) / config_.requests_dir;
+
+	notify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (notify_fd_ < 0 || wake_fd_ < 0
+		|| ::inotify_add_watch(notify_fd_, requests.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0)
+	{
+		auto error = std::format("journal watch on {} failed: {}", requests.string(), std::strerror(errno));
+		for (int* fd : { &notify_fd_, &wake_fd_ })
+		{
+			if (*fd >= 0)
+			{
+				::close(*fd);
+				*fd = -1;
+			}
+		}
+		return { false, error };
+	}
+
+	callback_ = std::move(callback);
+	running_.store(true);
+	thread_ = std::make_unique<std::thread>(&JournalTransport::run, this);
+
+	Utilities::Logger::handle().write(
+		Utilities::LogTypes::Information,
+		std::format("Journal transport tailing {}/*{}", requests.string(), journal_suffix)
+	);
+
+	return { true, std::nullopt };
+}
+
+auto JournalTransport::stop(void) -> void
+{
+	if (!running_.exchange(false))
+	{
+		return;
+	}
+
+	uint64_t one = 1;
+	[[maybe_unused]] auto written = ::write(wake_fd_, &one, sizeof(one));
+	thread_->join();
+	thread_.reset();
+
+	// Replies still in flight are dropped; their requests are before the persisted offset and replay on the next start
+	std::lock_guard<std::mutex> lock(journals_mutex_);
+	for (auto& [client_id, journal] : journals_)
+	{
+		close_journal(*journal);
+	}
+	journals_.clear();
+
+	::close(notify_fd_);
+	::close(wake_fd_);
+	notify_fd_ = wake_fd_ = -1;
+}
+
+auto JournalTransport::journal_count(void) -> size_t
+{
+	std::lock_guard<std::mutex> lock(journals_mutex_);
+	return journals_.size();
+}
+
+auto JournalTransport::append(const std::string& journal_path, const std::string& content) -> std::tuple<bool, std::optional<std::string>>
+{
+	int fd = ::open(journal_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		return { false, std::format("cannot open journal {}: {}", journal_path, std::strerror(errno)) };
+	}
+
+	lock_file(fd);
+	bool written = write_all(fd, SocketTransport::encode_frame(content));
+	auto error = errno;
+	::flock(fd, LOCK_UN);
+	::close(fd);
+
+	if (!written)
+	{
+		return { false, std::format("cannot append to journal {}: {}", journal_path, std::strerror(error)) };
+	}
+
+	return { true, std::nullopt };
+}
+
+auto JournalTransport::run(void) -> void
+{
+	// Journals written before start (or while the previous run was down) are picked up by the first scan
+	scan_journals();
+
+	alignas(inotify_event) char buffer[16 * 1024];
+
+	while (running_.load())
+	{
+		pollfd descriptors[2] = { { notify_fd_, POLLIN, 0 }, { wake_fd_, POLLIN, 0 } };
+		int count = ::poll(descriptors, 2, config_.poll_interval_ms);
+		if (count < 0 && errno != EINTR)
+		{
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Error,
+				std::format("Journal transport poll failed: {}", std::strerror(errno))
+			);
+			break;
+		}
+
+		if (descriptors[1].revents & POLLIN)
+		{
+			uint64_t value = 0;
+			[[maybe_unused]] auto consumed = ::read(wake_fd_, &value, sizeof(value));
+		}
+
+		if (count <= 0)
+		{
+			// Idle tick: catch up on anything a missed event left behind and roll drained journals
+			scan_journals();
+			continue;
+		}
+
+		std::set<std::string> touched;
+		bool overflowed = false;
+		while (true)
+		{
+			auto length = ::read(notify_fd_, buffer, sizeof(buffer));
+			if (length <= 0)
+			{
+				break;
+			}
+
+			for (ssize_t offset = 0; offset < length;)
+			{
+				auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					overflowed = true;
+					continue;
+				}
+
+				if (event->len == 0 || (event->mask & IN_ISDIR))
+				{
+					continue;
+				}
+
+				auto client_id = client_of(std::string(event->name, strnlen(event->name, event->len)));
+				if (!client_id.empty())
+				{
+					touched.insert(client_id);
+				}
+			}
+		}
+
+		if (overflowed)
+		{
+			scan_journals();
+			continue;
+		}
+
+		for (const auto& client_id : touched)
+		{
+			auto journal = find_journal(client_id);
+			if (journal != nullptr)
+			{
+				read_journal(journal);
+				roll_journal(*journal);
+			}
+		}
+	}
+}
+
+auto JournalTransport::scan_journals(void) -> void
+{
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(config_.root) / config_.requests_dir, ec))
+	{
+		std::error_code entry_ec;
+		if (!entry.is_regular_file(entry_ec))
+		{
+			continue;
+		}
+
+		auto client_id = client_of(entry.path().filename().string());
+		if (client_id.empty())
+		{
+			continue;
+		}
+
+		auto journal = find_journal(client_id);
+		if (journal != nullptr)
+		{
+			read_journal(journal);
+			roll_journal(*journal);
+		}
+	}
+}
+
+auto JournalTransport::find_journal(const std::string& client_id) -> std::shared_ptr<Journal>
+{
+	{
+		std::lock_guard<std::mutex> lock(journals_mutex_);
+		auto found = journals_.find(client_id);
+		if (found != journals_.end())
+		{
+			return found->second;
+		}
+	}
+
+	auto journal = open_journal(client_id);
+	if (journal == nullptr)
+	{
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(journals_mutex_);
+	journals_[client_id] = journal;
+	return journal;
+}
+
+auto JournalTransport::open_journal(const std::string& client_id) -> std::shared_ptr<Journal>
+{
+	auto journal = std::make_shared<Journal>();
+	journal->client_id = client_id;
+	journal->request_fd = ::open(request_path(client_id).c_str(), O_RDWR | O_CLOEXEC);
+	journal->response_fd = ::open(response_path(client_id).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	journal->offset_fd = ::open(offset_path(client_id).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (journal->request_fd < 0 || journal->response_fd < 0 || journal->offset_fd < 0)
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("Cannot open journal for client {}: {}", client_id, std::strerror(errno))
+		);
+		close_journal(*journal);
+		return nullptr;
+	}
+
+	char record[offset_record_bytes + 1] = {};
+	auto length = ::pread(journal->offset_fd, record, offset_record_bytes, 0);
+	uint64_t offset = length > 0 ? std::strtoull(record, nullptr, 10) : 0;
+
+	// An offset past the end means the journal was truncated after the offset was last written
+	struct stat info{};
+	if (::fstat(journal->request_fd, &info) == 0 && offset > static_cast<uint64_t>(info.st_size))
+	{
+		offset = 0;
+	}
+
+	journal->read_offset = offset;
+	journal->committed = offset;
+
+	return journal;
+}
+
+auto JournalTransport::close_journal(Journal& journal) -> void
+{
+	std::lock_guard<std::mutex> lock(journal.mutex);
+	journal.closed = true;
+	for (int* fd : { &journal.request_fd, &journal.response_fd, &journal.offset_fd })
+	{
+		if (*fd >= 0)
+		{
+			::close(*fd);
+			*fd = -1;
+		}
+	}
+}
+
+auto JournalTransport::read_journal(const std::shared_ptr<Journal>& journal) -> void
+{
+	if (journal->broken)
+	{
+		return;
+	}
+
+	char buffer[read_chunk_bytes];
+	while (true)
+	{
+		auto received = ::pread(journal->request_fd, buffer, sizeof(buffer), static_cast<off_t>(journal->read_offset));
+		if (received < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (received <= 0)
+		{
+			break;
+		}
+		journal->input.append(buffer, static_cast<size_t>(received));
+		journal->read_offset += static_cast<uint64_t>(received);
+	}
+
+	// Every complete frame is dispatched right away; a torn tail waits for the rest of its append
+	std::weak_ptr<Journal> target = journal;
+	uint64_t input_start = journal->read_offset - journal->input.size();
+	size_t offset = 0;
+	while (journal->input.size() - offset >= frame_header_bytes)
+	{
+		auto length = decode_length(journal->input.data() + offset);
+		if (length == 0 || length > config_.journal.max_frame_bytes)
+		{
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Error,
+				std::format("Journal of client {} has an invalid frame length {} at offset {}; no longer read", journal->client_id, length,
+							input_start + offset)
+			);
+			journal->broken = true;
+			break;
+		}
+
+		if (journal->input.size() - offset - frame_header_bytes < length)
+		{
+			break;
+		}
+
+		uint64_t end_offset = input_start + offset + frame_header_bytes + length;
+		{
+			std::lock_guard<std::mutex> lock(journal->mutex);
+			journal->in_flight[end_offset] = false;
+		}
+
+		callback_(journal->client_id, journal->input.substr(offset + frame_header_bytes, length),
+				  [this, target, end_offset](const std::string& response)
+				  {
+					  reply(target, end_offset, response);
+				  });
+		offset += frame_header_bytes + length;
+	}
+
+	if (offset > 0)
+	{
+		journal->input.erase(0, offset);
+	}
+}
+
+auto JournalTransport::roll_journal(Journal& journal) -> void
+{
+	if (journal.broken || !journal.input.empty() || journal.read_offset == 0 || journal.read_offset < config_.journal.roll_bytes)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(journal.mutex);
+	if (!journal.in_flight.empty() || journal.committed != journal.read_offset)
+	{
+		return;
+	}
+
+	// Under the writers' lock nothing can be appended between the size check and the truncate
+	lock_file(journal.request_fd);
+	struct stat info{};
+	if (::fstat(journal.request_fd, &info) == 0 && static_cast<uint64_t>(info.st_size) == journal.read_offset)
+	{
+		// Offset first: a crash before the truncate replays the journal rather than skipping new appends
+		persist_offset(journal, 0);
+		if (::ftruncate(journal.request_fd, 0) == 0)
+		{
+			journal.read_offset = 0;
+			journal.committed = 0;
+			rolls_.fetch_add(1);
+		}
+		else
+		{
+			persist_offset(journal, journal.committed);
+		}
+	}
+	::flock(journal.request_fd, LOCK_UN);
+}
+
+auto JournalTransport::reply(const std::weak_ptr<Journal>& target, const uint64_t& end_offset, const std::string& content) -> void
+{
+	auto journal = target.lock();
+	if (journal == nullptr)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(journal->mutex);
+	if (journal->closed)
+	{
+		return;
+	}
+
+	lock_file(journal->response_fd);
+	bool written = write_all(journal->response_fd, SocketTransport::encode_frame(content));
+	::flock(journal->response_fd, LOCK_UN);
+	if (!written)
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("Cannot append to the response journal of client {}: {}", journal->client_id, std::strerror(errno))
+		);
+		return;
+	}
+
+	// Answers can finish out of order across dispatch lanes; the offset only covers the answered prefix
+	journal->in_flight[end_offset] = true;
+	auto committed = journal->committed;
+	while (!journal->in_flight.empty() && journal->in_flight.begin()->second)
+	{
+		committed = journal->in_flight.begin()->first;
+		journal->in_flight.erase(journal->in_flight.begin());
+	}
+
+	if (committed != journal->committed)
+	{
+		journal->committed = committed;
+		persist_offset(*journal, committed);
+	}
+}
+
+auto JournalTransport::persist_offset(Journal& journal, const uint64_t& offset) -> void
+{
+	// Fixed width, so the record is overwritten in place and stays readable with cat
+	auto record = std::format("{:020}\n", offset);
+	[[maybe_unused]] auto written = ::pwrite(journal.offset_fd, record.data(), record.size(), 0);
+}
+
+auto JournalTransport::request_path(const std::string& client_id) const -> std::string
+{
+	return (std::filesystem::path(config_.root) / config_.requests_dir / (client_id + journal_suffix)).string();
+}
+
+auto JournalTransport::response_path(const std::string& client_id) const -> std::string
+{
+	return (std::filesystem::path(config_.root) / config_.responses_dir / (client_id + journal_suffix)).string();
+}
+
+auto JournalTransport::offset_path(const std::string& client_id) const -> std::string
+{
+	return (std::filesystem::path(config_.root) / config_.processing_dir / (client_id + ".offset")).string();
+}
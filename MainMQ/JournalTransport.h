@@ -0,0 +1,83 @@
+#pragma once
+
+#include "MailboxTypes.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+
+// Server side of the append-only journal mailbox transport.
+// A client appends framed requests (4-byte big-endian length + JSON, as on the socket) to {requests}/{client_id}.log
+// and reads its responses, framed the same way, from {responses}/{client_id}.log. One thread tails every request
+// journal from its consumed offset, which is kept as text in {processing}/{client_id}.offset and only moves past a
+// request once it is answered, so a restart replays what was in flight.
+// Writers append one whole frame per write while holding flock(LOCK_EX) on the journal; the transport truncates a
+// fully answered request journal under the same lock once it reaches roll_bytes. Response journals belong to the
+// client, which truncates them the same way after reading them to the end.
+class JournalTransport
+{
+public:
+	JournalTransport(const MailboxConfig& config);
+	~JournalTransport(void);
+
+	auto start(TransportRequestCallback callback) -> std::tuple<bool, std::optional<std::string>>;
+	auto stop(void) -> void;
+
+	auto journal_count(void) -> size_t;
+	auto rolls(void) const -> uint64_t { return rolls_.load(); }
+
+	// Client side of the locking protocol: appends one frame to a journal
+	static auto append(const std::string& journal_path, const std::string& content) -> std::tuple<bool, std::optional<std::string>>;
+
+private:
+	struct Journal
+	{
+		std::string client_id;
+		int request_fd = -1;
+		int response_fd = -1;
+		int offset_fd = -1;
+
+		// Owned by the transport thread
+		uint64_t read_offset = 0;
+		std::string input;
+		bool broken = false;
+
+		// Frames handed out but not yet answered, by end offset; committed is the end of the answered prefix
+		std::mutex mutex;
+		std::map<uint64_t, bool> in_flight;
+		uint64_t committed = 0;
+		bool closed = false;
+	};
+
+	auto run(void) -> void;
+	auto scan_journals(void) -> void;
+	auto find_journal(const std::string& client_id) -> std::shared_ptr<Journal>;
+	auto open_journal(const std::string& client_id) -> std::shared_ptr<Journal>;
+	auto close_journal(Journal& journal) -> void;
+	auto read_journal(const std::shared_ptr<Journal>& journal) -> void;
+	auto roll_journal(Journal& journal) -> void;
+	auto reply(const std::weak_ptr<Journal>& target, const uint64_t& end_offset, const std::string& content) -> void;
+	auto persist_offset(Journal& journal, const uint64_t& offset) -> void;
+
+	auto request_path(const std::string& client_id) const -> std::string;
+	auto response_path(const std::string& client_id) const -> std::string;
+	auto offset_path(const std::string& client_id) const -> std::string;
+
+private:
+	MailboxConfig config_;
+	TransportRequestCallback callback_;
+
+	int notify_fd_;
+	int wake_fd_;
+	std::atomic<uint64_t> rolls_;
+
+	std::map<std::string, std::shared_ptr<Journal>> journals_;
+	std::mutex journals_mutex_;
+
+	std::atomic<bool> running_;
+	std::unique_ptr<std::thread> thread_;
+};
@@ -0,0 +1,526 @@
+#include "JsonFieldScanner.h"
+
+#include <charconv>
+#include <cmath>
+#include <format>
+
+namespace
+{
+	auto is_whitespace(char c) -> bool
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	auto hex_value(char c) -> int
+	{
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	}
+
+	auto read_hex4(std::string_view text, size_t pos, uint32_t& value) -> bool
+	{
+		if (pos + 4 > text.size())
+		{
+			return false;
+		}
+
+		value = 0;
+		for (size_t index = pos; index < pos + 4; ++index)
+		{
+			auto digit = hex_value(text[index]);
+			if (digit < 0)
+			{
+				return false;
+			}
+			value = (value << 4) | static_cast<uint32_t>(digit);
+		}
+		return true;
+	}
+
+	// Length of the well-formed UTF-8 sequence at pos (RFC 3629: no overlongs, surrogates or code points past U+10FFFF), 0 if malformed
+	auto utf8_sequence_length(std::string_view text, size_t pos) -> size_t
+	{
+		auto lead = static_cast<unsigned char>(text[pos]);
+		if (lead < 0x80)
+		{
+			return 1;
+		}
+
+		size_t length = 0;
+		unsigned char second_min = 0x80;
+		unsigned char second_max = 0xBF;
+		if (lead >= 0xC2 && lead <= 0xDF)
+		{
+			length = 2;
+		}
+		else if (lead >= 0xE0 && lead <= 0xEF)
+		{
+			length = 3;
+			second_min = lead == 0xE0 ? 0xA0 : 0x80;
+			second_max = lead == 0xED ? 0x9F : 0xBF;
+		}
+		else if (lead >= 0xF0 && lead <= 0xF4)
+		{
+			length = 4;
+			second_min = lead == 0xF0 ? 0x90 : 0x80;
+			second_max = lead == 0xF4 ? 0x8F : 0xBF;
+		}
+		else
+		{
+			return 0;
+		}
+
+		if (pos + length > text.size())
+		{
+			return 0;
+		}
+
+		auto second = static_cast<unsigned char>(text[pos + 1]);
+		if (second < second_min || second > second_max)
+		{
+			return 0;
+		}
+		for (size_t index = pos + 2; index < pos + length; ++index)
+		{
+			if ((static_cast<unsigned char>(text[index]) & 0xC0) != 0x80)
+			{
+				return 0;
+			}
+		}
+
+		return length;
+	}
+
+	auto is_valid_utf8(std::string_view text) -> bool
+	{
+		for (size_t pos = 0; pos < text.size();)
+		{
+			auto length = utf8_sequence_length(text, pos);
+			if (length == 0)
+			{
+				return false;
+			}
+			pos += length;
+		}
+		return true;
+	}
+
+	// pos is on the 'u' of a \u escape; on success it is left on the last hex digit consumed, after a low surrogate if one was needed
+	auto read_unicode_escape(std::string_view text, size_t& pos, uint32_t& code_point) -> bool
+	{
+		if (!read_hex4(text, pos + 1, code_point))
+		{
+			return false;
+		}
+		pos += 4;
+
+		if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+		{
+			return false;
+		}
+
+		if (code_point >= 0xD800 && code_point <= 0xDBFF)
+		{
+			uint32_t low = 0;
+			if (pos + 2 >= text.size() || text[pos + 1] != '\\' || text[pos + 2] != 'u' || !read_hex4(text, pos + 3, low) || low < 0xDC00
+				|| low > 0xDFFF)
+			{
+				return false;
+			}
+			code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+			pos += 6;
+		}
+
+		return true;
+	}
+
+	auto append_utf8(std::string& out, uint32_t code_point) -> void
+	{
+		if (code_point < 0x80)
+		{
+			out.push_back(static_cast<char>(code_point));
+		}
+		else if (code_point < 0x800)
+		{
+			out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+			out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+		}
+		else if (code_point < 0x10000)
+		{
+			out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+			out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+		}
+		else
+		{
+			out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+			out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+		}
+	}
+}
+
+auto JsonFieldScanner::scan(std::string_view text) -> std::tuple<bool, std::optional<std::string>>
+{
+	fields_.clear();
+
+	size_t pos = 0;
+	skip_whitespace(text, pos);
+	if (pos >= text.size() || text[pos] != '{')
+	{
+		return { false, "expected object" };
+	}
+	++pos;
+
+	skip_whitespace(text, pos);
+	if (pos < text.size() && text[pos] == '}')
+	{
+		++pos;
+	}
+	else
+	{
+		while (true)
+		{
+			skip_whitespace(text, pos);
+			auto key_start = pos;
+			if (pos >= text.size() || text[pos] != '"' || !skip_string(text, pos))
+			{
+				return { false, std::format("expected member name at offset {}", key_start) };
+			}
+			auto key = text.substr(key_start + 1, pos - key_start - 2);
+
+			skip_whitespace(text, pos);
+			if (pos >= text.size() || text[pos] != ':')
+			{
+				return { false, std::format("expected ':' at offset {}", pos) };
+			}
+			++pos;
+
+			skip_whitespace(text, pos);
+			auto value_start = pos;
+			if (!skip_value(text, pos))
+			{
+				return { false, std::format("invalid value at offset {}", value_start) };
+			}
+			fields_.emplace_back(key, text.substr(value_start, pos - value_start));
+
+			skip_whitespace(text, pos);
+			if (pos < text.size() && text[pos] == ',')
+			{
+				++pos;
+				continue;
+			}
+			if (pos < text.size() && text[pos] == '}')
+			{
+				++pos;
+				break;
+			}
+			return { false, std::format("expected ',' or '}}' at offset {}", pos) };
+		}
+	}
+
+	skip_whitespace(text, pos);
+	if (pos != text.size())
+	{
+		return { false, std::format("trailing characters at offset {}", pos) };
+	}
+
+	return { true, std::nullopt };
+}
+
+auto JsonFieldScanner::contains(std::string_view key) const -> bool
+{
+	return raw(key).has_value();
+}
+
+auto JsonFieldScanner::raw(std::string_view key) const -> std::optional<std::string_view>
+{
+	// Later duplicates win, as with a DOM parser
+	for (auto field = fields_.rbegin(); field != fields_.rend(); ++field)
+	{
+		if (field->first == key)
+		{
+			return field->second;
+		}
+	}
+
+	return std::nullopt;
+}
+
+auto JsonFieldScanner::string(std::string_view key) const -> std::optional<std::string>
+{
+	auto value = raw(key);
+	if (!value.has_value() || value->front() != '"')
+	{
+		return std::nullopt;
+	}
+
+	return decode_string(value.value());
+}
+
+auto JsonFieldScanner::int64(std::string_view key) const -> std::optional<int64_t>
+{
+	auto value = raw(key);
+	if (!value.has_value())
+	{
+		return std::nullopt;
+	}
+
+	auto first = value->data();
+	auto last = value->data() + value->size();
+
+	int64_t result = 0;
+	auto [end, error] = std::from_chars(first, last, result);
+	if (error == std::errc() && end == last)
+	{
+		return result;
+	}
+
+	// Fractional or exponent forms truncate like a DOM number conversion would
+	double real = 0;
+	auto [real_end, real_error] = std::from_chars(first, last, real);
+	if (real_error == std::errc() && real_end == last && std::isfinite(real))
+	{
+		return static_cast<int64_t>(real);
+	}
+
+	return std::nullopt;
+}
+
+auto JsonFieldScanner::boolean(std::string_view key) const -> std::optional<bool>
+{
+	auto value = raw(key);
+	if (value == "true")
+	{
+		return true;
+	}
+	if (value == "false")
+	{
+		return false;
+	}
+
+	return std::nullopt;
+}
+
+auto JsonFieldScanner::is_string(std::string_view key) const -> bool
+{
+	auto value = raw(key);
+	return value.has_value() && value->front() == '"';
+}
+
+auto JsonFieldScanner::is_object(std::string_view key) const -> bool
+{
+	auto value = raw(key);
+	return value.has_value() && value->front() == '{';
+}
+
+auto JsonFieldScanner::decode_string(std::string_view raw) -> std::optional<std::string>
+{
+	if (raw.size() < 2 || raw.front() != '"' || raw.back() != '"')
+	{
+		return std::nullopt;
+	}
+
+	auto body = raw.substr(1, raw.size() - 2);
+
+	// Most strings carry no escapes and are copied in one go; like the DOM, only valid UTF-8 comes out
+	auto escape = body.find('\\');
+	if (escape == std::string_view::npos)
+	{
+		if (!is_valid_utf8(body))
+		{
+			return std::nullopt;
+		}
+		return std::string(body);
+	}
+
+	if (!is_valid_utf8(body.substr(0, escape)))
+	{
+		return std::nullopt;
+	}
+
+	std::string out;
+	out.reserve(body.size());
+	out.append(body.substr(0, escape));
+
+	for (size_t pos = escape; pos < body.size(); ++pos)
+	{
+		char c = body[pos];
+		if (c != '\\')
+		{
+			auto length = utf8_sequence_length(body, pos);
+			if (length == 0)
+			{
+				return std::nullopt;
+			}
+			out.append(body.substr(pos, length));
+			pos += length - 1;
+			continue;
+		}
+
+		if (++pos >= body.size())
+		{
+			return std::nullopt;
+		}
+
+		switch (body[pos])
+		{
+		case '"': out.push_back('"'); break;
+		case '\\': out.push_back('\\'); break;
+		case '/': out.push_back('/'); break;
+		case 'b': out.push_back('\b'); break;
+		case 'f': out.push_back('\f'); break;
+		case 'n': out.push_back('\n'); break;
+		case 'r': out.push_back('\r'); break;
+		case 't': out.push_back('\t'); break;
+		case 'u':
+		{
+			uint32_t code_point = 0;
+			if (!read_unicode_escape(body, pos, code_point))
+			{
+				return std::nullopt;
+			}
+
+			append_utf8(out, code_point);
+			break;
+		}
+		default:
+			return std::nullopt;
+		}
+	}
+
+	return out;
+}
+
+auto JsonFieldScanner::skip_whitespace(std::string_view text, size_t& pos) -> void
+{
+	while (pos < text.size() && is_whitespace(text[pos]))
+	{
+		++pos;
+	}
+}
+
+auto JsonFieldScanner::skip_string(std::string_view text, size_t& pos) -> bool
+{
+	// pos is on the opening quote. Escapes and UTF-8 are checked here so nothing accepted can fail a later dump()
+	for (++pos; pos < text.size(); ++pos)
+	{
+		auto c = static_cast<unsigned char>(text[pos]);
+		if (c == '\\')
+		{
+			if (++pos >= text.size())
+			{
+				return false;
+			}
+
+			uint32_t code_point = 0;
+			switch (text[pos])
+			{
+			case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+				break;
+			case 'u':
+				if (!read_unicode_escape(text, pos, code_point))
+				{
+					return false;
+				}
+				break;
+			default:
+				return false;
+			}
+			continue;
+		}
+		if (c == '"')
+		{
+			++pos;
+			return true;
+		}
+		if (c < 0x20)
+		{
+			return false;
+		}
+		if (c >= 0x80)
+		{
+			auto length = utf8_sequence_length(text, pos);
+			if (length == 0)
+			{
+				return false;
+			}
+			pos += length - 1;
+		}
+	}
+
+	return false;
+}
+
+auto JsonFieldScanner::skip_value(std::string_view text, size_t& pos) -> bool
+{
+	if (pos >= text.size())
+	{
+		return false;
+	}
+
+	char c = text[pos];
+	if (c == '"')
+	{
+		return skip_string(text, pos);
+	}
+
+	if (c == '{' || c == '[')
+	{
+		// Containers are only bracket-matched; their contents are validated by whoever decodes them
+		std::string closers;
+		while (pos < text.size())
+		{
+			c = text[pos];
+			if (c == '"')
+			{
+				if (!skip_string(text, pos))
+				{
+					return false;
+				}
+				continue;
+			}
+
+			if (c == '{' || c == '[')
+			{
+				closers.push_back(c == '{' ? '}' : ']');
+			}
+			else if (c == '}' || c == ']')
+			{
+				if (closers.empty() || closers.back() != c)
+				{
+					return false;
+				}
+				closers.pop_back();
+				if (closers.empty())
+				{
+					++pos;
+					return true;
+				}
+			}
+			++pos;
+		}
+
+		return false;
+	}
+
+	if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n')
+	{
+		auto start = pos;
+		while (pos < text.size() && !is_whitespace(text[pos]) && text[pos] != ',' && text[pos] != '}' && text[pos] != ']')
+		{
+			++pos;
+		}
+
+		auto token = text.substr(start, pos - start);
+		if (c == 't') return token == "true";
+		if (c == 'f') return token == "false";
+		if (c == 'n') return token == "null";
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// On-demand reader for the top-level members of a JSON object.
+// scan() only finds member boundaries: nested values are skipped over, not built, and a member is decoded
+// when it is asked for. Views point into the scanned text, which must outlive the scanner.
+class JsonFieldScanner
+{
+public:
+	JsonFieldScanner(void) = default;
+
+	auto scan(std::string_view text) -> std::tuple<bool, std::optional<std::string>>;
+
+	auto contains(std::string_view key) const -> bool;
+	auto raw(std::string_view key) const -> std::optional<std::string_view>;
+
+	// nullopt when the member is absent or has another type
+	auto string(std::string_view key) const -> std::optional<std::string>;
+	auto int64(std::string_view key) const -> std::optional<int64_t>;
+	auto boolean(std::string_view key) const -> std::optional<bool>;
+	auto is_string(std::string_view key) const -> bool;
+	auto is_object(std::string_view key) const -> bool;
+
+	static auto decode_string(std::string_view raw) -> std::optional<std::string>;
+
+private:
+	static auto skip_whitespace(std::string_view text, size_t& pos) -> void;
+	static auto skip_string(std::string_view text, size_t& pos) -> bool;
+	static auto skip_value(std::string_view text, size_t& pos) -> bool;
+
+private:
+	std::vector<std::pair<std::string_view, std::string_view>> fields_;
+};
@@ -2,17 +2,29 @@
 
 #include "BackendAdapter.h"
 #include "FolderWatcher.h"
+#include "JournalTransport.h"
+#include "LatencyHistogram.h"
 #include "MailboxTypes.h"
 #include "MessageValidator.h"
+#include "RequestWatcher.h"
+#include "ShmTransport.h"
+#include "SocketTransport.h"
 #include "ThreadPool.h"
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <set>
 #include <string>
 #include <tuple>
+#include <vector>
 
 class QueueManager;
 
@@ -49,16 +61,44 @@ private:
 
 	// Request processing loop
 	auto request_processing_worker(void) -> void;
+	auto watch_requests(void) -> void;
+	auto recover_requests(void) -> void;
+
+	// Request claims: a file stays in requests/ while claimed here and is unlinked as its response is published
+	auto claim_request(const std::string& file_path) -> bool;
+	auto unclaim_request(const std::string& file_path) -> void;
+	auto count_file_calls(const uint64_t& calls) -> void;
 	auto stale_cleanup_worker(void) -> void;
 	auto process_pending_requests(void) -> void;
 
+	// Dispatch stage: per-key FIFO lanes drained by a pool of workers, ready keys picked by weighted lane priority
+	auto dispatch_request_file(const std::string& file_path, const bool& replay = false) -> void;
+	auto dispatch_key(const MailboxRequest& request) -> std::string;
+	auto lane_of(const MailboxRequest& request) -> MailboxLane;
+	auto carries_publish(const MailboxRequest& request) -> bool;
+	auto dispatch_worker(const size_t& index) -> void;
+
+	// Admission control: per-queue counters kept by the handler so a publish is admitted without a backend scan
+	auto limits_of(const std::string& queue) -> MailboxQueueLimits;
+	auto admit_publish(const std::string& queue, const uint64_t& bytes) -> std::optional<std::string>;
+	auto adjust_admission(const std::string& queue, const int64_t& ready_delta, const int64_t& stored_delta,
+						  const std::optional<int64_t>& bytes_delta = std::nullopt) -> void;
+	auto refresh_admission(void) -> void;
+
+	// Long-poll ConsumeNext: parked requests are re-dispatched on wakeup or at their wait deadline
+	auto begin_poll(const std::string& queue) -> uint64_t;
+	auto end_poll(const std::string& queue) -> void;
+	auto poll_slot(const std::string& queue) -> std::atomic<uint32_t>&;
+	auto wake_waiters(const std::string& queue) -> void;
+	auto expire_waiters(void) -> void;
+
 	// File operations (atomic write)
 	auto read_request_file(const std::string& file_path) -> std::tuple<std::optional<MailboxRequest>, std::optional<std::string>>;
-	auto write_response_file(const std::string& client_id, const MailboxResponse& response) -> std::tuple<bool, std::optional<std::string>>;
-	auto atomic_write(const std::string& target_path, const std::string& content) -> std::tuple<bool, std::optional<std::string>>;
-	auto move_to_processing(const std::string& request_file) -> std::tuple<std::string, std::optional<std::string>>;
-	auto move_to_dead(const std::string& processing_file, const std::string& reason) -> std::tuple<bool, std::optional<std::string>>;
-	auto delete_processed(const std::string& processing_file) -> std::tuple<bool, std::optional<std::string>>;
+	// Returns whether the request file is gone, and the error of whichever step failed
+	auto write_response_file(const std::string& client_id, const MailboxResponse& response, const std::string& request_path)
+		-> std::tuple<bool, std::optional<std::string>>;
+	auto serialize_response(const MailboxResponse& response, const bool& indent) -> const std::string&;
+	auto move_to_dead(const std::string& request_file, const std::string& reason) -> std::tuple<bool, std::optional<std::string>>;
 
 	// Request parsing
 	auto parse_request(const std::string& json_content, const std::string& file_path) -> std::tuple<std::optional<MailboxRequest>, std::optional<std::string>>;
@@ -76,23 +116,79 @@ private:
 	auto handle_metrics(const MailboxRequest& request) -> MailboxResponse;
 	auto handle_list_dlq(const MailboxRequest& request) -> MailboxResponse;
 	auto handle_reprocess_dlq(const MailboxRequest& request) -> MailboxResponse;
+	auto handle_batch(const MailboxRequest& request) -> MailboxResponse;
 
 	// Response building
 	auto build_success_response(const std::string& request_id, const std::string& data_json = "{}") -> MailboxResponse;
 	auto build_error_response(const std::string& request_id, const std::string& error_code, const std::string& error_message) -> MailboxResponse;
+	auto build_backpressure_response(const std::string& request_id, const std::string& error_message) -> MailboxResponse;
 
-	// Stale request handling
-	auto cleanup_stale_requests(void) -> void;
+	// Stale response handling
 	auto cleanup_stale_responses(void) -> void;
 
 	// Utilities
 	auto current_time_ms(void) -> int64_t;
+	auto current_time_us(void) -> int64_t;
 	auto generate_uuid(void) -> std::string;
+	auto queue_of_key(const std::string& message_key) -> std::string;
 	auto list_files(const std::string& dir_path) -> std::vector<std::string>;
 
 	// Metrics helpers
 	auto record_request_start(void) -> int64_t;
 	auto record_request_end(MailboxCommand command, bool success, const std::string& error_code, int64_t start_time) -> void;
+	auto stage_latency(const MailboxStage& stage) -> Utilities::LatencyHistogram&;
+
+	template <typename Call>
+	auto backend_call(Call&& call) -> decltype(call())
+	{
+		Utilities::ScopedLatency timer(stage_latency(MailboxStage::Backend));
+		return call();
+	}
+
+private:
+	struct DispatchItem
+	{
+		MailboxRequest request;
+		std::string request_path;
+		std::function<void(const MailboxResponse&)> reply;  // set for transport requests instead of a response file
+		std::chrono::steady_clock::time_point queued_at;
+	};
+
+	// ready counts ready + delayed messages, stored adds leased ones; bytes follow stored at its running average
+	struct QueueAdmission
+	{
+		uint64_t ready = 0;
+		uint64_t stored = 0;
+		uint64_t bytes = 0;
+	};
+
+	// Written only by its own worker; padded so neighbouring workers do not share a cache line
+	struct alignas(64) DispatchWorkerStats
+	{
+		std::atomic<uint64_t> requests{ 0 };
+		std::atomic<uint64_t> busy_us{ 0 };
+	};
+
+	struct DispatchLaneStats
+	{
+		Utilities::ShardedCounter dispatched;
+		Utilities::ShardedCounter wait_us;
+		std::atomic<uint64_t> max_wait_us{ 0 };
+	};
+
+	static constexpr size_t lane_count = static_cast<size_t>(MailboxLane::Count);
+	static constexpr size_t command_count = static_cast<size_t>(MailboxCommand::Batch) + 1;
+	static constexpr size_t stage_count = static_cast<size_t>(MailboxStage::Count);
+	static constexpr size_t poll_slot_count = 64;
+
+	auto push_dispatch_locked(DispatchItem item) -> void;
+	auto push_ready_locked(const std::string& key) -> void;
+	auto pop_ready_locked(void) -> std::string;
+	auto execute_request(const DispatchItem& item) -> void;
+	auto deliver_response(const DispatchItem& item, const MailboxResponse& response) -> void;
+	auto admit_dispatch(DispatchItem item) -> void;
+	auto on_transport_request(const std::string& client_id, const std::string& content, TransportReply reply) -> void;
+	auto park_request(DispatchItem item, const std::string& queue, const uint64_t& sequence) -> void;
 
 private:
 	std::atomic<bool> running_;
@@ -101,13 +197,51 @@ private:
 	std::shared_ptr<QueueManager> queue_manager_;
 	std::shared_ptr<Thread::ThreadPool> thread_pool_;
 	MessageValidator validator_;
-	std::mutex processing_mutex_;
-	mutable std::mutex metrics_mutex_;
-	MailboxMetrics metrics_;
+	std::unique_ptr<MailboxMetrics> metrics_;  // replaced on start(), before any worker records into it
+	std::deque<DispatchWorkerStats> worker_stats_;
+	std::array<DispatchLaneStats, lane_count> lane_stats_;
+
+	// Latency in us per command (whole request) and per stage; recorded lock-free, reset by the metrics command
+	std::array<Utilities::LatencyHistogram, command_count> command_latency_;
+	std::array<Utilities::LatencyHistogram, stage_count> stage_latency_;
+
+	// Dispatch lanes keyed by client (or queue for publishes); a key is in dispatch_ready_ or dispatch_active_, never both.
+	// A ready key waits in the priority lane of its head request; lane_credit_ drives the smooth weighted round robin.
+	std::map<std::string, std::deque<DispatchItem>> dispatch_lanes_;
+	std::array<std::deque<std::string>, lane_count> dispatch_ready_;
+	std::array<int64_t, lane_count> lane_credit_;
+	size_t dispatch_ready_count_;
+	size_t dispatch_pending_;  // items queued in dispatch_lanes_, checked against the admission high-water mark
+	std::set<std::string> dispatch_active_;
+	std::mutex dispatch_mutex_;
+	std::condition_variable dispatch_cv_;
+
+	// Parked long-poll ConsumeNext requests per queue. A poll counts in its queue's slot from before its lease attempt
+	// until it leaves the park, so a wake finding the slot empty skips the lock; queue_wakes_ holds each queue's last
+	// wake_sequence_ value, which detects a wake racing a park without reacting to other queues.
+	std::map<std::string, std::vector<DispatchItem>> consume_waiters_;
+	std::map<std::string, uint64_t> queue_wakes_;
+	std::atomic<uint64_t> wake_sequence_;
+	std::array<std::atomic<uint32_t>, poll_slot_count> poll_slots_;
+
+	// Seeded from backend metrics() on a queue's first limited publish, then maintained by the command handlers
+	std::map<std::string, QueueAdmission> admission_;
+	std::mutex admission_mutex_;
+
+	std::set<std::string> claimed_requests_;
+	std::set<std::string> response_dirs_;
+	std::mutex claim_mutex_;
+	std::atomic<uint64_t> intake_requests_;
+	std::atomic<uint64_t> intake_file_calls_;
 
 	// FolderWatcher integration
 	std::queue<std::string> pending_requests_;
 	std::mutex pending_mutex_;
 	std::condition_variable pending_cv_;
 	bool use_folder_watcher_;
+	std::unique_ptr<Utilities::RequestWatcher> request_watcher_;  // native intake; efsw FolderWatcher when unavailable
+
+	std::unique_ptr<ShmTransport> shm_transport_;
+	std::unique_ptr<SocketTransport> socket_transport_;
+	std::unique_ptr<JournalTransport> journal_transport_;
 };
@@ -1,10 +1,67 @@
 #pragma once
 
+#include "ShardedCounter.h"
+
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <map>
 #include <optional>
 #include <string>
 #include <vector>
 
+// Shared-memory transport: per-client request/response rings next to the file mailbox.
+// A client creates /{name_prefix}-{client_id} and drops {client_id}.ring into {root}/{dir} to register.
+struct ShmTransportConfig
+{
+	bool enabled = false;
+	std::string dir = "shm";
+	std::string name_prefix = "yirangmq";
+	uint32_t ring_bytes = 1024 * 1024;
+};
+
+// Unix domain socket transport: length-prefixed request/response frames over persistent connections
+struct SocketTransportConfig
+{
+	bool enabled = false;
+	std::string path = "mailbox.sock";  // relative to the mailbox root unless absolute
+	uint32_t max_frame_bytes = 16 * 1024 * 1024;
+	uint64_t max_output_bytes = 64 * 1024 * 1024;  // unsent replies per connection; reading pauses at half, the connection drops beyond it
+};
+
+// Append-only journal transport: clients append framed requests to {requests_dir}/{client_id}.log
+struct JournalTransportConfig
+{
+	bool enabled = false;
+	uint32_t max_frame_bytes = 16 * 1024 * 1024;
+	uint64_t roll_bytes = 1024 * 1024;  // a fully answered journal at least this large is truncated; 0 truncates whenever drained
+};
+
+// Relative dispatch share of each lane while all of them have work queued
+struct MailboxLaneWeights
+{
+	int32_t settle = 8;
+	int32_t consume = 4;
+	int32_t publish = 2;
+	int32_t admin = 1;
+};
+
+// Publish admission limits per queue; 0 is unlimited
+struct MailboxQueueLimits
+{
+	uint64_t max_ready_depth = 0;  // ready + delayed messages
+	uint64_t max_bytes = 0;  // payload bytes held by the queue, leased messages included
+};
+
+// Publishes over a limit are answered with ERR_BACKPRESSURE and a retry-after hint instead of being stored
+struct MailboxAdmissionConfig
+{
+	uint32_t max_pending_requests = 0;  // requests waiting for a dispatch worker; 0 is unlimited
+	int32_t retry_after_ms = 1000;
+	MailboxQueueLimits queue_defaults;
+	std::map<std::string, MailboxQueueLimits> queue_limits;
+};
+
 // Mailbox IPC configuration
 struct MailboxConfig
 {
@@ -16,8 +73,20 @@ struct MailboxConfig
 	int32_t stale_timeout_ms = 30000;
 	int32_t poll_interval_ms = 100;
 	bool use_folder_watcher = true;
+	int32_t dispatch_workers = 4;
+	bool pretty_responses = false;  // debug: indent response files
+	MailboxLaneWeights lane_weights;
+	MailboxAdmissionConfig admission;
+	ShmTransportConfig shm;
+	SocketTransportConfig socket;
+	JournalTransportConfig journal;
 };
 
+// Transports hand raw request documents to the handler and get the serialized response back on reply.
+// A non-empty client_id is authoritative (the channel identifies the client); empty keeps the request's clientId.
+using TransportReply = std::function<void(const std::string& content)>;
+using TransportRequestCallback = std::function<void(const std::string& client_id, const std::string& content, TransportReply reply)>;
+
 // Mailbox command types
 enum class MailboxCommand
 {
@@ -31,7 +100,36 @@ enum class MailboxCommand
 	Health,
 	Metrics,
 	ListDlq,
-	ReprocessDlq
+	ReprocessDlq,
+	Batch
+};
+
+// Scheduling classes: settling leases must not wait behind a publish flood, or leases expire and redeliveries add to the load
+enum class MailboxLane : uint8_t
+{
+	Settle = 0,  // Ack, Nack, ExtendLease, Health
+	Consume,
+	Publish,
+	Admin,  // Status, Metrics, ListDlq, ReprocessDlq
+	Count
+};
+
+// One entry of a multi-command request; entries run in order under the envelope's ids and deadline
+struct MailboxSubCommand
+{
+	MailboxCommand command = MailboxCommand::Unknown;
+	std::string payload_json;
+};
+
+// Request stages timed by the latency histograms
+enum class MailboxStage
+{
+	QueueWait,
+	Parse,
+	Validation,
+	Backend,
+	ResponseWrite,
+	Count
 };
 
 // Mailbox request structure
@@ -44,6 +142,9 @@ struct MailboxRequest
 	int64_t deadline_ms = 0;
 	std::string payload_json;
 	std::string file_path;
+	int64_t wait_until_ms = 0;  // set once a long-poll ConsumeNext is parked
+	int64_t received_us = 0;  // file mtime or transport receipt (epoch us); the queue-wait stage starts here
+	std::vector<MailboxSubCommand> commands;  // Batch only
 };
 
 // Mailbox response structure
@@ -54,6 +155,15 @@ struct MailboxResponse
 	std::string data_json;
 	std::string error_code;
 	std::string error_message;
+	int64_t retry_after_ms = 0;  // backpressure: how long the client should back off
+
+	// Long-poll ConsumeNext with nothing ready: no response is written, the request is parked on wait_queue
+	std::string wait_queue;
+	int64_t wait_until_ms = 0;
+	uint64_t wait_sequence = 0;  // wake sequence seen before the lease attempt
+
+	// Batch: per-command results in request order
+	std::vector<MailboxResponse> results;
 };
 
 // Publish command payload
@@ -73,6 +183,7 @@ struct ConsumeNextPayload
 	std::string queue;
 	std::string consumer_id;
 	int32_t visibility_timeout_sec = 30;
+	int32_t wait_ms = 0;  // long-poll: hold the request until a message is ready or this elapses
 };
 
 // Ack command payload
@@ -121,32 +232,34 @@ struct ReprocessDlqPayload
 	std::string message_key;
 };
 
-// Mailbox handler metrics
+// Mailbox handler metrics; counters are sharded per thread and summed when read, so recording takes no lock
 struct MailboxMetrics
 {
 	// Request counters
-	uint64_t total_requests = 0;
-	uint64_t success_count = 0;
-	uint64_t error_count = 0;
+	Utilities::ShardedCounter total_requests;
+	Utilities::ShardedCounter success_count;
+	Utilities::ShardedCounter error_count;
 
 	// Per-command counters
-	uint64_t publish_count = 0;
-	uint64_t consume_count = 0;
-	uint64_t ack_count = 0;
-	uint64_t nack_count = 0;
-	uint64_t status_count = 0;
-	uint64_t health_count = 0;
-	uint64_t dlq_count = 0;
+	Utilities::ShardedCounter publish_count;
+	Utilities::ShardedCounter consume_count;
+	Utilities::ShardedCounter ack_count;
+	Utilities::ShardedCounter nack_count;
+	Utilities::ShardedCounter status_count;
+	Utilities::ShardedCounter health_count;
+	Utilities::ShardedCounter dlq_count;
+	Utilities::ShardedCounter batch_count;
 
 	// Error type counters
-	uint64_t parse_errors = 0;
-	uint64_t validation_errors = 0;
-	uint64_t timeout_errors = 0;
-	uint64_t internal_errors = 0;
+	Utilities::ShardedCounter parse_errors;
+	Utilities::ShardedCounter validation_errors;
+	Utilities::ShardedCounter timeout_errors;
+	Utilities::ShardedCounter internal_errors;
+	Utilities::ShardedCounter backpressure_errors;
 
-	// Timing (cumulative ms)
-	uint64_t total_processing_time_ms = 0;
-	uint64_t last_request_time_ms = 0;
+	// Timing (cumulative us)
+	Utilities::ShardedCounter total_processing_time_us;
+	std::atomic<int64_t> last_request_time_ms{ 0 };
 
 	// Uptime
 	int64_t start_time_ms = 0;
@@ -166,4 +279,5 @@ namespace MailboxErrorCode
 	constexpr const char* PARSE_ERROR = "ERR_PARSE_ERROR";
 	constexpr const char* VALIDATION_FAILED = "ERR_VALIDATION_FAILED";
 	constexpr const char* DLQ_NOT_FOUND = "ERR_DLQ_NOT_FOUND";
+	constexpr const char* BACKPRESSURE = "ERR_BACKPRESSURE";  // retryable; carries retryAfterMs
 }
@@ -37,6 +37,15 @@ QueueManager::QueueManager(std::shared_ptr<BackendAdapter> backend, const QueueM
 			);
 			thread_pool_->push(retry_worker);
 
+			if (config_.consistency_interval_ms > 0)
+			{
+				auto consistency_worker = std::make_shared<Thread::ThreadWorker>(
+					std::vector<Thread::JobPriorities>{ Thread::JobPriorities::LongTerm },
+					"QueueManagerConsistencyWorker"
+				);
+				thread_pool_->push(consistency_worker);
+			}
+
 			auto [started, start_error] = thread_pool_->start();
 			if (!started)
 			{
@@ -69,6 +78,21 @@ QueueManager::QueueManager(std::shared_ptr<BackendAdapter> backend, const QueueM
 			);
 			thread_pool_->push(retry_sweep_job);
 
+			// Launch consistency worker: one bounded slice per interval so scans never hold the backend for a full pass
+			if (config_.consistency_interval_ms > 0)
+			{
+				auto consistency_job = std::make_shared<Thread::Job>(
+					Thread::JobPriorities::LongTerm,
+					[this]() -> std::tuple<bool, std::optional<std::string>>
+					{
+						consistency_worker();
+						return { true, std::nullopt };
+					},
+					"ConsistencyWorker"
+				);
+				thread_pool_->push(consistency_job);
+			}
+
 			Utilities::Logger::handle().write(Utilities::LogTypes::Information, "QueueManager started");
 			return { true, std::nullopt };
 		}
@@ -106,6 +130,21 @@ QueueManager::QueueManager(std::shared_ptr<BackendAdapter> backend, const QueueM
 			return std::nullopt;
 		}
 
+		auto QueueManager::set_ready_listener(ReadyListener listener) -> void
+		{
+			std::lock_guard<std::mutex> lock(listener_mutex_);
+			ready_listener_ = std::move(listener);
+		}
+
+		auto QueueManager::notify_ready(const std::string& queue) -> void
+		{
+			std::lock_guard<std::mutex> lock(listener_mutex_);
+			if (ready_listener_)
+			{
+				ready_listener_(queue);
+			}
+		}
+
 		auto QueueManager::lease_sweep_worker(void) -> void
 		{
 			while (running_.load())
@@ -124,6 +163,69 @@ QueueManager::QueueManager(std::shared_ptr<BackendAdapter> backend, const QueueM
 			}
 		}
 
+		auto QueueManager::consistency_worker(void) -> void
+		{
+			while (running_.load())
+			{
+				if (!check_consistency_slice())
+				{
+					return;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(config_.consistency_interval_ms));
+			}
+		}
+
+		auto QueueManager::check_consistency_slice(void) -> bool
+		{
+			auto [slice, slice_error] = backend_->check_consistency_slice(config_.consistency_slice_keys);
+			if (slice_error.has_value())
+			{
+				if (slice_error.value() == "not supported")
+				{
+					return false;
+				}
+
+				Utilities::Logger::handle().write(
+					Utilities::LogTypes::Error,
+					std::format("Consistency slice failed: {}", slice_error.value())
+				);
+				return true;
+			}
+
+			if (slice.report.issues.empty())
+			{
+				return true;
+			}
+
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Information,
+				std::format("Consistency slice for queue {} found {} issue(s) in {} key(s)", slice.queue, slice.report.issues.size(),
+							slice.checked_keys)
+			);
+
+			if (!config_.consistency_repair)
+			{
+				return true;
+			}
+
+			auto [repaired, repair_error] = backend_->repair_consistency(slice.report);
+			if (repair_error.has_value())
+			{
+				Utilities::Logger::handle().write(
+					Utilities::LogTypes::Error,
+					std::format("Consistency repair failed for queue {}: {}", slice.queue, repair_error.value())
+				);
+				return true;
+			}
+
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Information,
+				std::format("Consistency repair fixed {} issue(s) in queue {}", repaired, slice.queue)
+			);
+
+			return true;
+		}
+
 		auto QueueManager::recover_expired_leases(void) -> void
 		{
 			// First, get list of expired inflight messages with their attempt counts
@@ -156,6 +258,7 @@ QueueManager::QueueManager(std::shared_ptr<BackendAdapter> backend, const QueueM
 					if (ok)
 					{
 						recovered_count++;
+						notify_ready(info.queue);
 					}
 					continue;
 				}
@@ -214,6 +317,7 @@ QueueManager::QueueManager(std::shared_ptr<BackendAdapter> backend, const QueueM
 					Utilities::LogTypes::Information,
 					std::format("Processed {} delayed messages", processed)
 				);
+				notify_ready("");
 			}
 		}
 
@@ -4,6 +4,7 @@
 #include "ThreadPool.h"
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -14,11 +15,17 @@ struct QueueManagerConfig
 {
 	int32_t lease_sweep_interval_ms = 1000;
 	int32_t retry_sweep_interval_ms = 1000;
+	int32_t consistency_interval_ms = 0;
+	int32_t consistency_slice_keys = 512;
+	bool consistency_repair = false;
 };
 
 class QueueManager
 {
 public:
+	// Called with the queue that has newly ready messages ("" when the sweep cannot tell which)
+	using ReadyListener = std::function<void(const std::string& queue)>;
+
 	QueueManager(std::shared_ptr<BackendAdapter> backend, const QueueManagerConfig& config);
 	~QueueManager(void);
 
@@ -28,16 +35,21 @@ public:
 	auto register_queue(const std::string& queue_name, const QueuePolicy& policy) -> void;
 	auto get_policy(const std::string& queue_name) -> std::optional<QueuePolicy>;
 
+	auto set_ready_listener(ReadyListener listener) -> void;
+
 private:
 	auto lease_sweep_worker(void) -> void;
 	auto retry_sweep_worker(void) -> void;
+	auto consistency_worker(void) -> void;
 
 	auto recover_expired_leases(void) -> void;
 	auto process_delayed_messages(void) -> void;
+	auto check_consistency_slice(void) -> bool;
 	auto apply_retry_or_dlq(const std::string& message_key, const std::string& queue, int32_t attempt, const QueuePolicy& policy)
 		-> std::tuple<bool, std::optional<std::string>>;
 
 	auto calculate_backoff_delay(int32_t attempt, const RetryPolicy& policy) -> int64_t;
+	auto notify_ready(const std::string& queue) -> void;
 
 private:
 	std::atomic<bool> running_;
@@ -46,4 +58,6 @@ private:
 	std::shared_ptr<Thread::ThreadPool> thread_pool_;
 	std::map<std::string, QueuePolicy> queue_policies_;
 	std::mutex policies_mutex_;
+	ReadyListener ready_listener_;
+	std::mutex listener_mutex_;
 };
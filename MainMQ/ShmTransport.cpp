@@ -0,0 +1,292 @@
+#include "ShmTransport.h"
+
+#include "Logger.h"
+
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <vector>
+
+namespace
+{
+	constexpr size_t reply_backlog_limit = 256;
+	constexpr int32_t reply_retry_interval_us = 1000;
+
+	auto is_valid_client_id(const std::string& client_id) -> bool
+	{
+		if (client_id.empty() || client_id.size() > 200)
+		{
+			return false;
+		}
+
+		for (char c : client_id)
+		{
+			if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+ShmTransport::ShmTransport(const MailboxConfig& config)
+	: config_(config)
+	, running_(false)
+{
+}
+
+ShmTransport::~ShmTransport(void)
+{
+	stop();
+}
+
+auto ShmTransport::start(TransportRequestCallback callback) -> std::tuple<bool, std::optional<std::string>>
+{
+	if (running_.load())
+	{
+		return { false, "already running" };
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(registration_dir(), ec);
+	if (ec)
+	{
+		return { false, std::format("failed to create directory {}: {}", registration_dir(), ec.message()) };
+	}
+
+	auto [doorbell, doorbell_error] = Utilities::SharedMemoryDoorbell::create(doorbell_name(config_.shm.name_prefix));
+	if (doorbell == nullptr)
+	{
+		return { false, doorbell_error };
+	}
+
+	doorbell_ = doorbell;
+	callback_ = std::move(callback);
+	running_.store(true);
+	thread_ = std::make_unique<std::thread>(&ShmTransport::run, this);
+
+	return { true, std::nullopt };
+}
+
+auto ShmTransport::stop(void) -> void
+{
+	if (!running_.exchange(false))
+	{
+		return;
+	}
+
+	doorbell_->ring();
+	thread_->join();
+	thread_.reset();
+
+	std::lock_guard<std::mutex> lock(clients_mutex_);
+	clients_.clear();
+	doorbell_.reset();
+}
+
+auto ShmTransport::client_count(void) -> size_t
+{
+	std::lock_guard<std::mutex> lock(clients_mutex_);
+	return clients_.size();
+}
+
+auto ShmTransport::channel_name(const std::string& name_prefix, const std::string& client_id) -> std::string
+{
+	return std::format("/{}-{}", name_prefix, client_id);
+}
+
+auto ShmTransport::doorbell_name(const std::string& name_prefix) -> std::string
+{
+	return std::format("/{}-doorbell", name_prefix);
+}
+
+auto ShmTransport::run(void) -> void
+{
+	auto poll_interval = std::chrono::milliseconds(config_.poll_interval_ms);
+	auto last_scan = std::chrono::steady_clock::time_point{};
+
+	while (running_.load())
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (now - last_scan >= poll_interval)
+		{
+			scan_registrations();
+			last_scan = now;
+		}
+
+		// Sample the doorbell before draining so a push that races the drain still wakes the wait
+		auto sequence = doorbell_->sequence();
+		auto backlog = flush_replies();
+		if (drain_requests())
+		{
+			continue;
+		}
+
+		doorbell_->wait(sequence, backlog ? reply_retry_interval_us : config_.poll_interval_ms * 1000);
+	}
+}
+
+auto ShmTransport::scan_registrations(void) -> void
+{
+	std::map<std::string, bool> registered;
+
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator(registration_dir(), ec))
+	{
+		if (entry.path().extension() == ".ring")
+		{
+			registered[entry.path().stem().string()] = true;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(clients_mutex_);
+
+	// Drop clients that unregistered or closed their segment
+	for (auto client = clients_.begin(); client != clients_.end();)
+	{
+		if (registered.find(client->first) == registered.end() || client->second->channel->closed())
+		{
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Information,
+				std::format("Shared-memory client detached: {}", client->first)
+			);
+			client = clients_.erase(client);
+			continue;
+		}
+		++client;
+	}
+
+	for (const auto& [client_id, present] : registered)
+	{
+		if (clients_.find(client_id) != clients_.end() || !is_valid_client_id(client_id))
+		{
+			continue;
+		}
+
+		auto [channel, attach_error] = Utilities::SharedMemoryChannel::attach(channel_name(config_.shm.name_prefix, client_id));
+		if (channel == nullptr)
+		{
+			continue;
+		}
+
+		auto client = std::make_shared<Client>();
+		client->channel = channel;
+		clients_[client_id] = client;
+
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Information,
+			std::format("Shared-memory client attached: {}", client_id)
+		);
+	}
+}
+
+auto ShmTransport::drain_requests(void) -> bool
+{
+	std::vector<std::pair<std::string, std::shared_ptr<Client>>> clients;
+	{
+		std::lock_guard<std::mutex> lock(clients_mutex_);
+		clients.assign(clients_.begin(), clients_.end());
+	}
+
+	bool drained = false;
+	for (const auto& [client_id, client] : clients)
+	{
+		while (auto content = client->channel->pop(Utilities::SharedMemoryDirection::Request))
+		{
+			drained = true;
+			callback_(client_id, content.value(), [this, client, client_id](const std::string& response)
+			{
+				reply(client, client_id, response);
+			});
+		}
+	}
+
+	return drained;
+}
+
+auto ShmTransport::flush_replies(void) -> bool
+{
+	std::vector<std::shared_ptr<Client>> clients;
+	{
+		std::lock_guard<std::mutex> lock(clients_mutex_);
+		for (const auto& [client_id, client] : clients_)
+		{
+			clients.push_back(client);
+		}
+	}
+
+	bool backlog = false;
+	for (const auto& client : clients)
+	{
+		std::lock_guard<std::mutex> lock(client->reply_mutex);
+
+		while (!client->pending_replies.empty() && !client->channel->closed())
+		{
+			if (!std::get<0>(client->channel->push(Utilities::SharedMemoryDirection::Response, client->pending_replies.front())))
+			{
+				break;
+			}
+			client->pending_replies.pop_front();
+		}
+
+		if (client->channel->closed())
+		{
+			client->pending_replies.clear();
+		}
+		backlog = backlog || !client->pending_replies.empty();
+	}
+
+	return backlog;
+}
+
+auto ShmTransport::reply(const std::shared_ptr<Client>& client, const std::string& client_id, const std::string& content) -> void
+{
+	std::lock_guard<std::mutex> lock(client->reply_mutex);
+
+	if (client->channel->closed())
+	{
+		return;
+	}
+
+	// Earlier replies still waiting go first
+	if (client->pending_replies.empty())
+	{
+		auto [pushed, push_error] = client->channel->push(Utilities::SharedMemoryDirection::Response, content);
+		if (pushed)
+		{
+			return;
+		}
+
+		if (push_error != "ring full")
+		{
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Error,
+				std::format("Failed to reply to shared-memory client {}: {}", client_id, push_error.value_or("unknown"))
+			);
+			return;
+		}
+	}
+
+	// A full response ring means the client is behind: the transport thread retries, the worker moves on
+	if (client->pending_replies.size() >= reply_backlog_limit)
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("Failed to reply to shared-memory client {}: {} replies already waiting for the response ring", client_id,
+				client->pending_replies.size())
+		);
+		return;
+	}
+
+	client->pending_replies.push_back(content);
+}
+
+auto ShmTransport::registration_dir(void) -> std::string
+{
+	std::filesystem::path path = config_.root;
+	path /= config_.shm.dir;
+	return path.string();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "MailboxTypes.h"
+#include "SharedMemoryRing.h"
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+
+// Server side of the shared-memory mailbox transport.
+// One thread sleeps on a shared doorbell, drains every attached client's request ring and hands the raw
+// request documents to the callback; replies go back on the same client's response ring.
+class ShmTransport
+{
+public:
+	ShmTransport(const MailboxConfig& config);
+	~ShmTransport(void);
+
+	auto start(TransportRequestCallback callback) -> std::tuple<bool, std::optional<std::string>>;
+	auto stop(void) -> void;
+
+	auto client_count(void) -> size_t;
+
+	static auto channel_name(const std::string& name_prefix, const std::string& client_id) -> std::string;
+	static auto doorbell_name(const std::string& name_prefix) -> std::string;
+
+private:
+	struct Client
+	{
+		std::shared_ptr<Utilities::SharedMemoryChannel> channel;
+		std::mutex reply_mutex;
+		std::deque<std::string> pending_replies;  // waiting for room on a full response ring, in order
+	};
+
+	auto run(void) -> void;
+	auto scan_registrations(void) -> void;
+	auto drain_requests(void) -> bool;
+	auto flush_replies(void) -> bool;
+	auto reply(const std::shared_ptr<Client>& client, const std::string& client_id, const std::string& content) -> void;
+	auto registration_dir(void) -> std::string;
+
+private:
+	MailboxConfig config_;
+	TransportRequestCallback callback_;
+
+	std::shared_ptr<Utilities::SharedMemoryDoorbell> doorbell_;
+	std::map<std::string, std::shared_ptr<Client>> clients_;
+	std::mutex clients_mutex_;
+
+	std::atomic<bool> running_;
+	std::unique_ptr<std::thread> thread_;
+};
@@ -0,0 +1,474 @@
+#include "SocketTransport.h"
+
+#include "Logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <string_view>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+	constexpr size_t frame_header_bytes = 4;
+	constexpr size_t read_chunk_bytes = 64 * 1024;
+	constexpr int max_events = 64;
+
+	auto decode_length(const char* data) -> uint32_t
+	{
+		auto bytes = reinterpret_cast<const uint8_t*>(data);
+		return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8)
+			   | static_cast<uint32_t>(bytes[3]);
+	}
+}
+
+SocketTransport::SocketTransport(const MailboxConfig& config)
+	: config_(config)
+	, listen_fd_(-1)
+	, epoll_fd_(-1)
+	, wake_fd_(-1)
+	, next_connection_id_(0)
+	, running_(false)
+{
+}
+
+SocketTransport::~SocketTransport(void)
+{
+	stop();
+}
+
+auto SocketTransport::start(TransportRequestCallback callback) -> std::tuple<bool, std::optional<std::string>>
+{
+	if (running_.load())
+	{
+		return { false, "already running" };
+	}
+
+	auto path = socket_path();
+	sockaddr_un address{};
+	if (path.size() >= sizeof(address.sun_path))
+	{
+		return { false, std::format("socket path too long: {}", path) };
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+	// A socket file left by a previous run would make bind fail
+	::unlink(path.c_str());
+
+	auto fail = [this](const std::string& message) -> std::tuple<bool, std::optional<std::string>>
+	{
+		auto error = std::format("{}: {}", message, std::strerror(errno));
+		for (int* fd : { &listen_fd_, &epoll_fd_, &wake_fd_ })
+		{
+			if (*fd >= 0)
+			{
+				::close(*fd);
+				*fd = -1;
+			}
+		}
+		return { false, error };
+	};
+
+	listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listen_fd_ < 0)
+	{
+		return fail("socket failed");
+	}
+
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+	{
+		return fail(std::format("bind {} failed", path));
+	}
+
+	if (::listen(listen_fd_, SOMAXCONN) < 0)
+	{
+		return fail("listen failed");
+	}
+
+	epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+	wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (epoll_fd_ < 0 || wake_fd_ < 0)
+	{
+		return fail("epoll setup failed");
+	}
+
+	for (int fd : { listen_fd_, wake_fd_ })
+	{
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0)
+		{
+			return fail("epoll_ctl failed");
+		}
+	}
+
+	callback_ = std::move(callback);
+	running_.store(true);
+	thread_ = std::make_unique<std::thread>(&SocketTransport::run, this);
+
+	Utilities::Logger::handle().write(
+		Utilities::LogTypes::Information,
+		std::format("Socket transport listening on {}", path)
+	);
+
+	return { true, std::nullopt };
+}
+
+auto SocketTransport::stop(void) -> void
+{
+	if (!running_.exchange(false))
+	{
+		return;
+	}
+
+	uint64_t one = 1;
+	[[maybe_unused]] auto written = ::write(wake_fd_, &one, sizeof(one));
+	thread_->join();
+	thread_.reset();
+
+	std::vector<std::shared_ptr<Connection>> connections;
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex_);
+		for (const auto& [fd, connection] : connections_)
+		{
+			connections.push_back(connection);
+		}
+	}
+	for (const auto& connection : connections)
+	{
+		close_connection(connection);
+	}
+
+	::close(listen_fd_);
+	::close(epoll_fd_);
+	::close(wake_fd_);
+	listen_fd_ = epoll_fd_ = wake_fd_ = -1;
+
+	::unlink(socket_path().c_str());
+}
+
+auto SocketTransport::connection_count(void) -> size_t
+{
+	std::lock_guard<std::mutex> lock(connections_mutex_);
+	return connections_.size();
+}
+
+auto SocketTransport::socket_path(void) const -> std::string
+{
+	std::filesystem::path path = config_.socket.path;
+	if (path.is_relative())
+	{
+		path = std::filesystem::path(config_.root) / path;
+	}
+	return path.string();
+}
+
+auto SocketTransport::encode_frame(const std::string& content) -> std::string
+{
+	auto length = static_cast<uint32_t>(content.size());
+
+	std::string frame;
+	frame.reserve(frame_header_bytes + content.size());
+	frame.push_back(static_cast<char>((length >> 24) & 0xFF));
+	frame.push_back(static_cast<char>((length >> 16) & 0xFF));
+	frame.push_back(static_cast<char>((length >> 8) & 0xFF));
+	frame.push_back(static_cast<char>(length & 0xFF));
+	frame.append(content);
+
+	return frame;
+}
+
+auto SocketTransport::run(void) -> void
+{
+	epoll_event events[max_events];
+
+	while (running_.load())
+	{
+		int count = ::epoll_wait(epoll_fd_, events, max_events, config_.poll_interval_ms);
+		if (count < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			Utilities::Logger::handle().write(
+				Utilities::LogTypes::Error,
+				std::format("Socket transport epoll_wait failed: {}", std::strerror(errno))
+			);
+			break;
+		}
+
+		for (int index = 0; index < count; ++index)
+		{
+			int fd = events[index].data.fd;
+			if (fd == wake_fd_)
+			{
+				uint64_t value = 0;
+				[[maybe_unused]] auto consumed = ::read(wake_fd_, &value, sizeof(value));
+				continue;
+			}
+
+			if (fd == listen_fd_)
+			{
+				accept_connections();
+				continue;
+			}
+
+			std::shared_ptr<Connection> connection;
+			{
+				std::lock_guard<std::mutex> lock(connections_mutex_);
+				auto found = connections_.find(fd);
+				if (found == connections_.end())
+				{
+					continue;
+				}
+				connection = found->second;
+			}
+
+			bool alive = true;
+			if (events[index].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+			{
+				alive = read_connection(connection);
+			}
+			if (alive && (events[index].events & EPOLLOUT))
+			{
+				alive = write_connection(connection);
+			}
+			if (!alive)
+			{
+				close_connection(connection);
+			}
+		}
+	}
+}
+
+auto SocketTransport::accept_connections(void) -> void
+{
+	while (true)
+	{
+		int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			{
+				Utilities::Logger::handle().write(
+					Utilities::LogTypes::Error,
+					std::format("Socket transport accept failed: {}", std::strerror(errno))
+				);
+			}
+			return;
+		}
+
+		auto connection = std::make_shared<Connection>();
+		connection->fd = fd;
+		connection->id = ++next_connection_id_;
+		connection->events = EPOLLIN;
+
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0)
+		{
+			::close(fd);
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(connections_mutex_);
+		connections_[fd] = connection;
+	}
+}
+
+auto SocketTransport::read_connection(const std::shared_ptr<Connection>& connection) -> bool
+{
+	char buffer[read_chunk_bytes];
+	std::weak_ptr<Connection> target = connection;
+
+	while (true)
+	{
+		auto received = ::recv(connection->fd, buffer, sizeof(buffer), 0);
+		if (received == 0)
+		{
+			return false;
+		}
+		if (received < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		connection->input.append(buffer, static_cast<size_t>(received));
+
+		// Frames are dispatched chunk by chunk, so input never holds more than one partial frame and a chunk
+		std::string_view input = connection->input;
+		size_t offset = 0;
+		while (input.size() - offset >= frame_header_bytes)
+		{
+			auto length = decode_length(input.data() + offset);
+			if (length == 0 || length > config_.socket.max_frame_bytes)
+			{
+				Utilities::Logger::handle().write(
+					Utilities::LogTypes::Error,
+					std::format("Socket connection {} sent an invalid frame length {}", connection->id, length)
+				);
+				return false;
+			}
+
+			if (input.size() - offset - frame_header_bytes < length)
+			{
+				break;
+			}
+
+			callback_("", std::string(input.substr(offset + frame_header_bytes, length)), [this, target](const std::string& response)
+			{
+				reply(target, response);
+			});
+			offset += frame_header_bytes + length;
+		}
+
+		if (offset > 0)
+		{
+			connection->input.erase(0, offset);
+		}
+
+		// Replies are backing up: leave the rest in the socket until the client drains them
+		std::lock_guard<std::mutex> lock(connection->output_mutex);
+		if ((connection->events & EPOLLIN) == 0)
+		{
+			return true;
+		}
+	}
+}
+
+auto SocketTransport::write_connection(const std::shared_ptr<Connection>& connection) -> bool
+{
+	std::lock_guard<std::mutex> lock(connection->output_mutex);
+	if (connection->closed)
+	{
+		return false;
+	}
+
+	if (!flush_locked(*connection))
+	{
+		return false;
+	}
+
+	update_events_locked(*connection);
+	return true;
+}
+
+auto SocketTransport::close_connection(const std::shared_ptr<Connection>& connection) -> void
+{
+	{
+		std::lock_guard<std::mutex> lock(connection->output_mutex);
+		if (connection->closed)
+		{
+			return;
+		}
+
+		connection->closed = true;
+		::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+		::close(connection->fd);
+	}
+
+	std::lock_guard<std::mutex> lock(connections_mutex_);
+	connections_.erase(connection->fd);
+}
+
+auto SocketTransport::reply(const std::weak_ptr<Connection>& target, const std::string& content) -> void
+{
+	auto connection = target.lock();
+	if (connection == nullptr)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(connection->output_mutex);
+	if (connection->closed)
+	{
+		return;
+	}
+
+	// Write inline from the dispatch worker; only a full socket buffer hands the rest to the event loop
+	connection->output.append(encode_frame(content));
+	if (!flush_locked(*connection))
+	{
+		connection->output.clear();
+		return;
+	}
+
+	// The event loop owns the descriptor, so an overflowing connection is shut down here and closed there
+	if (connection->output.size() > config_.socket.max_output_bytes)
+	{
+		Utilities::Logger::handle().write(
+			Utilities::LogTypes::Error,
+			std::format("Socket connection {} dropped: {} bytes of replies unsent", connection->id, connection->output.size())
+		);
+		connection->output.clear();
+		::shutdown(connection->fd, SHUT_RDWR);
+		return;
+	}
+
+	update_events_locked(*connection);
+}
+
+auto SocketTransport::flush_locked(Connection& connection) -> bool
+{
+	size_t sent = 0;
+	while (sent < connection.output.size())
+	{
+		auto written = ::send(connection.fd, connection.output.data() + sent, connection.output.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (written > 0)
+		{
+			sent += static_cast<size_t>(written);
+			continue;
+		}
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break;
+		}
+		return false;
+	}
+
+	connection.output.erase(0, sent);
+	return true;
+}
+
+auto SocketTransport::update_events_locked(Connection& connection) -> void
+{
+	uint32_t events = connection.output.size() < config_.socket.max_output_bytes / 2 ? EPOLLIN : 0;
+	if (!connection.output.empty())
+	{
+		events |= EPOLLOUT;
+	}
+
+	if (events == connection.events)
+	{
+		return;
+	}
+
+	connection.events = events;
+
+	epoll_event event{};
+	event.events = events;
+	event.data.fd = connection.fd;
+	::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+}
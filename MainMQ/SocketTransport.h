@@ -0,0 +1,68 @@
+#pragma once
+
+#include "MailboxTypes.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+
+// Server side of the Unix domain socket mailbox transport.
+// Frames are a 4-byte big-endian length followed by the JSON document, in both directions. One epoll
+// thread accepts connections and reads requests; clients may pipeline requests and match responses by
+// requestId, since replies are written as dispatch workers finish them. A client that stops reading its
+// replies is no longer read from once they back up, and is dropped if they keep growing.
+class SocketTransport
+{
+public:
+	SocketTransport(const MailboxConfig& config);
+	~SocketTransport(void);
+
+	auto start(TransportRequestCallback callback) -> std::tuple<bool, std::optional<std::string>>;
+	auto stop(void) -> void;
+
+	auto connection_count(void) -> size_t;
+	auto socket_path(void) const -> std::string;
+
+	static auto encode_frame(const std::string& content) -> std::string;
+
+private:
+	struct Connection
+	{
+		int fd = -1;
+		uint64_t id = 0;
+		std::string input;
+
+		std::mutex output_mutex;
+		std::string output;
+		uint32_t events = 0;  // epoll interest currently registered
+		bool closed = false;
+	};
+
+	auto run(void) -> void;
+	auto accept_connections(void) -> void;
+	auto read_connection(const std::shared_ptr<Connection>& connection) -> bool;
+	auto write_connection(const std::shared_ptr<Connection>& connection) -> bool;
+	auto close_connection(const std::shared_ptr<Connection>& connection) -> void;
+	auto reply(const std::weak_ptr<Connection>& target, const std::string& content) -> void;
+	auto flush_locked(Connection& connection) -> bool;
+	auto update_events_locked(Connection& connection) -> void;
+
+private:
+	MailboxConfig config_;
+	TransportRequestCallback callback_;
+
+	int listen_fd_;
+	int epoll_fd_;
+	int wake_fd_;
+	uint64_t next_connection_id_;
+
+	std::map<int, std::shared_ptr<Connection>> connections_;
+	std::mutex connections_mutex_;
+
+	std::atomic<bool> running_;
+	std::unique_ptr<std::thread> thread_;
+};
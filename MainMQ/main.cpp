@@ -86,6 +86,9 @@ auto main(int argc, char* argv[]) -> int
 	QueueManagerConfig mgr_config;
 	mgr_config.lease_sweep_interval_ms = configurations_->lease_sweep_interval_ms();
 	mgr_config.retry_sweep_interval_ms = 1000; // Default 1s
+	mgr_config.consistency_interval_ms = configurations_->consistency_interval_ms();
+	mgr_config.consistency_slice_keys = configurations_->consistency_slice_keys();
+	mgr_config.consistency_repair = configurations_->consistency_repair();
 
 	queue_manager_ = std::make_shared<QueueManager>(adapter, mgr_config);
 
@@ -34,3 +34,11 @@ CREATE INDEX IF NOT EXISTS idx_msg_lease ON {{msg_index_table}}(state, lease_unt
 CREATE INDEX IF NOT EXISTS idx_msg_delayed ON {{msg_index_table}}(state, available_at) WHERE state = 'delayed';
 CREATE INDEX IF NOT EXISTS idx_msg_dlq ON {{msg_index_table}}(queue, state) WHERE state = 'dlq';
 CREATE INDEX IF NOT EXISTS idx_msg_target ON {{msg_index_table}}(queue, state, target_consumer_id, available_at) WHERE state = 'ready';
+
+-- Payload Reclaim Table: File moves deferred past ack, replayed on open after a crash
+CREATE TABLE IF NOT EXISTS payload_reclaim (
+    message_key TEXT PRIMARY KEY,
+    source_path TEXT NOT NULL,
+    target_path TEXT NOT NULL,
+    created_at INTEGER NOT NULL
+);
@@ -20,6 +20,7 @@ Configurations::Configurations(ArgumentParser&& arguments)
 	, default_queue_("")
 	, consumer_id_("")
 	, visibility_timeout_sec_(30)
+	, wait_ms_(0)
 {
 	// IPC (Mailbox) defaults
 	mailbox_config_.root = "./ipc";
@@ -54,6 +55,7 @@ auto Configurations::timeout_ms() -> int32_t { return mailbox_config_.timeout_ms
 auto Configurations::default_queue() -> std::string { return default_queue_; }
 auto Configurations::consumer_id() -> std::string { return consumer_id_; }
 auto Configurations::visibility_timeout_sec() -> int32_t { return visibility_timeout_sec_; }
+auto Configurations::wait_ms() -> int32_t { return wait_ms_; }
 
 auto Configurations::load() -> void
 {
@@ -135,6 +137,10 @@ auto Configurations::load() -> void
 			{
 				visibility_timeout_sec_ = con["visibilityTimeoutSec"].get<int32_t>();
 			}
+			if (con.contains("waitMs") && con["waitMs"].is_number())
+			{
+				wait_ms_ = con["waitMs"].get<int32_t>();
+			}
 		}
 
 		// Legacy flat format support
@@ -206,4 +212,10 @@ auto Configurations::parse(ArgumentParser& arguments) -> void
 	{
 		visibility_timeout_sec_ = int_target.value();
 	}
+
+	int_target = arguments.to_int("--wait");
+	if (int_target != std::nullopt)
+	{
+		wait_ms_ = int_target.value();
+	}
 }
@@ -39,6 +39,7 @@ public:
 	auto default_queue() -> std::string;
 	auto consumer_id() -> std::string;
 	auto visibility_timeout_sec() -> int32_t;
+	auto wait_ms() -> int32_t;
 
 protected:
 	auto load() -> void;
@@ -60,4 +61,5 @@ private:
 	std::string default_queue_;
 	std::string consumer_id_;
 	int32_t visibility_timeout_sec_;
+	int32_t wait_ms_;
 };
@@ -1,121 +1,20 @@
 #include "Configurations.h"
-#include "Generator.h"
 #include "Logger.h"
+#include "MailboxClient.h"
 
 #include <nlohmann/json.hpp>
 
-#include <chrono>
-#include <filesystem>
-#include <fstream>
 #include <format>
 #include <string>
-#include <thread>
 
 using json = nlohmann::json;
 using namespace Utilities;
 
-auto current_time_ms() -> int64_t
-{
-	return std::chrono::duration_cast<std::chrono::milliseconds>(
-		std::chrono::system_clock::now().time_since_epoch()
-	).count();
-}
-
-auto atomic_write(const std::string& target_path, const std::string& content) -> bool
-{
-	auto temp_path = target_path + ".tmp";
-
-	std::ofstream file(temp_path, std::ios::out | std::ios::trunc);
-	if (!file.is_open())
-	{
-		Logger::handle().write(LogTypes::Error, std::format("Cannot create temp file: {}", temp_path));
-		return false;
-	}
-
-	file << content;
-	file.flush();
-	file.close();
-
-	std::error_code ec;
-	std::filesystem::rename(temp_path, target_path, ec);
-	if (ec)
-	{
-		std::filesystem::remove(temp_path, ec);
-		Logger::handle().write(LogTypes::Error, std::format("Rename failed: {}", ec.message()));
-		return false;
-	}
-
-	return true;
-}
-
 auto send_request(const MailboxConfig& config, const std::string& client_id, const std::string& command, const json& payload, int32_t timeout_ms)
 	-> std::tuple<bool, json>
 {
-	auto request_id = Generator::guid();
-	auto now = current_time_ms();
-	auto deadline = now + timeout_ms;
-
-	// Build request JSON
-	json request;
-	request["requestId"] = request_id;
-	request["clientId"] = client_id;
-	request["command"] = command;
-	request["timestampMs"] = now;
-	request["deadlineMs"] = deadline;
-	request["payload"] = payload;
-
-	// Ensure directories exist
-	std::filesystem::path requests_path = config.root;
-	requests_path /= config.requests_dir;
-
-	std::filesystem::path responses_path = config.root;
-	responses_path /= config.responses_dir;
-	responses_path /= client_id;
-
-	std::error_code ec;
-	std::filesystem::create_directories(requests_path, ec);
-	std::filesystem::create_directories(responses_path, ec);
-
-	// Write request file
-	auto request_file = (requests_path / std::format("{}.json", request_id)).string();
-	if (!atomic_write(request_file, request.dump(2)))
-	{
-		return { false, { { "error", "failed to write request" } } };
-	}
-
-	// Wait for response
-	auto response_file = (responses_path / std::format("{}.json", request_id)).string();
-	auto start_time = current_time_ms();
-
-	while (current_time_ms() - start_time < timeout_ms)
-	{
-		if (std::filesystem::exists(response_file, ec))
-		{
-			std::ifstream file(response_file);
-			if (file.is_open())
-			{
-				std::string content((std::istreambuf_iterator<char>(file)),
-					std::istreambuf_iterator<char>());
-				file.close();
-
-				// Delete response file after reading
-				std::filesystem::remove(response_file, ec);
-
-				try
-				{
-					return { true, json::parse(content) };
-				}
-				catch (const json::exception& e)
-				{
-					return { false, { { "error", std::format("response parse error: {}", e.what()) } } };
-				}
-			}
-		}
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(50));
-	}
-
-	return { false, { { "error", "timeout waiting for response" } } };
+	MailboxClient client(config.root, config.requests_dir, config.responses_dir, client_id);
+	return client.send_request(command, payload, timeout_ms);
 }
 
 auto print_usage() -> void
@@ -143,6 +42,7 @@ Global Options:
 Consume Options:
   --queue <name>        Queue name (required, or set in config)
   --visibility <sec>    Visibility timeout in seconds (default: from config or 30)
+  --wait <ms>           Long-poll: wait up to this long for a message (default: from config or 0)
 
 Ack/Nack Options:
   --message-key <key>   Message key (required)
@@ -171,7 +71,8 @@ Configuration File (consumer_configuration.json):
     "consumer": {
       "queue": "telemetry",
       "consumerId": "worker-01",
-      "visibilityTimeoutSec": 30
+      "visibilityTimeoutSec": 30,
+      "waitMs": 10000
     },
     "logging": {
       "writeConsole": 3,
@@ -183,6 +84,7 @@ Configuration File (consumer_configuration.json):
 Examples:
   yirangmq-cli-consumer                # consume using config defaults
   yirangmq-cli-consumer consume --queue telemetry
+  yirangmq-cli-consumer consume --queue telemetry --wait 10000
   yirangmq-cli-consumer ack --message-key msg:telemetry:abc123
   yirangmq-cli-consumer nack --message-key msg:telemetry:abc123 --reason "error" --requeue
   yirangmq-cli-consumer list-dlq --queue telemetry --limit 50
@@ -205,6 +107,10 @@ auto cmd_consume(ArgumentParser& args, Configurations& config) -> int
 	payload["queue"] = queue;
 	payload["consumerId"] = config.consumer_id();
 	payload["visibilityTimeoutSec"] = config.visibility_timeout_sec();
+	if (config.wait_ms() > 0)
+	{
+		payload["waitMs"] = config.wait_ms();
+	}
 
 	auto [ok, response] = send_request(
 		config.mailbox_config(),
@@ -0,0 +1,97 @@
+#include "Compressor.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <vector>
+
+using namespace Utilities;
+
+static auto make_data(size_t count) -> std::vector<uint8_t>
+{
+	std::string text;
+	for (size_t i = 0; i < count; ++i)
+	{
+		text += std::format(R"({{"deviceId":"sensor-{}","temp":36.5,"humidity":40}},)", i % 8);
+	}
+	return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// Offsets of every [original size][compressed size][LZ4 block] record in a frame
+static auto block_offsets(const std::vector<uint8_t>& frame) -> std::vector<size_t>
+{
+	std::vector<size_t> offsets;
+	for (size_t offset = 0; offset + 8 <= frame.size();)
+	{
+		offsets.push_back(offset);
+		uint32_t compressed_size = frame[offset + 4] | frame[offset + 5] << 8 | frame[offset + 6] << 16
+			| static_cast<uint32_t>(frame[offset + 7]) << 24;
+		offset += 8 + compressed_size;
+	}
+	return offsets;
+}
+
+// ---------------------------------------------------------------------------
+// RoundTrip: multi-block data decodes to the original
+// ---------------------------------------------------------------------------
+TEST(CompressorTest, RoundTrip)
+{
+	auto data = make_data(200);
+
+	auto [compressed, compress_message] = Compressor::compression(data, 1024);
+	ASSERT_TRUE(compressed.has_value()) << compress_message.value_or("unknown");
+	EXPECT_GT(block_offsets(compressed.value()).size(), 2u);
+
+	auto [decompressed, decompress_message] = Compressor::decompression(compressed.value(), 1024);
+	ASSERT_TRUE(decompressed.has_value()) << decompress_message.value_or("unknown");
+	EXPECT_EQ(decompressed.value(), data);
+}
+
+// ---------------------------------------------------------------------------
+// TruncatedFrame: a frame cut inside a block header or block is an error, not a shorter result
+// ---------------------------------------------------------------------------
+TEST(CompressorTest, TruncatedFrame)
+{
+	auto [compressed, compress_message] = Compressor::compression(make_data(200), 1024);
+	ASSERT_TRUE(compressed.has_value()) << compress_message.value_or("unknown");
+
+	const auto& frame = compressed.value();
+	auto last = block_offsets(frame).back();
+
+	for (auto cut : { frame.size() - 1, last + 9, last + 5 })
+	{
+		auto [decompressed, message] = Compressor::decompression(std::vector<uint8_t>(frame.begin(), frame.begin() + cut), 1024);
+		EXPECT_FALSE(decompressed.has_value()) << "cut at " << cut << " of " << frame.size();
+		EXPECT_TRUE(message.has_value());
+	}
+
+	auto padded = frame;
+	padded.insert(padded.end(), 3, 0);
+	EXPECT_FALSE(std::get<0>(Compressor::decompression(padded, 1024)).has_value()) << "trailing bytes";
+}
+
+// ---------------------------------------------------------------------------
+// CorruptFrame: a damaged block or block header fails the whole frame
+// ---------------------------------------------------------------------------
+TEST(CompressorTest, CorruptFrame)
+{
+	auto [compressed, compress_message] = Compressor::compression(make_data(200), 1024);
+	ASSERT_TRUE(compressed.has_value()) << compress_message.value_or("unknown");
+
+	auto last = block_offsets(compressed.value()).back();
+
+	auto damaged = compressed.value();
+	for (size_t index = last + 8; index < damaged.size(); ++index)
+	{
+		damaged[index] = 0xff;
+	}
+	EXPECT_FALSE(std::get<0>(Compressor::decompression(damaged, 1024)).has_value()) << "damaged block";
+
+	auto resized = compressed.value();
+	resized[last] ^= 0x01;
+	EXPECT_FALSE(std::get<0>(Compressor::decompression(resized, 1024)).has_value()) << "wrong original size";
+
+	auto oversized = compressed.value();
+	oversized[last + 3] = 0x7f;
+	EXPECT_FALSE(std::get<0>(Compressor::decompression(oversized, 1024)).has_value()) << "original size above the block size";
+}
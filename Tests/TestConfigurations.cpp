@@ -150,6 +150,7 @@ TEST_F(ConfigurationsTest, DefaultValues)
 	EXPECT_EQ(sqlite.busy_timeout_ms, 5000);
 	EXPECT_EQ(sqlite.journal_mode, "WAL");
 	EXPECT_EQ(sqlite.synchronous, "NORMAL");
+	EXPECT_EQ(sqlite.inline_payload_max_bytes, 4096);
 
 	// FileSystem defaults
 	auto fsc = cfg->filesystem_config();
@@ -282,7 +283,10 @@ TEST_F(ConfigurationsTest, SqliteConfigParsing)
 			{"messageIndexTable", "custom_idx"},
 			{"busyTimeoutMs", 10000},
 			{"journalMode", "DELETE"},
-			{"synchronous", "FULL"}
+			{"synchronous", "FULL"},
+			{"inlinePayloadMaxBytes", 1024},
+			{"payloadStorage", "pack"},
+			{"packMaxBytes", 4096}
 		}}
 	};
 
@@ -296,6 +300,9 @@ TEST_F(ConfigurationsTest, SqliteConfigParsing)
 	EXPECT_EQ(sqlite.busy_timeout_ms, 10000);
 	EXPECT_EQ(sqlite.journal_mode, "DELETE");
 	EXPECT_EQ(sqlite.synchronous, "FULL");
+	EXPECT_EQ(sqlite.inline_payload_max_bytes, 1024);
+	EXPECT_EQ(sqlite.payload_storage, PayloadStorage::Packs);
+	EXPECT_EQ(sqlite.pack_max_bytes, 4096u);
 }
 
 // =============================================================================
@@ -311,7 +318,8 @@ TEST_F(ConfigurationsTest, FileSystemConfigParsing)
 			{"processingDir", "active"},
 			{"archiveDir", "done"},
 			{"dlqDir", "failed"},
-			{"metaDir", "metadata"}
+			{"metaDir", "metadata"},
+			{"envelopeFormat", "binary"}
 		}}
 	};
 
@@ -325,6 +333,43 @@ TEST_F(ConfigurationsTest, FileSystemConfigParsing)
 	EXPECT_EQ(fsc.archive_dir, "done");
 	EXPECT_EQ(fsc.dlq_dir, "failed");
 	EXPECT_EQ(fsc.meta_dir, "metadata");
+	EXPECT_EQ(fsc.envelope_format, EnvelopeFormat::Binary);
+}
+
+// =============================================================================
+// CompressionConfigParsing
+// =============================================================================
+
+TEST_F(ConfigurationsTest, CompressionConfigParsing)
+{
+	json config = {
+		{"compression", {
+			{"enabled", false},
+			{"minBytes", 128},
+			{"blockBytes", 131072}
+		}},
+		{"queues", json::array({
+			{{"name", "telemetry"}, {"compression", {{"enabled", true}, {"dictionary", true}, {"dictionarySamples", 64}}}},
+			{{"name", "orders"}}
+		})}
+	};
+
+	ConfigFileGuard guard(config);
+	auto cfg = guard.make_configurations();
+
+	auto backend = cfg->backend_config();
+	EXPECT_FALSE(backend.compression.enabled);
+	EXPECT_EQ(backend.compression.min_bytes, 128u);
+	EXPECT_EQ(backend.compression.block_bytes, 131072u);
+
+	ASSERT_EQ(backend.queue_compression.size(), 1u);
+	auto& telemetry = backend.queue_compression["telemetry"];
+	EXPECT_TRUE(telemetry.enabled);
+	EXPECT_EQ(telemetry.min_bytes, 128u) << "queue overrides inherit the global settings";
+	EXPECT_TRUE(telemetry.dictionary);
+	EXPECT_EQ(telemetry.dictionary_samples, 64u);
+	EXPECT_EQ(telemetry.dictionary_bytes, 16u * 1024);
+	EXPECT_FALSE(backend.compression.dictionary);
 }
 
 // =============================================================================
@@ -341,8 +386,36 @@ TEST_F(ConfigurationsTest, MailboxConfigParsing)
 			{"responsesDir", "resp"},
 			{"deadDir", "dead_letters"},
 			{"staleTimeoutMs", 60000},
-			{"pollIntervalMs", 250}
-		}}
+			{"pollIntervalMs", 250},
+			{"dispatchWorkers", 8},
+			{"prettyResponses", true},
+			{"laneWeights", {{"settle", 16}, {"publish", 0}}},
+			{"admission", {
+				{"maxPendingRequests", 500},
+				{"retryAfterMs", 0},
+				{"maxReadyDepth", 1000}
+			}},
+			{"shm", {
+				{"enabled", true},
+				{"dir", "rings"},
+				{"namePrefix", "mq-test"},
+				{"ringBytes", 65536}
+			}},
+			{"socket", {
+				{"enabled", true},
+				{"path", "/tmp/mq-test.sock"},
+				{"maxFrameBytes", 4096},
+				{"maxOutputBytes", 1048576}
+			}},
+			{"journal", {
+				{"enabled", true},
+				{"rollBytes", 0}
+			}}
+		}},
+		{"queues", json::array({
+			{ {"name", "bulk"}, {"limits", {{"maxBytes", 1048576}}} },
+			{ {"name", "plain"} }
+		})}
 	};
 
 	ConfigFileGuard guard(config);
@@ -356,6 +429,30 @@ TEST_F(ConfigurationsTest, MailboxConfigParsing)
 	EXPECT_EQ(mailbox.dead_dir, "dead_letters");
 	EXPECT_EQ(mailbox.stale_timeout_ms, 60000);
 	EXPECT_EQ(mailbox.poll_interval_ms, 250);
+	EXPECT_EQ(mailbox.dispatch_workers, 8);
+	EXPECT_TRUE(mailbox.pretty_responses);
+	EXPECT_EQ(mailbox.lane_weights.settle, 16);
+	EXPECT_EQ(mailbox.lane_weights.consume, 4);
+	EXPECT_EQ(mailbox.lane_weights.publish, 2);
+	EXPECT_EQ(mailbox.lane_weights.admin, 1);
+	EXPECT_EQ(mailbox.admission.max_pending_requests, 500u);
+	EXPECT_EQ(mailbox.admission.retry_after_ms, 1000);
+	EXPECT_EQ(mailbox.admission.queue_defaults.max_ready_depth, 1000u);
+	EXPECT_EQ(mailbox.admission.queue_defaults.max_bytes, 0u);
+	ASSERT_EQ(mailbox.admission.queue_limits.size(), 1u);
+	EXPECT_EQ(mailbox.admission.queue_limits["bulk"].max_ready_depth, 1000u);
+	EXPECT_EQ(mailbox.admission.queue_limits["bulk"].max_bytes, 1048576u);
+	EXPECT_TRUE(mailbox.shm.enabled);
+	EXPECT_EQ(mailbox.shm.dir, "rings");
+	EXPECT_EQ(mailbox.shm.name_prefix, "mq-test");
+	EXPECT_EQ(mailbox.shm.ring_bytes, 65536u);
+	EXPECT_TRUE(mailbox.socket.enabled);
+	EXPECT_EQ(mailbox.socket.path, "/tmp/mq-test.sock");
+	EXPECT_EQ(mailbox.socket.max_frame_bytes, 4096u);
+	EXPECT_EQ(mailbox.socket.max_output_bytes, 1048576u);
+	EXPECT_TRUE(mailbox.journal.enabled);
+	EXPECT_EQ(mailbox.journal.max_frame_bytes, 16u * 1024 * 1024);
+	EXPECT_EQ(mailbox.journal.roll_bytes, 0u);
 }
 
 // =============================================================================
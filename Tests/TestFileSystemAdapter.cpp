@@ -1,7 +1,9 @@
 #include "TestHelpers.h"
 #include "FileSystemAdapter.h"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
 #include <thread>
 #include <chrono>
 
@@ -412,3 +414,286 @@ TEST_F(FileSystemAdapterTest, TargetConsumerId)
 	EXPECT_EQ(result2.message->payload_json, R"({"msg":"for_worker2"})");
 	EXPECT_EQ(result2.message->target_consumer_id, "worker-02");
 }
+
+// ---------------------------------------------------------------------------
+// EnvelopeFormat: compact and binary envelopes round-trip through the adapter
+// ---------------------------------------------------------------------------
+static auto reopen_with_format(std::unique_ptr<FileSystemAdapter>& adapter, const std::string& temp_dir, EnvelopeFormat format) -> void
+{
+	adapter->close();
+	adapter = std::make_unique<FileSystemAdapter>();
+
+	auto config = make_fs_config(temp_dir);
+	config.filesystem.envelope_format = format;
+	auto [ok, err] = adapter->open(config);
+	ASSERT_TRUE(ok) << "Failed to reopen adapter: " << err.value_or("unknown");
+}
+
+static auto read_envelope_file(const std::string& temp_dir, const std::string& queue, const std::string& sub_dir, const std::string& message_id) -> std::string
+{
+	std::ifstream file(std::format("{}/fs/{}/{}/{}.json", temp_dir, queue, sub_dir, message_id), std::ios::binary);
+	return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+TEST_F(FileSystemAdapterTest, CompactEnvelopeFormat)
+{
+	reopen_with_format(adapter_, temp_dir_->path(), EnvelopeFormat::CompactJson);
+
+	auto env = make_envelope("compact_q", R"({"data":"compact"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+
+	auto content = read_envelope_file(temp_dir_->path(), "compact_q", "inbox", env.message_id);
+	EXPECT_EQ(content.find('\n'), std::string::npos);
+
+	auto result = adapter_->lease_next("compact_q", "w1", 30);
+	ASSERT_TRUE(result.leased);
+	EXPECT_EQ(result.message->payload_json, R"({"data":"compact"})");
+}
+
+TEST_F(FileSystemAdapterTest, BinaryEnvelopeFormat)
+{
+	reopen_with_format(adapter_, temp_dir_->path(), EnvelopeFormat::Binary);
+
+	std::string payload(4096, 'x');
+	auto env = make_envelope("binary_q", payload, 3, "worker-02");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+
+	// Raw payload bytes follow the header unescaped
+	auto content = read_envelope_file(temp_dir_->path(), "binary_q", "inbox", env.message_id);
+	EXPECT_EQ(content.substr(0, 4), "YMQE");
+	EXPECT_EQ(content.substr(content.size() - payload.size()), payload);
+
+	EXPECT_FALSE(adapter_->lease_next("binary_q", "worker-01", 30).leased);
+
+	auto result = adapter_->lease_next("binary_q", "worker-02", 30);
+	ASSERT_TRUE(result.leased);
+	EXPECT_EQ(result.message->payload_json, payload);
+	EXPECT_EQ(result.message->priority, 3);
+	EXPECT_EQ(result.message->target_consumer_id, "worker-02");
+	EXPECT_EQ(result.message->attempt, 1);
+
+	auto [dlq_ok, dlq_err] = adapter_->nack(result.lease.value(), "binary failure", false);
+	ASSERT_TRUE(dlq_ok) << dlq_err.value_or("unknown");
+
+	auto [dlq_list, list_err] = adapter_->list_dlq_messages("binary_q", 10);
+	ASSERT_EQ(dlq_list.size(), 1u);
+	EXPECT_EQ(dlq_list[0].message_key, env.key);
+	EXPECT_EQ(dlq_list[0].reason, "binary failure");
+	EXPECT_GT(dlq_list[0].dlq_at_ms, 0);
+
+	auto [reprocess_ok, reprocess_err] = adapter_->reprocess_dlq_message(env.key);
+	ASSERT_TRUE(reprocess_ok) << reprocess_err.value_or("unknown");
+
+	auto again = adapter_->lease_next("binary_q", "worker-02", 30);
+	ASSERT_TRUE(again.leased);
+	EXPECT_EQ(again.message->payload_json, payload);
+}
+
+TEST_F(FileSystemAdapterTest, BinaryEnvelopeCorruptHeaderLength)
+{
+	reopen_with_format(adapter_, temp_dir_->path(), EnvelopeFormat::Binary);
+
+	auto env = make_envelope("corrupt_q", R"({"data":"binary"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+
+	// The header length is little-endian and bounded by the file, a corrupt one is skipped rather than allocated
+	auto path = std::format("{}/fs/corrupt_q/inbox/{}.json", temp_dir_->path(), env.message_id);
+	auto content = read_envelope_file(temp_dir_->path(), "corrupt_q", "inbox", env.message_id);
+	uint32_t header_size = static_cast<uint8_t>(content[4]) | static_cast<uint8_t>(content[5]) << 8
+		| static_cast<uint8_t>(content[6]) << 16 | static_cast<uint32_t>(static_cast<uint8_t>(content[7])) << 24;
+	EXPECT_LT(8 + header_size, content.size());
+
+	content.replace(4, 4, std::string(4, '\xff'));
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(content.data(), static_cast<std::streamsize>(content.size()));
+	}
+
+	EXPECT_FALSE(adapter_->lease_next("corrupt_q", "w1", 30).leased);
+}
+
+TEST_F(FileSystemAdapterTest, MixedEnvelopeFormats)
+{
+	// Files written in one format stay readable after switching formats
+	auto json_env = make_envelope("mixed_q", R"({"data":"json"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(json_env)));
+
+	reopen_with_format(adapter_, temp_dir_->path(), EnvelopeFormat::Binary);
+
+	auto binary_env = make_envelope("mixed_q", R"({"data":"binary"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(binary_env)));
+
+	std::vector<std::string> payloads;
+	for (int i = 0; i < 2; i++)
+	{
+		auto result = adapter_->lease_next("mixed_q", "w1", 30);
+		ASSERT_TRUE(result.leased);
+		payloads.push_back(result.message->payload_json);
+	}
+
+	std::sort(payloads.begin(), payloads.end());
+	EXPECT_EQ(payloads[0], R"({"data":"binary"})");
+	EXPECT_EQ(payloads[1], R"({"data":"json"})");
+}
+
+TEST_F(FileSystemAdapterTest, CompressedPayloads)
+{
+	adapter_->close();
+	adapter_ = std::make_unique<FileSystemAdapter>();
+
+	auto config = make_fs_config(temp_dir_->path());
+	config.filesystem.envelope_format = EnvelopeFormat::Binary;
+	config.queue_compression["zip_q"] = CompressionPolicy{ true, 64, 64 * 1024 };
+	ASSERT_TRUE(std::get<0>(adapter_->open(config)));
+
+	std::string payload = "[";
+	for (int i = 0; i < 100; ++i)
+	{
+		payload += R"({"deviceId":"sensor-01","temp":36.5},)";
+	}
+	payload.back() = ']';
+
+	auto env = make_envelope("zip_q", payload);
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+
+	auto content = read_envelope_file(temp_dir_->path(), "zip_q", "inbox", env.message_id);
+	EXPECT_LT(content.size(), payload.size());
+	EXPECT_NE(content.find("YMQZ"), std::string::npos);
+
+	auto [m, merr] = adapter_->metrics("zip_q");
+	EXPECT_EQ(m.compressed_messages, 1u);
+	EXPECT_GT(m.compression_original_bytes, m.compression_stored_bytes);
+
+	auto result = adapter_->lease_next("zip_q", "w1", 30);
+	ASSERT_TRUE(result.leased);
+	EXPECT_EQ(result.message->payload_json, payload);
+
+	// A raw payload that happens to start with the frame magic is flagged raw and never decoded
+	std::string lookalike = "YMQZ" + std::string(4, '\0') + std::string(200, 'x');
+	auto raw_env = make_envelope("plain_q", lookalike);
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(raw_env)));
+
+	auto raw = adapter_->lease_next("plain_q", "w1", 30);
+	ASSERT_TRUE(raw.leased);
+	EXPECT_EQ(raw.message->payload_json, lookalike);
+}
+
+// ---------------------------------------------------------------------------
+// EnvelopeWrittenOnce: lease/nack/delay/dlq keep state in meta, not in the envelope
+// ---------------------------------------------------------------------------
+TEST_F(FileSystemAdapterTest, EnvelopeWrittenOnce)
+{
+	auto env = make_envelope("once_q", R"({"data":"once"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+	auto original = read_envelope_file(temp_dir_->path(), "once_q", "inbox", env.message_id);
+
+	auto first = adapter_->lease_next("once_q", "w1", 30);
+	ASSERT_TRUE(first.leased);
+	EXPECT_EQ(first.message->attempt, 1);
+	EXPECT_EQ(read_envelope_file(temp_dir_->path(), "once_q", "processing", env.message_id), original);
+
+	// Attempt survives a requeue through state meta
+	ASSERT_TRUE(std::get<0>(adapter_->nack(first.lease.value(), "retry", true)));
+	EXPECT_EQ(read_envelope_file(temp_dir_->path(), "once_q", "inbox", env.message_id), original);
+
+	auto second = adapter_->lease_next("once_q", "w1", 30);
+	ASSERT_TRUE(second.leased);
+	EXPECT_EQ(second.message->attempt, 2);
+
+	// Delay keeps its due time in delayed meta
+	ASSERT_TRUE(std::get<0>(adapter_->delay_message(env.key, 60000)));
+	EXPECT_EQ(read_envelope_file(temp_dir_->path(), "once_q", "delayed", env.message_id), original);
+
+	auto [processed, process_err] = adapter_->process_delayed_messages();
+	EXPECT_EQ(processed, 0);
+}
+
+TEST_F(FileSystemAdapterTest, DlqInfoFromStateMeta)
+{
+	auto env = make_envelope("state_dlq_q", R"({"data":"dlq"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+	auto original = read_envelope_file(temp_dir_->path(), "state_dlq_q", "inbox", env.message_id);
+
+	auto lease_result = adapter_->lease_next("state_dlq_q", "w1", 30);
+	ASSERT_TRUE(lease_result.leased);
+
+	ASSERT_TRUE(std::get<0>(adapter_->move_to_dlq(env.key, "poison")));
+	EXPECT_EQ(read_envelope_file(temp_dir_->path(), "state_dlq_q", "dlq", env.message_id), original);
+
+	auto [dlq_list, list_err] = adapter_->list_dlq_messages("state_dlq_q", 10);
+	ASSERT_EQ(dlq_list.size(), 1u);
+	EXPECT_EQ(dlq_list[0].reason, "poison");
+	EXPECT_EQ(dlq_list[0].attempt, 1);
+
+	// Reprocess resets the attempt count
+	ASSERT_TRUE(std::get<0>(adapter_->reprocess_dlq_message(env.key)));
+	EXPECT_EQ(read_envelope_file(temp_dir_->path(), "state_dlq_q", "inbox", env.message_id), original);
+
+	auto again = adapter_->lease_next("state_dlq_q", "w1", 30);
+	ASSERT_TRUE(again.leased);
+	EXPECT_EQ(again.message->attempt, 1);
+
+	// Ack clears state meta once the deferred cleanup runs
+	ASSERT_TRUE(std::get<0>(adapter_->ack(again.lease.value())));
+	adapter_->flush_reclaimer();
+	EXPECT_FALSE(fs::exists(std::format("{}/fs/meta/state/{}.json", temp_dir_->path(), "msg_state_dlq_q_" + env.message_id)));
+}
+
+TEST_F(FileSystemAdapterTest, StateMetaWriteFailureSurfaces)
+{
+	auto env = make_envelope("state_fail_q", R"({"data":"dlq"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+	ASSERT_TRUE(adapter_->lease_next("state_fail_q", "w1", 30).leased);
+
+	// A directory in place of the state meta file makes its atomic write fail
+	auto state_path = std::format("{}/fs/meta/state/{}.json", temp_dir_->path(), "msg_state_fail_q_" + env.message_id);
+	fs::create_directories(state_path + "/blocked");
+
+	auto [moved, move_err] = adapter_->move_to_dlq(env.key, "poison");
+	EXPECT_FALSE(moved);
+	EXPECT_TRUE(move_err.has_value());
+
+	// The failed release leaves the message leased in processing, so it can be retried
+	auto root = temp_dir_->path() + "/fs";
+	EXPECT_TRUE(fs::exists(std::format("{}/state_fail_q/processing/{}.json", root, env.message_id)));
+	EXPECT_TRUE(fs::exists(std::format("{}/meta/leases/msg_state_fail_q_{}.json", root, env.message_id)));
+
+	fs::remove_all(state_path);
+	ASSERT_TRUE(std::get<0>(adapter_->move_to_dlq(env.key, "poison")));
+	EXPECT_TRUE(fs::exists(std::format("{}/state_fail_q/dlq/{}.json", root, env.message_id)));
+	EXPECT_FALSE(fs::exists(std::format("{}/meta/leases/msg_state_fail_q_{}.json", root, env.message_id)));
+}
+
+// ---------------------------------------------------------------------------
+// ExpiryScanSkipsFinishedLeases: acked messages and leases orphaned by a crash are not reported as expired
+// ---------------------------------------------------------------------------
+TEST_F(FileSystemAdapterTest, ExpiryScanSkipsFinishedLeases)
+{
+	auto acked = make_envelope("expiry_q", R"({"data":"acked"})");
+	auto orphaned = make_envelope("expiry_q", R"({"data":"orphaned"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(acked)));
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(orphaned)));
+
+	auto first = adapter_->lease_next("expiry_q", "w1", 1);
+	auto second = adapter_->lease_next("expiry_q", "w1", 1);
+	ASSERT_TRUE(first.leased);
+	ASSERT_TRUE(second.leased);
+	auto& acked_lease = first.message->key == acked.key ? first.lease.value() : second.lease.value();
+	ASSERT_TRUE(std::get<0>(adapter_->ack(acked_lease)));
+
+	auto lease_path = [this](const MessageEnvelope& envelope) {
+		return std::format("{}/fs/meta/leases/msg_expiry_q_{}.json", temp_dir_->path(), envelope.message_id);
+	};
+	EXPECT_FALSE(fs::exists(lease_path(acked)));
+
+	// A crash between the move out of processing and the lease meta unlink leaves the meta behind
+	auto root = temp_dir_->path() + "/fs/expiry_q";
+	fs::rename(std::format("{}/processing/{}.json", root, orphaned.message_id), std::format("{}/archive/{}.json", root, orphaned.message_id));
+	ASSERT_TRUE(fs::exists(lease_path(orphaned)));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+	auto [expired, expired_err] = adapter_->get_expired_inflight_messages();
+	EXPECT_TRUE(expired.empty());
+	EXPECT_FALSE(fs::exists(lease_path(orphaned)));
+}
@@ -1,8 +1,11 @@
 #include "TestHelpers.h"
 #include "HybridAdapter.h"
 #include <gtest/gtest.h>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <set>
 #include <thread>
 #include <chrono>
 
@@ -121,6 +124,38 @@ protected:
 	{
 		return std::format("{}/{}/dlq", payload_root(), queue);
 	}
+
+	auto reopen_with_slow_reclaim(void) -> void
+	{
+		adapter_->close();
+
+		auto config = make_hybrid_config(temp_dir_->path());
+		config.reclaim.batch_size = 1000;
+		config.reclaim.interval_ms = 60000;
+		auto [ok, err] = adapter_->open(config);
+		ASSERT_TRUE(ok) << "Failed to reopen HybridAdapter: " << err.value_or("unknown");
+	}
+
+	auto reopen_with_packs(const uint64_t& pack_max_bytes) -> void
+	{
+		adapter_->close();
+
+		auto config = make_hybrid_config(temp_dir_->path());
+		config.sqlite.payload_storage = PayloadStorage::Packs;
+		config.sqlite.pack_max_bytes = pack_max_bytes;
+		auto [ok, err] = adapter_->open(config);
+		ASSERT_TRUE(ok) << "Failed to reopen HybridAdapter: " << err.value_or("unknown");
+	}
+
+	auto reopen_with_inline_threshold(const int32_t& max_bytes) -> void
+	{
+		adapter_->close();
+
+		auto config = make_hybrid_config(temp_dir_->path());
+		config.sqlite.inline_payload_max_bytes = max_bytes;
+		auto [ok, err] = adapter_->open(config);
+		ASSERT_TRUE(ok) << "Failed to reopen HybridAdapter: " << err.value_or("unknown");
+	}
 };
 
 // ---------------------------------------------------------------------------
@@ -217,6 +252,7 @@ TEST_F(HybridAdapterTest, AckDeletesPayload)
 
 	auto [aok, aerr] = adapter_->ack(lease_result.lease.value());
 	EXPECT_TRUE(aok) << "ack failed: " << aerr.value_or("unknown");
+	adapter_->flush_reclaimer();
 
 	// Payload should be moved from active to archive
 	EXPECT_FALSE(fs::exists(active_path)) << "Payload should be removed from active after ack";
@@ -429,6 +465,28 @@ TEST_F(HybridAdapterTest, ConsistencyMissingPayload)
 	EXPECT_TRUE(found_missing) << "Should find the specific missing payload issue";
 }
 
+// ---------------------------------------------------------------------------
+// UnreadablePayloadIsNotLeased: a lease never hands out an empty payload
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, UnreadablePayloadIsNotLeased)
+{
+	auto env = make_envelope("broken_q", R"({"data":"lost"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+
+	std::error_code ec;
+	fs::remove(std::format("{}/{}.json", active_dir("broken_q"), env.message_id), ec);
+
+	auto result = adapter_->lease_next("broken_q", "w1", 30);
+	EXPECT_FALSE(result.leased);
+	EXPECT_TRUE(result.error.has_value());
+
+	// Parked in the DLQ rather than offered again
+	auto [metrics, metrics_err] = adapter_->metrics("broken_q");
+	EXPECT_EQ(metrics.dlq, 1u);
+	EXPECT_EQ(metrics.inflight, 0u);
+	EXPECT_FALSE(adapter_->lease_next("broken_q", "w1", 30).leased);
+}
+
 // ---------------------------------------------------------------------------
 // RepairOrphanPayload: repair creates DB entry for orphan file
 // ---------------------------------------------------------------------------
@@ -577,3 +635,522 @@ TEST_F(HybridAdapterTest, EmptyQueueLease)
 	EXPECT_FALSE(result.message.has_value());
 	EXPECT_FALSE(result.lease.has_value());
 }
+
+// ---------------------------------------------------------------------------
+// InlinePayloadPlacement: small payloads stay in kv, large ones go to files
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, InlinePayloadPlacement)
+{
+	reopen_with_inline_threshold(64);
+
+	auto small = make_envelope("inline_q", R"({"note":"it's small"})");
+	auto large = make_envelope("inline_q", std::format(R"({{"blob":"{}"}})", std::string(200, 'x')));
+
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(small)));
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(large)));
+
+	EXPECT_FALSE(fs::exists(std::format("{}/{}.json", active_dir("inline_q"), small.message_id)));
+	EXPECT_TRUE(fs::exists(std::format("{}/{}.json", active_dir("inline_q"), large.message_id)));
+
+	auto [report, check_err] = adapter_->check_consistency("inline_q");
+	EXPECT_FALSE(check_err.has_value());
+	EXPECT_EQ(report.missing_payloads, 0);
+	EXPECT_EQ(report.orphan_payloads, 0);
+
+	auto first = adapter_->lease_next("inline_q", "w1", 30);
+	auto second = adapter_->lease_next("inline_q", "w1", 30);
+	ASSERT_TRUE(first.leased && second.leased);
+
+	auto& inline_lease = first.message->key == small.key ? first : second;
+	auto& file_lease = first.message->key == small.key ? second : first;
+	EXPECT_EQ(inline_lease.message->payload_json, small.payload_json);
+	EXPECT_EQ(file_lease.message->payload_json, large.payload_json);
+
+	auto [ack_ok, ack_err] = adapter_->ack(inline_lease.lease.value());
+	EXPECT_TRUE(ack_ok) << ack_err.value_or("unknown");
+	EXPECT_FALSE(fs::exists(std::format("{}/{}.json", archive_dir("inline_q"), small.message_id)));
+
+	auto [ack_file_ok, ack_file_err] = adapter_->ack(file_lease.lease.value());
+	EXPECT_TRUE(ack_file_ok) << ack_file_err.value_or("unknown");
+	adapter_->flush_reclaimer();
+	EXPECT_TRUE(fs::exists(std::format("{}/{}.json", archive_dir("inline_q"), large.message_id)));
+}
+
+// ---------------------------------------------------------------------------
+// InlinePayloadDlq: inline messages round-trip through DLQ without files
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, InlinePayloadDlq)
+{
+	reopen_with_inline_threshold(4096);
+
+	auto env = make_envelope("inline_dlq_q", R"({"data":"inline"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+
+	auto [moved, move_err] = adapter_->move_to_dlq(env.key, "poison");
+	ASSERT_TRUE(moved) << move_err.value_or("unknown");
+	EXPECT_FALSE(fs::exists(std::format("{}/{}.json", dlq_dir("inline_dlq_q"), env.message_id)));
+
+	auto [report, check_err] = adapter_->check_consistency("inline_dlq_q");
+	EXPECT_EQ(report.missing_payloads, 0);
+
+	auto [reprocessed, reprocess_err] = adapter_->reprocess_dlq_message(env.key);
+	ASSERT_TRUE(reprocessed) << reprocess_err.value_or("unknown");
+
+	auto result = adapter_->lease_next("inline_dlq_q", "w1", 30);
+	ASSERT_TRUE(result.leased);
+	EXPECT_EQ(result.message->payload_json, R"({"data":"inline"})");
+}
+
+// ---------------------------------------------------------------------------
+// PackPayloadStorage: payloads go to pack files, ack and DLQ are state flags
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, PackPayloadStorage)
+{
+	reopen_with_packs(1024 * 1024);
+
+	auto first = make_envelope("pack_q", R"({"n":1})");
+	auto second = make_envelope("pack_q", R"({"n":2})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(first)));
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(second)));
+
+	EXPECT_FALSE(fs::exists(std::format("{}/{}.json", active_dir("pack_q"), first.message_id)));
+	EXPECT_TRUE(fs::exists("./data/packs/00000001.pack"));
+
+	auto lease = adapter_->lease_next("pack_q", "w1", 30);
+	ASSERT_TRUE(lease.leased);
+	EXPECT_EQ(lease.message->payload_json, R"({"n":1})");
+
+	auto [ack_ok, ack_err] = adapter_->ack(lease.lease.value());
+	EXPECT_TRUE(ack_ok) << ack_err.value_or("unknown");
+	EXPECT_FALSE(fs::exists(std::format("{}/{}.json", archive_dir("pack_q"), first.message_id)));
+
+	auto [moved, move_err] = adapter_->move_to_dlq(second.key, "poison");
+	ASSERT_TRUE(moved) << move_err.value_or("unknown");
+
+	auto [m, merr] = adapter_->metrics("pack_q");
+	EXPECT_EQ(m.ready, 0u);
+	EXPECT_EQ(m.inflight, 0u);
+	EXPECT_EQ(m.dlq, 1u);
+
+	auto [report, check_err] = adapter_->check_consistency("pack_q");
+	EXPECT_EQ(report.missing_payloads, 0);
+
+	ASSERT_TRUE(std::get<0>(adapter_->reprocess_dlq_message(second.key)));
+	auto again = adapter_->lease_next("pack_q", "w1", 30);
+	ASSERT_TRUE(again.leased);
+	EXPECT_EQ(again.message->payload_json, R"({"n":2})");
+}
+
+// ---------------------------------------------------------------------------
+// PackCompaction: sparse packs are rewritten and live payloads stay readable
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, PackCompaction)
+{
+	reopen_with_packs(256);
+
+	std::vector<MessageEnvelope> envelopes;
+	for (int i = 0; i < 8; ++i)
+	{
+		// The last message has the lowest priority so it is the one left in the queue
+		envelopes.push_back(make_envelope("compact_q", std::format(R"({{"i":{},"pad":"{}"}})", i, std::string(40, 'p')), i < 7 ? 1 : 0));
+		ASSERT_TRUE(std::get<0>(adapter_->enqueue(envelopes.back())));
+	}
+
+	for (int i = 0; i < 7; ++i)
+	{
+		auto lease = adapter_->lease_next("compact_q", "w1", 30);
+		ASSERT_TRUE(lease.leased);
+		ASSERT_TRUE(std::get<0>(adapter_->ack(lease.lease.value())));
+	}
+
+	auto [kept, kept_err] = adapter_->compact_payload_packs();
+	EXPECT_EQ(kept, 0) << "archived payloads within retention are still live";
+
+	// Age the archived rows past retention
+	DataBase::SQLite db;
+	ASSERT_TRUE(std::get<0>(db.open(temp_dir_->path() + "/hybrid.db")));
+	ASSERT_TRUE(std::get<0>(db.execute("UPDATE msg_index SET available_at = 0 WHERE state = 'archived'")));
+	db.close();
+
+	auto packs_before = std::distance(fs::directory_iterator("./data/packs"), fs::directory_iterator());
+
+	auto [compacted, compact_err] = adapter_->compact_payload_packs();
+	EXPECT_FALSE(compact_err.has_value()) << compact_err.value_or("");
+	EXPECT_GE(compacted, 1);
+
+	auto packs_after = std::distance(fs::directory_iterator("./data/packs"), fs::directory_iterator());
+	EXPECT_LT(packs_after, packs_before);
+
+	auto [report, check_err] = adapter_->check_consistency("compact_q");
+	EXPECT_EQ(report.missing_payloads, 0);
+
+	auto lease = adapter_->lease_next("compact_q", "w1", 30);
+	ASSERT_TRUE(lease.leased);
+	EXPECT_EQ(lease.message->payload_json, envelopes[7].payload_json);
+}
+
+// ---------------------------------------------------------------------------
+// PackCompactionInChunks: live rows spanning several kv chunks all move, and the queue keeps working meanwhile
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, PackCompactionInChunks)
+{
+	reopen_with_packs(4096);
+
+	// One message in four stays; the others are acked and aged out, leaving every pack a quarter live
+	std::map<std::string, std::string> kept;
+	for (int i = 0; i < 1200; ++i)
+	{
+		auto envelope = make_envelope("chunk_q", std::format(R"({{"i":{},"pad":"{}"}})", i, std::string(40, 'p')), i % 4 == 0 ? 0 : 1);
+		ASSERT_TRUE(std::get<0>(adapter_->enqueue(envelope)));
+		if (i % 4 == 0)
+		{
+			kept[envelope.key] = envelope.payload_json;
+		}
+	}
+
+	for (int i = 0; i < 900; ++i)
+	{
+		auto lease = adapter_->lease_next("chunk_q", "w1", 30);
+		ASSERT_TRUE(lease.leased);
+		ASSERT_TRUE(std::get<0>(adapter_->ack(lease.lease.value())));
+	}
+
+	DataBase::SQLite db;
+	ASSERT_TRUE(std::get<0>(db.open(temp_dir_->path() + "/hybrid.db")));
+	ASSERT_TRUE(std::get<0>(db.execute("UPDATE msg_index SET available_at = 0 WHERE state = 'archived'")));
+	db.close();
+
+	std::atomic<bool> done{ false };
+	std::atomic<int> enqueued{ 0 };
+	std::thread writer([&]() {
+		while (!done.load())
+		{
+			if (std::get<0>(adapter_->enqueue(make_envelope("other_q", R"({"writer":true})"))))
+			{
+				enqueued++;
+			}
+		}
+	});
+
+	auto [compacted, compact_err] = adapter_->compact_payload_packs();
+	done.store(true);
+	writer.join();
+
+	EXPECT_FALSE(compact_err.has_value()) << compact_err.value_or("");
+	EXPECT_GE(compacted, 2);
+
+	auto [report, check_err] = adapter_->check_consistency("chunk_q");
+	EXPECT_EQ(report.missing_payloads, 0);
+
+	for (size_t i = 0; i < kept.size(); ++i)
+	{
+		auto lease = adapter_->lease_next("chunk_q", "w1", 30);
+		ASSERT_TRUE(lease.leased) << i;
+		ASSERT_TRUE(kept.contains(lease.message->key));
+		EXPECT_EQ(lease.message->payload_json, kept[lease.message->key]);
+	}
+
+	for (int i = 0; i < enqueued.load(); ++i)
+	{
+		auto lease = adapter_->lease_next("other_q", "w1", 30);
+		ASSERT_TRUE(lease.leased) << i;
+		EXPECT_EQ(lease.message->payload_json, R"({"writer":true})");
+	}
+}
+
+// ---------------------------------------------------------------------------
+// ConcurrentEnqueue: payload writes outside the lock keep every message intact
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, ConcurrentEnqueue)
+{
+	adapter_->close();
+
+	auto config = make_hybrid_config(temp_dir_->path());
+	config.sqlite.sync_payloads = true;
+	ASSERT_TRUE(std::get<0>(adapter_->open(config)));
+
+	// make_envelope is not thread-safe, so build every batch up front
+	std::vector<std::vector<MessageEnvelope>> batches(4);
+	for (int t = 0; t < 4; ++t)
+	{
+		for (int i = 0; i < 10; ++i)
+		{
+			batches[t].push_back(make_envelope("concurrent_q", std::format(R"({{"t":{},"i":{}}})", t, i)));
+		}
+	}
+
+	std::vector<std::thread> threads;
+	std::atomic<int> failures{ 0 };
+	for (const auto& batch : batches)
+	{
+		threads.emplace_back([this, &failures, &batch]() {
+			for (const auto& env : batch)
+			{
+				if (!std::get<0>(adapter_->enqueue(env)))
+				{
+					failures++;
+				}
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(failures.load(), 0);
+
+	auto [m, merr] = adapter_->metrics("concurrent_q");
+	EXPECT_EQ(m.ready, 40u);
+
+	auto [report, check_err] = adapter_->check_consistency("concurrent_q");
+	EXPECT_EQ(report.orphan_payloads, 0);
+	EXPECT_EQ(report.missing_payloads, 0);
+
+	int leased = 0;
+	while (true)
+	{
+		auto result = adapter_->lease_next("concurrent_q", "w1", 30);
+		if (!result.leased)
+		{
+			break;
+		}
+		EXPECT_NE(result.message->payload_json.find("\"t\":"), std::string::npos);
+		leased++;
+	}
+	EXPECT_EQ(leased, 40);
+}
+
+// ---------------------------------------------------------------------------
+// DeferredArchive: ack leaves the archive move to the reclaimer, which replays after a crash
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, DeferredArchive)
+{
+	reopen_with_slow_reclaim();
+
+	auto env = make_envelope("reclaim_q", R"({"job":"deferred"})");
+	ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+
+	auto lease = adapter_->lease_next("reclaim_q", "w1", 30);
+	ASSERT_TRUE(lease.leased);
+	ASSERT_TRUE(std::get<0>(adapter_->ack(lease.lease.value())));
+
+	auto active_path = std::format("{}/{}.json", active_dir("reclaim_q"), env.message_id);
+	auto archive_path = std::format("{}/{}.json", archive_dir("reclaim_q"), env.message_id);
+	EXPECT_TRUE(fs::exists(active_path)) << "archive move is deferred";
+
+	auto [report, check_err] = adapter_->check_consistency("reclaim_q");
+	EXPECT_EQ(report.orphan_payloads, 0) << "pending reclaim is not an orphan";
+
+	adapter_->flush_reclaimer();
+	EXPECT_FALSE(fs::exists(active_path));
+	EXPECT_TRUE(fs::exists(archive_path));
+
+	// Simulate a crash between the ack commit and the reclaimer: payload back in active/, row still pending
+	adapter_->close();
+	fs::rename(archive_path, active_path);
+
+	DataBase::SQLite db;
+	ASSERT_TRUE(std::get<0>(db.open(temp_dir_->path() + "/hybrid.db")));
+	auto [pending, pending_err] = db.query("SELECT COUNT(*) FROM payload_reclaim");
+	ASSERT_TRUE(pending.has_value());
+	EXPECT_EQ(pending->rows[0][0], "0") << "completed moves clear their reclaim rows";
+	ASSERT_TRUE(std::get<0>(db.execute(std::format(
+		"INSERT INTO payload_reclaim (message_key, source_path, target_path, created_at) VALUES ('{}', '{}', '{}', 0)",
+		env.key, active_path, archive_path))));
+	db.close();
+
+	reopen_with_slow_reclaim();
+	adapter_->flush_reclaimer();
+
+	EXPECT_FALSE(fs::exists(active_path)) << "pending move is replayed on open";
+	EXPECT_TRUE(fs::exists(archive_path));
+}
+
+// ---------------------------------------------------------------------------
+// ConsistencyDuringEnqueue: a payload written ahead of its index row is neither reported nor repaired
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, ConsistencyDuringEnqueue)
+{
+	std::vector<std::vector<MessageEnvelope>> batches(2);
+	for (int t = 0; t < 2; ++t)
+	{
+		for (int i = 0; i < 100; ++i)
+		{
+			batches[t].push_back(make_envelope("racing_q", std::format(R"({{"t":{},"i":{}}})", t, i)));
+		}
+	}
+
+	std::atomic<int> failures{ 0 };
+	std::atomic<int> running{ 2 };
+	std::vector<std::thread> threads;
+	for (const auto& batch : batches)
+	{
+		threads.emplace_back([this, &failures, &running, &batch]() {
+			for (const auto& env : batch)
+			{
+				if (!std::get<0>(adapter_->enqueue(env)))
+				{
+					failures++;
+				}
+			}
+			running--;
+		});
+	}
+
+	int32_t orphans = 0;
+	while (running.load() > 0)
+	{
+		auto [report, check_err] = adapter_->check_consistency("racing_q");
+		orphans += report.orphan_payloads;
+		adapter_->repair_consistency(report);
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(failures.load(), 0);
+	EXPECT_EQ(orphans, 0);
+
+	auto [report, check_err] = adapter_->check_consistency("racing_q");
+	EXPECT_EQ(report.issues.size(), 0u);
+
+	auto [m, merr] = adapter_->metrics("racing_q");
+	EXPECT_EQ(m.ready, 200u);
+}
+
+// ---------------------------------------------------------------------------
+// ConsistencySlices: bounded slices cover every queue and resume from the persisted cursor
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, ConsistencySlices)
+{
+	std::vector<std::string> queues = { "slice_a", "slice_b", "slice_c" };
+	for (const auto& queue : queues)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			ASSERT_TRUE(std::get<0>(adapter_->enqueue(make_envelope(queue, std::format(R"({{"n":{}}})", i)))));
+		}
+
+		for (int i = 0; i < 2; ++i)
+		{
+			std::ofstream orphan_file(std::format("{}/orphan-{}.json", active_dir(queue), i), std::ios::out | std::ios::trunc);
+			orphan_file << R"({"payload":"orphan","attributes":"{}"})";
+		}
+	}
+
+	int32_t orphans = 0;
+	std::set<std::string> visited;
+	for (int slices = 0; slices < 100; ++slices)
+	{
+		auto [slice, slice_err] = adapter_->check_consistency_slice(2);
+		ASSERT_FALSE(slice_err.has_value()) << slice_err.value_or("");
+		EXPECT_LE(slice.checked_keys, 2);
+
+		orphans += slice.report.orphan_payloads;
+		visited.insert(slice.queue);
+
+		if (slice.pass_completed)
+		{
+			break;
+		}
+
+		// Reopen mid-pass: the cursor lives in the database, so the scan continues where it stopped
+		if (slice.queue == "slice_b")
+		{
+			adapter_->close();
+			auto [ok, err] = adapter_->open(make_hybrid_config(temp_dir_->path()));
+			ASSERT_TRUE(ok) << err.value_or("");
+
+			auto [resumed, resumed_err] = adapter_->check_consistency_slice(2);
+			ASSERT_FALSE(resumed_err.has_value());
+			EXPECT_NE(resumed.queue, "slice_a") << "scan restarted instead of resuming";
+
+			orphans += resumed.report.orphan_payloads;
+			visited.insert(resumed.queue);
+			if (resumed.pass_completed)
+			{
+				break;
+			}
+		}
+	}
+
+	EXPECT_EQ(orphans, 6);
+	EXPECT_EQ(visited, std::set<std::string>(queues.begin(), queues.end()));
+
+	// A completed pass resets the cursor to the first queue
+	auto [next, next_err] = adapter_->check_consistency_slice(2);
+	ASSERT_FALSE(next_err.has_value());
+	EXPECT_EQ(next.queue, "slice_a");
+}
+
+// ---------------------------------------------------------------------------
+// DictionaryRetention: a full consistency pass retires dictionaries only acked messages used
+// ---------------------------------------------------------------------------
+TEST_F(HybridAdapterTest, DictionaryRetention)
+{
+	adapter_->close();
+
+	CompressionPolicy policy;
+	policy.enabled = true;
+	policy.min_bytes = 32;
+	policy.dictionary = true;
+	policy.dictionary_samples = 8;
+	policy.dictionary_retrain_messages = 8;
+
+	auto config = make_hybrid_config(temp_dir_->path());
+	config.queue_compression["dict_q"] = policy;
+	auto [ok, err] = adapter_->open(config);
+	ASSERT_TRUE(ok) << err.value_or("unknown");
+
+	// Training happens on the 8th, 16th and 24th payload: messages 8-15 use version 1, 16-23 version 2, 24 version 3
+	std::map<std::string, int> index_of;
+	for (int i = 1; i <= 24; ++i)
+	{
+		auto payload = std::format(R"({{"deviceId":"sensor-{:04}","site":"plant-north","type":"environment","temperature":{},"firmware":"2.4.1"}})", i, 20 + i % 7);
+		auto env = make_envelope("dict_q", payload);
+		index_of[env.message_id] = i;
+		ASSERT_TRUE(std::get<0>(adapter_->enqueue(env)));
+	}
+
+	auto dictionary = [](int version) { return std::format("./data/dictionaries/dict_q/{:08}.dict", version); };
+	ASSERT_TRUE(fs::exists(dictionary(1)));
+	ASSERT_TRUE(fs::exists(dictionary(2)));
+	ASSERT_TRUE(fs::exists(dictionary(3)));
+
+	// Everything that used version 2 is acked; version 1 is still in flight
+	std::vector<LeaseToken> version_one;
+	for (int i = 0; i < 24; ++i)
+	{
+		auto result = adapter_->lease_next("dict_q", "w1", 30);
+		ASSERT_TRUE(result.leased);
+
+		auto index = index_of[result.message->message_id];
+		if (index >= 16 && index < 24)
+		{
+			ASSERT_TRUE(std::get<0>(adapter_->ack(result.lease.value())));
+		}
+		else if (index >= 8 && index < 16)
+		{
+			version_one.push_back(result.lease.value());
+		}
+	}
+	adapter_->flush_reclaimer();
+
+	auto [report, check_err] = adapter_->check_consistency();
+	ASSERT_FALSE(check_err.has_value()) << check_err.value_or("");
+
+	EXPECT_TRUE(fs::exists(dictionary(1)));
+	EXPECT_FALSE(fs::exists(dictionary(2)));
+	EXPECT_TRUE(fs::exists(dictionary(3))) << "the latest version is always kept";
+
+	// Messages on the kept version still decode
+	ASSERT_FALSE(version_one.empty());
+	ASSERT_TRUE(std::get<0>(adapter_->nack(version_one.front(), "retry", true)));
+	auto again = adapter_->lease_next("dict_q", "w1", 30);
+	ASSERT_TRUE(again.leased);
+	EXPECT_EQ(index_of[again.message->message_id] / 8, 1);
+}
@@ -0,0 +1,254 @@
+#include "TestHelpers.h"
+#include "IoEngine.h"
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static auto read_all(const std::string& path) -> std::string
+{
+	std::ifstream file(path);
+	return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+class IoEngineTest : public ::testing::Test
+{
+protected:
+	std::unique_ptr<TempDir> temp_dir_;
+
+	void SetUp() override
+	{
+		temp_dir_ = std::make_unique<TempDir>("io_engine_test_");
+	}
+
+	void TearDown() override
+	{
+		temp_dir_.reset();
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AtomicWrite: content lands at target, no temp file left behind
+// ---------------------------------------------------------------------------
+TEST_F(IoEngineTest, AtomicWrite)
+{
+	auto target = temp_dir_->path() + "/a.json";
+
+	auto [ok, err] = Utilities::IoEngine::handle().atomic_write(target, R"({"a":1})");
+	ASSERT_TRUE(ok) << err.value_or("unknown");
+
+	EXPECT_EQ(read_all(target), R"({"a":1})");
+	EXPECT_FALSE(fs::exists(target + ".tmp"));
+
+	auto [sync_ok, sync_err] = Utilities::IoEngine::handle().atomic_write(target, "replaced", true);
+	ASSERT_TRUE(sync_ok) << sync_err.value_or("unknown");
+	EXPECT_EQ(read_all(target), "replaced");
+}
+
+// ---------------------------------------------------------------------------
+// AtomicWriteMissingDirectory: error surfaces through the tuple
+// ---------------------------------------------------------------------------
+TEST_F(IoEngineTest, AtomicWriteMissingDirectory)
+{
+	auto [ok, err] = Utilities::IoEngine::handle().atomic_write(temp_dir_->path() + "/missing/a.json", "x");
+	EXPECT_FALSE(ok);
+	EXPECT_TRUE(err.has_value());
+}
+
+// ---------------------------------------------------------------------------
+// RenameAndUnlink: unlink of a missing file is not an error, the directory can be synced after a move
+// ---------------------------------------------------------------------------
+TEST_F(IoEngineTest, RenameAndUnlink)
+{
+	auto src = temp_dir_->path() + "/src.json";
+	auto dest = temp_dir_->path() + "/dest.json";
+	Utilities::IoEngine::handle().atomic_write(src, "payload");
+
+	auto [moved, move_err] = Utilities::IoEngine::handle().rename(src, dest);
+	ASSERT_TRUE(moved) << move_err.value_or("unknown");
+	EXPECT_FALSE(fs::exists(src));
+	EXPECT_EQ(read_all(dest), "payload");
+
+	auto [synced, sync_err] = Utilities::IoEngine::handle().sync_directory(temp_dir_->path());
+	EXPECT_TRUE(synced) << sync_err.value_or("unknown");
+
+	auto [missing_synced, missing_sync_err] = Utilities::IoEngine::handle().sync_directory(temp_dir_->path() + "/missing");
+	EXPECT_FALSE(missing_synced);
+	EXPECT_TRUE(missing_sync_err.has_value());
+
+	auto [missing_moved, missing_err] = Utilities::IoEngine::handle().rename(src, dest);
+	EXPECT_FALSE(missing_moved);
+	EXPECT_TRUE(missing_err.has_value());
+
+	auto [removed, remove_err] = Utilities::IoEngine::handle().unlink(dest);
+	EXPECT_TRUE(removed);
+	EXPECT_FALSE(fs::exists(dest));
+
+	auto [removed_again, remove_again_err] = Utilities::IoEngine::handle().unlink(dest);
+	EXPECT_TRUE(removed_again);
+}
+
+// ---------------------------------------------------------------------------
+// BatchExecute: results are returned per operation, in order
+// ---------------------------------------------------------------------------
+TEST_F(IoEngineTest, BatchExecute)
+{
+	auto root = temp_dir_->path();
+	Utilities::IoEngine::handle().atomic_write(root + "/old.json", "old");
+
+	auto operations_before = Utilities::IoEngine::handle().operation_count();
+
+	auto results = Utilities::IoEngine::handle().execute({
+		{ Utilities::IoOperationTypes::AtomicWrite, root + "/new.json", "", "new" },
+		{ Utilities::IoOperationTypes::Rename, root + "/old.json", root + "/moved.json" },
+		{ Utilities::IoOperationTypes::Rename, root + "/none.json", root + "/none2.json" },
+		{ Utilities::IoOperationTypes::Unlink, root + "/none.json" }
+	});
+
+	ASSERT_EQ(results.size(), 4u);
+	EXPECT_TRUE(std::get<0>(results[0]));
+	EXPECT_TRUE(std::get<0>(results[1]));
+	EXPECT_FALSE(std::get<0>(results[2]));
+	EXPECT_TRUE(std::get<0>(results[3]));
+
+	EXPECT_EQ(read_all(root + "/new.json"), "new");
+	EXPECT_EQ(read_all(root + "/moved.json"), "old");
+	EXPECT_GE(Utilities::IoEngine::handle().operation_count() - operations_before, 4u);
+}
+
+// ---------------------------------------------------------------------------
+// ConcurrentWriters: many threads writing distinct files all succeed
+// ---------------------------------------------------------------------------
+TEST_F(IoEngineTest, ConcurrentWriters)
+{
+	auto root = temp_dir_->path();
+	std::vector<std::thread> threads;
+	std::atomic<int> failures{ 0 };
+
+	for (int t = 0; t < 8; ++t)
+	{
+		threads.emplace_back([&root, &failures, t]() {
+			for (int i = 0; i < 50; ++i)
+			{
+				auto [ok, err] = Utilities::IoEngine::handle().atomic_write(std::format("{}/{}_{}.json", root, t, i), std::to_string(i));
+				if (!ok)
+				{
+					failures++;
+				}
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(failures.load(), 0);
+	EXPECT_EQ(read_all(root + "/7_49.json"), "49");
+}
+
+// ---------------------------------------------------------------------------
+// DependentOperationsInOneBatch: a caller's operations apply in order, and a
+// burst of synced writes takes one submission per phase on io_uring
+// ---------------------------------------------------------------------------
+TEST_F(IoEngineTest, DependentOperationsInOneBatch)
+{
+	auto root = temp_dir_->path();
+
+	auto results = Utilities::IoEngine::handle().execute({
+		{ Utilities::IoOperationTypes::AtomicWrite, root + "/first.json", "", "chained", true },
+		{ Utilities::IoOperationTypes::Rename, root + "/first.json", root + "/second.json", "", false },
+		{ Utilities::IoOperationTypes::Rename, root + "/missing.json", root + "/other.json", "", false },
+		{ Utilities::IoOperationTypes::Rename, root + "/second.json", root + "/third.json", "", false },
+		{ Utilities::IoOperationTypes::Unlink, root + "/second.json", "", "", false }
+	});
+
+	ASSERT_EQ(results.size(), 5u);
+	EXPECT_TRUE(std::get<0>(results[0]));
+	EXPECT_TRUE(std::get<0>(results[1]));
+	EXPECT_FALSE(std::get<0>(results[2]));
+	EXPECT_TRUE(std::get<0>(results[3]));
+	EXPECT_TRUE(std::get<0>(results[4]));
+	EXPECT_FALSE(fs::exists(root + "/first.json"));
+	EXPECT_FALSE(fs::exists(root + "/second.json"));
+	EXPECT_EQ(read_all(root + "/third.json"), "chained");
+
+	std::vector<Utilities::IoOperation> burst;
+	for (int i = 0; i < 64; ++i)
+	{
+		burst.push_back({ Utilities::IoOperationTypes::AtomicWrite, std::format("{}/burst_{}.json", root, i), "", std::to_string(i), true });
+	}
+
+	auto submissions_before = Utilities::IoEngine::handle().submission_count();
+	for (const auto& [ok, err] : Utilities::IoEngine::handle().execute(burst))
+	{
+		EXPECT_TRUE(ok) << err.value_or("unknown");
+	}
+	auto submissions = Utilities::IoEngine::handle().submission_count() - submissions_before;
+
+	EXPECT_EQ(read_all(root + "/burst_63.json"), "63");
+	if (Utilities::IoEngine::handle().uring_enabled())
+	{
+		// openat, write linked to fsync, renameat
+		EXPECT_EQ(submissions, 3u);
+	}
+	else
+	{
+		EXPECT_EQ(submissions, burst.size());
+	}
+}
+
+// ---------------------------------------------------------------------------
+// BenchmarkSerialCaller: a lone thread making small calls, engine vs plain system calls
+// ---------------------------------------------------------------------------
+TEST_F(IoEngineTest, BenchmarkSerialCaller)
+{
+	auto root = temp_dir_->path();
+	const int iterations = 500;
+
+	// The mailbox response write: unlink the answered request, then publish the response
+	auto submissions_before = Utilities::IoEngine::handle().submission_count();
+	auto engine_start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		auto results = Utilities::IoEngine::handle().execute({
+			{ Utilities::IoOperationTypes::Unlink, std::format("{}/request_{}.json", root, i) },
+			{ Utilities::IoOperationTypes::AtomicWrite, std::format("{}/engine_{}.json", root, i), "", R"({"ok":true})" }
+		});
+		ASSERT_TRUE(std::get<0>(results.back())) << std::get<1>(results.back()).value_or("unknown");
+	}
+	auto engine_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - engine_start).count();
+	auto submissions = Utilities::IoEngine::handle().submission_count() - submissions_before;
+
+	auto plain_start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		::unlink(std::format("{}/request_{}.json", root, i).c_str());
+
+		auto path = std::format("{}/plain_{}.json", root, i);
+		int fd = ::open((path + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		ASSERT_GE(fd, 0);
+		ASSERT_EQ(::write(fd, R"({"ok":true})", 11), 11);
+		::close(fd);
+		ASSERT_EQ(::rename((path + ".tmp").c_str(), path.c_str()), 0);
+	}
+	auto plain_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - plain_start).count();
+
+	// Nothing else is in the engine, so every call ran inline instead of going through the submitter
+	EXPECT_EQ(submissions, static_cast<uint64_t>(2 * iterations));
+	EXPECT_EQ(read_all(std::format("{}/engine_{}.json", root, iterations - 1)), R"({"ok":true})");
+
+	std::cout << std::format("[ bench    ] serial unlink + atomic write ({}): engine {:.2f} us/call, plain {:.2f} us/call\n",
+							 Utilities::IoEngine::handle().uring_enabled() ? "io_uring" : "blocking", static_cast<double>(engine_us) / iterations,
+							 static_cast<double>(plain_us) / iterations);
+}
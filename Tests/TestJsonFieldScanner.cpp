@@ -0,0 +1,161 @@
+#include "TestHelpers.h"
+#include "JsonFieldScanner.h"
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <format>
+#include <iostream>
+
+using json = nlohmann::json;
+
+// ---------------------------------------------------------------------------
+// Fields: routing members decode like the DOM, nested values stay raw
+// ---------------------------------------------------------------------------
+TEST(JsonFieldScannerTest, Fields)
+{
+	std::string text = R"( {"requestId":"req-1", "deadlineMs": 1700000000123, "ok" : true,
+		"payload": {"queue":"q1","message":"{\"a\":[1,2,{\"b\":\"}\"}]}","nested":{"x":[]}}, "ratio": 2.5e0, "none": null} )";
+
+	JsonFieldScanner fields;
+	auto [ok, error] = fields.scan(text);
+	ASSERT_TRUE(ok) << error.value_or("");
+
+	EXPECT_EQ(fields.string("requestId"), "req-1");
+	EXPECT_EQ(fields.int64("deadlineMs"), 1700000000123);
+	EXPECT_EQ(fields.boolean("ok"), true);
+	EXPECT_EQ(fields.int64("ratio"), 2);
+	EXPECT_TRUE(fields.contains("none"));
+	EXPECT_FALSE(fields.string("none").has_value());
+	EXPECT_FALSE(fields.contains("queue"));
+	EXPECT_FALSE(fields.int64("requestId").has_value());
+
+	ASSERT_TRUE(fields.is_object("payload"));
+	auto payload_raw = fields.raw("payload").value();
+	EXPECT_EQ(json::parse(payload_raw), json::parse(text)["payload"]);
+
+	JsonFieldScanner payload;
+	ASSERT_TRUE(std::get<0>(payload.scan(payload_raw)));
+	EXPECT_EQ(payload.string("queue"), "q1");
+	EXPECT_EQ(payload.string("message"), json::parse(text)["payload"]["message"].get<std::string>());
+}
+
+// ---------------------------------------------------------------------------
+// Strings: escapes and unicode decode to the same bytes as nlohmann
+// ---------------------------------------------------------------------------
+TEST(JsonFieldScannerTest, Strings)
+{
+	json source;
+	source["s"] = "tab\t quote\" slash\\ newline\n \x01 caf\xC3\xA9 \xF0\x9F\x98\x80";
+	auto text = source.dump(-1, ' ', true);  // ASCII-only output forces \u escapes and surrogate pairs
+
+	JsonFieldScanner fields;
+	ASSERT_TRUE(std::get<0>(fields.scan(text)));
+	EXPECT_EQ(fields.string("s"), source["s"].get<std::string>());
+
+	EXPECT_FALSE(JsonFieldScanner::decode_string(R"("bad \x escape")").has_value());
+	EXPECT_FALSE(JsonFieldScanner::decode_string(R"("lone \ud800 surrogate")").has_value());
+}
+
+// ---------------------------------------------------------------------------
+// Utf8: whatever the scanner accepts, nlohmann can dump again
+// ---------------------------------------------------------------------------
+TEST(JsonFieldScannerTest, Utf8)
+{
+	for (std::string bad : { "a\xff", "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "caf\xc3", "\\udc00", "\\ud800\\u0041", "\\ud800x" })
+	{
+		auto text = std::format(R"({{"message":"{}"}})", bad);
+		EXPECT_FALSE(json::accept(text)) << bad;
+
+		JsonFieldScanner fields;
+		EXPECT_FALSE(std::get<0>(fields.scan(text))) << bad;
+		EXPECT_FALSE(JsonFieldScanner::decode_string(std::format(R"("{}")", bad)).has_value()) << bad;
+
+		// Nested strings are checked too, since the payload slice is scanned as its own document
+		JsonFieldScanner nested;
+		EXPECT_FALSE(std::get<0>(nested.scan(std::format(R"({{"payload":{}}})", text)))) << bad;
+	}
+
+	std::string good = "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \\ud83d\\ude00";
+	auto text = std::format(R"({{"message":"{}"}})", good);
+	JsonFieldScanner fields;
+	ASSERT_TRUE(std::get<0>(fields.scan(text)));
+	auto decoded = fields.string("message");
+	ASSERT_TRUE(decoded.has_value());
+	EXPECT_EQ(decoded.value(), json::parse(text)["message"].get<std::string>());
+	EXPECT_NO_THROW(json(decoded.value()).dump());
+}
+
+// ---------------------------------------------------------------------------
+// Malformed: structural errors are reported
+// ---------------------------------------------------------------------------
+TEST(JsonFieldScannerTest, Malformed)
+{
+	for (const auto* text : { "", "[]", "{not json", R"({"a":1,})", R"({"a":[1,2})", R"({"a":{"b":1]})", R"({"a":tru})",
+							  R"({"a":"unterminated})", R"({"a":1} trailing)", R"({"a" 1})" })
+	{
+		JsonFieldScanner fields;
+		EXPECT_FALSE(std::get<0>(fields.scan(text))) << text;
+	}
+
+	JsonFieldScanner empty;
+	EXPECT_TRUE(std::get<0>(empty.scan(" { } ")));
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark: routing fields plus message extraction, DOM path vs on-demand path
+// ---------------------------------------------------------------------------
+TEST(JsonFieldScannerTest, BenchmarkAgainstDom)
+{
+	for (size_t payload_bytes : { size_t(1024), size_t(64 * 1024) })
+	{
+		json message;
+		message["blob"] = std::string(payload_bytes, 'x');
+		message["items"] = json::array({ 1, 2, 3 });
+
+		json request;
+		request["requestId"] = "req-bench";
+		request["clientId"] = "client-bench";
+		request["command"] = "publish";
+		request["deadlineMs"] = 1700000000000;
+		request["payload"] = { { "queue", "bench-q" }, { "message", message.dump() } };
+		auto text = request.dump(2);
+
+		const int iterations = payload_bytes > 4096 ? 50 : 500;
+
+		// What parse_request + handle_publish did: DOM, dump payload, parse it again, copy message out
+		auto dom_start = std::chrono::steady_clock::now();
+		size_t dom_bytes = 0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			auto document = json::parse(text);
+			auto request_id = document["requestId"].get<std::string>();
+			auto payload_json = document["payload"].dump();
+			auto payload = json::parse(payload_json);
+			auto queue = payload["queue"].get<std::string>();
+			std::string body = payload.value("message", "{}");
+			dom_bytes += body.size() + request_id.size() + queue.size();
+		}
+		auto dom_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - dom_start).count();
+
+		auto scan_start = std::chrono::steady_clock::now();
+		size_t scan_bytes = 0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			JsonFieldScanner fields;
+			fields.scan(text);
+			auto request_id = fields.string("requestId").value();
+			std::string payload_json(fields.raw("payload").value());
+			JsonFieldScanner payload;
+			payload.scan(payload_json);
+			auto queue = payload.string("queue").value();
+			auto body = payload.string("message").value();
+			scan_bytes += body.size() + request_id.size() + queue.size();
+		}
+		auto scan_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - scan_start).count();
+
+		EXPECT_EQ(dom_bytes, scan_bytes);
+
+		std::cout << std::format("[ bench    ] {:>6} B payload: DOM {:.2f} us/request, on-demand {:.2f} us/request\n", payload_bytes,
+								 static_cast<double>(dom_us) / iterations, static_cast<double>(scan_us) / iterations);
+	}
+}
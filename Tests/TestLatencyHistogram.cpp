@@ -0,0 +1,98 @@
+#include "LatencyHistogram.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Utilities;
+
+// ---------------------------------------------------------------------------
+// Buckets: exact below 32 us, within 1/32 of the value above, ordered throughout
+// ---------------------------------------------------------------------------
+TEST(LatencyHistogramTest, Buckets)
+{
+	for (uint64_t value = 0; value < 32; ++value)
+	{
+		EXPECT_EQ(LatencyHistogram::highest_of(LatencyHistogram::bucket_of(value)), value);
+	}
+
+	size_t previous = 0;
+	for (uint64_t value = 1; value < (uint64_t(1) << 40); value = value * 3 / 2 + 1)
+	{
+		auto bucket = LatencyHistogram::bucket_of(value);
+		auto highest = LatencyHistogram::highest_of(bucket);
+		EXPECT_GE(bucket, previous);
+		EXPECT_GE(highest, value);
+		EXPECT_LE(static_cast<double>(highest - value), static_cast<double>(value) / 32.0) << value;
+		previous = bucket;
+	}
+
+	// Beyond the tracked range everything shares the last bucket
+	EXPECT_EQ(LatencyHistogram::bucket_of(uint64_t(1) << 50), LatencyHistogram::bucket_of(UINT64_MAX));
+}
+
+// ---------------------------------------------------------------------------
+// Percentiles: quantiles of a uniform 1..10000 us sample, reset clears them
+// ---------------------------------------------------------------------------
+TEST(LatencyHistogramTest, Percentiles)
+{
+	LatencyHistogram histogram;
+	EXPECT_EQ(histogram.snapshot().p99_us, 0u);
+
+	for (uint64_t value = 1; value <= 10000; ++value)
+	{
+		histogram.record(value);
+	}
+
+	auto snapshot = histogram.snapshot();
+	EXPECT_EQ(snapshot.count, 10000u);
+	EXPECT_EQ(snapshot.max_us, 10000u);
+	EXPECT_DOUBLE_EQ(snapshot.mean_us(), 5000.5);
+	EXPECT_NEAR(static_cast<double>(snapshot.p50_us), 5000.0, 5000.0 / 32.0);
+	EXPECT_NEAR(static_cast<double>(snapshot.p90_us), 9000.0, 9000.0 / 32.0);
+	EXPECT_NEAR(static_cast<double>(snapshot.p99_us), 9900.0, 9900.0 / 32.0);
+	EXPECT_NEAR(static_cast<double>(snapshot.p999_us), 9990.0, 9990.0 / 32.0);
+	EXPECT_LE(snapshot.p999_us, snapshot.max_us);
+	EXPECT_EQ(histogram.percentile(0.5), snapshot.p50_us);
+	EXPECT_EQ(histogram.percentile(1.0), 10000u);
+
+	histogram.reset();
+	EXPECT_EQ(histogram.count(), 0u);
+	EXPECT_EQ(histogram.snapshot().max_us, 0u);
+}
+
+// ---------------------------------------------------------------------------
+// Concurrent: writers on several threads lose no records
+// ---------------------------------------------------------------------------
+TEST(LatencyHistogramTest, Concurrent)
+{
+	LatencyHistogram histogram;
+	constexpr int thread_count = 4;
+	constexpr int per_thread = 250000;
+
+	auto started = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([&histogram, t]()
+		{
+			for (int i = 0; i < per_thread; ++i)
+			{
+				histogram.record(static_cast<uint64_t>((i * 7 + t) % 5000));
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+
+	EXPECT_EQ(histogram.count(), static_cast<uint64_t>(thread_count) * per_thread);
+	EXPECT_EQ(histogram.snapshot().max_us, 4999u);
+
+	std::cout << std::format("[ bench    ] {:.1f} ns per record with {} threads recording\n",
+							 static_cast<double>(elapsed_ns) / (thread_count * per_thread) * thread_count, thread_count);
+}
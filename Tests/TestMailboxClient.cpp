@@ -0,0 +1,125 @@
+#include "TestHelpers.h"
+#include "MailboxClient.h"
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+using namespace Utilities;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+class MailboxClientTest : public ::testing::Test
+{
+protected:
+	std::unique_ptr<TempDir> temp_dir_;
+	std::string root_;
+	std::atomic<bool> responding_{ false };
+	std::thread responder_;
+
+	void SetUp() override
+	{
+		init_test_logger();
+		temp_dir_ = std::make_unique<TempDir>();
+		root_ = temp_dir_->path() + "/ipc";
+	}
+
+	void TearDown() override
+	{
+		responding_.store(false);
+		if (responder_.joinable())
+		{
+			responder_.join();
+		}
+		temp_dir_.reset();
+	}
+
+	// Minimal daemon stand-in: answers every request with an atomically renamed response file
+	auto start_responder(void) -> void
+	{
+		responding_.store(true);
+		responder_ = std::thread([this]()
+		{
+			while (responding_.load())
+			{
+				std::error_code ec;
+				for (const auto& entry : fs::directory_iterator(root_ + "/requests", ec))
+				{
+					if (entry.path().extension() != ".json")
+					{
+						continue;
+					}
+
+					std::ifstream file(entry.path());
+					auto request = json::parse(file, nullptr, false);
+					file.close();
+					fs::remove(entry.path(), ec);
+					if (request.is_discarded())
+					{
+						continue;
+					}
+
+					json response;
+					response["requestId"] = request["requestId"];
+					response["ok"] = true;
+					response["data"] = { { "command", request["command"] } };
+
+					auto target = std::format("{}/responses/{}/{}.json", root_, request["clientId"].get<std::string>(),
+											  request["requestId"].get<std::string>());
+					std::ofstream(target + ".tmp") << response.dump();
+					fs::rename(target + ".tmp", target, ec);
+				}
+				std::this_thread::sleep_for(std::chrono::microseconds(500));
+			}
+		});
+	}
+};
+
+// ---------------------------------------------------------------------------
+// RoundTrip: responses are picked up by the watch without the polling delay
+// ---------------------------------------------------------------------------
+TEST_F(MailboxClientTest, RoundTrip)
+{
+	MailboxClient client(root_, "requests", "responses", "client-1");
+	ASSERT_TRUE(client.watching());
+	start_responder();
+
+	std::vector<int64_t> latencies_us;
+	for (int i = 0; i < 20; ++i)
+	{
+		auto started = std::chrono::steady_clock::now();
+		auto [ok, response] = client.send_request("health", json::object(), 3000);
+		latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+
+		ASSERT_TRUE(ok) << response.dump();
+		EXPECT_TRUE(response["ok"].get<bool>());
+		EXPECT_EQ(response["data"]["command"], "health");
+	}
+
+	// Consumed responses are removed
+	EXPECT_TRUE(fs::is_empty(root_ + "/responses/client-1"));
+
+	std::sort(latencies_us.begin(), latencies_us.end());
+	EXPECT_LT(latencies_us[latencies_us.size() / 2], 20000) << "median round trip should not include a polling interval";
+}
+
+// ---------------------------------------------------------------------------
+// Timeout: no responder means a timeout error once the deadline passes
+// ---------------------------------------------------------------------------
+TEST_F(MailboxClientTest, Timeout)
+{
+	MailboxClient client(root_, "requests", "responses", "client-2");
+
+	auto started = std::chrono::steady_clock::now();
+	auto [ok, response] = client.send_request("health", json::object(), 200);
+	auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+
+	EXPECT_FALSE(ok);
+	EXPECT_EQ(response["error"], "timeout waiting for response");
+	EXPECT_GE(elapsed_ms, 190);
+	EXPECT_LT(elapsed_ms, 1000);
+	EXPECT_EQ(std::distance(fs::directory_iterator(root_ + "/requests"), fs::directory_iterator{}), 1);
+}
@@ -1,15 +1,21 @@
 #include "TestHelpers.h"
 #include "MailboxHandler.h"
 #include "QueueManager.h"
+#include "SharedMemoryRing.h"
 
 #include <gtest/gtest.h>
 #include <nlohmann/json.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <mutex>
 #include <thread>
+#include <set>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
@@ -28,11 +34,13 @@ public:
 	struct EnqueueRecord
 	{
 		MessageEnvelope envelope;
+		uint64_t sequence = 0;
 	};
 
 	struct AckRecord
 	{
 		LeaseToken lease;
+		uint64_t sequence = 0;
 	};
 
 	struct NackRecord
@@ -51,6 +59,10 @@ public:
 	// Configurable return for lease_next
 	LeaseResult next_lease_result = { false, std::nullopt, std::nullopt, std::nullopt };
 
+	// Artificial latency for lease_next (simulates a slow request)
+	std::atomic<int32_t> lease_delay_ms{ 0 };
+	std::atomic<int32_t> lease_calls{ 0 };
+
 	// Configurable return for enqueue
 	bool enqueue_should_succeed = true;
 
@@ -72,6 +84,12 @@ public:
 	// Configurable DLQ messages
 	std::vector<DlqMessageInfo> configured_dlq_messages;
 
+	auto set_next_lease_result(const LeaseResult& result) -> void
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		next_lease_result = result;
+	}
+
 	// -- Recorded calls -------------------------------------------------------
 
 	auto get_enqueue_calls(void) -> std::vector<EnqueueRecord>
@@ -116,7 +134,7 @@ public:
 	auto enqueue(const MessageEnvelope& message) -> std::tuple<bool, std::optional<std::string>> override
 	{
 		std::lock_guard<std::mutex> lock(mutex_);
-		enqueue_calls_.push_back({ message });
+		enqueue_calls_.push_back({ message, ++call_sequence_ });
 		if (enqueue_should_succeed)
 		{
 			return { true, std::nullopt };
@@ -127,6 +145,12 @@ public:
 	auto lease_next(const std::string& /*queue*/, const std::string& /*consumer_id*/, const int32_t& /*visibility_timeout_sec*/)
 		-> LeaseResult override
 	{
+		lease_calls++;
+		if (lease_delay_ms.load() > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(lease_delay_ms.load()));
+		}
+
 		std::lock_guard<std::mutex> lock(mutex_);
 		return next_lease_result;
 	}
@@ -134,7 +158,7 @@ public:
 	auto ack(const LeaseToken& lease) -> std::tuple<bool, std::optional<std::string>> override
 	{
 		std::lock_guard<std::mutex> lock(mutex_);
-		ack_calls_.push_back({ lease });
+		ack_calls_.push_back({ lease, ++call_sequence_ });
 		if (ack_should_succeed)
 		{
 			return { true, std::nullopt };
@@ -234,6 +258,7 @@ public:
 
 private:
 	mutable std::mutex mutex_;
+	uint64_t call_sequence_ = 0;
 	std::vector<EnqueueRecord> enqueue_calls_;
 	std::vector<AckRecord> ack_calls_;
 	std::vector<NackRecord> nack_calls_;
@@ -968,6 +993,49 @@ TEST_F(MailboxHandlerTest, MetricsCommand)
 	EXPECT_TRUE((*response)["data"].contains("timing"));
 }
 
+TEST_F(MailboxHandlerTest, MetricsLatencyHistograms)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	for (int i = 0; i < 20; ++i)
+	{
+		json payload;
+		payload["queue"] = "latency-q";
+		payload["message"] = R"({"n":1})";
+		write_request(make_request_json(std::format("req-lat-{}", i), "client-1", "publish", payload));
+		ASSERT_TRUE(wait_for_response("client-1", std::format("req-lat-{}", i)).has_value()) << i;
+	}
+
+	json reset_payload;
+	reset_payload["reset"] = true;
+	write_request(make_request_json("req-lat-metrics", "client-1", "metrics", reset_payload));
+	auto response = wait_for_response("client-1", "req-lat-metrics");
+	ASSERT_TRUE(response.has_value());
+
+	auto& latency = (*response)["data"]["latency"];
+	auto& publish = latency["commands"]["publish"];
+	EXPECT_EQ(publish["count"], 20);
+	EXPECT_LE(publish["p50Us"].get<uint64_t>(), publish["p90Us"].get<uint64_t>());
+	EXPECT_LE(publish["p90Us"].get<uint64_t>(), publish["p99Us"].get<uint64_t>());
+	EXPECT_LE(publish["p999Us"].get<uint64_t>(), publish["maxUs"].get<uint64_t>());
+	EXPECT_TRUE(latency["reset"].get<bool>());
+
+	// Every stage a file publish passes through was timed; no schema is registered, so nothing was validated
+	for (const auto* stage : { "queueWait", "parse", "backend", "responseWrite" })
+	{
+		EXPECT_GE(latency["stages"][stage]["count"].get<int>(), 20) << stage;
+	}
+	EXPECT_EQ(latency["stages"]["validation"]["count"], 0);
+
+	// The reset cleared them: only the previous metrics request shows up now
+	write_request(make_request_json("req-lat-metrics-2", "client-1", "metrics"));
+	auto after = wait_for_response("client-1", "req-lat-metrics-2");
+	ASSERT_TRUE(after.has_value());
+	EXPECT_EQ((*after)["data"]["latency"]["commands"]["publish"]["count"], 0);
+	EXPECT_EQ((*after)["data"]["latency"]["commands"]["metrics"]["count"], 1);
+}
+
 // ---------------------------------------------------------------------------
 // ListDlq command
 // ---------------------------------------------------------------------------
@@ -1186,6 +1254,46 @@ TEST_F(MailboxHandlerTest, MissingRequestIdGoesToDead)
 	EXPECT_TRUE(found_in_dead) << "Request with missing requestId should be moved to dead directory";
 }
 
+TEST_F(MailboxHandlerTest, InvalidUtf8PublishGoesToDead)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	// Invalid UTF-8 and a lone low surrogate would make any later dump() of the envelope throw
+	auto request_dir = config_.root + "/requests";
+	std::vector<std::pair<std::string, std::string>> bad_messages = { { "bad-utf8", "a\xff" }, { "lone-surrogate", "\\udc00" } };
+	for (const auto& [request_id, message] : bad_messages)
+	{
+		json payload;
+		payload["queue"] = "utf8-q";
+		payload["message"] = "MESSAGE";
+		auto text = make_request_json(request_id, "utf8-client", "publish", payload).dump();
+		text.replace(text.find("MESSAGE"), 7, message);
+
+		auto file_path = std::format("{}/{}.json", request_dir, request_id);
+		std::ofstream file(file_path + ".tmp");
+		file << text;
+		file.close();
+		fs::rename(file_path + ".tmp", file_path);
+	}
+
+	json payload;
+	payload["queue"] = "utf8-q";
+	payload["message"] = R"({"ok":true})";
+	write_request(make_request_json("good-utf8", "utf8-client", "publish", payload));
+
+	auto response = wait_for_response("utf8-client", "good-utf8", 3000);
+	ASSERT_TRUE(response.has_value()) << "a valid publish after the bad ones was not answered";
+	EXPECT_TRUE((*response)["ok"].get<bool>());
+	EXPECT_EQ(mock_backend_->get_enqueue_calls().size(), 1u);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	for (const auto& [request_id, message] : bad_messages)
+	{
+		EXPECT_TRUE(fs::exists(std::format("{}/dead/{}.json", config_.root, request_id))) << request_id;
+	}
+}
+
 // ---------------------------------------------------------------------------
 // Command alias tests (consume, extend, dlq, reprocess)
 // ---------------------------------------------------------------------------
@@ -1256,6 +1364,117 @@ TEST_F(MailboxHandlerTest, MultipleRequestsProcessedSequentially)
 	}
 }
 
+TEST_F(MailboxHandlerTest, WatcherPicksUpExistingAndNewRequests)
+{
+	config_.use_folder_watcher = true;
+	config_.poll_interval_ms = 5000;  // answers must come from events, not the wait timeout
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	write_request(make_request_json("req-watch-existing", "client-1", "health"));
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	auto existing = wait_for_response("client-1", "req-watch-existing", 2000);
+	ASSERT_TRUE(existing.has_value());
+	EXPECT_TRUE((*existing)["ok"].get<bool>());
+
+	for (int i = 0; i < 50; ++i)
+	{
+		write_request(make_request_json(std::format("req-watch-{}", i), "client-1", "health"));
+	}
+	for (int i = 0; i < 50; ++i)
+	{
+		ASSERT_TRUE(wait_for_response("client-1", std::format("req-watch-{}", i), 2000).has_value()) << i;
+	}
+}
+
+TEST_F(MailboxHandlerTest, RequestsAreClaimedInPlace)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	constexpr int request_count = 20;
+	for (int i = 0; i < request_count; ++i)
+	{
+		write_request(make_request_json(std::format("req-claim-{}", i), "client-1", "health"));
+	}
+	for (int i = 0; i < request_count; ++i)
+	{
+		ASSERT_TRUE(wait_for_response("client-1", std::format("req-claim-{}", i)).has_value()) << i;
+	}
+
+	write_request(make_request_json("req-claim-metrics", "client-1", "metrics"));
+	auto metrics = wait_for_response("client-1", "req-claim-metrics");
+	ASSERT_TRUE(metrics.has_value());
+
+	// open, fstat, one read and close, then the unlink and the response's atomic write as estimated by the handler
+	auto& intake = (*metrics)["data"]["intake"];
+	EXPECT_GE(intake["requests"].get<int>(), request_count);
+	EXPECT_LE(intake["estimatedFileCallsPerRequest"].get<double>(), 9.0) << intake.dump();
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	EXPECT_TRUE(fs::is_empty(config_.root + "/" + config_.processing_dir));
+	for (const auto& entry : fs::directory_iterator(config_.root + "/" + config_.requests_dir))
+	{
+		ADD_FAILURE() << "left behind: " << entry.path();
+	}
+}
+
+TEST_F(MailboxHandlerTest, RequestIsRemovedBeforeItsResponseAppears)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	// A client may read and delete its response at once; the request must not still be there for a restart to replay
+	constexpr int request_count = 10;
+	for (int i = 0; i < request_count; ++i)
+	{
+		json payload;
+		payload["queue"] = "answered-q";
+		payload["message"] = R"({"n":1})";
+		write_request(make_request_json(std::format("req-answered-{}", i), "client-1", "publish", payload));
+
+		auto request_path = std::format("{}/{}/req-answered-{}.json", config_.root, config_.requests_dir, i);
+		auto response_path = std::format("{}/{}/client-1/req-answered-{}.json", config_.root, config_.responses_dir, i);
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+		while (!fs::exists(response_path) && std::chrono::steady_clock::now() < deadline)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		ASSERT_TRUE(fs::exists(response_path)) << i;
+		EXPECT_FALSE(fs::exists(request_path)) << "request " << i << " outlived its response";
+		fs::remove(response_path);
+	}
+}
+
+TEST_F(MailboxHandlerTest, UnansweredRequestsReplayOnStart)
+{
+	json payload;
+	payload["queue"] = "replay-q";
+	payload["message"] = R"({"n":1})";
+
+	// Left by a previous run: one never claimed, one claimed by an older build, one answered but not yet removed
+	write_request(make_request_json("req-replay-open", "client-1", "publish", payload));
+	write_request(make_request_json("req-replay-legacy", "client-1", "publish", payload));
+	fs::create_directories(config_.root + "/" + config_.processing_dir);
+	fs::rename(config_.root + "/requests/req-replay-legacy.json", config_.root + "/processing/req-replay-legacy.json");
+	write_request(make_request_json("req-replay-done", "client-1", "publish", payload));
+	fs::create_directories(config_.root + "/responses/client-1");
+	std::ofstream(config_.root + "/responses/client-1/req-replay-done.json") << R"({"requestId":"req-replay-done","ok":true,"data":{}})";
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	ASSERT_TRUE(wait_for_response("client-1", "req-replay-open").has_value());
+	ASSERT_TRUE(wait_for_response("client-1", "req-replay-legacy").has_value());
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	EXPECT_EQ(mock_backend_->get_enqueue_calls().size(), 2u);
+	EXPECT_FALSE(fs::exists(config_.root + "/requests/req-replay-done.json"));
+	EXPECT_TRUE(fs::is_empty(config_.root + "/" + config_.processing_dir));
+}
+
 // ---------------------------------------------------------------------------
 // Multiple clients
 // ---------------------------------------------------------------------------
@@ -1282,6 +1501,857 @@ TEST_F(MailboxHandlerTest, MultipleClientsGetSeparateResponses)
 	EXPECT_EQ((*resp2)["requestId"], "req-mc-2");
 }
 
+// ---------------------------------------------------------------------------
+// Parallel dispatch
+// ---------------------------------------------------------------------------
+
+TEST_F(MailboxHandlerTest, SlowClientDoesNotBlockOthers)
+{
+	config_.dispatch_workers = 2;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+	mock_backend_->lease_delay_ms = 1500;
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	json payload;
+	payload["queue"] = "slow-q";
+	payload["consumerId"] = "consumer-1";
+	write_request(make_request_json("req-par-1", "client-slow", "consume_next", payload));
+	std::this_thread::sleep_for(std::chrono::milliseconds(150));
+	write_request(make_request_json("req-par-2", "client-fast", "health"));
+
+	auto fast = wait_for_response("client-fast", "req-par-2", 1000);
+	ASSERT_TRUE(fast.has_value()) << "independent client was blocked by a slow request";
+
+	auto slow_path = std::format("{}/{}/client-slow/req-par-1.json", config_.root, config_.responses_dir);
+	EXPECT_FALSE(fs::exists(slow_path));
+
+	EXPECT_TRUE(wait_for_response("client-slow", "req-par-1").has_value());
+}
+
+TEST_F(MailboxHandlerTest, PublishesToOneQueueStayOrdered)
+{
+	config_.dispatch_workers = 4;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	// Written before start so the whole batch is dispatched at once, in filename order
+	for (int i = 0; i < 12; ++i)
+	{
+		json payload;
+		payload["queue"] = "ordered";
+		payload["message"] = std::format(R"({{"n":{}}})", i);
+		write_request(make_request_json(std::format("req-ord-{:02}", i), std::format("client-{}", i % 3), "publish", payload));
+	}
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	ASSERT_TRUE(wait_for_response("client-2", "req-ord-11").has_value());
+	for (int i = 0; i < 12; ++i)
+	{
+		ASSERT_TRUE(wait_for_response(std::format("client-{}", i % 3), std::format("req-ord-{:02}", i)).has_value());
+	}
+
+	auto calls = mock_backend_->get_enqueue_calls();
+	ASSERT_EQ(calls.size(), 12u);
+	for (int i = 0; i < 12; ++i)
+	{
+		EXPECT_EQ(json::parse(calls[i].envelope.payload_json)["n"], i);
+	}
+}
+
+TEST_F(MailboxHandlerTest, MetricsReportWorkerUtilization)
+{
+	config_.dispatch_workers = 3;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	write_request(make_request_json("req-util-1", "client-1", "health"));
+	ASSERT_TRUE(wait_for_response("client-1", "req-util-1").has_value());
+
+	write_request(make_request_json("req-util-2", "client-1", "metrics"));
+	auto response = wait_for_response("client-1", "req-util-2");
+	ASSERT_TRUE(response.has_value());
+
+	auto& workers = (*response)["data"]["workers"];
+	ASSERT_EQ(workers.size(), 3u);
+
+	uint64_t handled = 0;
+	for (const auto& worker : workers)
+	{
+		handled += worker["requests"].get<uint64_t>();
+		EXPECT_GE(worker["utilization"].get<double>(), 0.0);
+		EXPECT_LE(worker["utilization"].get<double>(), 1.0);
+	}
+	EXPECT_GE(handled, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// Long-poll ConsumeNext
+// ---------------------------------------------------------------------------
+
+TEST_F(MailboxHandlerTest, LongPollWakesOnPublish)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	json payload;
+	payload["queue"] = "poll-q";
+	payload["consumerId"] = "worker-01";
+	payload["waitMs"] = 5000;
+	write_request(make_request_json("req-poll-1", "client-c", "consume_next", payload));
+
+	// Parked: no response while the queue is empty
+	EXPECT_FALSE(wait_for_response("client-c", "req-poll-1", 400).has_value());
+
+	MessageEnvelope msg;
+	msg.message_id = "msg-poll";
+	msg.key = "msg:poll-q:msg-poll";
+	msg.queue = "poll-q";
+	msg.payload_json = R"({"v":1})";
+
+	LeaseToken lease;
+	lease.lease_id = "lease-poll";
+	lease.message_key = msg.key;
+	lease.consumer_id = "worker-01";
+	mock_backend_->set_next_lease_result({ true, msg, lease, std::nullopt });
+
+	json publish;
+	publish["queue"] = "poll-q";
+	publish["message"] = R"({"v":1})";
+	auto published_at = std::chrono::steady_clock::now();
+	write_request(make_request_json("req-poll-pub", "client-p", "publish", publish));
+
+	auto response = wait_for_response("client-c", "req-poll-1", 2000);
+	ASSERT_TRUE(response.has_value()) << "parked consumer was not woken by the publish";
+	EXPECT_LT(std::chrono::steady_clock::now() - published_at, std::chrono::milliseconds(2000));
+	EXPECT_EQ((*response)["data"]["message"]["messageId"], "msg-poll");
+}
+
+TEST_F(MailboxHandlerTest, LongPollTimesOutEmpty)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	json payload;
+	payload["queue"] = "idle-q";
+	payload["waitMs"] = 300;
+
+	auto started = std::chrono::steady_clock::now();
+	write_request(make_request_json("req-idle-1", "client-1", "consume_next", payload));
+
+	auto response = wait_for_response("client-1", "req-idle-1", 3000);
+	ASSERT_TRUE(response.has_value());
+	EXPECT_GE(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(300));
+	EXPECT_TRUE((*response)["ok"].get<bool>());
+	EXPECT_TRUE((*response)["data"]["message"].is_null());
+}
+
+TEST_F(MailboxHandlerTest, LongPollIgnoresOtherQueues)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	// Slow leases keep poll-a's lease attempt in flight while poll-b is being published to
+	mock_backend_->lease_delay_ms.store(50);
+
+	json payload;
+	payload["queue"] = "poll-a";
+	payload["waitMs"] = 5000;
+	write_request(make_request_json("req-poll-a", "client-a", "consume_next", payload));
+
+	for (int i = 0; i < 30; ++i)
+	{
+		json publish;
+		publish["queue"] = "poll-b";
+		publish["message"] = R"({"v":1})";
+		write_request(make_request_json(std::format("req-pub-b-{}", i), "client-b", "publish", publish));
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	ASSERT_TRUE(wait_for_response("client-b", "req-pub-b-29", 3000).has_value());
+
+	EXPECT_EQ(mock_backend_->lease_calls.load(), 1) << "publishes to poll-b re-dispatched the poll on poll-a";
+	EXPECT_FALSE(wait_for_response("client-a", "req-poll-a", 100).has_value());
+}
+
+TEST_F(MailboxHandlerTest, StopReleasesParkedConsumers)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	json payload;
+	payload["queue"] = "idle-q";
+	payload["waitMs"] = 10000;
+	write_request(make_request_json("req-stop-1", "client-1", "consume_next", payload));
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+	handler_->stop();
+
+	auto response = wait_for_response("client-1", "req-stop-1", 1000);
+	ASSERT_TRUE(response.has_value());
+	EXPECT_TRUE((*response)["data"]["message"].is_null());
+}
+
+// ---------------------------------------------------------------------------
+// Shared-memory transport
+// ---------------------------------------------------------------------------
+
+TEST_F(MailboxHandlerTest, SharedMemoryRoundTrip)
+{
+	config_.shm.enabled = true;
+	config_.shm.name_prefix = std::format("yirangmq-test-{}", ::getpid());
+	config_.shm.ring_bytes = 64 * 1024;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	auto [channel, channel_error] = Utilities::SharedMemoryChannel::create(
+		ShmTransport::channel_name(config_.shm.name_prefix, "shm-client"), config_.shm.ring_bytes);
+	ASSERT_NE(channel, nullptr) << channel_error.value_or("");
+	auto [doorbell, doorbell_error] = Utilities::SharedMemoryDoorbell::attach(ShmTransport::doorbell_name(config_.shm.name_prefix));
+	ASSERT_NE(doorbell, nullptr) << doorbell_error.value_or("");
+	std::ofstream(std::format("{}/{}/shm-client.ring", config_.root, config_.shm.dir)).close();
+
+	auto round_trip = [&](const json& request) -> std::optional<json>
+	{
+		if (!std::get<0>(channel->push(Utilities::SharedMemoryDirection::Request, request.dump())))
+		{
+			return std::nullopt;
+		}
+		doorbell->ring();
+
+		if (!channel->wait(Utilities::SharedMemoryDirection::Response, 3000000))
+		{
+			return std::nullopt;
+		}
+		return json::parse(channel->pop(Utilities::SharedMemoryDirection::Response).value());
+	};
+
+	json publish;
+	publish["queue"] = "shm-q";
+	publish["message"] = R"({"v":1})";
+	auto published = round_trip(make_request_json("req-shm-pub", "ignored", "publish", publish));
+	ASSERT_TRUE(published.has_value());
+	EXPECT_TRUE((*published)["ok"].get<bool>());
+	EXPECT_EQ((*published)["requestId"], "req-shm-pub");
+	ASSERT_EQ(mock_backend_->get_enqueue_calls().size(), 1u);
+
+	// No files are involved: the response went over the ring only
+	EXPECT_FALSE(fs::exists(std::format("{}/{}/shm-client/req-shm-pub.json", config_.root, config_.responses_dir)));
+
+	std::vector<int64_t> latencies_us;
+	for (int i = 0; i < 200; ++i)
+	{
+		auto started = std::chrono::steady_clock::now();
+		auto response = round_trip(make_request_json(std::format("req-shm-{}", i), "shm-client", "health"));
+		ASSERT_TRUE(response.has_value());
+		ASSERT_EQ((*response)["requestId"], std::format("req-shm-{}", i));
+		latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+	}
+
+	std::sort(latencies_us.begin(), latencies_us.end());
+	EXPECT_LT(latencies_us[latencies_us.size() / 2], 5000) << "median shared-memory round trip";
+
+	auto malformed = round_trip(json("not a request"));
+	ASSERT_TRUE(malformed.has_value());
+	EXPECT_FALSE((*malformed)["ok"].get<bool>());
+}
+
+TEST_F(MailboxHandlerTest, SocketPipelinedRequests)
+{
+	config_.socket.enabled = true;
+	config_.socket.max_frame_bytes = 64 * 1024;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	ASSERT_GE(fd, 0);
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	auto path = std::format("{}/{}", config_.root, config_.socket.path);
+	std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", path.c_str());
+	ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+
+	timeval timeout{ 3, 0 };
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	auto read_frame = [&]() -> std::optional<json>
+	{
+		auto read_exact = [&](char* target, size_t bytes) -> bool
+		{
+			size_t received = 0;
+			while (received < bytes)
+			{
+				auto n = ::recv(fd, target + received, bytes - received, 0);
+				if (n <= 0)
+				{
+					return false;
+				}
+				received += static_cast<size_t>(n);
+			}
+			return true;
+		};
+
+		unsigned char header[4];
+		if (!read_exact(reinterpret_cast<char*>(header), sizeof(header)))
+		{
+			return std::nullopt;
+		}
+		uint32_t length = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | uint32_t(header[3]);
+		std::string body(length, '\0');
+		if (!read_exact(body.data(), length))
+		{
+			return std::nullopt;
+		}
+		return json::parse(body);
+	};
+
+	// All requests go out in one write before any response is read
+	constexpr int request_count = 100;
+	std::string batch;
+	for (int i = 0; i < request_count; ++i)
+	{
+		json payload;
+		payload["queue"] = std::format("sock-q-{}", i % 4);
+		payload["message"] = std::format(R"({{"seq":{}}})", i);
+		batch += SocketTransport::encode_frame(make_request_json(std::format("req-sock-{}", i), std::format("sock-client-{}", i % 8), "publish", payload).dump());
+	}
+	ASSERT_EQ(::send(fd, batch.data(), batch.size(), 0), static_cast<ssize_t>(batch.size()));
+
+	std::set<std::string> answered;
+	for (int i = 0; i < request_count; ++i)
+	{
+		auto response = read_frame();
+		ASSERT_TRUE(response.has_value()) << "response " << i;
+		EXPECT_TRUE((*response)["ok"].get<bool>());
+		answered.insert((*response)["requestId"].get<std::string>());
+	}
+	EXPECT_EQ(answered.size(), static_cast<size_t>(request_count));
+	EXPECT_EQ(mock_backend_->get_enqueue_calls().size(), static_cast<size_t>(request_count));
+
+	// Publishes to one queue keep their order even when pipelined
+	std::map<std::string, int> last_seq;
+	for (const auto& call : mock_backend_->get_enqueue_calls())
+	{
+		auto seq = json::parse(call.envelope.payload_json)["seq"].get<int>();
+		auto& last = last_seq.try_emplace(call.envelope.queue, -1).first->second;
+		EXPECT_GT(seq, last);
+		last = seq;
+	}
+	EXPECT_FALSE(fs::exists(std::format("{}/{}/sock-client-0/req-sock-0.json", config_.root, config_.responses_dir)));
+
+	// An oversized frame drops the connection
+	auto oversized = SocketTransport::encode_frame(std::string(config_.socket.max_frame_bytes + 1, 'x'));
+	::send(fd, oversized.data(), oversized.size(), MSG_NOSIGNAL);
+	EXPECT_FALSE(read_frame().has_value());
+
+	::close(fd);
+}
+
+TEST_F(MailboxHandlerTest, SocketStopsReadingUnreadClient)
+{
+	config_.socket.enabled = true;
+	config_.socket.max_output_bytes = 16 * 1024;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	auto path = std::format("{}/{}", config_.root, config_.socket.path);
+	std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", path.c_str());
+
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+
+	// Pipeline far more requests than the reply cap allows and never read a response
+	auto frame = SocketTransport::encode_frame(make_request_json("req-unread", "sock-unread", "health").dump());
+	std::string stream;
+	for (int i = 0; i < 40000; ++i)
+	{
+		stream += frame;
+	}
+
+	size_t sent = 0;
+	auto stalled_since = std::chrono::steady_clock::now();
+	while (sent < stream.size() && std::chrono::steady_clock::now() - stalled_since < std::chrono::milliseconds(500))
+	{
+		auto n = ::send(fd, stream.data() + sent, stream.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (n > 0)
+		{
+			sent += static_cast<size_t>(n);
+			stalled_since = std::chrono::steady_clock::now();
+			continue;
+		}
+		if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		{
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	EXPECT_LT(sent, stream.size()) << "the server kept reading while its replies piled up";
+	::close(fd);
+
+	// Other connections are unaffected
+	int other = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	ASSERT_GE(other, 0);
+	ASSERT_EQ(::connect(other, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+	timeval timeout{ 3, 0 };
+	::setsockopt(other, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	auto health = SocketTransport::encode_frame(make_request_json("req-after", "sock-after", "health").dump());
+	ASSERT_EQ(::send(other, health.data(), health.size(), 0), static_cast<ssize_t>(health.size()));
+	char header[4];
+	EXPECT_EQ(::recv(other, header, sizeof(header), MSG_WAITALL), 4);
+	::close(other);
+}
+
+TEST_F(MailboxHandlerTest, JournalAppendsAreTailedAndRolled)
+{
+	config_.journal.enabled = true;
+	config_.journal.roll_bytes = 0;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	auto request_journal = std::format("{}/{}/journal-client.log", config_.root, config_.requests_dir);
+	auto response_journal = std::format("{}/{}/journal-client.log", config_.root, config_.responses_dir);
+	auto offset_file = std::format("{}/{}/journal-client.offset", config_.root, config_.processing_dir);
+
+	auto append_publish = [&](int seq)
+	{
+		json payload;
+		payload["queue"] = "journal-q";
+		payload["message"] = std::format(R"({{"seq":{}}})", seq);
+		// The channel names the client, whatever the document says
+		auto [appended, error] = JournalTransport::append(request_journal, make_request_json(std::format("req-jr-{}", seq), "other", "publish", payload).dump());
+		ASSERT_TRUE(appended) << error.value_or("");
+	};
+
+	auto read_responses = [&](size_t expected) -> std::vector<json>
+	{
+		std::vector<json> responses;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (std::chrono::steady_clock::now() < deadline)
+		{
+			responses.clear();
+			std::ifstream file(response_journal, std::ios::binary);
+			std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			for (size_t offset = 0; offset + 4 <= content.size();)
+			{
+				auto bytes = reinterpret_cast<const unsigned char*>(content.data() + offset);
+				uint32_t length = (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | uint32_t(bytes[3]);
+				if (offset + 4 + length > content.size())
+				{
+					break;
+				}
+				responses.push_back(json::parse(content.substr(offset + 4, length)));
+				offset += 4 + length;
+			}
+			if (responses.size() >= expected)
+			{
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return responses;
+	};
+
+	auto wait_for_roll = [&]() -> bool
+	{
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+		while (std::chrono::steady_clock::now() < deadline)
+		{
+			std::error_code ec;
+			if (fs::file_size(request_journal, ec) == 0 && !ec)
+			{
+				return true;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return false;
+	};
+
+	// Appended before start: picked up by the transport's first scan
+	fs::create_directories(fs::path(request_journal).parent_path());
+	for (int i = 0; i < 3; ++i)
+	{
+		append_publish(i);
+	}
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	constexpr int request_count = 50;
+	for (int i = 3; i < request_count; ++i)
+	{
+		append_publish(i);
+	}
+
+	auto responses = read_responses(request_count);
+	ASSERT_EQ(responses.size(), static_cast<size_t>(request_count));
+	std::set<std::string> answered;
+	for (const auto& response : responses)
+	{
+		EXPECT_TRUE(response["ok"].get<bool>());
+		answered.insert(response["requestId"].get<std::string>());
+	}
+	EXPECT_EQ(answered.size(), static_cast<size_t>(request_count));
+	ASSERT_EQ(mock_backend_->get_enqueue_calls().size(), static_cast<size_t>(request_count));
+	for (int i = 0; i < request_count; ++i)
+	{
+		EXPECT_EQ(json::parse(mock_backend_->get_enqueue_calls()[i].envelope.payload_json)["seq"].get<int>(), i);
+	}
+
+	// Answered in full, so the journal is truncated and its offset reset; no per-request files were made
+	EXPECT_TRUE(wait_for_roll());
+	std::ifstream offset_stream(offset_file);
+	uint64_t offset = 1;
+	offset_stream >> offset;
+	EXPECT_EQ(offset, 0u);
+	EXPECT_FALSE(fs::exists(std::format("{}/{}/journal-client", config_.root, config_.responses_dir)));
+	EXPECT_FALSE(fs::exists(std::format("{}/{}/other", config_.root, config_.responses_dir)));
+
+	// Appends while the daemon is down resume from the persisted offset
+	handler_->stop();
+	fs::remove(response_journal);
+	append_publish(request_count);
+
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+	std::tie(ok, err) = handler_->start();
+	ASSERT_TRUE(ok);
+
+	auto resumed = read_responses(1);
+	ASSERT_EQ(resumed.size(), 1u);
+	EXPECT_EQ(resumed[0]["requestId"], std::format("req-jr-{}", request_count));
+	EXPECT_EQ(mock_backend_->get_enqueue_calls().size(), static_cast<size_t>(request_count + 1));
+}
+
+// ---------------------------------------------------------------------------
+// Priority lanes
+// ---------------------------------------------------------------------------
+
+TEST_F(MailboxHandlerTest, SettleOvertakesPublishFlood)
+{
+	config_.dispatch_workers = 1;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	// Hold the only worker while the flood and the ack queue up behind it
+	mock_backend_->lease_delay_ms.store(400);
+	json consume;
+	consume["queue"] = "busy-q";
+	write_request(make_request_json("req-hold", "client-hold", "consume_next", consume));
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	constexpr int publish_count = 40;
+	for (int i = 0; i < publish_count; ++i)
+	{
+		json payload;
+		payload["queue"] = std::format("flood-q-{}", i);
+		payload["message"] = R"({"flood":true})";
+		write_request(make_request_json(std::format("req-flood-{}", i), "client-flood", "publish", payload));
+	}
+
+	json ack;
+	ack["leaseId"] = "lease-settle";
+	ack["messageKey"] = "msg:busy-q:settle";
+	write_request(make_request_json("req-settle", "client-settle", "ack", ack));
+
+	ASSERT_TRUE(wait_for_response("client-settle", "req-settle").has_value());
+	ASSERT_TRUE(wait_for_response("client-flood", std::format("req-flood-{}", publish_count - 1)).has_value());
+
+	auto acks = mock_backend_->get_ack_calls();
+	ASSERT_EQ(acks.size(), 1u);
+	auto enqueues = mock_backend_->get_enqueue_calls();
+	ASSERT_EQ(enqueues.size(), static_cast<size_t>(publish_count));
+
+	// Arrived last, yet settled ahead of nearly all of the flood
+	auto overtaken = std::count_if(enqueues.begin(), enqueues.end(), [&](const auto& call) { return call.sequence > acks[0].sequence; });
+	EXPECT_GE(overtaken, publish_count - 5);
+
+	write_request(make_request_json("req-lane-metrics", "client-settle", "metrics"));
+	auto metrics = wait_for_response("client-settle", "req-lane-metrics");
+	ASSERT_TRUE(metrics.has_value());
+	auto& lanes = (*metrics)["data"]["lanes"];
+	EXPECT_EQ(lanes["publish"]["dispatched"], publish_count);
+	EXPECT_GE(lanes["settle"]["dispatched"], 1);
+	EXPECT_LT(lanes["settle"]["maxWaitMs"].get<double>(), lanes["publish"]["maxWaitMs"].get<double>());
+}
+
+// ---------------------------------------------------------------------------
+// Admission control
+// ---------------------------------------------------------------------------
+
+TEST_F(MailboxHandlerTest, PublishOverQueueLimitGetsBackpressure)
+{
+	config_.admission.retry_after_ms = 750;
+	config_.admission.queue_limits["capped-q"] = { 2, 0 };
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	// One message already waiting when the handler first sees the queue
+	mock_backend_->configured_metrics.ready = 1;
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	// The mock's metrics never change, so let the startup resync pass before the counters are seeded
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	auto publish = [&](const std::string& request_id, const std::string& queue) -> std::optional<json>
+	{
+		json payload;
+		payload["queue"] = queue;
+		payload["message"] = R"({"n":1})";
+		write_request(make_request_json(request_id, "client-1", "publish", payload));
+		return wait_for_response("client-1", request_id);
+	};
+
+	auto admitted = publish("req-cap-1", "capped-q");
+	ASSERT_TRUE(admitted.has_value());
+	EXPECT_TRUE((*admitted)["ok"].get<bool>());
+
+	auto rejected = publish("req-cap-2", "capped-q");
+	ASSERT_TRUE(rejected.has_value());
+	EXPECT_FALSE((*rejected)["ok"].get<bool>());
+	EXPECT_EQ((*rejected)["error"]["code"], "ERR_BACKPRESSURE");
+	EXPECT_EQ((*rejected)["error"]["retryAfterMs"], 750);
+
+	auto other = publish("req-cap-other", "free-q");
+	ASSERT_TRUE(other.has_value());
+	EXPECT_TRUE((*other)["ok"].get<bool>());
+
+	// A lease takes a message out of the ready depth and makes room again
+	MessageEnvelope msg;
+	msg.message_id = "m1";
+	msg.key = "msg:capped-q:m1";
+	msg.queue = "capped-q";
+	LeaseToken lease;
+	lease.lease_id = "lease-cap";
+	lease.message_key = msg.key;
+	mock_backend_->set_next_lease_result({ true, msg, lease, std::nullopt });
+
+	json consume;
+	consume["queue"] = "capped-q";
+	write_request(make_request_json("req-cap-consume", "client-1", "consume_next", consume));
+	ASSERT_TRUE(wait_for_response("client-1", "req-cap-consume").has_value());
+
+	auto retried = publish("req-cap-3", "capped-q");
+	ASSERT_TRUE(retried.has_value());
+	EXPECT_TRUE((*retried)["ok"].get<bool>());
+	EXPECT_EQ(mock_backend_->get_enqueue_calls().size(), 3u);
+
+	write_request(make_request_json("req-cap-metrics", "client-1", "metrics"));
+	auto metrics = wait_for_response("client-1", "req-cap-metrics");
+	ASSERT_TRUE(metrics.has_value());
+	EXPECT_EQ((*metrics)["data"]["errors"]["backpressure"], 1);
+	EXPECT_EQ((*metrics)["data"]["admission"]["queues"]["capped-q"]["ready"], 2);
+	EXPECT_FALSE((*metrics)["data"]["admission"]["queues"].contains("free-q"));
+}
+
+TEST_F(MailboxHandlerTest, PendingHighWaterShedsPublishes)
+{
+	config_.dispatch_workers = 1;
+	config_.admission.max_pending_requests = 5;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	// Hold the only worker so everything after it queues up
+	mock_backend_->lease_delay_ms.store(600);
+	json consume;
+	consume["queue"] = "busy-q";
+	write_request(make_request_json("req-hold", "client-hold", "consume_next", consume));
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	constexpr int publish_count = 10;
+	for (int i = 0; i < publish_count; ++i)
+	{
+		json payload;
+		payload["queue"] = std::format("shed-q-{}", i);
+		payload["message"] = R"({"n":1})";
+		write_request(make_request_json(std::format("req-shed-{}", i), "client-flood", "publish", payload));
+	}
+
+	json ack;
+	ack["leaseId"] = "lease-settle";
+	ack["messageKey"] = "msg:busy-q:settle";
+	write_request(make_request_json("req-shed-ack", "client-settle", "ack", ack));
+
+	// An admin entry moves a batch to the Admin lane, but its publish is still shed
+	json mixed = make_request_json("req-shed-mixed", "client-mixed", "batch");
+	mixed["commands"] = json::array();
+	mixed["commands"].push_back({ { "command", "publish" }, { "payload", { { "queue", "shed-q-mixed" }, { "message", R"({"n":1})" } } } });
+	mixed["commands"].push_back({ { "command", "status" }, { "payload", json::object() } });
+	write_request(mixed);
+
+	int shed = 0;
+	for (int i = 0; i < publish_count; ++i)
+	{
+		auto response = wait_for_response("client-flood", std::format("req-shed-{}", i));
+		ASSERT_TRUE(response.has_value());
+		if (!(*response)["ok"].get<bool>())
+		{
+			EXPECT_EQ((*response)["error"]["code"], "ERR_BACKPRESSURE");
+			EXPECT_GT((*response)["error"]["retryAfterMs"].get<int64_t>(), 0);
+			++shed;
+		}
+	}
+
+	// Settles are never shed, even past the mark
+	auto settled = wait_for_response("client-settle", "req-shed-ack");
+	ASSERT_TRUE(settled.has_value());
+	EXPECT_TRUE((*settled)["ok"].get<bool>());
+
+	auto mixed_response = wait_for_response("client-mixed", "req-shed-mixed");
+	ASSERT_TRUE(mixed_response.has_value());
+	EXPECT_EQ((*mixed_response)["error"]["code"], "ERR_BACKPRESSURE");
+
+	EXPECT_EQ(shed, publish_count - 5);
+	EXPECT_EQ(mock_backend_->get_enqueue_calls().size(), 5u);
+}
+
+// ---------------------------------------------------------------------------
+// Response rendering
+// ---------------------------------------------------------------------------
+
+TEST_F(MailboxHandlerTest, ResponsesAreCompactUnlessPretty)
+{
+	auto read_raw = [&](const std::string& request_id) -> std::string
+	{
+		if (!wait_for_response("client-1", request_id).has_value())
+		{
+			return "";
+		}
+		std::ifstream file(std::format("{}/{}/client-1/{}.json", config_.root, config_.responses_dir, request_id));
+		return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	};
+
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	json payload;
+	payload["queue"] = "render-q";
+	write_request(make_request_json("req-render-1", "client-1", "status", payload));
+	auto compact = read_raw("req-render-1");
+	ASSERT_FALSE(compact.empty());
+	EXPECT_EQ(compact.find('\n'), std::string::npos);
+
+	auto parsed = json::parse(compact);
+	EXPECT_EQ(parsed["requestId"], "req-render-1");
+	EXPECT_TRUE(parsed["ok"].get<bool>());
+	EXPECT_TRUE(parsed["data"].is_object());
+
+	write_request(make_request_json("req-render-2", "client-1", "status"));
+	auto error = json::parse(read_raw("req-render-2"));
+	EXPECT_FALSE(error["ok"].get<bool>());
+	EXPECT_EQ(error["error"]["code"], "ERR_INVALID_REQUEST");
+
+	handler_->stop();
+	config_.pretty_responses = true;
+	handler_ = std::make_unique<MailboxHandler>(mock_backend_, queue_manager_, config_);
+	std::tie(ok, err) = handler_->start();
+	ASSERT_TRUE(ok);
+
+	write_request(make_request_json("req-render-3", "client-1", "status", payload));
+	auto pretty = read_raw("req-render-3");
+	EXPECT_NE(pretty.find("\n  "), std::string::npos);
+	EXPECT_EQ(json::parse(pretty)["data"], parsed["data"]);
+}
+
+// ---------------------------------------------------------------------------
+// Multi-command requests
+// ---------------------------------------------------------------------------
+
+TEST_F(MailboxHandlerTest, BatchRunsCommandsInOrder)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	json request;
+	request["requestId"] = "req-batch-1";
+	request["clientId"] = "client-1";
+	request["timestampMs"] = now_ms();
+	request["commands"] = json::array();
+	for (int i = 0; i < 3; ++i)
+	{
+		request["commands"].push_back({ { "command", "ack" }, { "payload", {
+			{ "leaseId", std::format("lease-{}", i) }, { "messageKey", std::format("msg:batch-q:{}", i) }, { "consumerId", "worker-01" } } } });
+	}
+	request["commands"].push_back({ { "command", "publish" }, { "payload", { { "queue", "batch-q" }, { "message", R"({"n":1})" } } } });
+	request["commands"].push_back({ { "command", "publish" }, { "payload", { { "message", R"({"n":2})" } } } });
+	request["commands"].push_back({ { "command", "consume_next" }, { "payload", { { "queue", "batch-q" }, { "waitMs", 5000 } } } });
+	request["commands"].push_back({ { "command", "bogus" } });
+	write_request(request);
+
+	auto response = wait_for_response("client-1", "req-batch-1");
+	ASSERT_TRUE(response.has_value());
+	EXPECT_TRUE((*response)["ok"].get<bool>());
+	EXPECT_EQ((*response)["data"]["count"], 7);
+	EXPECT_EQ((*response)["data"]["failed"], 2);
+
+	auto& results = (*response)["results"];
+	ASSERT_EQ(results.size(), 7u);
+	for (int i = 0; i < 4; ++i)
+	{
+		EXPECT_TRUE(results[i]["ok"].get<bool>()) << "result " << i;
+	}
+	EXPECT_EQ(results[4]["error"]["code"], "ERR_INVALID_REQUEST");
+	// A long-poll inside a batch answers right away instead of parking the whole batch
+	EXPECT_TRUE(results[5]["ok"].get<bool>());
+	EXPECT_TRUE(results[5]["data"]["message"].is_null());
+	EXPECT_EQ(results[6]["error"]["code"], "ERR_UNKNOWN_COMMAND");
+
+	auto acks = mock_backend_->get_ack_calls();
+	ASSERT_EQ(acks.size(), 3u);
+	for (int i = 0; i < 3; ++i)
+	{
+		EXPECT_EQ(acks[i].lease.lease_id, std::format("lease-{}", i));
+	}
+	EXPECT_EQ(mock_backend_->get_enqueue_calls().size(), 1u);
+
+	// One request file in, one response file out
+	EXPECT_TRUE(fs::is_empty(config_.root + "/" + config_.processing_dir));
+
+	// Each command is counted once, and the envelope is not counted again as a success
+	write_request(make_request_json("req-batch-metrics", "client-1", "metrics"));
+	auto metrics = wait_for_response("client-1", "req-batch-metrics");
+	ASSERT_TRUE(metrics.has_value());
+	auto& requests = (*metrics)["data"]["requests"];
+	EXPECT_EQ(requests["total"], 7) << requests.dump();
+	EXPECT_EQ(requests["success"], 5) << requests.dump();
+	EXPECT_EQ(requests["error"], 2) << requests.dump();
+	EXPECT_EQ((*metrics)["data"]["commands"]["batch"], 1);
+}
+
+TEST_F(MailboxHandlerTest, InvalidBatchGoesToDead)
+{
+	auto [ok, err] = handler_->start();
+	ASSERT_TRUE(ok);
+
+	json empty_batch = make_request_json("req-batch-empty", "client-1", "batch");
+	empty_batch["commands"] = json::array();
+	write_request(empty_batch);
+
+	json nested = make_request_json("req-batch-mixed", "client-1", "publish");
+	nested["commands"] = json::array({ { { "command", "health" } } });
+	write_request(nested);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+	EXPECT_TRUE(fs::exists(config_.root + "/dead/req-batch-empty.json"));
+	EXPECT_TRUE(fs::exists(config_.root + "/dead/req-batch-mixed.json"));
+}
+
 // ---------------------------------------------------------------------------
 // Publish with delay
 // ---------------------------------------------------------------------------
@@ -0,0 +1,389 @@
+#include "TestHelpers.h"
+#include "PayloadCodec.h"
+#include "ByteOrder.h"
+#include "Converter.h"
+#include <gtest/gtest.h>
+#include <format>
+#include <map>
+#include <thread>
+#include <vector>
+
+static auto make_telemetry(size_t count) -> std::string
+{
+	std::string payload = "[";
+	for (size_t i = 0; i < count; ++i)
+	{
+		payload += std::format(R"({{"deviceId":"sensor-{}","temp":36.5,"humidity":40}},)", i % 8);
+	}
+	payload.back() = ']';
+	return payload;
+}
+
+static auto enabled_policy(const uint32_t& min_bytes = 64) -> CompressionPolicy
+{
+	CompressionPolicy policy;
+	policy.enabled = true;
+	policy.min_bytes = min_bytes;
+	return policy;
+}
+
+// ---------------------------------------------------------------------------
+// RoundTrip: compressible payloads shrink and decode to the original
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, RoundTrip)
+{
+	PayloadCodec codec;
+	codec.configure(enabled_policy(), {});
+
+	auto payload = make_telemetry(50);
+	auto stored = codec.encode("telemetry", payload);
+
+	EXPECT_TRUE(PayloadCodec::is_compressed(stored));
+	EXPECT_LT(stored.size(), payload.size());
+
+	// Frame integers are little-endian whatever the host
+	EXPECT_EQ(stored.substr(4, 4), std::string("\x00\x00\x01\x00", 4)) << "block size 65536";
+	EXPECT_EQ(static_cast<uint8_t>(stored[8]) | static_cast<uint8_t>(stored[9]) << 8, static_cast<int>(payload.size()));
+
+	auto [decoded, error] = codec.decode("telemetry", stored);
+	ASSERT_TRUE(decoded.has_value()) << error.value_or("unknown");
+	EXPECT_EQ(decoded.value(), payload);
+
+	QueueMetrics metrics;
+	codec.apply_metrics("telemetry", metrics);
+	EXPECT_EQ(metrics.compressed_messages, 1u);
+	EXPECT_EQ(metrics.compression_original_bytes, payload.size());
+	EXPECT_EQ(metrics.compression_stored_bytes, stored.size());
+}
+
+// ---------------------------------------------------------------------------
+// PerQueuePolicy: threshold and per-queue overrides decide what is compressed
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, PerQueuePolicy)
+{
+	PayloadCodec codec;
+	codec.configure(CompressionPolicy{}, { { "telemetry", enabled_policy(1024) } });
+
+	auto payload = make_telemetry(50);
+	EXPECT_EQ(codec.encode("orders", payload), payload) << "compression is off by default";
+	EXPECT_EQ(codec.encode("telemetry", R"({"small":true})"), R"({"small":true})") << "below threshold";
+	EXPECT_TRUE(PayloadCodec::is_compressed(codec.encode("telemetry", payload)));
+
+	auto [plain, plain_error] = codec.decode("telemetry", R"({"legacy":1})");
+	EXPECT_EQ(plain.value_or(""), R"({"legacy":1})");
+}
+
+// ---------------------------------------------------------------------------
+// ConcurrentStatistics: counters from many encoding threads and queues add up exactly
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, ConcurrentStatistics)
+{
+	PayloadCodec codec;
+	codec.configure(enabled_policy(), {});
+
+	auto payload = make_telemetry(50);
+	auto stored_size = codec.encode("warmup", payload).size();
+
+	constexpr int thread_count = 8;
+	constexpr int iterations = 200;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([&codec, &payload, t]()
+		{
+			auto queue = std::format("concurrent-{}", t % 2);
+			for (int i = 0; i < iterations; ++i)
+			{
+				auto [decoded, error] = codec.decode(queue, codec.encode(queue, payload));
+				EXPECT_EQ(decoded.value_or(""), payload);
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	for (const auto* queue : { "concurrent-0", "concurrent-1" })
+	{
+		QueueMetrics metrics;
+		codec.apply_metrics(queue, metrics);
+		EXPECT_EQ(metrics.compressed_messages, static_cast<uint64_t>(thread_count / 2 * iterations)) << queue;
+		EXPECT_EQ(metrics.compression_original_bytes, payload.size() * thread_count / 2 * iterations) << queue;
+		EXPECT_EQ(metrics.compression_stored_bytes, stored_size * thread_count / 2 * iterations) << queue;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// LargeBlocks: payloads larger than 64KB use the wide block size
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, LargeBlocks)
+{
+	auto policy = enabled_policy();
+	policy.block_bytes = 256 * 1024;
+
+	PayloadCodec codec;
+	codec.configure(policy, {});
+
+	auto payload = make_telemetry(5000);
+	ASSERT_GT(payload.size(), 65536u);
+
+	auto stored = codec.encode("telemetry", payload);
+	ASSERT_TRUE(PayloadCodec::is_compressed(stored));
+
+	// Decoding uses the block size recorded in the frame, not the current policy
+	codec.configure(enabled_policy(), {});
+	auto [decoded, error] = codec.decode("telemetry", stored);
+	ASSERT_TRUE(decoded.has_value()) << error.value_or("unknown");
+	EXPECT_EQ(decoded.value(), payload);
+}
+
+// ---------------------------------------------------------------------------
+// JsonField: text containers carry base64 with an encoding flag
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, JsonField)
+{
+	PayloadCodec codec;
+	codec.configure(enabled_policy(), {});
+
+	auto payload = make_telemetry(50);
+	nlohmann::json envelope;
+	codec.encode_field("telemetry", payload, envelope, "payload");
+
+	EXPECT_EQ(envelope.value("payloadEncoding", ""), "lz4");
+	EXPECT_NE(envelope.value("payload", ""), payload);
+	EXPECT_EQ(std::get<0>(codec.decode_field("telemetry", envelope, "payload", "{}")).value_or(""), payload);
+
+	nlohmann::json legacy = { { "payload", R"({"a":1})" } };
+	EXPECT_EQ(std::get<0>(codec.decode_field("telemetry", legacy, "payload", "{}")).value_or(""), R"({"a":1})");
+}
+
+// ---------------------------------------------------------------------------
+// CorruptFrame: damaged frames fail loudly instead of decoding to a fallback
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, CorruptFrame)
+{
+	PayloadCodec codec;
+	codec.configure(enabled_policy(), {});
+
+	auto stored = codec.encode("telemetry", make_telemetry(50));
+	ASSERT_TRUE(PayloadCodec::is_compressed(stored));
+
+	auto oversized = stored.substr(0, 4);
+	Utilities::ByteOrder::append_little_endian(oversized, CompressionPolicy::max_block_bytes + 1);
+	oversized.append(stored, 8);
+	auto [too_large, too_large_error] = codec.decode("telemetry", oversized);
+	EXPECT_FALSE(too_large.has_value());
+	EXPECT_TRUE(too_large_error.has_value());
+
+	nlohmann::json envelope;
+	codec.encode_field("telemetry", make_telemetry(50), envelope, "payload");
+	envelope["payload"] = Utilities::Converter::to_base64(std::vector<uint8_t>(stored.begin(), stored.begin() + 16));
+	auto [truncated, truncated_error] = codec.decode_field("telemetry", envelope, "payload", "{}");
+	EXPECT_FALSE(truncated.has_value());
+	EXPECT_TRUE(truncated_error.has_value());
+}
+
+// ---------------------------------------------------------------------------
+// TornBlocks: a frame missing or damaging any block fails instead of decoding to a shorter payload
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, TornBlocks)
+{
+	auto policy = enabled_policy();
+	policy.block_bytes = 1024;
+
+	PayloadCodec codec;
+	codec.configure(policy, {});
+
+	auto stored = codec.encode("telemetry", make_telemetry(200));
+	ASSERT_TRUE(PayloadCodec::is_compressed(stored));
+
+	// Blocks follow the 12-byte frame prefix as [original size][compressed size][LZ4 block]
+	std::vector<size_t> block_offsets;
+	for (size_t offset = 12; offset < stored.size();)
+	{
+		block_offsets.push_back(offset);
+		uint32_t compressed_size = 0;
+		auto size_offset = offset + 4;
+		Utilities::ByteOrder::read_little_endian(stored, size_offset, compressed_size);
+		offset += 8 + compressed_size;
+	}
+	ASSERT_GT(block_offsets.size(), 2u);
+
+	auto expect_failure = [&codec](const std::string& frame, const std::string& label)
+	{
+		auto [decoded, error] = codec.decode("telemetry", frame);
+		EXPECT_FALSE(decoded.has_value()) << label << " decoded to " << decoded.value_or("").size() << " bytes";
+		EXPECT_TRUE(error.has_value()) << label;
+	};
+
+	expect_failure(stored.substr(0, block_offsets.back()), "last block dropped");
+	expect_failure(stored.substr(0, stored.size() - 3), "last block cut short");
+	expect_failure(stored.substr(0, block_offsets.back() + 5), "last block header cut short");
+	expect_failure(stored + std::string(3, '\0'), "trailing bytes");
+
+	auto corrupt = stored;
+	auto last = block_offsets.back() + 8;
+	for (size_t index = last; index < corrupt.size(); ++index)
+	{
+		corrupt[index] = static_cast<char>(0xff);
+	}
+	expect_failure(corrupt, "last block corrupted");
+}
+
+static auto make_reading(size_t index) -> std::string
+{
+	return std::format(
+		R"({{"deviceId":"sensor-{:04}","site":"plant-north","type":"environment","temperature":{}.{},"humidity":{},"pressure":1013,"battery":{},"firmware":"2.4.1","ts":{}}})",
+		index % 50, 20 + index % 7, index % 10, 40 + index % 13, 90 - index % 11, 1700000000000 + index * 1000);
+}
+
+static auto dictionary_policy(const uint32_t& samples) -> CompressionPolicy
+{
+	auto policy = enabled_policy(32);
+	policy.dictionary = true;
+	policy.dictionary_samples = samples;
+	return policy;
+}
+
+// ---------------------------------------------------------------------------
+// DictionarySmallMessages: a trained dictionary shrinks messages stream LZ4 cannot
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, DictionarySmallMessages)
+{
+	PayloadCodec plain;
+	plain.configure(enabled_policy(32), {});
+
+	PayloadCodec trained;
+	trained.configure(dictionary_policy(64), {});
+
+	for (size_t i = 0; i < 64; ++i)
+	{
+		trained.encode("telemetry", make_reading(i));
+	}
+	ASSERT_EQ(trained.dictionary_version("telemetry"), 1u);
+
+	size_t plain_bytes = 0;
+	size_t trained_bytes = 0;
+	for (size_t i = 1000; i < 1100; ++i)
+	{
+		auto reading = make_reading(i);
+		plain_bytes += plain.encode("telemetry", reading).size();
+
+		auto stored = trained.encode("telemetry", reading);
+		ASSERT_TRUE(PayloadCodec::is_compressed(stored));
+		trained_bytes += stored.size();
+
+		auto [decoded, error] = trained.decode("telemetry", stored);
+		ASSERT_TRUE(decoded.has_value()) << error.value_or("unknown");
+		EXPECT_EQ(decoded.value(), reading);
+	}
+
+	EXPECT_LT(trained_bytes * 4, plain_bytes * 3) << "dictionary should cut small messages well below stream LZ4";
+
+	QueueMetrics metrics;
+	trained.apply_metrics("telemetry", metrics);
+	EXPECT_EQ(metrics.compression_dictionary_version, 1u);
+}
+
+// ---------------------------------------------------------------------------
+// DictionaryVersions: retrained dictionaries are persisted and old versions stay decodable
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, DictionaryVersions)
+{
+	TempDir temp_dir("codec_dict");
+	auto root = temp_dir.path() + "/dictionaries";
+
+	auto policy = dictionary_policy(16);
+	policy.dictionary_retrain_messages = 16;
+
+	std::vector<std::pair<std::string, std::string>> stored;
+	{
+		PayloadCodec codec;
+		auto [ok, error] = codec.configure(policy, {}, root);
+		ASSERT_TRUE(ok) << error.value_or("unknown");
+
+		for (size_t i = 0; i < 48; ++i)
+		{
+			auto reading = make_reading(i);
+			stored.emplace_back(reading, codec.encode("telemetry", reading));
+		}
+		EXPECT_EQ(codec.dictionary_version("telemetry"), 3u);
+	}
+
+	EXPECT_TRUE(std::filesystem::exists(root + "/telemetry/00000001.dict"));
+	EXPECT_TRUE(std::filesystem::exists(root + "/telemetry/00000003.dict"));
+
+	// A fresh codec with compression now disabled still decodes every version
+	PayloadCodec reopened;
+	ASSERT_TRUE(std::get<0>(reopened.configure(CompressionPolicy{}, {}, root)));
+	EXPECT_EQ(reopened.dictionary_version("telemetry"), 3u);
+
+	for (const auto& [original, encoded] : stored)
+	{
+		auto [decoded, error] = reopened.decode("telemetry", encoded);
+		ASSERT_TRUE(decoded.has_value()) << error.value_or("unknown");
+		EXPECT_EQ(decoded.value(), original);
+	}
+
+	PayloadCodec missing;
+	missing.configure(CompressionPolicy{}, {});
+	auto [lost, lost_error] = missing.decode("telemetry", stored.back().second);
+	EXPECT_FALSE(lost.has_value());
+	EXPECT_TRUE(lost_error.has_value());
+}
+
+// ---------------------------------------------------------------------------
+// DictionaryRetention: an audit drops the versions no stored payload reported, never the latest
+// ---------------------------------------------------------------------------
+TEST(PayloadCodecTest, DictionaryRetention)
+{
+	TempDir temp_dir("codec_retention");
+	auto root = temp_dir.path() + "/dictionaries";
+
+	auto policy = dictionary_policy(16);
+	policy.dictionary_retrain_messages = 16;
+
+	PayloadCodec codec;
+	ASSERT_TRUE(std::get<0>(codec.configure(policy, {}, root)));
+
+	std::map<uint32_t, std::string> frames;
+	for (size_t i = 0; i < 64; ++i)
+	{
+		auto stored = codec.encode("telemetry", make_reading(i));
+		size_t offset = 12;
+		uint32_t version = 0;
+		if (stored.starts_with("YMQD") && Utilities::ByteOrder::read_little_endian(stored, offset, version))
+		{
+			frames[version] = stored;
+		}
+	}
+	ASSERT_EQ(codec.dictionary_version("telemetry"), 4u);
+	ASSERT_TRUE(frames.contains(2));
+
+	// An unreadable payload keeps every version of its queue for this pass
+	codec.begin_dictionary_audit();
+	EXPECT_TRUE(codec.audits_dictionaries("telemetry"));
+	codec.note_dictionary_use("telemetry", std::nullopt);
+	EXPECT_FALSE(codec.audits_dictionaries("telemetry"));
+	EXPECT_EQ(std::get<0>(codec.finish_dictionary_audit()), 0);
+
+	codec.begin_dictionary_audit();
+	codec.note_dictionary_use("telemetry", frames[2]);
+	codec.note_dictionary_use("telemetry", R"({"raw":true})");
+	auto [dropped, error] = codec.finish_dictionary_audit();
+	EXPECT_FALSE(error.has_value()) << error.value_or("");
+	EXPECT_EQ(dropped, 2) << "versions 1 and 3";
+
+	EXPECT_FALSE(std::filesystem::exists(root + "/telemetry/00000001.dict"));
+	EXPECT_TRUE(std::filesystem::exists(root + "/telemetry/00000002.dict"));
+	EXPECT_FALSE(std::filesystem::exists(root + "/telemetry/00000003.dict"));
+	EXPECT_TRUE(std::filesystem::exists(root + "/telemetry/00000004.dict"));
+
+	auto [kept, kept_error] = codec.decode("telemetry", frames[2]);
+	EXPECT_TRUE(kept.has_value()) << kept_error.value_or("");
+	EXPECT_FALSE(std::get<0>(codec.decode("telemetry", frames[1])).has_value());
+
+	// Retraining continues from the latest version, which is never retired
+	EXPECT_EQ(std::get<0>(codec.train_dictionary("telemetry")).value_or(0), 5u);
+}
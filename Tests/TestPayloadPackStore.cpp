@@ -0,0 +1,144 @@
+#include "TestHelpers.h"
+#include "PayloadPackStore.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <format>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class PayloadPackStoreTest : public ::testing::Test
+{
+protected:
+	std::unique_ptr<TempDir> temp_dir_;
+	PayloadPackStore store_;
+
+	void SetUp() override
+	{
+		temp_dir_ = std::make_unique<TempDir>("pack_store_test_");
+	}
+
+	void TearDown() override
+	{
+		store_.close();
+		temp_dir_.reset();
+	}
+};
+
+// ---------------------------------------------------------------------------
+// AppendAndRead: records are addressed by (pack_id, offset, length)
+// ---------------------------------------------------------------------------
+TEST_F(PayloadPackStoreTest, AppendAndRead)
+{
+	ASSERT_TRUE(std::get<0>(store_.open(temp_dir_->path(), 1024)));
+
+	auto [first, first_err] = store_.append("first");
+	auto [second, second_err] = store_.append("second-record");
+	ASSERT_TRUE(first.has_value()) << first_err.value_or("unknown");
+	ASSERT_TRUE(second.has_value()) << second_err.value_or("unknown");
+
+	EXPECT_EQ(first->pack_id, second->pack_id);
+	EXPECT_EQ(first->offset, 0u);
+	EXPECT_EQ(second->offset, 5u);
+
+	EXPECT_EQ(std::get<0>(store_.read(first.value())).value_or(""), "first");
+	EXPECT_EQ(std::get<0>(store_.read(second.value())).value_or(""), "second-record");
+
+	PackLocation out_of_range{ first->pack_id, 100, 10 };
+	auto [missing, missing_err] = store_.read(out_of_range);
+	EXPECT_FALSE(missing.has_value());
+	EXPECT_TRUE(missing_err.has_value());
+}
+
+// ---------------------------------------------------------------------------
+// RollsAndReopens: full packs roll over and survive a reopen
+// ---------------------------------------------------------------------------
+TEST_F(PayloadPackStoreTest, RollsAndReopens)
+{
+	ASSERT_TRUE(std::get<0>(store_.open(temp_dir_->path(), 16)));
+
+	auto [first, first_err] = store_.append("0123456789");
+	auto [second, second_err] = store_.append("abcdefghij");
+	ASSERT_TRUE(first.has_value() && second.has_value());
+	EXPECT_NE(first->pack_id, second->pack_id);
+	EXPECT_EQ(store_.pack_ids().size(), 2u);
+	EXPECT_TRUE(fs::exists(store_.build_pack_path(first->pack_id)));
+
+	store_.close();
+	ASSERT_TRUE(std::get<0>(store_.open(temp_dir_->path(), 16)));
+
+	EXPECT_EQ(store_.active_pack_id(), second->pack_id);
+	EXPECT_EQ(std::get<0>(store_.read(first.value())).value_or(""), "0123456789");
+	EXPECT_EQ(std::get<0>(store_.read(second.value())).value_or(""), "abcdefghij");
+
+	EXPECT_FALSE(std::get<0>(store_.remove(second->pack_id))) << "active pack must not be removed";
+	EXPECT_TRUE(std::get<0>(store_.sync(first->pack_id)));
+	EXPECT_TRUE(std::get<0>(store_.remove(first->pack_id)));
+	EXPECT_FALSE(fs::exists(store_.build_pack_path(first->pack_id)));
+	EXPECT_FALSE(std::get<0>(store_.sync(first->pack_id))) << "a removed pack must not be recreated";
+	EXPECT_FALSE(fs::exists(store_.build_pack_path(first->pack_id)));
+}
+
+// ---------------------------------------------------------------------------
+// PinnedPackIsKept: a pack with an uncommitted append cannot be removed
+// ---------------------------------------------------------------------------
+TEST_F(PayloadPackStoreTest, PinnedPackIsKept)
+{
+	ASSERT_TRUE(std::get<0>(store_.open(temp_dir_->path(), 16)));
+
+	auto [pinned, pinned_err] = store_.append("0123456789", false, true);
+	auto [next, next_err] = store_.append("abcdefghij");
+	ASSERT_TRUE(pinned.has_value() && next.has_value());
+	ASSERT_NE(pinned->pack_id, store_.active_pack_id());
+
+	EXPECT_TRUE(store_.is_pinned(pinned->pack_id));
+	EXPECT_FALSE(std::get<0>(store_.remove(pinned->pack_id)));
+	EXPECT_EQ(std::get<0>(store_.read(pinned.value())).value_or(""), "0123456789");
+
+	store_.release(pinned->pack_id);
+	EXPECT_FALSE(store_.is_pinned(pinned->pack_id));
+	EXPECT_TRUE(std::get<0>(store_.remove(pinned->pack_id)));
+}
+
+// ---------------------------------------------------------------------------
+// ConcurrentAppendAndRead: reserved ranges never overlap when writes run outside the lock
+// ---------------------------------------------------------------------------
+TEST_F(PayloadPackStoreTest, ConcurrentAppendAndRead)
+{
+	ASSERT_TRUE(std::get<0>(store_.open(temp_dir_->path(), 4096)));
+
+	constexpr int thread_count = 8;
+	constexpr int per_thread = 200;
+	std::vector<std::vector<std::pair<PackLocation, std::string>>> written(thread_count);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([this, t, &written]()
+		{
+			for (int i = 0; i < per_thread; ++i)
+			{
+				auto content = std::format("{}:{}:{}", t, i, std::string(static_cast<size_t>(i % 50), 'a' + static_cast<char>(t)));
+				auto [location, error] = store_.append(content, i % 20 == 0);
+				ASSERT_TRUE(location.has_value()) << error.value_or("unknown");
+				written[t].push_back({ location.value(), content });
+
+				auto [read_back, read_error] = store_.read(location.value());
+				EXPECT_EQ(read_back.value_or(""), content) << read_error.value_or("");
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	for (const auto& records : written)
+	{
+		for (const auto& [location, content] : records)
+		{
+			EXPECT_EQ(std::get<0>(store_.read(location)).value_or(""), content);
+		}
+	}
+}
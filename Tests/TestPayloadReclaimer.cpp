@@ -0,0 +1,110 @@
+#include "TestHelpers.h"
+#include "PayloadReclaimer.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+class PayloadReclaimerTest : public ::testing::Test
+{
+protected:
+	std::unique_ptr<TempDir> temp_dir_;
+	PayloadReclaimer reclaimer_;
+
+	void SetUp() override
+	{
+		init_test_logger();
+		temp_dir_ = std::make_unique<TempDir>("reclaimer_test_");
+	}
+
+	void TearDown() override
+	{
+		reclaimer_.stop();
+		temp_dir_.reset();
+	}
+
+	auto touch(const std::string& name) -> std::string
+	{
+		auto path = (temp_dir_->path_obj() / name).string();
+		std::ofstream(path) << name;
+		return path;
+	}
+};
+
+// ---------------------------------------------------------------------------
+// BatchedCompletion: queued work runs on flush and reports finished tokens
+// ---------------------------------------------------------------------------
+TEST_F(PayloadReclaimerTest, BatchedCompletion)
+{
+	std::mutex completed_mutex;
+	std::vector<std::string> completed;
+	reclaimer_.start(100, 60000, [&](const std::vector<std::string>& tokens) {
+		std::lock_guard<std::mutex> lock(completed_mutex);
+		completed.insert(completed.end(), tokens.begin(), tokens.end());
+	});
+
+	std::vector<std::string> paths;
+	for (int i = 0; i < 5; ++i)
+	{
+		paths.push_back(touch(std::format("file_{}.json", i)));
+		reclaimer_.schedule(std::format("token_{}", i), { Utilities::IoOperationTypes::Unlink, paths.back() });
+	}
+
+	EXPECT_TRUE(fs::exists(paths.front())) << "work waits for the batch window";
+	EXPECT_EQ(reclaimer_.pending(), 5u);
+
+	reclaimer_.flush();
+
+	EXPECT_EQ(reclaimer_.pending(), 0u);
+	for (const auto& path : paths)
+	{
+		EXPECT_FALSE(fs::exists(path));
+	}
+
+	std::lock_guard<std::mutex> lock(completed_mutex);
+	EXPECT_EQ(completed.size(), 5u);
+}
+
+// ---------------------------------------------------------------------------
+// IntervalElapses: a partial batch runs once the interval passes, without flush or stop
+// ---------------------------------------------------------------------------
+TEST_F(PayloadReclaimerTest, IntervalElapses)
+{
+	reclaimer_.start(64, 50);
+
+	// Let the worker reach its idle wait so the schedule has to wake it
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	auto path = touch("single.json");
+	reclaimer_.schedule("single", { Utilities::IoOperationTypes::Unlink, path });
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+	while ((fs::exists(path) || reclaimer_.pending() > 0) && std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	EXPECT_FALSE(fs::exists(path));
+	EXPECT_EQ(reclaimer_.pending(), 0u);
+}
+
+// ---------------------------------------------------------------------------
+// StopDrains: stop finishes queued work; without a worker operations run inline
+// ---------------------------------------------------------------------------
+TEST_F(PayloadReclaimerTest, StopDrains)
+{
+	reclaimer_.start(100, 60000);
+
+	auto source = touch("source.json");
+	auto target = (temp_dir_->path_obj() / "target.json").string();
+	reclaimer_.schedule("move", { Utilities::IoOperationTypes::Rename, source, target });
+
+	reclaimer_.stop();
+	EXPECT_FALSE(fs::exists(source));
+	EXPECT_TRUE(fs::exists(target));
+
+	reclaimer_.schedule("inline", { Utilities::IoOperationTypes::Unlink, target });
+	EXPECT_FALSE(fs::exists(target));
+}
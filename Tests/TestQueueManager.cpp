@@ -182,6 +182,40 @@ public:
 		return { true, std::nullopt };
 	}
 
+	auto check_consistency_slice(const int32_t& /*max_keys*/)
+		-> std::tuple<ConsistencySlice, std::optional<std::string>> override
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		consistency_slice_call_count_++;
+
+		ConsistencySlice slice;
+		slice.queue = "test-queue";
+		slice.checked_keys = 1;
+		slice.report.orphan_payloads = 1;
+		slice.report.issues.push_back({ ConsistencyIssueType::OrphanPayload, "test-queue", "", "orphan.json", "" });
+		return { slice, std::nullopt };
+	}
+
+	auto repair_consistency(const ConsistencyReport& report)
+		-> std::tuple<int32_t, std::optional<std::string>> override
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		repair_call_count_++;
+		return { static_cast<int32_t>(report.issues.size()), std::nullopt };
+	}
+
+	auto get_consistency_slice_call_count(void) -> int32_t
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return consistency_slice_call_count_;
+	}
+
+	auto get_repair_call_count(void) -> int32_t
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return repair_call_count_;
+	}
+
 	auto get_process_delayed_call_count(void) -> int32_t
 	{
 		std::lock_guard<std::mutex> lock(mutex_);
@@ -195,6 +229,8 @@ private:
 	std::vector<MoveToDlqRecord> move_to_dlq_calls_;
 	std::vector<ExpiredLeaseInfo> expired_inflight_messages_;
 	int32_t process_delayed_call_count_ = 0;
+	int32_t consistency_slice_call_count_ = 0;
+	int32_t repair_call_count_ = 0;
 };
 
 // ---------------------------------------------------------------------------
@@ -795,3 +831,35 @@ TEST_F(QueueManagerTest, RetrySweepWorkerCallsProcessDelayed)
 	// Verify process_delayed_messages was called at least once
 	EXPECT_GE(mock_backend_->get_process_delayed_call_count(), 1);
 }
+
+TEST_F(QueueManagerTest, ConsistencyWorkerDisabledByDefault)
+{
+	queue_manager_ = create_manager();
+
+	auto [started, err] = queue_manager_->start();
+	ASSERT_TRUE(started);
+
+	wait_for_sweep();
+
+	queue_manager_->stop();
+
+	EXPECT_EQ(mock_backend_->get_consistency_slice_call_count(), 0);
+}
+
+TEST_F(QueueManagerTest, ConsistencyWorkerRunsSlicesAndRepairs)
+{
+	config_.consistency_interval_ms = 20;
+	config_.consistency_slice_keys = 16;
+	config_.consistency_repair = true;
+	queue_manager_ = create_manager();
+
+	auto [started, err] = queue_manager_->start();
+	ASSERT_TRUE(started);
+
+	wait_for_sweep();
+
+	queue_manager_->stop();
+
+	EXPECT_GE(mock_backend_->get_consistency_slice_call_count(), 2);
+	EXPECT_EQ(mock_backend_->get_repair_call_count(), mock_backend_->get_consistency_slice_call_count());
+}
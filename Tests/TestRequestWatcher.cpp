@@ -0,0 +1,198 @@
+#include "TestHelpers.h"
+#include "RequestWatcher.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <thread>
+
+using namespace Utilities;
+namespace fs = std::filesystem;
+
+class RequestWatcherTest : public ::testing::Test
+{
+protected:
+	std::unique_ptr<TempDir> temp_dir_;
+
+	void SetUp() override
+	{
+		init_test_logger();
+		temp_dir_ = std::make_unique<TempDir>("request_watcher_test_");
+	}
+
+	void TearDown() override
+	{
+		temp_dir_.reset();
+	}
+
+	auto make_dir(const std::string& name) -> std::string
+	{
+		auto dir = temp_dir_->path() + "/" + name;
+		fs::create_directories(dir);
+		return dir;
+	}
+
+	// Written under a temporary name and renamed in, like the mailbox clients do
+	auto drop(const std::string& dir, const std::string& name) -> void
+	{
+		auto temp = std::format("{}/{}.tmp", dir, name);
+		std::ofstream(temp) << "{}";
+		fs::rename(temp, std::format("{}/{}", dir, name));
+	}
+
+	auto collect(RequestWatcher& watcher, const size_t& expected, const int& timeout_ms = 2000) -> std::vector<std::string>
+	{
+		std::vector<std::string> paths;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+		while (paths.size() < expected && std::chrono::steady_clock::now() < deadline)
+		{
+			watcher.wait(paths, 50);
+		}
+		return paths;
+	}
+};
+
+// ---------------------------------------------------------------------------
+// Events: renamed-in and closed-after-write files are reported, others are not
+// ---------------------------------------------------------------------------
+TEST_F(RequestWatcherTest, Events)
+{
+	auto dir = make_dir("requests");
+	drop(dir, "existing.json");
+
+	RequestWatcher watcher(dir);
+	auto [ok, error] = watcher.start();
+	ASSERT_TRUE(ok) << error.value_or("");
+
+	// The first wait reports what was already there
+	auto initial = collect(watcher, 1);
+	ASSERT_EQ(initial.size(), 1u);
+	EXPECT_EQ(initial[0], dir + "/existing.json");
+
+	drop(dir, "renamed.json");
+	std::ofstream(dir + "/written.json") << "{}";
+	std::ofstream(dir + "/ignored.txt") << "x";
+	fs::create_directories(dir + "/sub.json");
+
+	auto paths = collect(watcher, 2);
+	std::set<std::string> seen(paths.begin(), paths.end());
+	EXPECT_EQ(seen, (std::set<std::string>{ dir + "/renamed.json", dir + "/written.json" }));
+
+	std::vector<std::string> none;
+	EXPECT_EQ(watcher.wait(none, 100), 0u);
+	EXPECT_EQ(watcher.rescans(), 1u);
+}
+
+// ---------------------------------------------------------------------------
+// Overflow: a full ring falls back to a directory rescan without losing files
+// ---------------------------------------------------------------------------
+TEST_F(RequestWatcherTest, OverflowRescans)
+{
+	auto dir = make_dir("requests");
+
+	RequestWatcher watcher(dir, ".json", 8);
+	ASSERT_TRUE(std::get<0>(watcher.start()));
+	std::vector<std::string> initial;
+	watcher.wait(initial, 0);
+
+	for (int i = 0; i < 100; ++i)
+	{
+		drop(dir, std::format("req-{:03}.json", i));
+	}
+
+	auto paths = collect(watcher, 100);
+	std::set<std::string> seen(paths.begin(), paths.end());
+	EXPECT_EQ(seen.size(), 100u);
+	EXPECT_GE(watcher.rescans(), 2u);
+}
+
+// ---------------------------------------------------------------------------
+// Independent: two watchers only see their own directories
+// ---------------------------------------------------------------------------
+TEST_F(RequestWatcherTest, Independent)
+{
+	auto first_dir = make_dir("first");
+	auto second_dir = make_dir("second");
+
+	RequestWatcher first(first_dir);
+	RequestWatcher second(second_dir);
+	ASSERT_TRUE(std::get<0>(first.start()));
+	ASSERT_TRUE(std::get<0>(second.start()));
+
+	drop(first_dir, "a.json");
+	drop(second_dir, "b.json");
+
+	auto first_paths = collect(first, 1);
+	auto second_paths = collect(second, 1);
+	ASSERT_EQ(first_paths.size(), 1u);
+	ASSERT_EQ(second_paths.size(), 1u);
+	EXPECT_EQ(first_paths[0], first_dir + "/a.json");
+	EXPECT_EQ(second_paths[0], second_dir + "/b.json");
+}
+
+// ---------------------------------------------------------------------------
+// Wake: a blocked wait returns as soon as wake() is called
+// ---------------------------------------------------------------------------
+TEST_F(RequestWatcherTest, Wake)
+{
+	auto dir = make_dir("requests");
+
+	RequestWatcher watcher(dir);
+	ASSERT_TRUE(std::get<0>(watcher.start()));
+	std::vector<std::string> paths;
+	watcher.wait(paths, 0);
+
+	std::thread waker([&watcher]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		watcher.wake();
+	});
+
+	auto started = std::chrono::steady_clock::now();
+	watcher.wait(paths, 5000);
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+	waker.join();
+
+	EXPECT_LT(elapsed, 2000);
+}
+
+// ---------------------------------------------------------------------------
+// Burst: 10k request files dropped at once are picked up in a handful of bulk reads
+// ---------------------------------------------------------------------------
+TEST_F(RequestWatcherTest, Burst)
+{
+	auto dir = make_dir("requests");
+
+	RequestWatcher watcher(dir);
+	ASSERT_TRUE(std::get<0>(watcher.start()));
+	std::vector<std::string> initial;
+	watcher.wait(initial, 0);
+
+	// Two events per file (the .tmp close and the rename) can exceed the kernel queue, which the watcher must survive
+	constexpr size_t file_count = 10000;
+	for (size_t i = 0; i < file_count; ++i)
+	{
+		drop(dir, std::format("req-{:05}.json", i));
+	}
+
+	std::set<std::string> seen;
+	size_t waits = 0;
+	auto started = std::chrono::steady_clock::now();
+	auto deadline = started + std::chrono::seconds(30);
+	while (seen.size() < file_count && std::chrono::steady_clock::now() < deadline)
+	{
+		std::vector<std::string> paths;
+		watcher.wait(paths, 50);
+		seen.insert(paths.begin(), paths.end());
+		++waits;
+	}
+	auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+
+	EXPECT_EQ(seen.size(), file_count);
+	EXPECT_LE(waits, 4u);
+
+	std::cout << std::format("[ bench    ] {} files collected in {} us over {} waits, {} rescans\n", file_count, elapsed_us, waits,
+							 watcher.rescans());
+}
@@ -0,0 +1,68 @@
+#include "ShardedCounter.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Utilities;
+
+// ---------------------------------------------------------------------------
+// Basic: adds sum across shards, reset clears them
+// ---------------------------------------------------------------------------
+TEST(ShardedCounterTest, Basic)
+{
+	ShardedCounter counter;
+	EXPECT_EQ(counter.value(), 0u);
+
+	counter.add();
+	counter.add(41);
+	std::thread([&counter]() { counter.add(100); }).join();
+	EXPECT_EQ(counter.value(), 142u);
+
+	counter.reset();
+	EXPECT_EQ(counter.value(), 0u);
+}
+
+// ---------------------------------------------------------------------------
+// Concurrent: no adds are lost; compared against one shared atomic
+// ---------------------------------------------------------------------------
+TEST(ShardedCounterTest, Concurrent)
+{
+	const int thread_count = static_cast<int>(std::max(4u, std::thread::hardware_concurrency()));
+	constexpr int per_thread = 1000000;
+
+	auto run = [&](auto&& add) -> int64_t
+	{
+		auto started = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (int t = 0; t < thread_count; ++t)
+		{
+			threads.emplace_back([&add]()
+			{
+				for (int i = 0; i < per_thread; ++i)
+				{
+					add();
+				}
+			});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+	};
+
+	ShardedCounter sharded;
+	auto sharded_us = run([&sharded]() { sharded.add(); });
+	EXPECT_EQ(sharded.value(), static_cast<uint64_t>(thread_count) * per_thread);
+
+	std::atomic<uint64_t> shared{ 0 };
+	auto shared_us = run([&shared]() { shared.fetch_add(1, std::memory_order_relaxed); });
+	EXPECT_EQ(shared.load(), static_cast<uint64_t>(thread_count) * per_thread);
+
+	std::cout << std::format("[ bench    ] {} threads x {} adds: sharded {} ms, one shared atomic {} ms\n", thread_count, per_thread,
+							 sharded_us / 1000, shared_us / 1000);
+}
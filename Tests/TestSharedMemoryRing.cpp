@@ -0,0 +1,152 @@
+#include "TestHelpers.h"
+#include "SharedMemoryRing.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <format>
+#include <string_view>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace Utilities;
+
+class SharedMemoryRingTest : public ::testing::Test
+{
+protected:
+	std::string name_;
+
+	void SetUp() override
+	{
+		init_test_logger();
+		name_ = std::format("/yirangmq-ring-test-{}", ::getpid());
+	}
+};
+
+// ---------------------------------------------------------------------------
+// RoundTrip: records pushed by the creator are popped in order by an attached peer
+// ---------------------------------------------------------------------------
+TEST_F(SharedMemoryRingTest, RoundTrip)
+{
+	auto [owner, create_error] = SharedMemoryChannel::create(name_, 4096);
+	ASSERT_NE(owner, nullptr) << create_error.value_or("");
+
+	auto [peer, attach_error] = SharedMemoryChannel::attach(name_);
+	ASSERT_NE(peer, nullptr) << attach_error.value_or("");
+
+	for (int i = 0; i < 3; ++i)
+	{
+		ASSERT_TRUE(std::get<0>(owner->push(SharedMemoryDirection::Request, std::format("request-{}", i))));
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		auto record = peer->pop(SharedMemoryDirection::Request);
+		ASSERT_TRUE(record.has_value());
+		EXPECT_EQ(record.value(), std::format("request-{}", i));
+	}
+	EXPECT_FALSE(peer->pop(SharedMemoryDirection::Request).has_value());
+	EXPECT_FALSE(owner->pop(SharedMemoryDirection::Response).has_value()) << "directions are independent";
+
+	owner->close();
+	EXPECT_TRUE(peer->closed());
+}
+
+// ---------------------------------------------------------------------------
+// WrapAndFull: records wrap around the end of the ring and a full ring rejects pushes
+// ---------------------------------------------------------------------------
+TEST_F(SharedMemoryRingTest, WrapAndFull)
+{
+	auto [channel, create_error] = SharedMemoryChannel::create(name_, 4096);
+	ASSERT_NE(channel, nullptr) << create_error.value_or("");
+
+	std::string record(1000, 'x');
+	int pushed = 0;
+	while (std::get<0>(channel->push(SharedMemoryDirection::Request, record)))
+	{
+		pushed++;
+	}
+	EXPECT_EQ(pushed, 4);
+
+	auto [too_large, too_large_error] = channel->push(SharedMemoryDirection::Request, std::string(4000, 'y'));
+	EXPECT_FALSE(too_large);
+
+	// Cycle enough records through to wrap several times
+	for (int i = 0; i < 40; ++i)
+	{
+		ASSERT_TRUE(channel->pop(SharedMemoryDirection::Request).has_value());
+		auto content = std::format("{}-{}", i, std::string(300 + i * 5, 'z'));
+		ASSERT_TRUE(std::get<0>(channel->push(SharedMemoryDirection::Request, content))) << "push " << i;
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		ASSERT_TRUE(channel->pop(SharedMemoryDirection::Request).has_value());
+	}
+	EXPECT_FALSE(channel->pop(SharedMemoryDirection::Request).has_value());
+}
+
+// ---------------------------------------------------------------------------
+// WaitWakesOnPush: a blocked reader is woken by a push from another thread
+// ---------------------------------------------------------------------------
+TEST_F(SharedMemoryRingTest, WaitWakesOnPush)
+{
+	auto [channel, create_error] = SharedMemoryChannel::create(name_, 4096);
+	ASSERT_NE(channel, nullptr) << create_error.value_or("");
+
+	EXPECT_FALSE(channel->wait(SharedMemoryDirection::Response, 1000));
+
+	std::thread writer([&]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		channel->push(SharedMemoryDirection::Response, "pong");
+	});
+
+	auto started = std::chrono::steady_clock::now();
+	EXPECT_TRUE(channel->wait(SharedMemoryDirection::Response, 5000000));
+	EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(2));
+	EXPECT_EQ(channel->pop(SharedMemoryDirection::Response).value_or(""), "pong");
+
+	writer.join();
+}
+
+// ---------------------------------------------------------------------------
+// CorruptPeerFaults: a rewritten ring size is ignored and a record longer than what was pushed faults the channel
+// ---------------------------------------------------------------------------
+TEST_F(SharedMemoryRingTest, CorruptPeerFaults)
+{
+	auto [owner, create_error] = SharedMemoryChannel::create(name_, 4096);
+	ASSERT_NE(owner, nullptr) << create_error.value_or("");
+
+	auto [peer, attach_error] = SharedMemoryChannel::attach(name_);
+	ASSERT_NE(peer, nullptr) << attach_error.value_or("");
+
+	ASSERT_TRUE(std::get<0>(owner->push(SharedMemoryDirection::Response, "first-record")));
+	ASSERT_TRUE(std::get<0>(owner->push(SharedMemoryDirection::Response, "second-record")));
+
+	// Tamper with the segment the way a misbehaving client could
+	int fd = ::shm_open(name_.c_str(), O_RDWR, 0600);
+	ASSERT_GE(fd, 0);
+	struct stat status{};
+	ASSERT_EQ(::fstat(fd, &status), 0);
+	auto bytes = static_cast<size_t>(status.st_size);
+	auto* raw = static_cast<char*>(::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+	::close(fd);
+	ASSERT_NE(raw, MAP_FAILED);
+
+	uint32_t huge_ring = 0x7FFFFFF8;
+	std::memcpy(raw + 2 * sizeof(uint32_t), &huge_ring, sizeof(huge_ring));  // header: magic, version, ring_bytes
+
+	auto second = std::string_view(raw, bytes).find("second-record");
+	ASSERT_NE(second, std::string_view::npos);
+	uint32_t huge_length = 1024 * 1024;
+	std::memcpy(raw + second - sizeof(uint32_t), &huge_length, sizeof(huge_length));
+
+	EXPECT_EQ(peer->pop(SharedMemoryDirection::Response).value_or(""), "first-record");
+	EXPECT_FALSE(peer->pop(SharedMemoryDirection::Response).has_value());
+	EXPECT_TRUE(peer->closed());
+	EXPECT_FALSE(owner->closed());
+
+	::munmap(raw, bytes);
+}